@@ -0,0 +1,233 @@
+/********************************************************************************
+* bam.c: Innehller funktionsdefinitioner fr avbrottsstyrd mjukvaru-PWM via
+*        Bit Angle Modulation.
+********************************************************************************/
+#include "bam.h"
+
+/* Makrodefinitioner: */
+#define BAM_CLOCK_SELECT (1 << CS11)                                  /* Prescaler 8 fr Timer 1. */
+#define BAM_LSB_TICKS ((uint16_t)(BAM_LSB_US * ((F_CPU) / 1000000UL) / 8)) /* Minsta tidsluckan i timersteg. */
+#define BAM_NUM_PORTS 3                                               /* Antal I/O-portar (B, C och D). */
+#define BAM_PORT_B 0                                                  /* Index fr PORTB (pin 8 - 13). */
+#define BAM_PORT_C 1                                                  /* Index fr PORTC (pin 14 - 19). */
+#define BAM_PORT_D 2                                                  /* Index fr PORTD (pin 0 - 7). */
+
+#if BAM_LSB_US < 8 || BAM_LSB_US > 255
+#error "BAM_LSB_US must be in the range 8 - 255!"
+#endif
+
+/* Statiska variabler: */
+static uint8_t masks[2][BAM_BITS][BAM_NUM_PORTS];  /* Portmasker per tidslucka (dubbelbuffrade). */
+static uint8_t keep[BAM_NUM_PORTS];                /* Pinnar per port som inte tillhr ngon kanal. */
+static uint8_t channel_port[BAM_CHANNELS_MAX];     /* Portindex per kanal. */
+static uint8_t channel_mask[BAM_CHANNELS_MAX];     /* Bitmask per kanal p aktuell port. */
+static uint8_t duty_cycles[BAM_CHANNELS_MAX];      /* Senast satt duty cycle per kanal. */
+static uint8_t num_channels = 0;                   /* Antalet kanaler. */
+static volatile uint8_t active = 0;                /* Index fr masker som anvnds av avbrottsrutinen. */
+static volatile bool pending = false;              /* Indikerar att bakre masker ska brja anvndas. */
+static volatile uint8_t slot = 0;                  /* Nsta tidslucka. */
+static bool enabled = false;                       /* Indikerar att BAM r aktiverat. */
+
+/* Statiska funktioner: */
+static void bam_update(void);
+
+/********************************************************************************
+* ISR (TIMER1_COMPB_vect): Avbrottsrutin som ger rum i brjan av varje
+*                          tidslucka, varvid tidsluckans portmasker skrivs
+*                          till samtliga portar och nsta avbrott
+*                          schemalggs relativt fregende, s att
+*                          avbrottsrutinens frdrjning inte ackumuleras.
+*                          I brjan av varje period byts till nya masker,
+*                          frutsatt att sdana har berknats.
+********************************************************************************/
+ISR (TIMER1_COMPB_vect)
+{
+   const uint8_t n = slot;
+
+   if (n == 0 && pending)
+   {
+      active ^= 1;
+      pending = false;
+   }
+
+   const uint8_t* mask = masks[active][n];
+   PORTB = (PORTB & keep[BAM_PORT_B]) | mask[BAM_PORT_B];
+   PORTC = (PORTC & keep[BAM_PORT_C]) | mask[BAM_PORT_C];
+   PORTD = (PORTD & keep[BAM_PORT_D]) | mask[BAM_PORT_D];
+   OCR1B += BAM_LSB_TICKS << n;
+   slot = n + 1 < BAM_BITS ? n + 1 : 0;
+   return;
+}
+
+/********************************************************************************
+* bam_init: Registrerar lysdioderna i angiven vektor som kanaler, slcker dem
+*           och startar avbrotten fr Timer 1 Compare B. Frsta avbrottet
+*           schemalggs en tidslucka efter Timer 1:s aktuella vrde.
+*
+*           - leds: Pekare till vektorn med lysdioderna som ska styras.
+********************************************************************************/
+int bam_init(const struct led_vector* leds)
+{
+   if (leds->size > BAM_CHANNELS_MAX) return 1;
+   bam_disable();
+   if (timer1_acquire(BAM_CLOCK_SELECT)) return 1;
+
+   for (uint8_t i = 0; i < BAM_NUM_PORTS; ++i)
+   {
+      keep[i] = 0xFF;
+   }
+
+   num_channels = (uint8_t)leds->size;
+
+   for (uint8_t i = 0; i < num_channels; ++i)
+   {
+      struct led* led = leds->leds[i];
+
+      if (led->output == &PORTB) channel_port[i] = BAM_PORT_B;
+      else if (led->output == &PORTC) channel_port[i] = BAM_PORT_C;
+      else channel_port[i] = BAM_PORT_D;
+
+      channel_mask[i] = (1 << led->pin);
+      keep[channel_port[i]] &= ~channel_mask[i];
+      duty_cycles[i] = 0;
+      led_off(led);
+   }
+
+   const uint8_t sreg = SREG;
+   asm("CLI");
+
+   for (uint8_t i = 0; i < BAM_BITS; ++i)
+   {
+      for (uint8_t j = 0; j < BAM_NUM_PORTS; ++j)
+      {
+         masks[0][i][j] = 0;
+         masks[1][i][j] = 0;
+      }
+   }
+
+   active = 0;
+   pending = false;
+   slot = 0;
+   OCR1B = TCNT1 + BAM_LSB_TICKS;
+   TIFR1 = (1 << OCF1B);
+   TIMSK1 |= (1 << OCIE1B);
+   enabled = true;
+
+   SREG = sreg;
+   return 0;
+}
+
+/********************************************************************************
+* bam_disable: Inaktiverar avbrotten fr Timer 1 Compare B, slcker samtliga
+*              kanaler och slpper Timer 1.
+********************************************************************************/
+void bam_disable(void)
+{
+   if (!enabled) return;
+
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   TIMSK1 &= ~(1 << OCIE1B);
+   PORTB &= keep[BAM_PORT_B];
+   PORTC &= keep[BAM_PORT_C];
+   PORTD &= keep[BAM_PORT_D];
+   enabled = false;
+   SREG = sreg;
+
+   timer1_release();
+   return;
+}
+
+/********************************************************************************
+* bam_enabled: Indikerar ifall BAM r aktiverat.
+********************************************************************************/
+bool bam_enabled(void)
+{
+   return enabled;
+}
+
+/********************************************************************************
+* bam_channels: Returnerar antalet kanaler.
+********************************************************************************/
+uint8_t bam_channels(void)
+{
+   return num_channels;
+}
+
+/********************************************************************************
+* bam_set_duty: Stter duty cycle fr angiven kanal och berknar nya
+*               portmasker.
+*
+*               - channel: Kanalen.
+*               - duty   : Duty cycle (0 - BAM_DUTY_MAX).
+********************************************************************************/
+void bam_set_duty(const uint8_t channel,
+                  const uint8_t duty)
+{
+   if (channel >= num_channels) return;
+   duty_cycles[channel] = duty;
+   bam_update();
+   return;
+}
+
+/********************************************************************************
+* bam_set_duties: Stter duty cycle fr samtliga kanaler och berknar nya
+*                 portmasker en gng fr samtliga kanaler.
+*
+*                 - duties: Pekare till array med en duty cycle per kanal.
+********************************************************************************/
+void bam_set_duties(const uint8_t* duties)
+{
+   for (uint8_t i = 0; i < num_channels; ++i)
+   {
+      duty_cycles[i] = duties[i];
+   }
+
+   bam_update();
+   return;
+}
+
+/********************************************************************************
+* bam_get_duty: Returnerar senast satt duty cycle fr angiven kanal, eller 0
+*               om kanalen inte finns.
+*
+*               - channel: Kanalen.
+********************************************************************************/
+uint8_t bam_get_duty(const uint8_t channel)
+{
+   return channel < num_channels ? duty_cycles[channel] : 0;
+}
+
+/********************************************************************************
+* bam_update: Berknar portmasker fr samtliga tidsluckor in i den bakre
+*             bufferten och markerar dem som klara att anvndas. Flaggan
+*             pending nollstlls frst, drmed kan avbrottsrutinen inte byta
+*             buffert under berkningen, och en tidigare berkning som nnu
+*             inte har brjat anvndas erstts av den nya. En minnesbarrir
+*             hindrar kompilatorn frn att flytta skrivningarna till den
+*             bakre bufferten frbi pending = true.
+********************************************************************************/
+static void bam_update(void)
+{
+   pending = false;
+   uint8_t (*back)[BAM_NUM_PORTS] = masks[active ^ 1];
+
+   for (uint8_t i = 0; i < BAM_BITS; ++i)
+   {
+      uint8_t mask[BAM_NUM_PORTS] = { 0, 0, 0 };
+
+      for (uint8_t j = 0; j < num_channels; ++j)
+      {
+         if (duty_cycles[j] & (1 << i)) mask[channel_port[j]] |= channel_mask[j];
+      }
+
+      for (uint8_t j = 0; j < BAM_NUM_PORTS; ++j)
+      {
+         back[i][j] = mask[j];
+      }
+   }
+
+   asm volatile("" ::: "memory");
+   pending = true;
+   return;
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+/********************************************************************************
+* bam.h: Innehller drivrutiner fr avbrottsstyrd mjukvaru-PWM via Bit Angle
+*        Modulation (BAM), vilket mjliggr individuell ljusstyrka fr upp
+*        till 20 lysdioder eller andra digitala utportar p godtyckliga
+*        pinnar, ven pinnar som saknar PWM i hrdvara.
+*
+*        Varje period delas in i BAM_BITS tidsluckor, dr lucka n varar
+*        2^n * BAM_LSB_US mikrosekunder. Under lucka n r en kanal tnd om
+*        bit n i dess duty cycle r satt, vilket ger en on-tid som r
+*        proportionell mot duty cycle. Vid 8 bitar och 16 us blir
+*        periodtiden 255 * 16 us = 4.08 ms (cirka 245 Hz), med endast
+*        tta avbrott per period oavsett duty cycle.
+*
+*        Fr varje lucka berknas i frvg en mask per I/O-port (PORTB,
+*        PORTC samt PORTD), drmed skriver avbrottsrutinen endast tre
+*        portregister per avbrott, vilket innebr att exekveringstiden inte
+*        kar med antalet kanaler. Endast pinnar som tillhr ngon kanal
+*        pverkas.
+*
+*        Maskerna r dubbelbuffrade: ny duty cycle berknas in i en
+*        bakre buffert i huvudprogrammet, som avbrottsrutinen byter till
+*        frst i brjan av nsta period. Drmed uppstr aldrig en period
+*        med en blandning av gammal och ny duty cycle.
+*
+*        Drivrutinen delar den frirullande rknaren p Timer 1 (prescaler
+*        8, dvs. 0.5 us per timersteg) med Input Capture, se timer1_acquire
+*        i timer.h, och anvnder jmfrelseregistret OCR1B samt
+*        avbrottsvektor TIMER1_COMPB_vect. Timer 1 kan drmed inte
+*        anvndas via strukten timer eller pwm_hw samtidigt.
+********************************************************************************/
+#ifndef BAM_H_
+#define BAM_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "timer.h"
+#include "led_vector.h"
+
+/* Makrodefinitioner: */
+#define BAM_BITS 8                         /* Upplsning i bitar. */
+#define BAM_DUTY_MAX ((1 << BAM_BITS) - 1) /* Duty cycle 100 %. */
+#define BAM_CHANNELS_MAX 20                /* Maximalt antal kanaler (samtliga pinnar). */
+
+#ifndef BAM_LSB_US
+#define BAM_LSB_US 16 /* Lngd p minsta tidsluckan i mikrosekunder (8 - 255). */
+#endif
+
+/********************************************************************************
+* bam_init: Startar BAM fr lysdioderna lagrade i angiven vektor, dr
+*           lysdioden p index i utgr kanal i. Samtliga kanaler startar
+*           med duty cycle 0. Returnerar 0 vid lyckad initiering, annars 1
+*           (fler n BAM_CHANNELS_MAX lysdioder, eller Timer 1 anvnds i en
+*           annan mod). Lysdioderna ska drefter inte styras p annat stt,
+*           exempelvis via pwm.h, frrn bam_disable har anropats.
+*
+*           - leds: Pekare till vektorn med lysdioderna som ska styras.
+********************************************************************************/
+int bam_init(const struct led_vector* leds);
+
+/********************************************************************************
+* bam_disable: Stoppar BAM och slcker samtliga kanaler. Timer 1 stoppas om
+*              den inte delas med en annan drivrutin.
+********************************************************************************/
+void bam_disable(void);
+
+/********************************************************************************
+* bam_enabled: Indikerar ifall BAM r aktiverat.
+********************************************************************************/
+bool bam_enabled(void);
+
+/********************************************************************************
+* bam_channels: Returnerar antalet kanaler.
+********************************************************************************/
+uint8_t bam_channels(void);
+
+/********************************************************************************
+* bam_set_duty: Stter duty cycle fr angiven kanal, vilken gller frn och
+*               med nsta period.
+*
+*               - channel: Kanalen (index i vektorn som passerades vid
+*                          initieringen).
+*               - duty   : Duty cycle (0 - BAM_DUTY_MAX).
+********************************************************************************/
+void bam_set_duty(const uint8_t channel,
+                  const uint8_t duty);
+
+/********************************************************************************
+* bam_set_duties: Stter duty cycle fr samtliga kanaler, vilka brjar glla
+*                 samtidigt frn och med nsta period.
+*
+*                 - duties: Pekare till array med en duty cycle per kanal.
+********************************************************************************/
+void bam_set_duties(const uint8_t* duties);
+
+/********************************************************************************
+* bam_get_duty: Returnerar senast satt duty cycle fr angiven kanal.
+*
+*               - channel: Kanalen.
+********************************************************************************/
+uint8_t bam_get_duty(const uint8_t channel);
+
+#endif /* BAM_H_ */
\ No newline at end of file
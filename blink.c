@@ -0,0 +1,123 @@
+/********************************************************************************
+* blink.c: Innehller funktionsdefinitioner fr blinkning av lysdioder.
+********************************************************************************/
+#include "blink.h"
+
+/* Makrodefinitioner: */
+#define BLINK_CLOCK_MASK ((1 << CS02) | (1 << CS01) | (1 << CS00)) /* Bitar CSn2:0 i TCCRnB. */
+
+/* Statiska funktioner: */
+static void blink_toggle(void* context);
+static bool blink_timer_busy(const enum timer_sel timer_sel);
+
+/********************************************************************************
+* blink_init: Initierar ny blinkning av angiven lysdiod.
+*
+*             - self     : Pekare till blinkningen som ska initieras.
+*             - led      : Pekare till lysdioden som ska blinka.
+*             - timer_sel: Timerkretsen som fr anvndas fr blinkning i
+*                          hrdvara.
+********************************************************************************/
+void blink_init(struct blink* self,
+                struct led* led,
+                const enum timer_sel timer_sel)
+{
+   self->led = led;
+   self->timer_sel = timer_sel;
+   self->hardware = false;
+   soft_timer_init(&self->soft_timer, &blink_toggle, led);
+   return;
+}
+
+/********************************************************************************
+* blink_start: Startar blinkning med angiven tid mellan tv toggningar. Bda
+*              utpinnarna p tillten timerkrets jmfrs med lysdiodens pin.
+*              Om lysdioden inte sitter p ngon av dem, om timerkretsen
+*              redan anvnds av annan kod eller om tiden inte ryms i en
+*              timerperiod, anvnds mjukvarutimern i stllet.
+*
+*              - self     : Pekare till blinkningen som ska startas.
+*              - toggle_ms: Tid mellan tv toggningar i millisekunder.
+********************************************************************************/
+int blink_start(struct blink* self,
+                const uint16_t toggle_ms)
+{
+   blink_stop(self);
+
+   if (self->timer_sel != TIMER_SEL_NONE && !blink_timer_busy(self->timer_sel))
+   {
+      const uint8_t pin = led_get_pin(self->led);
+
+      for (enum timer_channel channel = TIMER_CHANNEL_A; channel <= TIMER_CHANNEL_B; ++channel)
+      {
+         if (pin == timer_output_pin(self->timer_sel, channel) &&
+             timer_init_output(&self->timer, self->timer_sel, toggle_ms, channel) == 0)
+         {
+            self->hardware = true;
+            return 0;
+         }
+      }
+   }
+
+   return soft_timer_start(&self->soft_timer, toggle_ms, toggle_ms);
+}
+
+/********************************************************************************
+* blink_stop: Stoppar angiven blinkning och slcker lysdioden.
+*
+*             - self: Pekare till blinkningen som ska stoppas.
+********************************************************************************/
+void blink_stop(struct blink* self)
+{
+   if (self->hardware)
+   {
+      timer_clear(&self->timer);
+      self->hardware = false;
+   }
+   else
+   {
+      soft_timer_cancel(&self->soft_timer);
+   }
+
+   led_off(self->led);
+   return;
+}
+
+/********************************************************************************
+* blink_toggle: Callback-rutin fr mjukvarutimern vid blinkning i mjukvara,
+*               som togglar angiven lysdiod.
+*
+*               - context: Pekare till lysdioden som ska togglas.
+********************************************************************************/
+static void blink_toggle(void* context)
+{
+   led_toggle((struct led*)context);
+   return;
+}
+
+/********************************************************************************
+* blink_timer_busy: Indikerar ifall angiven timerkrets redan anvnds, dvs. om
+*                   den rknar (ngon av bitarna CSn2:0 r ettstlld) eller
+*                   om ngot av dess avbrott r aktiverat. Exempelvis delas
+*                   Timer 1 av Input Capture, BAM, servon och PWM i
+*                   hrdvara, som samtliga skulle stras om timerkretsen
+*                   stlldes om till CTC Mode fr blinkning.
+*
+*                   - timer_sel: Timerkretsen som ska kontrolleras.
+********************************************************************************/
+static bool blink_timer_busy(const enum timer_sel timer_sel)
+{
+   if (timer_sel == TIMER_SEL_0)
+   {
+      return (TCCR0B & BLINK_CLOCK_MASK) || (TIMSK0 & ((1 << OCIE0A) | (1 << OCIE0B) | (1 << TOIE0)));
+   }
+   else if (timer_sel == TIMER_SEL_1)
+   {
+      return (TCCR1B & BLINK_CLOCK_MASK) ||
+             (TIMSK1 & ((1 << ICIE1) | (1 << OCIE1A) | (1 << OCIE1B) | (1 << TOIE1)));
+   }
+   else
+   {
+      return (TCCR2B & BLINK_CLOCK_MASK) || (TIMSK2 & ((1 << OCIE2A) | (1 << OCIE2B) | (1 << TOIE2)));
+   }
+}
\ No newline at end of file
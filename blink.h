@@ -0,0 +1,108 @@
+/********************************************************************************
+* blink.h: Innehller drivrutiner fr kontinuerlig blinkning av lysdioder med
+*          fast frekvens via strukten blink.
+*
+*          Om lysdioden r ansluten till en utpinne (OCnA eller OCnB) p den
+*          timerkrets som blinkningen fr anvnda, och tiden mellan tv
+*          toggningar ryms i en timerperiod, togglas lysdioden direkt i
+*          hrdvara via timer_init_output, helt utan avbrott. Annars sker
+*          blinkningen i mjukvara via en periodisk mjukvarutimer, vilket
+*          krver en callback frn systemets tick per toggling.
+*
+*          Vilken timerkrets som fr anvndas anges av applikationen vid
+*          initieringen, eftersom endast applikationen vet vilka
+*          timerkretsar som r lediga. I detta system r Timer 0 systemets
+*          tick, Timer 1 anvnds av Input Capture (capture.h) och Timer 2 av
+*          Modbus (modbus.h) samt realtidsklockan (rtc.h). Med prescaler
+*          1024 ryms som mest 4194 ms per toggling p Timer 1 och 16 ms p
+*          Timer 2, medan Timer 0 begrnsas till cirka 1 ms.
+*
+*          Blinkning i hrdvara stller om hela timerkretsen till CTC Mode
+*          och stoppar den vid blink_stop. Den anvnds drfr endast om
+*          timerkretsen r ledig nr blink_start anropas, dvs. inte rknar
+*          och inte har ngot avbrott aktiverat. Timer 1 delas exempelvis
+*          av Input Capture (capture.h), BAM (bam.h), servon (servo.h)
+*          samt PWM i hrdvara (pwm_hw.h) via timer1_acquire; anvnds den
+*          av ngon av dessa sker blinkningen i stllet i mjukvara. Timer 0
+*          r alltid upptagen av systemets tick. Omvnt fr timerkretsen
+*          inte tas i bruk av annan kod medan blinkningen pgr i hrdvara.
+********************************************************************************/
+#ifndef BLINK_H_
+#define BLINK_H_
+
+/* Inkluderingsdirektiv: */
+#include "led.h"
+#include "timer.h"
+#include "soft_timer.h"
+
+/********************************************************************************
+* blink: Strukt fr kontinuerlig blinkning av en lysdiod, i hrdvara om
+*        mjligt och annars i mjukvara.
+********************************************************************************/
+struct blink
+{
+   struct led* led;              /* Lysdioden som ska blinka. */
+   struct timer timer;           /* Timerkrets vid blinkning i hrdvara. */
+   struct soft_timer soft_timer; /* Mjukvarutimer vid blinkning i mjukvara. */
+   enum timer_sel timer_sel;     /* Timerkrets som fr anvndas (TIMER_SEL_NONE = ingen). */
+   bool hardware;                /* Indikerar pgende blinkning i hrdvara. */
+};
+
+/********************************************************************************
+* blink_init: Initierar ny blinkning av angiven lysdiod, som startas via
+*             blink_start.
+*
+*             - self     : Pekare till blinkningen som ska initieras.
+*             - led      : Pekare till lysdioden som ska blinka.
+*             - timer_sel: Timerkretsen som fr anvndas fr blinkning i
+*                          hrdvara (TIMER_SEL_NONE = endast mjukvara).
+********************************************************************************/
+void blink_init(struct blink* self,
+                struct led* led,
+                const enum timer_sel timer_sel);
+
+/********************************************************************************
+* blink_start: Startar blinkning med angiven tid mellan tv toggningar, i
+*              hrdvara om lysdioden sitter p en utpinne till tillten
+*              timerkrets, timerkretsen r ledig och tiden ryms i en
+*              timerperiod, annars i mjukvara. En pgende blinkning
+*              startas om.
+*              Returnerar 0 om blinkningen startades, annars 1 (maximalt
+*              antal aktiva mjukvarutimers har uppntts).
+*
+*              - self     : Pekare till blinkningen som ska startas.
+*              - toggle_ms: Tid mellan tv toggningar i millisekunder.
+********************************************************************************/
+int blink_start(struct blink* self,
+                const uint16_t toggle_ms);
+
+/********************************************************************************
+* blink_stop: Stoppar angiven blinkning och slcker lysdioden. Vid blinkning
+*             i hrdvara nollstlls timerkretsen, varvid utpinnen tergr
+*             till att styras av lysdiodens dataregister.
+*
+*             - self: Pekare till blinkningen som ska stoppas.
+********************************************************************************/
+void blink_stop(struct blink* self);
+
+/********************************************************************************
+* blink_active: Indikerar ifall angiven blinkning pgr.
+*
+*               - self: Pekare till blinkningen.
+********************************************************************************/
+static inline bool blink_active(const struct blink* self)
+{
+   return self->hardware || soft_timer_active(&self->soft_timer);
+}
+
+/********************************************************************************
+* blink_in_hardware: Indikerar ifall angiven blinkning sker i hrdvara.
+*
+*                    - self: Pekare till blinkningen.
+********************************************************************************/
+static inline bool blink_in_hardware(const struct blink* self)
+{
+   return self->hardware;
+}
+
+#endif /* BLINK_H_ */
\ No newline at end of file
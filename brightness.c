@@ -0,0 +1,51 @@
+/********************************************************************************
+* brightness.c: Innehller funktionsdefinitioner fr omvandling av niv till
+*               duty cycle via uppslagstabeller i programminnet.
+********************************************************************************/
+#include "brightness.h"
+#include "brightness_tables.h"
+
+/********************************************************************************
+* brightness_8: Returnerar duty cycle med 8 bitars upplsning, dr nivn
+*               returneras direkt vid linjr kurva.
+*
+*               - curve: Kurvan.
+*               - level: Nivn (0 - 255).
+********************************************************************************/
+uint8_t brightness_8(const enum brightness_curve curve,
+                     const uint8_t level)
+{
+   if (curve == BRIGHTNESS_CURVE_GAMMA) return pgm_read_byte(&brightness_gamma_8[level]);
+   if (curve == BRIGHTNESS_CURVE_CIE) return pgm_read_byte(&brightness_cie_8[level]);
+   return level;
+}
+
+/********************************************************************************
+* brightness_10: Returnerar duty cycle med 10 bitars upplsning, dr nivn
+*                skalas till 0 - 1023 vid linjr kurva.
+*
+*                - curve: Kurvan.
+*                - level: Nivn (0 - 255).
+********************************************************************************/
+uint16_t brightness_10(const enum brightness_curve curve,
+                       const uint8_t level)
+{
+   if (curve == BRIGHTNESS_CURVE_GAMMA) return pgm_read_word(&brightness_gamma_10[level]);
+   if (curve == BRIGHTNESS_CURVE_CIE) return pgm_read_word(&brightness_cie_10[level]);
+   return (uint16_t)(((uint32_t)level * 1023 + 127) / 255);
+}
+
+/********************************************************************************
+* brightness_16: Returnerar duty cycle med 16 bitars upplsning, dr nivn
+*                skalas till 0 - 65 535 vid linjr kurva (niv * 257).
+*
+*                - curve: Kurvan.
+*                - level: Nivn (0 - 255).
+********************************************************************************/
+uint16_t brightness_16(const enum brightness_curve curve,
+                       const uint8_t level)
+{
+   if (curve == BRIGHTNESS_CURVE_GAMMA) return pgm_read_word(&brightness_gamma_16[level]);
+   if (curve == BRIGHTNESS_CURVE_CIE) return pgm_read_word(&brightness_cie_16[level]);
+   return (uint16_t)level * 257;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+/********************************************************************************
+* brightness.h: Innehller funktioner fr omvandling av en linjr niv, ssom
+*               en potentiometers lge, till duty cycle enligt en kurva som
+*               motsvarar gats uppfattning av ljusstyrka.
+*
+*               gat uppfattar ljusstyrka ungefr logaritmiskt, drmed ger en
+*               linjr duty cycle stora skillnader i ljusstyrka vid lga
+*               niver och nstan ingen skillnad vid hga niver. Fljande
+*               kurvor kan vljas:
+*
+*               - Linjr: Duty cycle r proportionell mot nivn.
+*               - Gamma: Duty cycle = (niv / 255)^2.2.
+*               - CIE: Duty cycle enligt CIE 1976 L*, dr lika steg i niv
+*                      ger lika steg i upplevd ljushet.
+*
+*               Kurvorna lagras som uppslagstabeller i programminnet med 256
+*               niver fr 8-, 10- samt 16-bitars utsignal, drmed krvs
+*               endast en tabellsning per omvandling. Tabellerna genereras
+*               av tools/brightness_tables.py och lagras i
+*               brightness_tables.h.
+********************************************************************************/
+#ifndef BRIGHTNESS_H_
+#define BRIGHTNESS_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+
+/* Makrodefinitioner: */
+#define BRIGHTNESS_LEVELS 256 /* Antal niver per tabell (8-bitars niv). */
+
+/********************************************************************************
+* brightness_curve: Enumeration fr val av kurva.
+********************************************************************************/
+enum brightness_curve
+{
+   BRIGHTNESS_CURVE_LINEAR, /* Linjr (ingen korrigering). */
+   BRIGHTNESS_CURVE_GAMMA,  /* Gammakorrigering. */
+   BRIGHTNESS_CURVE_CIE     /* CIE 1976 L*. */
+};
+
+/********************************************************************************
+* brightness_8: Returnerar duty cycle med 8 bitars upplsning (0 - 255) fr
+*               angiven niv enligt angiven kurva.
+*
+*               - curve: Kurvan.
+*               - level: Nivn (0 - 255).
+********************************************************************************/
+uint8_t brightness_8(const enum brightness_curve curve,
+                     const uint8_t level);
+
+/********************************************************************************
+* brightness_10: Returnerar duty cycle med 10 bitars upplsning (0 - 1023)
+*                fr angiven niv enligt angiven kurva.
+*
+*                - curve: Kurvan.
+*                - level: Nivn (0 - 255).
+********************************************************************************/
+uint16_t brightness_10(const enum brightness_curve curve,
+                       const uint8_t level);
+
+/********************************************************************************
+* brightness_16: Returnerar duty cycle med 16 bitars upplsning (0 - 65 535)
+*                fr angiven niv enligt angiven kurva.
+*
+*                - curve: Kurvan.
+*                - level: Nivn (0 - 255).
+********************************************************************************/
+uint16_t brightness_16(const enum brightness_curve curve,
+                       const uint8_t level);
+
+#endif /* BRIGHTNESS_H_ */
\ No newline at end of file
@@ -0,0 +1,181 @@
+/********************************************************************************
+* brightness_tables.h: Uppslagstabeller fr ljusstyrka, genererade av
+*                      tools/brightness_tables.py (gamma = 2.20).
+*                      Redigera inte denna fil manuellt, utan generera
+*                      den p nytt via skriptet. Inkluderas endast av
+*                      brightness.c.
+********************************************************************************/
+#ifndef BRIGHTNESS_TABLES_H_
+#define BRIGHTNESS_TABLES_H_
+
+/* Gammakorrigering, 8 bitar (0 - 255): */
+static const uint8_t brightness_gamma_8[BRIGHTNESS_LEVELS] PROGMEM =
+{
+     0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+     1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+     3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+     6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+    12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+    20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+    30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+    42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+    56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+    73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+    91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+   113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+   137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+   163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+   192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+   223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255
+};
+
+/* Gammakorrigering, 10 bitar (0 - 1023): */
+static const uint16_t brightness_gamma_10[BRIGHTNESS_LEVELS] PROGMEM =
+{
+      0,    0,    0,    0,    0,    0,    0,    0,    1,    1,    1,    1,
+      1,    1,    2,    2,    2,    3,    3,    3,    4,    4,    5,    5,
+      6,    6,    7,    7,    8,    9,    9,   10,   11,   11,   12,   13,
+     14,   15,   16,   16,   17,   18,   19,   20,   21,   23,   24,   25,
+     26,   27,   28,   30,   31,   32,   34,   35,   36,   38,   39,   41,
+     42,   44,   46,   47,   49,   51,   52,   54,   56,   58,   60,   61,
+     63,   65,   67,   69,   71,   73,   76,   78,   80,   82,   84,   87,
+     89,   91,   94,   96,   98,  101,  103,  106,  109,  111,  114,  117,
+    119,  122,  125,  128,  130,  133,  136,  139,  142,  145,  148,  151,
+    155,  158,  161,  164,  167,  171,  174,  177,  181,  184,  188,  191,
+    195,  198,  202,  206,  209,  213,  217,  221,  225,  228,  232,  236,
+    240,  244,  248,  252,  257,  261,  265,  269,  274,  278,  282,  287,
+    291,  295,  300,  304,  309,  314,  318,  323,  328,  333,  337,  342,
+    347,  352,  357,  362,  367,  372,  377,  382,  387,  393,  398,  403,
+    408,  414,  419,  425,  430,  436,  441,  447,  452,  458,  464,  470,
+    475,  481,  487,  493,  499,  505,  511,  517,  523,  529,  535,  542,
+    548,  554,  561,  567,  573,  580,  586,  593,  599,  606,  613,  619,
+    626,  633,  640,  647,  653,  660,  667,  674,  681,  689,  696,  703,
+    710,  717,  725,  732,  739,  747,  754,  762,  769,  777,  784,  792,
+    800,  807,  815,  823,  831,  839,  847,  855,  863,  871,  879,  887,
+    895,  903,  912,  920,  928,  937,  945,  954,  962,  971,  979,  988,
+    997, 1005, 1014, 1023
+};
+
+/* Gammakorrigering, 16 bitar (0 - 65535): */
+static const uint16_t brightness_gamma_16[BRIGHTNESS_LEVELS] PROGMEM =
+{
+       0,     0,     2,     4,     7,    11,    17,    24,
+      32,    42,    53,    65,    79,    94,   111,   129,
+     148,   169,   192,   216,   242,   270,   299,   330,
+     362,   396,   432,   469,   508,   549,   591,   635,
+     681,   729,   779,   830,   883,   938,   995,  1053,
+    1113,  1175,  1239,  1305,  1373,  1443,  1514,  1587,
+    1663,  1740,  1819,  1900,  1983,  2068,  2155,  2243,
+    2334,  2427,  2521,  2618,  2717,  2817,  2920,  3024,
+    3131,  3240,  3350,  3463,  3578,  3694,  3813,  3934,
+    4057,  4182,  4309,  4438,  4570,  4703,  4838,  4976,
+    5115,  5257,  5401,  5547,  5695,  5845,  5998,  6152,
+    6309,  6468,  6629,  6792,  6957,  7124,  7294,  7466,
+    7640,  7816,  7994,  8175,  8358,  8543,  8730,  8919,
+    9111,  9305,  9501,  9699,  9900, 10102, 10307, 10515,
+   10724, 10936, 11150, 11366, 11585, 11806, 12029, 12254,
+   12482, 12712, 12944, 13179, 13416, 13655, 13896, 14140,
+   14386, 14635, 14885, 15138, 15394, 15652, 15912, 16174,
+   16439, 16706, 16975, 17247, 17521, 17798, 18077, 18358,
+   18642, 18928, 19216, 19507, 19800, 20095, 20393, 20694,
+   20996, 21301, 21609, 21919, 22231, 22546, 22863, 23182,
+   23504, 23829, 24156, 24485, 24817, 25151, 25487, 25826,
+   26168, 26512, 26858, 27207, 27558, 27912, 28268, 28627,
+   28988, 29351, 29717, 30086, 30457, 30830, 31206, 31585,
+   31966, 32349, 32735, 33124, 33514, 33908, 34304, 34702,
+   35103, 35507, 35913, 36321, 36732, 37146, 37562, 37981,
+   38402, 38825, 39252, 39680, 40112, 40546, 40982, 41421,
+   41862, 42306, 42753, 43202, 43654, 44108, 44565, 45025,
+   45487, 45951, 46418, 46888, 47360, 47835, 48313, 48793,
+   49275, 49761, 50249, 50739, 51232, 51728, 52226, 52727,
+   53230, 53736, 54245, 54756, 55270, 55787, 56306, 56828,
+   57352, 57879, 58409, 58941, 59476, 60014, 60554, 61097,
+   61642, 62190, 62741, 63295, 63851, 64410, 64971, 65535
+};
+
+/* CIE 1976 L*, 8 bitar (0 - 255): */
+static const uint8_t brightness_cie_8[BRIGHTNESS_LEVELS] PROGMEM =
+{
+     0,   0,   0,   0,   0,   1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,
+     2,   2,   2,   2,   2,   2,   2,   3,   3,   3,   3,   3,   3,   3,   3,   4,
+     4,   4,   4,   4,   4,   5,   5,   5,   5,   5,   6,   6,   6,   6,   6,   7,
+     7,   7,   7,   8,   8,   8,   8,   9,   9,   9,  10,  10,  10,  10,  11,  11,
+    11,  12,  12,  12,  13,  13,  13,  14,  14,  15,  15,  15,  16,  16,  17,  17,
+    17,  18,  18,  19,  19,  20,  20,  21,  21,  22,  22,  23,  23,  24,  24,  25,
+    25,  26,  26,  27,  28,  28,  29,  29,  30,  31,  31,  32,  32,  33,  34,  34,
+    35,  36,  37,  37,  38,  39,  39,  40,  41,  42,  43,  43,  44,  45,  46,  47,
+    47,  48,  49,  50,  51,  52,  53,  54,  54,  55,  56,  57,  58,  59,  60,  61,
+    62,  63,  64,  65,  66,  67,  68,  70,  71,  72,  73,  74,  75,  76,  77,  79,
+    80,  81,  82,  83,  85,  86,  87,  88,  90,  91,  92,  94,  95,  96,  98,  99,
+   100, 102, 103, 105, 106, 108, 109, 110, 112, 113, 115, 116, 118, 120, 121, 123,
+   124, 126, 128, 129, 131, 132, 134, 136, 138, 139, 141, 143, 145, 146, 148, 150,
+   152, 154, 155, 157, 159, 161, 163, 165, 167, 169, 171, 173, 175, 177, 179, 181,
+   183, 185, 187, 189, 191, 193, 196, 198, 200, 202, 204, 207, 209, 211, 214, 216,
+   218, 220, 223, 225, 228, 230, 232, 235, 237, 240, 242, 245, 247, 250, 252, 255
+};
+
+/* CIE 1976 L*, 10 bitar (0 - 1023): */
+static const uint16_t brightness_cie_10[BRIGHTNESS_LEVELS] PROGMEM =
+{
+      0,    0,    1,    1,    2,    2,    3,    3,    4,    4,    4,    5,
+      5,    6,    6,    7,    7,    8,    8,    8,    9,    9,   10,   10,
+     11,   11,   12,   12,   13,   13,   14,   15,   15,   16,   17,   17,
+     18,   19,   19,   20,   21,   22,   22,   23,   24,   25,   26,   27,
+     28,   29,   30,   31,   32,   33,   34,   35,   36,   37,   38,   39,
+     40,   42,   43,   44,   45,   47,   48,   50,   51,   52,   54,   55,
+     57,   58,   60,   61,   63,   65,   66,   68,   70,   71,   73,   75,
+     77,   79,   81,   83,   84,   86,   88,   90,   93,   95,   97,   99,
+    101,  103,  106,  108,  110,  113,  115,  118,  120,  123,  125,  128,
+    130,  133,  136,  138,  141,  144,  147,  149,  152,  155,  158,  161,
+    164,  167,  171,  174,  177,  180,  183,  187,  190,  194,  197,  200,
+    204,  208,  211,  215,  218,  222,  226,  230,  234,  237,  241,  245,
+    249,  254,  258,  262,  266,  270,  275,  279,  283,  288,  292,  297,
+    301,  306,  311,  315,  320,  325,  330,  335,  340,  345,  350,  355,
+    360,  365,  370,  376,  381,  386,  392,  397,  403,  408,  414,  420,
+    425,  431,  437,  443,  449,  455,  461,  467,  473,  480,  486,  492,
+    499,  505,  512,  518,  525,  532,  538,  545,  552,  559,  566,  573,
+    580,  587,  594,  601,  609,  616,  624,  631,  639,  646,  654,  662,
+    669,  677,  685,  693,  701,  709,  717,  726,  734,  742,  751,  759,
+    768,  776,  785,  794,  802,  811,  820,  829,  838,  847,  857,  866,
+    875,  885,  894,  903,  913,  923,  932,  942,  952,  962,  972,  982,
+    992, 1002, 1013, 1023
+};
+
+/* CIE 1976 L*, 16 bitar (0 - 65535): */
+static const uint16_t brightness_cie_16[BRIGHTNESS_LEVELS] PROGMEM =
+{
+       0,    28,    57,    85,   114,   142,   171,   199,
+     228,   256,   285,   313,   341,   370,   398,   427,
+     455,   484,   512,   541,   569,   598,   627,   658,
+     689,   721,   755,   789,   825,   861,   899,   937,
+     977,  1018,  1060,  1103,  1147,  1192,  1239,  1287,
+    1336,  1386,  1437,  1490,  1544,  1599,  1656,  1714,
+    1773,  1834,  1896,  1959,  2024,  2090,  2157,  2226,
+    2297,  2369,  2442,  2517,  2593,  2671,  2751,  2832,
+    2914,  2999,  3085,  3172,  3261,  3352,  3444,  3538,
+    3634,  3732,  3831,  3932,  4035,  4139,  4245,  4354,
+    4464,  4575,  4689,  4804,  4922,  5041,  5162,  5285,
+    5410,  5537,  5666,  5797,  5930,  6065,  6202,  6341,
+    6482,  6626,  6771,  6918,  7068,  7220,  7373,  7529,
+    7687,  7848,  8010,  8175,  8342,  8512,  8683,  8857,
+    9033,  9212,  9393,  9576,  9762,  9949, 10140, 10333,
+   10528, 10725, 10926, 11128, 11333, 11541, 11751, 11963,
+   12179, 12396, 12617, 12840, 13065, 13293, 13524, 13757,
+   13993, 14232, 14474, 14718, 14965, 15215, 15467, 15722,
+   15980, 16241, 16505, 16771, 17041, 17313, 17588, 17866,
+   18147, 18431, 18717, 19007, 19300, 19596, 19894, 20196,
+   20501, 20809, 21119, 21433, 21750, 22071, 22394, 22720,
+   23050, 23383, 23719, 24058, 24400, 24746, 25095, 25447,
+   25802, 26161, 26523, 26888, 27257, 27629, 28004, 28383,
+   28765, 29151, 29540, 29932, 30328, 30728, 31131, 31537,
+   31947, 32360, 32777, 33198, 33622, 34050, 34481, 34916,
+   35355, 35797, 36243, 36693, 37146, 37603, 38064, 38529,
+   38997, 39469, 39945, 40425, 40908, 41396, 41887, 42382,
+   42881, 43384, 43891, 44401, 44916, 45435, 45957, 46484,
+   47015, 47549, 48088, 48631, 49178, 49728, 50283, 50843,
+   51406, 51973, 52545, 53120, 53700, 54284, 54873, 55465,
+   56062, 56663, 57269, 57878, 58492, 59111, 59733, 60360,
+   60992, 61627, 62268, 62912, 63561, 64215, 64873, 65535
+};
+
+#endif /* BRIGHTNESS_TABLES_H_ */
\ No newline at end of file
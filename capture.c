@@ -0,0 +1,250 @@
+/********************************************************************************
+* capture.c: Innehller funktionsdefinitioner fr Input Capture p Timer 1.
+********************************************************************************/
+#include "capture.h"
+
+/* Makrodefinitioner: */
+#define CAPTURE_BUFFER_MASK (CAPTURE_BUFFER_SIZE - 1)
+#define CAPTURE_AIN1_PIN PORTD7 /* Komparatorns negativa ingng AIN1. */
+#define CAPTURE_ICP1_PIN PORTB0 /* Pin ICP1. */
+
+#if (CAPTURE_BUFFER_SIZE & CAPTURE_BUFFER_MASK) || CAPTURE_BUFFER_SIZE > 128
+#error "CAPTURE_BUFFER_SIZE must be a power of two no larger than 128!"
+#endif
+
+/* Statiska variabler: */
+static struct capture_event buffer[CAPTURE_BUFFER_SIZE]; /* Lagrade tidsstmplar. */
+static volatile uint8_t head = 0;                        /* Nsta position att skriva till. */
+static volatile uint8_t tail = 0;                        /* Nsta position att lsa frn. */
+static volatile uint16_t overflows = 0;                  /* Antalet overflows fr Timer 1. */
+static volatile uint16_t num_overruns = 0;               /* Antalet kastade flanker. */
+static bool both_edges = false;                          /* Indikerar att flanken ska vxla. */
+static bool inverted = false;                            /* Indikerar inverterad signal (komparatorn). */
+static uint16_t capture_prescaler = 0;                   /* Aktuell prescaler fr Timer 1. */
+
+/* Statiska funktioner: */
+static uint8_t capture_clock_select(const uint16_t prescaler);
+
+/********************************************************************************
+* ISR (TIMER1_CAPT_vect): Avbrottsrutin som ger rum nr en flank har
+*                         tidsstmplats i ICR1. Om Timer 1 har slagit runt
+*                         utan att overflow-avbrottet har exekverats och
+*                         ICR1 ligger i frsta halvan av varvet skedde
+*                         flanken efter overflow, varvid den rknas med.
+*                         Vid mtning av bda flankerna byts vald flank,
+*                         varefter flaggan ICF1 mste nollstllas.
+********************************************************************************/
+ISR (TIMER1_CAPT_vect)
+{
+   const uint16_t icr = ICR1;
+   uint16_t high = overflows;
+   const bool rising = (TCCR1B & (1 << ICES1)) != 0;
+
+   if ((TIFR1 & (1 << TOV1)) && icr < 0x8000)
+   {
+      high++;
+   }
+
+   if (both_edges)
+   {
+      TCCR1B ^= (1 << ICES1);
+      TIFR1 = (1 << ICF1);
+   }
+
+   if ((uint8_t)(head - tail) >= CAPTURE_BUFFER_SIZE)
+   {
+      num_overruns++;
+      return;
+   }
+
+   struct capture_event* event = &buffer[head & CAPTURE_BUFFER_MASK];
+   event->time = ((uint32_t)high << 16) | icr;
+   event->rising = rising != inverted;
+   head++;
+   return;
+}
+
+/********************************************************************************
+* ISR (TIMER1_OVF_vect): Avbrottsrutin som ger rum nr Timer 1 slr runt,
+*                        varvid antalet overflows rknas upp.
+********************************************************************************/
+ISR (TIMER1_OVF_vect)
+{
+   overflows++;
+   return;
+}
+
+/********************************************************************************
+* capture_init: Startar Timer 1 i Normal Mode med angiven prescaler och
+*               aktiverar Input Capture fr angiven signal och flank.
+*
+*               Den analoga komparatorns utsignal r hg nr den interna
+*               referensen (AIN0) verstiger signalen p AIN1, allts
+*               inverterad mot signalen. Vald flank inverteras drfr fr
+*               komparatorn, s att stigande flank alltid avser signalen.
+*
+*               - source        : Signalen som triggar Input Capture.
+*               - edge          : Flanken som ska tidsstmplas.
+*               - prescaler     : Prescaler fr Timer 1 (1, 8, 64, 256 eller
+*                                 1024).
+*               - noise_canceler: Aktiverar brusfiltret.
+********************************************************************************/
+int capture_init(const enum capture_source source,
+                 const enum capture_edge edge,
+                 const uint16_t prescaler,
+                 const bool noise_canceler)
+{
+   const uint8_t clock = capture_clock_select(prescaler);
+   if (!clock) return 1;
+
+   capture_disable();
+   if (timer1_acquire(clock)) return 1;
+   inverted = source == CAPTURE_SOURCE_COMPARATOR;
+   both_edges = edge == CAPTURE_EDGE_BOTH;
+   capture_prescaler = prescaler;
+
+   if (source == CAPTURE_SOURCE_COMPARATOR)
+   {
+      DDRD &= ~(1 << CAPTURE_AIN1_PIN);
+      PORTD &= ~(1 << CAPTURE_AIN1_PIN);
+      DIDR1 |= (1 << AIN1D);
+      ACSR = (1 << ACBG) | (1 << ACIC);
+   }
+   else
+   {
+      DDRB &= ~(1 << CAPTURE_ICP1_PIN);
+      ACSR &= ~(1 << ACIC);
+   }
+
+   const uint8_t sreg = SREG;
+   asm("CLI");
+
+   head = 0;
+   tail = 0;
+   overflows = 0;
+   num_overruns = 0;
+
+   TCCR1B = (TCCR1B & ~((1 << ICNC1) | (1 << ICES1))) |
+            (noise_canceler ? (1 << ICNC1) : 0) |
+            ((edge == CAPTURE_EDGE_FALLING) == inverted ? (1 << ICES1) : 0);
+   TIFR1 = (1 << ICF1) | (1 << TOV1);
+   TIMSK1 |= (1 << ICIE1) | (1 << TOIE1);
+
+   SREG = sreg;
+   return 0;
+}
+
+/********************************************************************************
+* capture_disable: Inaktiverar Input Capture och stnger av Timer 1, om inget
+*                  annat avbrott r aktiverat fr den.
+********************************************************************************/
+void capture_disable(void)
+{
+   TIMSK1 &= ~((1 << ICIE1) | (1 << TOIE1));
+   TCCR1B &= ~((1 << ICNC1) | (1 << ICES1));
+   timer1_release();
+   ACSR &= ~(1 << ACIC);
+   return;
+}
+
+/********************************************************************************
+* capture_read: Lser ldsta lagrade tidsstmpeln ur ringbufferten.
+*               Tidsstmpeln kopieras innan lspositionen flyttas fram, s
+*               att avbrottsrutinen inte kan skriva ver den under tiden.
+*
+*               - event: Pekare till strukten dr tidsstmpeln lagras.
+********************************************************************************/
+bool capture_read(struct capture_event* event)
+{
+   const uint8_t position = tail;
+   if (position == head) return false;
+
+   *event = buffer[position & CAPTURE_BUFFER_MASK];
+   tail = position + 1;
+   return true;
+}
+
+/********************************************************************************
+* capture_available: Returnerar antalet lagrade tidsstmplar.
+********************************************************************************/
+uint8_t capture_available(void)
+{
+   return (uint8_t)(head - tail);
+}
+
+/********************************************************************************
+* capture_discard: Kastar samtliga lagrade tidsstmplar.
+********************************************************************************/
+void capture_discard(void)
+{
+   tail = head;
+   return;
+}
+
+/********************************************************************************
+* capture_overruns: Returnerar antalet flanker som har kastats p grund av
+*                   full ringbuffert och nollstller sedan rknaren.
+********************************************************************************/
+uint16_t capture_overruns(void)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   const uint16_t count = num_overruns;
+   num_overruns = 0;
+   SREG = sreg;
+   return count;
+}
+
+/********************************************************************************
+* capture_now: Returnerar aktuellt vrde p Timer 1 utkat till 32 bitar.
+*              Rknarregistret lses fre flaggan TOV1. Om flaggan r satt
+*              har Timer 1 slagit runt utan att overflow-avbrottet har
+*              exekverats, varvid rknarregistret lses om.
+********************************************************************************/
+uint32_t capture_now(void)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+
+   uint16_t high = overflows;
+   uint16_t low = TCNT1;
+
+   if (TIFR1 & (1 << TOV1))
+   {
+      low = TCNT1;
+      high++;
+   }
+
+   SREG = sreg;
+   return ((uint32_t)high << 16) | low;
+}
+
+/********************************************************************************
+* capture_ticks_to_us: Omvandlar angivet antal timersteg till mikrosekunder
+*                      utifrn aktuell prescaler.
+*
+*                      - ticks: Antalet timersteg.
+********************************************************************************/
+double capture_ticks_to_us(const uint32_t ticks)
+{
+   return (double)ticks * capture_prescaler / (F_CPU / 1000000.0);
+}
+
+/********************************************************************************
+* capture_clock_select: Returnerar vrdet p bitarna CS12 - CS10 fr angiven
+*                       prescaler, eller 0 om prescalern r ogiltig.
+*
+*                       - prescaler: Prescaler fr Timer 1.
+********************************************************************************/
+static uint8_t capture_clock_select(const uint16_t prescaler)
+{
+   switch (prescaler)
+   {
+      case 1:    return (1 << CS10);
+      case 8:    return (1 << CS11);
+      case 64:   return (1 << CS11) | (1 << CS10);
+      case 256:  return (1 << CS12);
+      case 1024: return (1 << CS12) | (1 << CS10);
+      default:   return 0;
+   }
+}
\ No newline at end of file
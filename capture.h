@@ -0,0 +1,154 @@
+/********************************************************************************
+* capture.h: Innehller drivrutiner fr Input Capture p Timer 1, vilket
+*            mjliggr mtning av frekvens, periodtid och pulsbredd hos
+*            externa signaler, exempelvis frn flktar, fldesmtare eller
+*            PWM-signaler frn andra kretskort.
+*
+*            Vid varje flank kopierar hrdvaran Timer 1:s rknarvrde till
+*            registret ICR1, drmed r tidsstmpeln exakt p en klockcykel
+*            nr (plus fyra cykler med brusfiltret aktiverat) oavsett hur
+*            lnge avbrottsrutinen frdrjs. Avbrottsrutinen utkar
+*            tidsstmpeln till 32 bitar via antalet overflows fr Timer 1
+*            och lagrar den i en ringbuffert, som tms av huvudprogrammet
+*            via capture_read. Tidsstmplarna rknas i timersteg, som
+*            omvandlas till mikrosekunder via capture_ticks_to_us.
+*
+*            Flanken kan triggas antingen av pin ICP1 (pin 8, PORTB0) eller
+*            av den analoga komparatorn, dr signalen ansluts till AIN1
+*            (pin 7, PORTD7) och jmfrs med den interna referensen p
+*            1.1 V. Observera att pin 8 anvnds av lysdiod l1 i detta
+*            system, drmed anvnds komparatorn som standard.
+*
+*            Vid mtning av bda flankerna byts vald flank efter varje
+*            avbrott, vilket mjliggr mtning av pulsbredd. Tv flanker som
+*            ligger nrmare varandra n avbrottsrutinens exekveringstid
+*            (cirka 5 us) kan d missas.
+*
+*            Drivrutinen anvnder Timer 1 (Normal Mode) samt avbrottsvektorer
+*            TIMER1_CAPT_vect och TIMER1_OVF_vect. Timer 1 ska drmed inte
+*            anvndas av timer.c samtidigt. Rknaren kan dremot delas med
+*            andra drivrutiner som anvnder den frirullande rknaren med
+*            samma prescaler, se timer1_acquire i timer.h.
+********************************************************************************/
+#ifndef CAPTURE_H_
+#define CAPTURE_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "timer.h"
+
+/* Makrodefinitioner: */
+#ifndef CAPTURE_BUFFER_SIZE
+#define CAPTURE_BUFFER_SIZE 16 /* Antal tidsstmplar i ringbufferten (tvpotens, max 128). */
+#endif
+
+/********************************************************************************
+* capture_source: Enumeration fr val av signal som triggar Input Capture.
+********************************************************************************/
+enum capture_source
+{
+   CAPTURE_SOURCE_ICP1,      /* Pin ICP1 (pin 8, PORTB0). */
+   CAPTURE_SOURCE_COMPARATOR /* Analog komparator, AIN1 (pin 7, PORTD7) mot 1.1 V. */
+};
+
+/********************************************************************************
+* capture_edge: Enumeration fr val av flank som ska tidsstmplas.
+********************************************************************************/
+enum capture_edge
+{
+   CAPTURE_EDGE_FALLING, /* Fallande flank. */
+   CAPTURE_EDGE_RISING,  /* Stigande flank. */
+   CAPTURE_EDGE_BOTH     /* Bda flankerna (fr mtning av pulsbredd). */
+};
+
+/********************************************************************************
+* capture_event: Strukt fr lagring av en tidsstmplad flank.
+********************************************************************************/
+struct capture_event
+{
+   uint32_t time; /* Tidsstmpel i timersteg. */
+   bool rising;   /* Indikerar stigande flank (annars fallande). */
+};
+
+/********************************************************************************
+* capture_init: Startar Timer 1 i Normal Mode med angiven prescaler och
+*               aktiverar Input Capture fr angiven signal och flank.
+*               Ringbufferten tms och tidsstmplarna rknas frn noll, eller
+*               frn rknarens aktuella vrde om Timer 1 redan delas med en
+*               annan drivrutin. Returnerar 0 vid lyckad initiering, annars
+*               1 (ogiltig prescaler, eller Timer 1 anvnds i en annan mod
+*               eller med en annan prescaler).
+*
+*               - source        : Signalen som triggar Input Capture.
+*               - edge          : Flanken som ska tidsstmplas.
+*               - prescaler     : Prescaler fr Timer 1 (1, 8, 64, 256 eller
+*                                 1024), dr varje timersteg motsvarar
+*                                 prescaler / 16 us.
+*               - noise_canceler: Aktiverar brusfiltret, som krver fyra
+*                                 lika samplingar innan en flank godknns.
+********************************************************************************/
+int capture_init(const enum capture_source source,
+                 const enum capture_edge edge,
+                 const uint16_t prescaler,
+                 const bool noise_canceler);
+
+/********************************************************************************
+* capture_disable: Inaktiverar Input Capture och stnger av Timer 1, om den
+*                  inte delas med en annan drivrutin. Lagrade tidsstmplar
+*                  finns kvar tills de lses.
+********************************************************************************/
+void capture_disable(void);
+
+/********************************************************************************
+* capture_read: Lser ldsta lagrade tidsstmpeln ur ringbufferten.
+*               Returnerar true om en tidsstmpel lstes, annars false.
+*
+*               - event: Pekare till strukten dr tidsstmpeln lagras.
+********************************************************************************/
+bool capture_read(struct capture_event* event);
+
+/********************************************************************************
+* capture_available: Returnerar antalet lagrade tidsstmplar.
+********************************************************************************/
+uint8_t capture_available(void);
+
+/********************************************************************************
+* capture_discard: Kastar samtliga lagrade tidsstmplar.
+********************************************************************************/
+void capture_discard(void);
+
+/********************************************************************************
+* capture_overruns: Returnerar antalet flanker som har kastats p grund av
+*                   full ringbuffert och nollstller sedan rknaren.
+********************************************************************************/
+uint16_t capture_overruns(void);
+
+/********************************************************************************
+* capture_now: Returnerar aktuellt vrde p Timer 1 utkat till 32 bitar,
+*              exempelvis fr att detektera att en signal har upphrt.
+********************************************************************************/
+uint32_t capture_now(void);
+
+/********************************************************************************
+* capture_ticks_to_us: Omvandlar angivet antal timersteg till mikrosekunder
+*                      utifrn aktuell prescaler.
+*
+*                      - ticks: Antalet timersteg.
+********************************************************************************/
+double capture_ticks_to_us(const uint32_t ticks);
+
+/********************************************************************************
+* capture_elapsed: Returnerar antalet timersteg mellan tv tidsstmplar,
+*                  exempelvis periodtiden mellan tv stigande flanker eller
+*                  pulsbredden mellan en stigande och en fallande flank.
+*
+*                  - first : Pekare till den tidigare tidsstmpeln.
+*                  - second: Pekare till den senare tidsstmpeln.
+********************************************************************************/
+static inline uint32_t capture_elapsed(const struct capture_event* first,
+                                       const struct capture_event* second)
+{
+   return second->time - first->time;
+}
+
+#endif /* CAPTURE_H_ */
\ No newline at end of file
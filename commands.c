@@ -0,0 +1,968 @@
+/********************************************************************************
+* commands.c: Innehller kommandotabellen fr kommandotolken shell1, vilket
+*             mjliggr justering av systemet via seriell terminal utan
+*             omprogrammering. Fljande kommandon finns:
+*
+*             pwm [period_us|curve|mode] Skriver ut eller stter
+*                                    periodtiden, ljusstyrkekurvan (linear,
+*                                    gamma eller cie) eller moden (sync
+*                                    eller stagger) fr PWM-kontroller pwm1.
+*             adc <channel>          Lser av angiven analog pin (0 - 5).
+*             eeprom <address> [n]   Skriver ut n byte frn EEPROM-minnet
+*                                    med start p angiven adress.
+*             wdt [reset]            Skriver ut eller nollstller antalet
+*                                    Watchdog timeouts lagrat i EEPROM.
+*             telemetry [n]          Skickar n avlsningar av pwm1:s analoga
+*                                    insignal samt systemets rknare som
+*                                    telemetriramar, se telemetry.h.
+*             modbus <address>       Lagrar angiven slavadress i EEPROM och
+*                                    vergr till Modbus RTU, se
+*                                    modbus_map.c.
+*             uart2 [text]           Skickar text via mjukvaru-UART:en och
+*                                    skriver ut mottagna tecken, se
+*                                    soft_serial.h.
+*             timer                  Skriver ut vald prescaler, uppndd tid
+*                                    samt avvikelse fr timer t0, systemtiden
+*                                    samt antalet aktiva mjukvarutimers.
+*             capture [source] [edge] Startar Input Capture p Timer 1
+*                                    (icp eller comp, rising, falling eller
+*                                    both), stoppar den (stop) eller skriver
+*                                    ut uppmtta flanker, se capture.h.
+*             tasks [reset]          Skriver ut eller nollstller
+*                                    exekveringsstatistiken fr
+*                                    schemalggarens tasks.
+*             rtc [set|sleep] ...    Skriver ut eller stller
+*                                    realtidsklockans datum och klockslag
+*                                    (set YYYY-MM-DD hh:mm:ss), eller sover
+*                                    i angivet antal sekunder (sleep n), se
+*                                    rtc.h.
+*             leds [n duty | stop]   Skriver ut eller stter ljusstyrkan
+*                                    (0 - 255) fr lysdiod n i v1 via BAM,
+*                                    varvid PWM-kontroller pwm1 inaktiveras,
+*                                    eller tergr till pwm1 (stop), se
+*                                    bam.h.
+*             servo [start|stop|n] ... Startar servopulser p upp till fyra
+*                                    pinnar 2 - 19 (start <pin> ...), dr
+*                                    pin 0 och 1 tillhr USART:en, stoppar
+*                                    dem (stop), stter brvrde fr servo
+*                                    n i mikrosekunder (n <us> [deg/s])
+*                                    eller grader (n angle <deg> [deg/s])
+*                                    med valfri maximal hastighet, eller
+*                                    skriver ut samtliga servon, se servo.h.
+********************************************************************************/
+#include "header.h"
+
+/* Makrodefinitioner: */
+#define EEPROM_DUMP_MAX 256           /* Maximalt antal byte per EEPROM-utskrift. */
+#define EEPROM_DUMP_BYTES_PER_LINE 16 /* Antal byte per rad vid EEPROM-utskrift. */
+#define TELEMETRY_SAMPLES_MAX 32      /* Maximalt antal avlsningar per telemetriram. */
+#define CAPTURE_PRESCALER 8           /* Prescaler fr Input Capture (0.5 us upplsning). */
+
+/********************************************************************************
+* telemetry_counter: Enumeration fr ID:n hos rknare som skickas via
+*                    kommandot telemetry.
+********************************************************************************/
+enum telemetry_counter
+{
+   TELEMETRY_COUNTER_TIMEOUTS,          /* Antalet Watchdog timeouts. */
+   TELEMETRY_COUNTER_PWM_ON_US,         /* Senaste on-tid fr pwm1 i mikrosekunder. */
+   TELEMETRY_COUNTER_PWM_PERIOD_US,     /* Periodtid fr pwm1 i mikrosekunder. */
+   TELEMETRY_COUNTER_LOG_DROPPED,       /* Antalet kastade loggposter. */
+   TELEMETRY_COUNTER_TELEMETRY_DROPPED, /* Antalet kastade telemetriramar. */
+   TELEMETRY_NUM_COUNTERS               /* Antalet rknare. */
+};
+
+/* Statiska funktioner: */
+static void command_pwm(uint8_t argc, char** argv);
+static void command_adc(uint8_t argc, char** argv);
+static void command_eeprom(uint8_t argc, char** argv);
+static void command_wdt(uint8_t argc, char** argv);
+static void command_telemetry(uint8_t argc, char** argv);
+static void command_modbus(uint8_t argc, char** argv);
+static void command_uart2(uint8_t argc, char** argv);
+static void command_timer(uint8_t argc, char** argv);
+static void command_print_timer(PGM_P name,
+                                const struct timer* self);
+static void command_capture(uint8_t argc, char** argv);
+static void command_tasks(uint8_t argc, char** argv);
+static void command_rtc(uint8_t argc, char** argv);
+static void command_print_time(const struct rtc_time* time);
+static void command_leds(uint8_t argc, char** argv);
+static void command_servo(uint8_t argc, char** argv);
+static bool command_parse_fields(const char* s,
+                                 const char separator,
+                                 uint16_t* fields,
+                                 const uint8_t num_fields);
+
+/* Kommandonamn och hjlptexter (lagras i programminnet): */
+static const char pwm_name[] PROGMEM = "pwm";
+static const char pwm_help[] PROGMEM = "pwm [period_us | linear | gamma | cie | sync | stagger] - read or set the PWM period, brightness curve or phase mode";
+static const char adc_name[] PROGMEM = "adc";
+static const char adc_help[] PROGMEM = "adc <channel> - read analog pin 0 - 5";
+static const char eeprom_name[] PROGMEM = "eeprom";
+static const char eeprom_help[] PROGMEM = "eeprom <address> [n] - dump n bytes of EEPROM";
+static const char wdt_name[] PROGMEM = "wdt";
+static const char wdt_help[] PROGMEM = "wdt [reset] - read or reset the timeout counter";
+static const char telemetry_name[] PROGMEM = "telemetry";
+static const char telemetry_help[] PROGMEM = "telemetry [n] - send n ADC samples and counters as frames";
+static const char modbus_name[] PROGMEM = "modbus";
+static const char modbus_help[] PROGMEM = "modbus <address> - switch to Modbus RTU slave 1 - 247";
+static const char uart2_name[] PROGMEM = "uart2";
+static const char uart2_help[] PROGMEM = "uart2 [text] - send text on the software UART and print received bytes";
+static const char timer_name[] PROGMEM = "timer";
+static const char timer_help[] PROGMEM = "timer - print the system tick of t0, the uptime and the number of active soft timers";
+static const char capture_name[] PROGMEM = "capture";
+static const char capture_help[] PROGMEM = "capture [icp|comp|stop] [rising|falling|both] - start, stop or print input capture";
+static const char tasks_name[] PROGMEM = "tasks";
+static const char tasks_help[] PROGMEM = "tasks [reset] - print or reset run time and overruns per task";
+static const char rtc_name[] PROGMEM = "rtc";
+static const char rtc_help[] PROGMEM = "rtc [set YYYY-MM-DD hh:mm:ss | sleep <s>] - print or set the real-time clock, or sleep (blocks all tasks, system time and soft timers stop)";
+static const char leds_name[] PROGMEM = "leds";
+static const char leds_help[] PROGMEM = "leds [<n> <duty 0 - 255> | stop] - print or set per-LED brightness, or return to pwm";
+static const char servo_name[] PROGMEM = "servo";
+static const char servo_help[] PROGMEM = "servo [start <pin 2 - 19>... | stop | <n> <us> [deg/s] | <n> angle <deg> [deg/s]] - drive servos";
+
+/* Kommandotabell: */
+const struct shell_command commands[] =
+{
+   { pwm_name, &command_pwm, pwm_help },
+   { adc_name, &command_adc, adc_help },
+   { eeprom_name, &command_eeprom, eeprom_help },
+   { wdt_name, &command_wdt, wdt_help },
+   { telemetry_name, &command_telemetry, telemetry_help },
+   { modbus_name, &command_modbus, modbus_help },
+   { uart2_name, &command_uart2, uart2_help },
+   { timer_name, &command_timer, timer_help },
+   { capture_name, &command_capture, capture_help },
+   { tasks_name, &command_tasks, tasks_help },
+   { rtc_name, &command_rtc, rtc_help },
+   { leds_name, &command_leds, leds_help },
+   { servo_name, &command_servo, servo_help }
+};
+
+const uint8_t num_commands = sizeof(commands) / sizeof(struct shell_command);
+
+/********************************************************************************
+* command_pwm: Skriver ut aktuell periodtid samt ljusstyrkekurva fr
+*              PWM-kontroller pwm1 eller, om ett argument anges, stter ny
+*              kurva (linear, gamma eller cie) eller ny periodtid mtt i
+*              mikrosekunder. ndringen gller frn nsta avlsning av
+*              insignalen. Med stagger tnds lysdioderna i v1 frskjutna
+*              ver perioden och med sync samtidigt. Vid frskjuten fas
+*              skrivs ven hgsta antalet samtidigt tnda lysdioder sedan
+*              fregende utskrift ut. Fasfrskjuten fas avvisas nr
+*              pwm1 drivs av en PWM-generator i hrdvara.
+*
+*              - argc: Antalet argument.
+*              - argv: Pekare till argumenten.
+********************************************************************************/
+static void command_pwm(uint8_t argc, char** argv)
+{
+   static const char curve_names[][7] PROGMEM = { "linear", "gamma", "cie" };
+
+   if (argc > 1)
+   {
+      for (uint8_t i = 0; i < sizeof(curve_names) / sizeof(curve_names[0]); ++i)
+      {
+         if (strcmp_P(argv[1], curve_names[i]) == 0)
+         {
+            pwm_set_curve(&pwm1, (enum brightness_curve)i);
+            argc = 1;
+            break;
+         }
+      }
+
+      if (strcmp_P(argv[1], PSTR("stagger")) == 0)
+      {
+         if (pwm_set_staggered(&pwm1, &pwm1_stagger, &v1))
+         {
+            serial_print_P("Not available with hardware PWM!\n");
+            return;
+         }
+
+         argc = 1;
+      }
+      else if (strcmp_P(argv[1], PSTR("sync")) == 0)
+      {
+         pwm_set_staggered(&pwm1, 0, 0);
+         argc = 1;
+      }
+   }
+
+   if (argc > 1)
+   {
+      uint32_t period_us;
+
+      if (!shell_parse_unsigned(argv[1], &period_us) || period_us == 0 || period_us > UINT16_MAX)
+      {
+         serial_print_P("Invalid period!\n");
+         return;
+      }
+
+      pwm1.period_us = (uint16_t)period_us;
+   }
+
+   serial_print_P("PWM period: ");
+   serial_print_unsigned(pwm1.period_us);
+   serial_print_P(" us, curve: ");
+   serial_print_string_P(curve_names[pwm1.curve]);
+
+   if (pwm1.stagger)
+   {
+      serial_print_P(", staggered, peak on: ");
+      serial_print_unsigned(pwm_stagger_peak(pwm1.stagger));
+   }
+
+   serial_print_P("\n");
+   return;
+}
+
+/********************************************************************************
+* command_adc: Lser av angiven analog pin och skriver ut resultatet frn
+*              AD-omvandlingen (0 - 1023).
+*
+*              - argc: Antalet argument.
+*              - argv: Pekare till argumenten.
+********************************************************************************/
+static void command_adc(uint8_t argc, char** argv)
+{
+   uint32_t channel;
+   struct adc input;
+
+   if (argc < 2 || !shell_parse_unsigned(argv[1], &channel) || channel > 5)
+   {
+      serial_print_P("Invalid channel!\n");
+      return;
+   }
+
+   adc_init(&input, (uint8_t)channel);
+   serial_print_P("ADC");
+   serial_print_unsigned(channel);
+   serial_print_P(": ");
+   serial_print_unsigned(adc_read(&input));
+   serial_print_new_line();
+   return;
+}
+
+/********************************************************************************
+* command_eeprom: Skriver ut angivet antal byte (default 16) frn
+*                 EEPROM-minnet med start p angiven adress, hexadecimalt
+*                 med 16 byte per rad fregnget av radens startadress.
+*
+*                 - argc: Antalet argument.
+*                 - argv: Pekare till argumenten.
+********************************************************************************/
+static void command_eeprom(uint8_t argc, char** argv)
+{
+   uint32_t address;
+   uint32_t num_bytes = EEPROM_DUMP_BYTES_PER_LINE;
+
+   if (argc < 2 || !shell_parse_unsigned(argv[1], &address) || address > EEPROM_ADDRESS_MAX)
+   {
+      serial_print_P("Invalid address!\n");
+      return;
+   }
+   else if (argc > 2 && (!shell_parse_unsigned(argv[2], &num_bytes) || num_bytes > EEPROM_DUMP_MAX))
+   {
+      serial_print_P("Invalid number of bytes!\n");
+      return;
+   }
+
+   if (address + num_bytes > EEPROM_ADDRESS_MAX + 1)
+   {
+      num_bytes = EEPROM_ADDRESS_MAX + 1 - address;
+   }
+
+   for (uint16_t i = 0; i < num_bytes; ++i)
+   {
+      if (i % EEPROM_DUMP_BYTES_PER_LINE == 0)
+      {
+         if (i) serial_print_new_line();
+         serial_print_P("0x");
+         serial_print_hex16((uint16_t)(address + i));
+         serial_print_P(":");
+      }
+
+      serial_print_char(' ');
+      serial_print_hex8(eeprom_read_byte((uint16_t)(address + i)));
+   }
+
+   serial_print_new_line();
+   return;
+}
+
+/********************************************************************************
+* command_wdt: Skriver ut antalet Watchdog timeouts lagrat p adressen
+*              TIMEOUT_ADDRESS i EEPROM-minnet. Med argumentet reset
+*              nollstlls antalet timeouts frst.
+*
+*              - argc: Antalet argument.
+*              - argv: Pekare till argumenten.
+********************************************************************************/
+static void command_wdt(uint8_t argc, char** argv)
+{
+   if (argc > 1)
+   {
+      if (strcmp_P(argv[1], PSTR("reset")) != 0)
+      {
+         serial_print_P("Invalid argument!\n");
+         return;
+      }
+
+      eeprom_write_byte(TIMEOUT_ADDRESS, 0);
+   }
+
+   serial_print_P("Number of timeouts: ");
+   serial_print_unsigned(eeprom_read_byte(TIMEOUT_ADDRESS));
+   serial_print_new_line();
+   return;
+}
+
+
+/********************************************************************************
+* command_telemetry: Lser av pwm1:s analoga insignal angivet antal gnger
+*                    (default 8) och skickar avlsningarna som en ram med
+*                    mtvrden, fljt av en ram med systemets rknare enligt
+*                    enum telemetry_counter. Ramarna avkodas med
+*                    tools/telemetry_decode.py.
+*
+*                    - argc: Antalet argument.
+*                    - argv: Pekare till argumenten.
+********************************************************************************/
+static void command_telemetry(uint8_t argc, char** argv)
+{
+   uint16_t samples[TELEMETRY_SAMPLES_MAX];
+   uint32_t counters[TELEMETRY_NUM_COUNTERS];
+   uint32_t num_samples = 8;
+
+   if (argc > 1 && (!shell_parse_unsigned(argv[1], &num_samples) || num_samples == 0 ||
+       num_samples > TELEMETRY_SAMPLES_MAX))
+   {
+      serial_print_P("Invalid number of samples!\n");
+      return;
+   }
+
+   for (uint8_t i = 0; i < num_samples; ++i)
+   {
+      samples[i] = adc_read(&pwm1.input);
+   }
+
+   counters[TELEMETRY_COUNTER_TIMEOUTS] = eeprom_read_byte(TIMEOUT_ADDRESS);
+   counters[TELEMETRY_COUNTER_PWM_ON_US] = pwm1.input.pwm_on_us;
+   counters[TELEMETRY_COUNTER_PWM_PERIOD_US] = pwm1.period_us;
+   counters[TELEMETRY_COUNTER_LOG_DROPPED] = log_dropped();
+   counters[TELEMETRY_COUNTER_TELEMETRY_DROPPED] = telemetry_dropped();
+
+   telemetry_send_samples(pwm1.input.pin, samples, (uint8_t)num_samples);
+   telemetry_send_counters(0, counters, TELEMETRY_NUM_COUNTERS);
+   return;
+}
+
+/********************************************************************************
+* command_modbus: Lagrar angiven slavadress i EEPROM-minnet och vergr till
+*                 Modbus RTU, bde direkt och efter omstart. Kommandotolken
+*                 tar drefter inte emot ngra fler kommandon. tergng till
+*                 kommandotolken sker genom att skriva 0 till slavadressens
+*                 holding register fljt av omstart, se modbus_map.c.
+*
+*                 - argc: Antalet argument.
+*                 - argv: Pekare till argumenten.
+********************************************************************************/
+static void command_modbus(uint8_t argc, char** argv)
+{
+   uint32_t address;
+
+   if (argc < 2 || !shell_parse_unsigned(argv[1], &address) || address == 0 ||
+       address > MODBUS_ADDRESS_MAX)
+   {
+      serial_print_P("Invalid address!\n");
+      return;
+   }
+
+   eeprom_write_byte(MODBUS_ADDRESS_ADDRESS, (uint8_t)address);
+   serial_print_P("Modbus RTU slave address ");
+   serial_print_unsigned(address);
+   serial_print_new_line();
+   serial_flush();
+
+   log_set_enabled(false);
+
+   if (rtc_source() == RTC_SOURCE_CRYSTAL)
+   {
+      rtc_init(RTC_SOURCE_SYSTEM);
+   }
+
+   modbus_init(&modbus1, (uint8_t)address, &modbus_map, SERIAL_BAUD_RATE);
+   return;
+}
+
+/********************************************************************************
+* command_uart2: Skickar angiven text fljd av radslut via mjukvaru-UART:en
+*                och vntar tills sista tecknet har skickats. Drefter
+*                skrivs mottagna tecken samt antalet kastade tecken ut.
+*                Med pin 3 ansluten till pin 2 skrivs drmed skickad text
+*                tillbaka, vilket kan anvndas fr att testa verfringen.
+*
+*                - argc: Antalet argument.
+*                - argv: Pekare till argumenten.
+********************************************************************************/
+static void command_uart2(uint8_t argc, char** argv)
+{
+   char c;
+
+   if (argc > 1)
+   {
+      for (uint8_t i = 1; i < argc; ++i)
+      {
+         if (i > 1) soft_serial_print_char(' ');
+         soft_serial_print_string(argv[i]);
+      }
+
+      soft_serial_print_new_line();
+      soft_serial_flush();
+   }
+
+   serial_print_P("Received: ");
+
+   while (soft_serial_read_char(&c))
+   {
+      serial_print_char(c);
+   }
+
+   serial_print_new_line();
+   serial_print_P("Errors: ");
+   serial_print_unsigned(soft_serial_rx_errors());
+   serial_print_new_line();
+   return;
+}
+
+/********************************************************************************
+* command_timer: Skriver ut vald prescaler, jmfrelsevrde, antal avbrott per
+*                period, nskad samt uppndd tid och avvikelsen mellan dessa
+*                fr timer t0, som genererar systemets tick, fljt av
+*                systemtiden samt antalet aktiva mjukvarutimers.
+*
+*                - argc: Antalet argument.
+*                - argv: Pekare till argumenten.
+********************************************************************************/
+static void command_timer(uint8_t argc, char** argv)
+{
+   command_print_timer(PSTR("t0"), &t0);
+   serial_print_P("Uptime: ");
+   serial_print_unsigned(time_ms());
+   serial_print_P(" ms\n");
+   serial_print_P("Soft timers: ");
+   serial_print_unsigned(soft_timer_num_active());
+   serial_print_char('/');
+   serial_print_unsigned(SOFT_TIMER_MAX);
+   serial_print_new_line();
+   return;
+}
+
+/********************************************************************************
+* command_print_timer: Skriver ut konfigurationen fr angiven timer p en rad,
+*                      exempelvis:
+*
+*                      t0: 1.00 ms -> 1.000 ms (0 ppm), prescaler 64,
+*                          OCR 249, 1 interrupts
+*
+*                      - name: Timerns namn (lagras i programminnet).
+*                      - self: Pekare till timern.
+********************************************************************************/
+static void command_print_timer(PGM_P name,
+                                const struct timer* self)
+{
+   serial_print_string_P(name);
+   serial_print_P(": ");
+   serial_print_double(self->time_ms);
+   serial_print_P(" ms -> ");
+   serial_print_fixed((int32_t)(timer_get_time_ms(self) * 1000.0 + 0.5), 3);
+   serial_print_P(" ms (");
+   serial_print_integer(timer_get_error_ppm(self));
+   serial_print_P(" ppm), prescaler ");
+   serial_print_unsigned(timer_get_prescaler(self));
+   serial_print_P(", OCR ");
+   serial_print_unsigned(self->top);
+   serial_print_P(", ");
+   serial_print_unsigned(self->max_count);
+   serial_print_P(" interrupts\n");
+   return;
+}
+
+/********************************************************************************
+* command_capture: Startar Input Capture fr angiven signal (icp eller comp)
+*                  och flank (rising, falling eller both, default rising)
+*                  med brusfiltret aktiverat, eller stoppar den (stop).
+*                  Utan argument skrivs samtliga uppmtta flanker ut, en per
+*                  rad, med tiden sedan fregende flank samt periodtid och
+*                  frekvens sedan fregende flank i samma riktning,
+*                  exempelvis:
+*
+*                  rising +750.00 us, period 1000.00 us (1000.00 Hz)
+*                  falling +250.00 us, period 1000.00 us (1000.00 Hz)
+*
+*                  Vid mtning av bda flankerna motsvarar tiden sedan
+*                  fregende flank drmed pulsbredden (hg respektive lg).
+*
+*                  - argc: Antalet argument.
+*                  - argv: Pekare till argumenten.
+********************************************************************************/
+static void command_capture(uint8_t argc, char** argv)
+{
+   static struct capture_event previous;
+   static uint32_t previous_edge[2];
+   static bool has_previous = false;
+   static bool has_previous_edge[2] = { false, false };
+   struct capture_event event;
+
+   if (argc > 1)
+   {
+      enum capture_source source;
+      enum capture_edge edge = CAPTURE_EDGE_RISING;
+
+      if (strcmp_P(argv[1], PSTR("stop")) == 0)
+      {
+         capture_disable();
+         return;
+      }
+      else if (strcmp_P(argv[1], PSTR("icp")) == 0)
+      {
+         source = CAPTURE_SOURCE_ICP1;
+      }
+      else if (strcmp_P(argv[1], PSTR("comp")) == 0)
+      {
+         source = CAPTURE_SOURCE_COMPARATOR;
+      }
+      else
+      {
+         serial_print_P("Invalid source!\n");
+         return;
+      }
+
+      if (argc > 2)
+      {
+         if (strcmp_P(argv[2], PSTR("falling")) == 0) edge = CAPTURE_EDGE_FALLING;
+         else if (strcmp_P(argv[2], PSTR("both")) == 0) edge = CAPTURE_EDGE_BOTH;
+         else if (strcmp_P(argv[2], PSTR("rising")) != 0)
+         {
+            serial_print_P("Invalid edge!\n");
+            return;
+         }
+      }
+
+      if (capture_init(source, edge, CAPTURE_PRESCALER, true))
+      {
+         serial_print_P("Timer 1 is busy!\n");
+         return;
+      }
+
+      has_previous = false;
+      has_previous_edge[0] = false;
+      has_previous_edge[1] = false;
+      return;
+   }
+
+   while (capture_read(&event))
+   {
+      serial_print_string_P(event.rising ? PSTR("rising") : PSTR("falling"));
+
+      if (has_previous)
+      {
+         serial_print_P(" +");
+         serial_print_double(capture_ticks_to_us(capture_elapsed(&previous, &event)));
+         serial_print_P(" us");
+      }
+
+      if (has_previous_edge[event.rising])
+      {
+         const double period_us = capture_ticks_to_us(event.time - previous_edge[event.rising]);
+         serial_print_P(", period ");
+         serial_print_double(period_us);
+         serial_print_P(" us (");
+         serial_print_double(1000000.0 / period_us);
+         serial_print_P(" Hz)");
+      }
+
+      serial_print_new_line();
+      previous = event;
+      previous_edge[event.rising] = event.time;
+      has_previous = true;
+      has_previous_edge[event.rising] = true;
+   }
+
+   serial_print_P("Overruns: ");
+   serial_print_unsigned(capture_overruns());
+   serial_print_new_line();
+   return;
+}
+
+/********************************************************************************
+* command_tasks: Skriver ut exekveringsstatistiken fr schemalggarens tasks
+*                i prioritetsordning, en task per rad, exempelvis:
+*
+*                comm: priority 1, 512 runs, avg 35 us, max 2120 us,
+*                      0 overruns
+*
+*                Med argumentet reset nollstlls statistiken i stllet.
+*
+*                - argc: Antalet argument.
+*                - argv: Pekare till argumenten.
+********************************************************************************/
+static void command_tasks(uint8_t argc, char** argv)
+{
+   if (argc > 1)
+   {
+      if (strcmp_P(argv[1], PSTR("reset")) != 0)
+      {
+         serial_print_P("Invalid argument!\n");
+         return;
+      }
+
+      for (struct task* task = scheduler_first(); task; task = task->next)
+      {
+         task_reset_stats(task);
+      }
+
+      return;
+   }
+
+   for (struct task* task = scheduler_first(); task; task = task->next)
+   {
+      serial_print_string_P(task->name);
+      serial_print_P(": priority ");
+      serial_print_unsigned(task->priority);
+      serial_print_P(", ");
+      serial_print_unsigned(task->num_runs);
+      serial_print_P(" runs, avg ");
+      serial_print_unsigned(task->num_runs ? task->total_us / task->num_runs : 0);
+      serial_print_P(" us, max ");
+      serial_print_unsigned(task->max_us);
+      serial_print_P(" us, ");
+      serial_print_unsigned(task->num_overruns);
+      serial_print_P(" overruns\n");
+   }
+
+   return;
+}
+
+/********************************************************************************
+* command_rtc: Skriver ut realtidsklockans datum, klockslag samt klla,
+*              exempelvis:
+*
+*              2026-10-17 14:05:09 (crystal)
+*
+*              Med argumenten set YYYY-MM-DD hh:mm:ss stlls klockan, medan
+*              argumenten sleep n frstter processorn i vilolge via
+*              rtc_sleep tills n sekunder har passerat. Sndbufferten tms
+*              innan processorn somnar, d USART:en stannar i Power-save
+*              Mode. Kommandotolken svarar inte under tiden.
+*
+*              Observera att vntan sker i comm_task, drmed krs ingen
+*              annan task frrn n sekunder har passerat. Med kristallen
+*              som klla stannar dessutom Timer 0 i Power-save Mode, vilket
+*              innebr att systemtiden timebase_ms samt samtliga
+*              mjukvarutimers str still under tiden och drefter ligger
+*              efter realtidsklockan med motsvarande tid.
+*
+*              - argc: Antalet argument.
+*              - argv: Pekare till argumenten.
+********************************************************************************/
+static void command_rtc(uint8_t argc, char** argv)
+{
+   struct rtc_time time;
+
+   if (argc > 1 && strcmp_P(argv[1], PSTR("set")) == 0)
+   {
+      uint16_t date[3], clock[3];
+
+      if (argc < 4 || !command_parse_fields(argv[2], '-', date, 3) ||
+          !command_parse_fields(argv[3], ':', clock, 3) || date[1] > 12 || date[2] > 31 ||
+          clock[0] > 23 || clock[1] > 59 || clock[2] > 59)
+      {
+         serial_print_P("Invalid time!\n");
+         return;
+      }
+
+      time.year = date[0];
+      time.month = (uint8_t)date[1];
+      time.day = (uint8_t)date[2];
+      time.hour = (uint8_t)clock[0];
+      time.minute = (uint8_t)clock[1];
+      time.second = (uint8_t)clock[2];
+
+      if (rtc_set_time(&time))
+      {
+         serial_print_P("Invalid time!\n");
+         return;
+      }
+   }
+   else if (argc > 1 && strcmp_P(argv[1], PSTR("sleep")) == 0)
+   {
+      uint32_t seconds;
+
+      if (argc < 3 || !shell_parse_unsigned(argv[2], &seconds))
+      {
+         serial_print_P("Invalid duration!\n");
+         return;
+      }
+
+      const uint32_t start = rtc_seconds();
+      serial_flush();
+
+      while (rtc_seconds() - start < seconds)
+      {
+         rtc_sleep();
+      }
+   }
+   else if (argc > 1)
+   {
+      serial_print_P("Invalid argument!\n");
+      return;
+   }
+
+   rtc_get_time(&time);
+   command_print_time(&time);
+   serial_print_string_P(rtc_source() == RTC_SOURCE_CRYSTAL ? PSTR(" (crystal)\n") :
+                         rtc_source() == RTC_SOURCE_SYSTEM ? PSTR(" (system)\n") : PSTR(" (stopped)\n"));
+   return;
+}
+
+/********************************************************************************
+* command_print_time: Skriver ut angivet datum och klockslag p formatet
+*                     YYYY-MM-DD hh:mm:ss.
+*
+*                     - time: Pekare till tiden som ska skrivas ut.
+********************************************************************************/
+static void command_print_time(const struct rtc_time* time)
+{
+   const uint8_t fields[] = { time->month, time->day, time->hour, time->minute, time->second };
+
+   serial_print_unsigned(time->year);
+
+   for (uint8_t i = 0; i < sizeof(fields); ++i)
+   {
+      serial_print_char(i < 2 ? '-' : i == 2 ? ' ' : ':');
+      if (fields[i] < 10) serial_print_char('0');
+      serial_print_unsigned(fields[i]);
+   }
+
+   return;
+}
+
+/********************************************************************************
+* command_parse_fields: Tolkar angivet argument som ett antal decimala tal
+*                       tskilda av angivet tecken, exempelvis 2026-10-17.
+*                       Inledande nollor tillts (till skillnad frn
+*                       shell_parse_unsigned, som avvisar dessa). Returnerar
+*                       true om exakt angivet antal tal tolkades, annars
+*                       false.
+*
+*                       - s         : Pekare till argumentet som ska tolkas.
+*                       - separator : Tecknet mellan talen.
+*                       - fields    : Pekare till array dr talen lagras.
+*                       - num_fields: Antalet tal som ska tolkas.
+********************************************************************************/
+static bool command_parse_fields(const char* s,
+                                 const char separator,
+                                 uint16_t* fields,
+                                 const uint8_t num_fields)
+{
+   for (uint8_t i = 0; i < num_fields; ++i)
+   {
+      uint32_t value = 0;
+      uint8_t num_digits = 0;
+
+      while (*s >= '0' && *s <= '9' && num_digits < 5)
+      {
+         value = value * 10 + (uint8_t)(*s++ - '0');
+         num_digits++;
+      }
+
+      if (num_digits == 0 || value > UINT16_MAX) return false;
+      fields[i] = (uint16_t)value;
+
+      if (*s != (i < num_fields - 1 ? separator : '\0')) return false;
+      s++;
+   }
+
+   return true;
+}
+
+/********************************************************************************
+* command_leds: Skriver ut ljusstyrkan fr samtliga lysdioder i v1 eller, om
+*               en lysdiod och en duty cycle anges, stter dess ljusstyrka.
+*               Frsta gngen startas BAM fr v1 och pwm1 inaktiveras, s
+*               att lysdioderna inte styrs av bda samtidigt. Med argumentet
+*               stop stoppas BAM och pwm1 aktiveras p nytt, men endast om
+*               pwm1 inaktiverades av detta kommando och systemet inte har
+*               lsts. Nr systemet har lsts kan BAM inte startas.
+*
+*               - argc: Antalet argument.
+*               - argv: Pekare till argumenten.
+********************************************************************************/
+static void command_leds(uint8_t argc, char** argv)
+{
+   static bool pwm_paused = false;
+
+   if (argc == 2 && strcmp_P(argv[1], PSTR("stop")) == 0)
+   {
+      bam_disable();
+      if (pwm_paused && !system_locked()) pwm_enable(&pwm1);
+      pwm_paused = false;
+      return;
+   }
+   else if (argc > 2)
+   {
+      uint32_t channel, duty;
+
+      if (!shell_parse_unsigned(argv[1], &channel) || channel >= v1.size)
+      {
+         serial_print_P("Invalid LED!\n");
+         return;
+      }
+
+      if (!shell_parse_unsigned(argv[2], &duty) || duty > BAM_DUTY_MAX)
+      {
+         serial_print_P("Invalid duty cycle!\n");
+         return;
+      }
+
+      if (!bam_enabled())
+      {
+         if (system_locked())
+         {
+            serial_print_P("System locked!\n");
+            return;
+         }
+
+         pwm_paused = pwm1.enabled;
+         pwm_disable(&pwm1);
+
+         if (bam_init(&v1))
+         {
+            serial_print_P("Timer 1 is busy!\n");
+            if (pwm_paused) pwm_enable(&pwm1);
+            pwm_paused = false;
+            return;
+         }
+      }
+
+      bam_set_duty((uint8_t)channel, (uint8_t)duty);
+   }
+   else if (argc > 1)
+   {
+      serial_print_P("Invalid argument!\n");
+      return;
+   }
+
+   if (!bam_enabled())
+   {
+      serial_print_P("BAM disabled\n");
+      return;
+   }
+
+   for (uint8_t i = 0; i < bam_channels(); ++i)
+   {
+      serial_print_P("LED ");
+      serial_print_unsigned(i);
+      serial_print_P(": ");
+      serial_print_unsigned(bam_get_duty(i));
+      serial_print_P("\n");
+   }
+
+   return;
+}
+
+/********************************************************************************
+* command_servo: Startar servopulser p angivna pinnar, stoppar dem eller
+*                stter brvrde fr en servo i mikrosekunder eller grader,
+*                eventuellt med en maximal hastighet i grader per sekund.
+*                Drefter skrivs aktuell pulsbredd samt brvrde ut fr
+*                samtliga servon.
+*
+*                - argc: Antalet argument.
+*                - argv: Pekare till argumenten.
+********************************************************************************/
+static void command_servo(uint8_t argc, char** argv)
+{
+   if (argc > 1 && strcmp_P(argv[1], PSTR("stop")) == 0)
+   {
+      servo_disable();
+      return;
+   }
+   else if (argc > 2 && strcmp_P(argv[1], PSTR("start")) == 0)
+   {
+      uint8_t pins[SHELL_MAX_ARGS];
+
+      for (uint8_t i = 2; i < argc; ++i)
+      {
+         uint32_t pin;
+
+         if (!shell_parse_unsigned(argv[i], &pin) || pin < 2 || pin > 19)
+         {
+            serial_print_P("Invalid pin!\n");
+            return;
+         }
+
+         pins[i - 2] = (uint8_t)pin;
+      }
+
+      if (servo_init(pins, argc - 2))
+      {
+         serial_print_P("Timer 1 is busy!\n");
+         return;
+      }
+   }
+   else if (argc > 2)
+   {
+      const bool angle = strcmp_P(argv[2], PSTR("angle")) == 0;
+      const uint8_t value_index = angle ? 3 : 2;
+      uint32_t channel, value, speed = 0;
+
+      if (!shell_parse_unsigned(argv[1], &channel) || channel >= servo_channels())
+      {
+         serial_print_P("Invalid servo!\n");
+         return;
+      }
+
+      if (argc <= value_index || !shell_parse_unsigned(argv[value_index], &value) ||
+          value > (angle ? SERVO_ANGLE_MAX / 10 : SERVO_PULSE_MAX_US) ||
+          (argc > value_index + 1 && !shell_parse_unsigned(argv[value_index + 1], &speed)) ||
+          speed > UINT16_MAX)
+      {
+         serial_print_P("Invalid value!\n");
+         return;
+      }
+
+      servo_set_speed((uint8_t)channel, (uint16_t)speed);
+
+      if (angle) servo_write_angle((uint8_t)channel, (uint16_t)value * 10);
+      else servo_write_us((uint8_t)channel, (uint16_t)value);
+   }
+   else if (argc > 1)
+   {
+      serial_print_P("Invalid argument!\n");
+      return;
+   }
+
+   if (!servo_enabled())
+   {
+      serial_print_P("Servos disabled\n");
+      return;
+   }
+
+   for (uint8_t i = 0; i < servo_channels(); ++i)
+   {
+      serial_print_P("Servo ");
+      serial_print_unsigned(i);
+      serial_print_P(" (pin ");
+      serial_print_unsigned(servo_get_pin(i));
+      serial_print_P("): ");
+      serial_print_unsigned(servo_position_us(i));
+      serial_print_P(" / ");
+      serial_print_unsigned(servo_read_us(i));
+      serial_print_P(" us\n");
+   }
+
+   return;
+}
\ No newline at end of file
@@ -0,0 +1,213 @@
+/********************************************************************************
+* coroutine.h: Innehller stacklsa coroutines (i stil med protothreads), som
+*              gr det mjligt att skriva sekventiell logik med vntan, ssom
+*              blinkning av lysdioder eller PWM-generering, utan att
+*              processorn blockeras av frdrjningsloopar.
+*
+*              En coroutine r en vanlig funktion som tar en pekare till en
+*              strukt coroutine (sju byte) och returnerar COROUTINE_WAITING
+*              medan den vntar, eller COROUTINE_DONE nr den har krt klart.
+*              Funktionen anropas (pollas) upprepat, exempelvis frn en task
+*              i schemalggaren, och fortstter vid varje anrop dr den
+*              senast vntade. Ingen egen stack krvs, drmed kan ett stort
+*              antal coroutines kras samtidigt:
+*
+*              enum coroutine_state blink(struct coroutine* co)
+*              {
+*                 coroutine_begin(co);
+*
+*                 while (1)
+*                 {
+*                    led_toggle(&l1);
+*                    await_ms(co, 500);
+*                 }
+*
+*                 coroutine_end(co);
+*              }
+*
+*              Begrnsningar:
+*
+*              - Lokala variabler behller inte sina vrden ver en
+*                vntepunkt. Rknaren counter i strukten, flt i anropande
+*                strukt eller statiska variabler anvnds i stllet.
+*              - Vntepunkter baseras p radnummer via __LINE__, drmed fr
+*                hgst en vntepunkt finnas per rad.
+*              - Vntepunkter fr inte placeras inuti en egen switch-sats
+*                mellan coroutine_begin och coroutine_end.
+********************************************************************************/
+#ifndef COROUTINE_H_
+#define COROUTINE_H_
+
+/* Inkluderingsdirektiv: */
+#include "timebase.h"
+
+/* Makrodefinitioner: */
+#define COROUTINE_LINE_DONE 0xFFFF /* Radnummer fr en coroutine som har krt klart. */
+
+/********************************************************************************
+* coroutine_state: Enumeration fr en coroutines tillstnd efter ett anrop.
+********************************************************************************/
+enum coroutine_state
+{
+   COROUTINE_WAITING, /* Coroutinen vntar och ska anropas p nytt. */
+   COROUTINE_DONE     /* Coroutinen har krt klart. */
+};
+
+/********************************************************************************
+* coroutine: Strukt fr lagring av en coroutines tillstnd mellan anropen.
+********************************************************************************/
+struct coroutine
+{
+   uint16_t line;       /* Rad dr coroutinen vntar (0 = ej startad). */
+   uint8_t counter;     /* Rknare fr loopar som innehller vntepunkter. */
+   uint32_t wait_until; /* Tidpunkt i ms eller us som await_ms/await_us vntar p. */
+};
+
+/********************************************************************************
+* coroutine_init: Initierar (eller startar om) angiven coroutine, s att den
+*                 brjar frn brjan vid nsta anrop.
+*
+*                 - self: Pekare till coroutinens tillstnd.
+********************************************************************************/
+static inline void coroutine_init(struct coroutine* self)
+{
+   self->line = 0;
+   self->counter = 0;
+   self->wait_until = 0;
+   return;
+}
+
+/********************************************************************************
+* coroutine_done: Indikerar ifall angiven coroutine har krt klart.
+*
+*                 - self: Pekare till coroutinens tillstnd.
+********************************************************************************/
+static inline bool coroutine_done(const struct coroutine* self)
+{
+   return self->line == COROUTINE_LINE_DONE;
+}
+
+/********************************************************************************
+* coroutine_begin: Markerar brjan av en coroutines kropp. Vid varje anrop
+*                  hoppar exekveringen hrifrn till senaste vntepunkt.
+*
+*                  - self: Pekare till coroutinens tillstnd.
+********************************************************************************/
+#define coroutine_begin(self) switch ((self)->line) { case 0:
+
+/********************************************************************************
+* coroutine_end: Markerar slutet av en coroutines kropp, varefter
+*                COROUTINE_DONE returneras vid detta och samtliga
+*                efterfljande anrop tills coroutine_init anropas.
+*
+*                - self: Pekare till coroutinens tillstnd.
+********************************************************************************/
+#define coroutine_end(self)               \
+   }                                      \
+   (self)->line = COROUTINE_LINE_DONE;    \
+   return COROUTINE_DONE
+
+/********************************************************************************
+* await_condition: Vntar tills angivet villkor r sant. Villkoret utvrderas
+*                  vid varje anrop av coroutinen.
+*
+*                  - self     : Pekare till coroutinens tillstnd.
+*                  - condition: Villkoret som ska uppfyllas.
+********************************************************************************/
+#define await_condition(self, condition)            \
+   do                                               \
+   {                                                \
+      (self)->line = __LINE__;                      \
+      case __LINE__:                                \
+      if (!(condition)) return COROUTINE_WAITING;   \
+   } while (0)
+
+/********************************************************************************
+* await_ms: Vntar angivet antal millisekunder.
+*
+*           - self    : Pekare till coroutinens tillstnd.
+*           - delay_ms: Vntetiden i millisekunder.
+********************************************************************************/
+#define await_ms(self, delay_ms)                                   \
+   do                                                              \
+   {                                                               \
+      (self)->wait_until = time_ms() + (delay_ms);                 \
+      await_condition(self, time_reached_ms((self)->wait_until));  \
+   } while (0)
+
+/********************************************************************************
+* await_us: Vntar angivet antal mikrosekunder, med en upplsning p ett
+*           steg i Timer 0 (4 us).
+*
+*           - self    : Pekare till coroutinens tillstnd.
+*           - delay_us: Vntetiden i mikrosekunder.
+********************************************************************************/
+#define await_us(self, delay_us)                                            \
+   do                                                                       \
+   {                                                                        \
+      (self)->wait_until = time_us() + (delay_us);                          \
+      await_condition(self, !time_before(time_us(), (self)->wait_until));  \
+   } while (0)
+
+/********************************************************************************
+* await_event: Vntar tills ngon av angivna hndelseflaggor har postats via
+*              coroutine_post, varefter dessa flaggor nollstlls.
+*
+*              - self : Pekare till coroutinens tillstnd.
+*              - event: Pekare till byten som lagrar hndelseflaggorna.
+*              - mask : Hndelseflaggor att vnta p.
+********************************************************************************/
+#define await_event(self, event, mask) \
+   await_condition(self, coroutine_take_event((event), (mask)))
+
+/********************************************************************************
+* coroutine_yield: Lmnar ver till anroparen en gng och fortstter vid
+*                  nsta anrop.
+*
+*                  - self: Pekare till coroutinens tillstnd.
+********************************************************************************/
+#define coroutine_yield(self)         \
+   do                                 \
+   {                                  \
+      (self)->line = __LINE__;        \
+      return COROUTINE_WAITING;       \
+      case __LINE__:;                 \
+   } while (0)
+
+/********************************************************************************
+* coroutine_post: Postar angivna hndelseflaggor. Kan anropas frn bde
+*                 huvudprogrammet och avbrottsrutiner.
+*
+*                 - event: Pekare till byten som lagrar hndelseflaggorna.
+*                 - mask : Hndelseflaggor som ska postas.
+********************************************************************************/
+static inline void coroutine_post(volatile uint8_t* event,
+                                  const uint8_t mask)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   *event |= mask;
+   SREG = sreg;
+   return;
+}
+
+/********************************************************************************
+* coroutine_take_event: Indikerar ifall ngon av angivna hndelseflaggor har
+*                       postats, varvid dessa flaggor nollstlls.
+*
+*                       - event: Pekare till byten som lagrar
+*                                hndelseflaggorna.
+*                       - mask : Hndelseflaggor att kontrollera.
+********************************************************************************/
+static inline bool coroutine_take_event(volatile uint8_t* event,
+                                        const uint8_t mask)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   const bool posted = (*event & mask) != 0;
+   *event &= ~mask;
+   SREG = sreg;
+   return posted;
+}
+
+#endif /* COROUTINE_H_ */
\ No newline at end of file
@@ -8,23 +8,77 @@
 /* Inkluderingsdirektiv: */
 #include "led.h"
 #include "button.h"
-#include "timer.h"
-#include "serial.h"
+#include "timer.h"
+#include "timebase.h"
+#include "soft_timer.h"
+#include "serial.h"
+#include "serial_stdio.h"
 #include "eeprom.h"
 #include "wdt.h"
 #include "pwm.h"
-#include "led_vector.h"
+#include "led_vector.h"
+#include "shell.h"
+#include "log.h"
+#include "telemetry.h"
+#include "tmp36.h"
+#include "modbus.h"
+#include "soft_serial.h"
+#include "capture.h"
+#include "scheduler.h"
+#include "rtc.h"
+#include "blink.h"
+#include "bam.h"
+#include "servo.h"
 
 /* Makrodefinitioner: */
 #define TIMEOUT_ADDRESS 100 /* Lagrar antalet passerade Watchdog timeouts. */
-#define TIMEOUT_MAX 5       /* Maximalt antal timeouts innan programmet lses. */
+#define TIMEOUT_MAX 5       /* Maximalt antal timeouts innan programmet lses. */
+#define MODBUS_ADDRESS_ADDRESS 101 /* Lagrar Modbus-slavens adress (ogiltig = kommandotolk). */
+#define RTC_LOG_INTERVAL_S 60      /* Intervall fr loggning av realtidsklockans tid. */
+
+#ifndef PWM_HARDWARE
+#define PWM_HARDWARE 0 /* 1 = pwm1 styr pin 9 - 10 via Timer 1 i hrdvara. */
+#endif
 
 /* Deklaration av globala objekt: */
 extern struct led l1, l2, l3;
 extern struct led_vector v1;
 extern struct button b1;
-extern struct timer t0, t1;
-extern struct pwm pwm1;
+extern struct timer t0;
+extern struct soft_timer debounce_timer;
+extern struct blink lockdown_blink;
+extern struct pwm pwm1;
+extern struct pwm_stagger pwm1_stagger;
+#if PWM_HARDWARE
+extern struct pwm_hw pwm1_hw;
+#endif
+extern struct shell shell1;
+extern struct tmp36 temp1;
+extern struct modbus modbus1;
+extern struct task watchdog_task, comm_task, pwm_task, startup_task;
+extern struct rtc_alarm rtc_log_alarm;
+
+/* Kommandotabell fr kommandotolken shell1 (se commands.c): */
+extern const struct shell_command commands[];
+extern const uint8_t num_commands;
+
+/* Registertabell fr Modbus-slaven modbus1 (se modbus_map.c): */
+extern const struct modbus_map modbus_map;
+
+/* Callback-rutin fr mjukvarutimer (se isr.c): */
+void debounce_timer_elapsed(void* context);
+
+/* Callback-rutin fr realtidsklockans larm (se isr.c): */
+void rtc_log_alarm_elapsed(void* context);
+
+/* Rutiner fr schemalggarens tasks (se tasks.c): */
+void watchdog_task_run(void* context);
+void comm_task_run(void* context);
+void pwm_task_run(void* context);
+void startup_task_run(void* context);
+
+/* Indikerar ifall systemet har lsts (se tasks.c): */
+bool system_locked(void);
 
 /********************************************************************************
 * setup: Initierar systemet enligt fljande:
@@ -38,17 +92,24 @@ extern struct pwm pwm1;
 *           aktiverar avbrott vid nedtryckning/uppslppning.
 *           Avbrottsvektor fr avbrottsrutinen r PCINT0_vect.
 *
-*        4. Initierar timer t0 till den 8-bitars timerkretsen Timer 0, som
-*           lper ut efter 300 millisekunder efter aktivering i Normal Mode.
-*           Avbrottsvektor fr avbrottsrutinen r TIMER0_OVF_vect.
+*        4. Initierar timer t0 till den 8-bitars timerkretsen Timer 0 som
+*           systemets tick, vilket krs i CTC Mode med avbrott varje
+*           millisekund (prescaler 64, OCR0A = 249). Avbrottsvektor fr
+*           avbrottsrutinen r TIMER0_COMPA_vect, som driver systemtiden
+*           (se timebase.h) samt samtliga mjukvarutimers (se soft_timer.h).
+*           Systemtiden anvnds som tidsstmpel fr loggning och telemetri.
 *
-*        5. Initierar timer t1 till den 16-bitars timerkretsen Timer 1, som
-*           lper ut efter 50 millisekunder efter aktivering i CTC Mode
-*           (rknar upp till 256 och fungerar drmed som en 8-bitars timer).
-*           Avbrottsvektor fr avbrottsrutinen r TIMER0_COMPA_vect.
+*        5. Initierar mjukvarutimer debounce_timer, som teraktiverar
+*           PCI-avbrott p I/O-port B 300 millisekunder efter nedtryckning,
+*           samt blinkningen lockdown_blink, som togglar lysdiod l1 var
+*           50:e millisekund nr systemet har lsts. Blinkningen fr
+*           anvnda Timer 1 fr toggling i hrdvara, men d pin 8 inte r
+*           en utpinne till Timer 1 sker den via en mjukvarutimer, se
+*           blink.h. Timer 1 och Timer 2 anvnds drmed inte fr tidmtning.
 *
-*        6. Initierar seriell verfring med en baud rate p 9600 kbps fr
-*           att mjliggra utskrift till seriell terminal.
+*        6. Initierar seriell verfring med en baud rate p 9600 bps fr
+*           att mjliggra utskrift till seriell terminal. stdout och stderr
+*           kopplas till seriell verfring, s att printf kan anvndas.
 *
 *        7. Skriver startvrdet 0 till adressen 100 i EEPROM-minnet. Denna
 *           adress anvnds fr att lagra antalet passerade Watchdog timeouts.
@@ -58,8 +119,47 @@ extern struct pwm pwm1;
 *           motsvarande avbrottsrutin r WDT_vect.
 *
 *        9. Initierar PWM-kontroller pwm1 fr PWM-styrning av lysdioderna med
-*           en periodtid p 1000 mikrosekunder.
-********************************************************************************/
+*           en periodtid p 1000 mikrosekunder, dr potentiometerns lge
+*           omvandlas till duty cycle enligt CIE L*, s att ljusstyrkan
+*           upplevs ka jmnt ver hela vridomrdet (se brightness.h).
+*           Med PWM_HARDWARE satt till 1 genereras PWM i stllet i
+*           hrdvara av Timer 1 p pin 9 - 10 (OC1A samt OC1B) med en
+*           frekvens p 1 kHz, dr potentiometern endast lses av var
+*           20:e millisekund. Lysdioden p pin 8 saknar utpinne frn
+*           timerkretsen och styrs d inte av pwm1. Timer 1 anvnds d
+*           inte fr Input Capture (kommandot capture).
+*
+*       10. Initierar temperatursensor temp1 ansluten till analog pin A1.
+*
+*       11. Om en giltig slavadress (1 - 247) finns lagrad p adressen 101
+*           i EEPROM-minnet initieras Modbus-slaven modbus1 med
+*           registertabellen i modbus_map.c, vilket mjliggr avlsning och
+*           styrning via Modbus RTU. Loggning inaktiveras d fr att inte
+*           stra Modbus-ramarna. Annars initieras kommandotolken shell1 med
+*           kommandotabellen i commands.c, vilket mjliggr justering av
+*           systemet via seriell terminal.
+*
+*       12. Initierar mjukvaru-UART:en fr en andra seriell kanal med en baud
+*           rate p 9600 bps, med sndning p pin 3 (PORTD3) och mottagning
+*           p pin 2 (PORTD2). Bittiden genereras av Timer 0 via
+*           avbrottsvektor TIMER0_COMPB_vect och startbitar detekteras via
+*           avbrottsvektor INT0_vect, se soft_serial.h.
+*
+*       13. Initierar schemalggarens tasks watchdog, comm, pwm och
+*           startup, se tasks.c. Task comm schemalggs var 10:e
+*           millisekund och task pwm aktiveras direkt. Task startup blinkar
+*           lysdioderna i v1 en efter en som startsekvens, varefter pwm1
+*           aktiveras. Huvudprogrammet kr sedan schemalggaren.
+*
+*       14. Startar realtidsklockan, se rtc.h. Med RTC_CRYSTAL satt till 1
+*           drivs den av Timer 2 frn en 32.768 kHz urkristall, frutsatt
+*           att Modbus inte r aktiverat (Modbus anvnder Timer 2), annars
+*           frn systemets klocka. Vid binr loggning startas larmet
+*           rtc_log_alarm, som loggar klockans tid var 60:e sekund. Drmed
+*           kan avkodaren tools/log_decode.py frse samtliga loggposter med
+*           datum och klockslag, eftersom loggposternas tidsstmplar i
+*           millisekunder slr runt frst efter 65.5 sekunder.
+********************************************************************************/
 void setup(void);
 
 #endif /* HEADER_H_ */
\ No newline at end of file
@@ -7,111 +7,178 @@
 * ISR (PCINT0_vect): Avbrottsrutin som ger rum vid nedtryckning/uppslppning
 *                    av tryckknapp b1 ansluten till pin 13 (PORTB5).
 *                    Vid nedtryckning terstlls Watchdog-timern, vilket
-*                    skrivs ut i ansluten seriell terminal. Dremot vid
+*                    loggas via seriell verfring. Dremot vid
 *                    uppslppning grs ingenting.
 *
 *                    Oavsett vad som orsakade avbrottet inaktiveras PCI-avbrott
-*                    p I/O-port B i 300 millisekunder via timer 0 fr att
-*                    undvika multipla avbrott orsakade av kontaktstudsar.
+*                    p I/O-port B i 300 millisekunder via mjukvarutimer
+*                    debounce_timer fr att undvika multipla avbrott orsakade
+*                    av kontaktstudsar.
 ********************************************************************************/
-ISR (PCINT0_vect)
-{
-   disable_pin_change_interrupt(IO_PORTB);
-   timer_enable_interrupt(&t0);
+ISR (PCINT0_vect)
+{
+   disable_pin_change_interrupt(IO_PORTB);
+   soft_timer_start(&debounce_timer, 300, 0);
 
    if (button_is_pressed(&b1))
    {
-      wdt_reset();
-      serial_print_string("Watchdog timer reset!\n");
+      wdt_reset();
+      log_event(LOG_WATCHDOG_RESET);
    }
 
    return;
 }
 
 /********************************************************************************
-* ISR (TIMER0_OVF_vect): Avbrottsrutin som ger rum vid overflow av Timer 0,
-*                        dvs. upprkning till 256, vilket sker var 0.128:e
-*                        millisekund nr timern r aktiverad.
+* ISR (TIMER0_COMPA_vect): Avbrottsrutin som ger rum nr Timer 0 nr
+*                          jmfrelsevrdet OCR0A i CTC Mode, vilket fr
+*                          timer t0 sker varje millisekund (prescaler 64,
+*                          OCR0A = 249). Systemtiden timebase_ms rknas upp
+*                          en millisekund och jmfrs sedan med tidpunkten
+*                          d nsta mjukvarutimer lper ut. Vid likhet hoppar
+*                          rutinen till SOFT_TIMER_DISPATCH_vect, som anropar
+*                          callback-rutinerna fr de timers som lper ut.
 *
-*                        Timern rknas upp via upprkning av varje passerat
-*                        avbrott. Nr timern lper ut (nr berknat antal
-*                        avbrott fr specificerad tid har rknats upp) s
-*                        teraktiveras PCI-avbrott p I/O-port B (som har
-*                        stngts av i 300 millisekunder fr att undvika
-*                        multipla avbrott orsakat av kontaktstudsar), fljt
-*                        av att timern stngs av.
-********************************************************************************/
-ISR (TIMER0_OVF_vect)
-{
-   timer_count(&t0);
-
-   if (timer_elapsed(&t0))
-   {
-      enable_pin_change_interrupt(IO_PORTB);
-      timer_disable_interrupt(&t0);
-   }
-
-   return;
-}
-
+*                          Rutinen r skriven i assembler utan prolog och
+*                          epilog frn kompilatorn, s att endast tv
+*                          register samt statusregistret sparas undan.
+*                          Upprkningen sker via subi/sbci med 0xFF, dr
+*                          carry-flaggan (inverterad) frs vidare till nsta
+*                          byte. Jmfrelsen avbryts vid frsta olika byte,
+*                          vilket i regel r den minst signifikanta.
+*
+*                          Uppskattat antal klockcykler per avbrott (inklusive
+*                          4 cykler fr avbrottsstart och 3 fr hoppet i
+*                          vektortabellen). Siffrorna r rknade fr hand ur
+*                          instruktionstabellen och inte uppmtta, exempelvis
+*                          i simulator eller via en utpinne p oscilloskop:
+*
+*                          Fre (timebase_tick + anrop av soft_timer_tick):
+*                          uppskattningsvis minst 120 cykler, varav cirka 65
+*                          fr att spara undan och terstlla samtliga 15
+*                          register som anropad funktion fr skriva ver.
+*                          Den genererade koden fr funktionerna r inte
+*                          medrknad.
+*
+*                          Efter: 52 cykler enligt handrkningen nr ingen
+*                          timer lper ut och frsta byten skiljer sig, vilket
+*                          motsvarar cirka 0.33 % av processortiden vid 16 MHz.
+********************************************************************************/
+ISR (TIMER0_COMPA_vect, ISR_NAKED)
+{
+   asm("push r24                        \n\t"
+       "in   r24, __SREG__              \n\t"
+       "push r24                        \n\t"
+       "push r25                        \n\t"
+       "lds  r24, timebase_ms           \n\t"
+       "subi r24, 0xFF                  \n\t"
+       "sts  timebase_ms, r24           \n\t"
+       "lds  r24, timebase_ms + 1       \n\t"
+       "sbci r24, 0xFF                  \n\t"
+       "sts  timebase_ms + 1, r24       \n\t"
+       "lds  r24, timebase_ms + 2       \n\t"
+       "sbci r24, 0xFF                  \n\t"
+       "sts  timebase_ms + 2, r24       \n\t"
+       "lds  r24, timebase_ms + 3       \n\t"
+       "sbci r24, 0xFF                  \n\t"
+       "sts  timebase_ms + 3, r24       \n\t"
+       "lds  r24, timebase_ms           \n\t"
+       "lds  r25, soft_timer_next_expiry \n\t"
+       "cpse r24, r25                   \n\t"
+       "rjmp 1f                         \n\t"
+       "lds  r24, timebase_ms + 1       \n\t"
+       "lds  r25, soft_timer_next_expiry + 1 \n\t"
+       "cpse r24, r25                   \n\t"
+       "rjmp 1f                         \n\t"
+       "lds  r24, timebase_ms + 2       \n\t"
+       "lds  r25, soft_timer_next_expiry + 2 \n\t"
+       "cpse r24, r25                   \n\t"
+       "rjmp 1f                         \n\t"
+       "lds  r24, timebase_ms + 3       \n\t"
+       "lds  r25, soft_timer_next_expiry + 3 \n\t"
+       "cpse r24, r25                   \n\t"
+       "rjmp 1f                         \n\t"
+       "pop  r25                        \n\t"
+       "pop  r24                        \n\t"
+       "out  __SREG__, r24              \n\t"
+       "pop  r24                        \n\t"
+       "jmp  __vector_soft_timer_dispatch \n\t"
+       "1:                              \n\t"
+       "pop  r25                        \n\t"
+       "pop  r24                        \n\t"
+       "out  __SREG__, r24              \n\t"
+       "pop  r24                        \n\t"
+       "reti                            \n\t");
+}
+
 /********************************************************************************
-* ISR (TIMER1_COMPA_vect): Avbrottsrutin som ger rum vid upprkning till 256 av
-*                          Timer 1 i CTC Mode, vilket sker var 0.128:e
-*                          millisekund nr timern r aktiverad.
+* debounce_timer_elapsed: Callback-rutin fr mjukvarutimer debounce_timer,
+*                         som anropas 300 millisekunder efter nedtryckning
+*                         eller uppslppning av tryckknapp b1. PCI-avbrott p
+*                         I/O-port B (som har stngts av fr att undvika
+*                         multipla avbrott orsakat av kontaktstudsar)
+*                         teraktiveras.
 *
-*                          Timern rknas upp via upprkning av varje passerat
-*                          avbrott. Nr timern lper ut (var 50:e millisekund
-*                          nr timern r aktiverad) togglas lysdiod l1.
-********************************************************************************/
-ISR (TIMER1_COMPA_vect)
-{
-   timer_count(&t1);
-
-   if (timer_elapsed(&t1))
-   {
-      led_toggle(&l1);
-   }
-
-   return;
-}
+*                         - context: Anvnds inte.
+********************************************************************************/
+void debounce_timer_elapsed(void* context)
+{
+   enable_pin_change_interrupt(IO_PORTB);
+   return;
+}
+
+/********************************************************************************
+* rtc_log_alarm_elapsed: Callback-rutin fr realtidsklockans larm
+*                        rtc_log_alarm, som anropas var 60:e sekund vid
+*                        binr loggning. Klockans tid loggas, vilket ger
+*                        loggposternas tidsstmplar en knd tidpunkt.
+*
+*                        - context: Anvnds inte.
+********************************************************************************/
+void rtc_log_alarm_elapsed(void* context)
+{
+   log_u32(LOG_RTC_TIME, rtc_seconds());
+   return;
+}
 
 /********************************************************************************
 * ISR (WDT_vect): Avbrottsrutin som ger rum vid Watchdog timeout, vilket sker
-*                 om Watchdog-timern inte blir terslld var 1024:e millisekund.
-*                 Antalet timeouts rknas upp och skrivs ut i ansluten seriell
-*                 terminal. Nr maximalt antal timeouts har genomfrts lses
-*                 systemet i ett tillstnd dr lysdioden ansluten till pin 8
-*                 (PORTB0) blinkar var 50:e millisekund.
-********************************************************************************/
-ISR (WDT_vect)
-{
-   static volatile bool system_lockdown = false;
-
-   if (!system_lockdown)
-   {
-      uint8_t num_timeouts = eeprom_read_byte(TIMEOUT_ADDRESS);
-
-      serial_print_string("Number of timeouts: ");
-      serial_print_unsigned(++num_timeouts);
-      serial_print_new_line();
-
-      if (num_timeouts >= TIMEOUT_MAX)
-      {
-         system_lockdown = true;
-         serial_print_string("Maximum number of timeouts has elapsed!\n");
-         serial_print_string("System lockdown!\n");
-
-         button_clear(&b1);
-         timer_clear(&t0);
-         pwm_disable(&pwm1);
-         timer_enable_interrupt(&t1);
-      }
-      else
-      {
-         eeprom_write_byte(TIMEOUT_ADDRESS, num_timeouts);
-      }
-   }
-
-   wdt_enable_interrupt();
-   return;
-}
+*                 om Watchdog-timern inte blir terstlld var 8192:e
+*                 millisekund. Task watchdog aktiveras, som rknar upp och
+*                 loggar antalet timeouts samt lser systemet nr maximalt
+*                 antal timeouts har genomfrts, se tasks.c. Avbrott vid
+*                 timeout teraktiveras direkt, s att nsta timeout inte
+*                 medfr systemterstllning.
+********************************************************************************/
+ISR (WDT_vect)
+{
+   task_activate(&watchdog_task);
+   wdt_enable_interrupt();
+   return;
+}
+
+/********************************************************************************
+* ISR (TIMER2_COMPA_vect): Avbrottsrutin som ger rum nr 1.5 teckentider har
+*                          passerat sedan Modbus-slaven modbus1 tog emot
+*                          senaste tecknet. Tecken som tas emot drefter
+*                          tillhr inte lngre samma ram.
+********************************************************************************/
+ISR (TIMER2_COMPA_vect)
+{
+   modbus_char_gap_elapsed(&modbus1);
+   return;
+}
+
+/********************************************************************************
+* ISR (TIMER2_COMPB_vect): Avbrottsrutin som ger rum nr 3.5 teckentider har
+*                          passerat sedan Modbus-slaven modbus1 tog emot
+*                          senaste tecknet, vilket innebr att ramen r
+*                          komplett och kan tolkas i huvudprogrammet, varvid
+*                          task comm aktiveras.
+********************************************************************************/
+ISR (TIMER2_COMPB_vect)
+{
+   modbus_frame_gap_elapsed(&modbus1);
+   task_activate(&comm_task);
+   return;
+}
\ No newline at end of file
@@ -71,4 +71,22 @@ void led_blink(struct led* self,
    delay_ms(blink_speed_ms);
    return;
 }
+
+/********************************************************************************
+* led_blink_async: Togglar angiven lysdiod och vntar sedan angiven tid utan
+*                  att blockera processorn.
+*
+*                  - self          : Pekare till lysdioden som ska blinkas.
+*                  - co            : Pekare till coroutinens tillstnd.
+*                  - blink_speed_ms: Blinkhastigheten mtt i millisekunder.
+********************************************************************************/
+enum coroutine_state led_blink_async(struct led* self,
+                                     struct coroutine* co,
+                                     const uint16_t blink_speed_ms)
+{
+   coroutine_begin(co);
+   led_toggle(self);
+   await_ms(co, blink_speed_ms);
+   coroutine_end(co);
+}
  
\ No newline at end of file
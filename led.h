@@ -7,6 +7,7 @@
 
 /* Inkluderingsdirektiv: */
 #include "misc.h"
+#include "coroutine.h"
 
 /********************************************************************************
 * led: Strukt fr implementering av lysdioder och andra digitala utportar.
@@ -30,6 +31,19 @@ struct led
 void led_init(struct led* self,
               const uint8_t pin);
 
+/********************************************************************************
+* led_get_pin: Returnerar pin-numret p Arduino Uno fr angiven lysdiod,
+*              exempelvis 8 fr PORTB0.
+*
+*              - self: Pekare till lysdioden.
+********************************************************************************/
+static inline uint8_t led_get_pin(const struct led* self)
+{
+   if (self->output == &PORTB) return self->pin + 8;
+   if (self->output == &PORTC) return self->pin + 14;
+   return self->pin;
+}
+
 /********************************************************************************
 * led_clear: Nollstller lysdiod samt motsvarande pin.
 *
@@ -92,4 +106,17 @@ static inline bool led_enabled(const struct led* self)
 void led_blink(struct led* self,
                const uint16_t blink_speed_ms);
 
+/********************************************************************************
+* led_blink_async: Motsvarar led_blink, men implementerad som en coroutine
+*                  som vntar utan att blockera processorn. Ska anropas
+*                  upprepat tills COROUTINE_DONE returneras, se coroutine.h.
+*
+*                  - self          : Pekare till lysdioden som ska blinkas.
+*                  - co            : Pekare till coroutinens tillstnd.
+*                  - blink_speed_ms: Blinkhastigheten mtt i millisekunder.
+********************************************************************************/
+enum coroutine_state led_blink_async(struct led* self,
+                                     struct coroutine* co,
+                                     const uint16_t blink_speed_ms);
+
 #endif /* LED_H_ */
\ No newline at end of file
@@ -160,4 +160,67 @@ void led_vector_blink_sequentially(struct led_vector* self,
    }
 
    return;
+}
+
+/********************************************************************************
+* led_vector_blink_collectively_async: Tnder samtliga lysdioder i angiven
+*                                      vektor, vntar angiven tid, slcker
+*                                      dem och vntar sedan p nytt, utan att
+*                                      blockera processorn.
+*
+*                                      - self          : Pekare till vektorn
+*                                                        vars lysdioder ska
+*                                                        blinkas.
+*                                      - co            : Pekare till
+*                                                        coroutinens
+*                                                        tillstnd.
+*                                      - blink_speed_ms: Lysdiodernas
+*                                                        blinkhastighet mtt
+*                                                        i millisekunder.
+********************************************************************************/
+enum coroutine_state led_vector_blink_collectively_async(struct led_vector* self,
+                                                         struct coroutine* co,
+                                                         const uint16_t blink_speed_ms)
+{
+   coroutine_begin(co);
+   led_vector_on(self);
+   await_ms(co, blink_speed_ms);
+   led_vector_off(self);
+   await_ms(co, blink_speed_ms);
+   coroutine_end(co);
+}
+
+/********************************************************************************
+* led_vector_blink_sequentially_async: Blinkar lysdioderna i angiven vektor
+*                                      en efter en utan att blockera
+*                                      processorn. Aktuell lysdiod lagras i
+*                                      coroutinens rknare, eftersom lokala
+*                                      variabler inte behller sina vrden
+*                                      ver en vntepunkt.
+*
+*                                      - self          : Pekare till vektorn
+*                                                        vars lysdioder ska
+*                                                        blinkas.
+*                                      - co            : Pekare till
+*                                                        coroutinens
+*                                                        tillstnd.
+*                                      - blink_speed_ms: Lysdiodernas
+*                                                        blinkhastighet mtt
+*                                                        i millisekunder.
+********************************************************************************/
+enum coroutine_state led_vector_blink_sequentially_async(struct led_vector* self,
+                                                         struct coroutine* co,
+                                                         const uint16_t blink_speed_ms)
+{
+   coroutine_begin(co);
+   led_vector_off(self);
+
+   for (co->counter = 0; co->counter < self->size; ++co->counter)
+   {
+      led_on(self->leds[co->counter]);
+      await_ms(co, blink_speed_ms);
+      led_off(self->leds[co->counter]);
+   }
+
+   coroutine_end(co);
 }
\ No newline at end of file
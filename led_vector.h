@@ -161,4 +161,45 @@ void led_vector_blink_collectively(struct led_vector* self,
 void led_vector_blink_sequentially(struct led_vector* self,
                                    const uint16_t blink_speed_ms);
 
+/********************************************************************************
+* led_vector_blink_collectively_async: Motsvarar led_vector_blink_collectively,
+*                                      men implementerad som en coroutine som
+*                                      vntar utan att blockera processorn,
+*                                      se coroutine.h.
+*
+*                                      - self          : Pekare till vektorn
+*                                                        vars lysdioder ska
+*                                                        blinkas.
+*                                      - co            : Pekare till
+*                                                        coroutinens
+*                                                        tillstnd.
+*                                      - blink_speed_ms: Lysdiodernas
+*                                                        blinkhastighet mtt
+*                                                        i millisekunder.
+********************************************************************************/
+enum coroutine_state led_vector_blink_collectively_async(struct led_vector* self,
+                                                         struct coroutine* co,
+                                                         const uint16_t blink_speed_ms);
+
+/********************************************************************************
+* led_vector_blink_sequentially_async: Motsvarar led_vector_blink_sequentially,
+*                                      men implementerad som en coroutine som
+*                                      vntar utan att blockera processorn,
+*                                      se coroutine.h. Vektorn fr innehlla
+*                                      hgst 255 lysdioder.
+*
+*                                      - self          : Pekare till vektorn
+*                                                        vars lysdioder ska
+*                                                        blinkas.
+*                                      - co            : Pekare till
+*                                                        coroutinens
+*                                                        tillstnd.
+*                                      - blink_speed_ms: Lysdiodernas
+*                                                        blinkhastighet mtt
+*                                                        i millisekunder.
+********************************************************************************/
+enum coroutine_state led_vector_blink_sequentially_async(struct led_vector* self,
+                                                         struct coroutine* co,
+                                                         const uint16_t blink_speed_ms);
+
 #endif /* LED_VECTOR_H_ */
\ No newline at end of file
@@ -0,0 +1,218 @@
+/********************************************************************************
+* log.c: Innehller funktionsdefinitioner fr loggning av frdefinierade
+*        meddelanden, antingen som text eller som binra loggposter.
+********************************************************************************/
+#include "log.h"
+
+/* Makrodefinitioner: */
+#define LOG_SHORT_ID_FIRST 0x80 /* Frsta byte fr ID som ryms i en byte. */
+#define LOG_LONG_ID_FIRST 0xF0  /* Frsta byte fr ID som krver tv byte. */
+#define LOG_SHORT_IDS (LOG_LONG_ID_FIRST - LOG_SHORT_ID_FIRST) /* Antal ID som ryms i en byte. */
+#define LOG_RECORD_MAX (2 + 2 + LOG_ARGS_MAX) /* Maximal storlek p en loggpost. */
+
+#if LOG_NUM_MESSAGES > LOG_SHORT_IDS + 4096
+#error "Too many log messages for the two-byte message ID format!"
+#endif
+
+/* Statiska variabler: */
+static uint16_t (*log_timestamp)(void) = 0; /* Funktion som returnerar aktuell tidsstmpel. */
+static volatile uint16_t log_num_dropped = 0; /* Antalet kastade loggposter. */
+static bool log_enabled = true; /* Indikerar ifall loggning r aktiverad. */
+
+#if !LOG_BINARY
+#define LOG_MESSAGE(id, format) static const char id##_FORMAT[] PROGMEM = format;
+LOG_MESSAGES /* Formatstrngar, lagras i programminnet. */
+#undef LOG_MESSAGE
+
+#define LOG_MESSAGE(id, format) id##_FORMAT,
+static PGM_P const log_formats[LOG_NUM_MESSAGES] PROGMEM = { LOG_MESSAGES }; /* Pekare till formatstrngarna. */
+#undef LOG_MESSAGE
+
+static void log_print_text(PGM_P format,
+                           const uint8_t* args,
+                           uint8_t size);
+#endif
+
+/********************************************************************************
+* log_set_timestamp_source: Anger funktion som returnerar tidsstmpeln i
+*                           millisekunder fr nya loggposter. Om ingen
+*                           funktion anges stts tidsstmpeln till 0.
+*
+*                           - timestamp: Pekare till funktionen.
+********************************************************************************/
+void log_set_timestamp_source(uint16_t (*timestamp)(void))
+{
+   log_timestamp = timestamp;
+   return;
+}
+
+/********************************************************************************
+* log_set_enabled: Aktiverar eller inaktiverar loggning. Meddelanden som
+*                  loggas nr loggning r inaktiverad ignoreras.
+*
+*                  - enabled: Indikerar ifall loggning ska vara aktiverad.
+********************************************************************************/
+void log_set_enabled(const bool enabled)
+{
+   log_enabled = enabled;
+   return;
+}
+
+/********************************************************************************
+* log_write: Loggar angivet meddelande med angivna packade argument.
+*
+*            I binrt lge sammanstlls loggposten frst lokalt och placeras
+*            sedan i sndbufferten med avbrott inaktiverade, frutsatt att
+*            hela posten fr plats. Annars kastas posten och rknas i
+*            log_dropped, s att en halv loggpost aldrig skickas.
+*
+*            I textlge skrivs formatstrngen ut med argumenten insatta,
+*            fljt av ett nyradstecken.
+*
+*            - id  : Meddelandets ID.
+*            - args: Pekare till packade argument (little endian).
+*            - size: Antalet byte argument (max LOG_ARGS_MAX).
+********************************************************************************/
+void log_write(const enum log_id id,
+               const void* args,
+               const uint8_t size)
+{
+   if (!log_enabled || (uint16_t)id >= LOG_NUM_MESSAGES || size > LOG_ARGS_MAX) return;
+
+#if LOG_BINARY
+   uint8_t record[LOG_RECORD_MAX];
+   uint8_t length = 0;
+   const uint16_t timestamp = log_timestamp ? log_timestamp() : 0;
+
+   if ((uint16_t)id < LOG_SHORT_IDS)
+   {
+      record[length++] = LOG_SHORT_ID_FIRST + (uint8_t)id;
+   }
+   else
+   {
+      const uint16_t extended_id = (uint16_t)id - LOG_SHORT_IDS;
+      record[length++] = LOG_LONG_ID_FIRST | (uint8_t)(extended_id >> 8);
+      record[length++] = (uint8_t)extended_id;
+   }
+
+   record[length++] = (uint8_t)timestamp;
+   record[length++] = (uint8_t)(timestamp >> 8);
+
+   for (uint8_t i = 0; i < size; ++i)
+   {
+      record[length++] = ((const uint8_t*)args)[i];
+   }
+
+   const uint8_t sreg = SREG;
+   asm("CLI");
+
+   if (serial_tx_free() >= length)
+   {
+      serial_write(record, length);
+   }
+   else
+   {
+      log_num_dropped++;
+   }
+
+   SREG = sreg;
+#else
+   log_print_text((PGM_P)pgm_read_word(&log_formats[id]), (const uint8_t*)args, size);
+#endif
+   return;
+}
+
+/********************************************************************************
+* log_dropped: Returnerar antalet loggposter som har kastats fr att
+*              sndbufferten var full.
+********************************************************************************/
+uint16_t log_dropped(void)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   const uint16_t num_dropped = log_num_dropped;
+   SREG = sreg;
+   return num_dropped;
+}
+
+#if !LOG_BINARY
+/********************************************************************************
+* log_print_text: Skriver ut angiven formatstrng med angivna packade
+*                 argument insatta, fljt av ett nyradstecken. Argumentens
+*                 storlek bestms av formatstrngen (hh = 8 bitar, h eller
+*                 ingen lngd = 16 bitar, l = 32 bitar). Om argument saknas
+*                 avbryts utskriften av formatstrngen.
+*
+*                 - format: Pekare till formatstrngen i programminnet.
+*                 - args  : Pekare till packade argument (little endian).
+*                 - size  : Antalet byte argument.
+********************************************************************************/
+static void log_print_text(PGM_P format,
+                           const uint8_t* args,
+                           uint8_t size)
+{
+   for (char c = pgm_read_byte(format); c; c = pgm_read_byte(++format))
+   {
+      if (c != '%')
+      {
+         serial_print_char(c);
+         continue;
+      }
+
+      uint8_t width = 2;
+      uint32_t value = 0;
+
+      if ((c = pgm_read_byte(++format)) == 'h')
+      {
+         if ((c = pgm_read_byte(++format)) == 'h')
+         {
+            width = 1;
+            c = pgm_read_byte(++format);
+         }
+      }
+      else if (c == 'l')
+      {
+         width = 4;
+         c = pgm_read_byte(++format);
+      }
+
+      if (c == '%')
+      {
+         serial_print_char('%');
+         continue;
+      }
+      else if (c == '\0' || width > size)
+      {
+         break;
+      }
+
+      for (uint8_t j = 0; j < width; ++j)
+      {
+         value |= (uint32_t)args[j] << (8 * j);
+      }
+
+      if (c == 'd')
+      {
+         if (width == 1) serial_print_int8((int8_t)value);
+         else if (width == 2) serial_print_int16((int16_t)value);
+         else serial_print_int32((int32_t)value);
+      }
+      else if (c == 'x')
+      {
+         if (width == 1) serial_print_hex8((uint8_t)value);
+         else if (width == 2) serial_print_hex16((uint16_t)value);
+         else serial_print_hex32(value);
+      }
+      else
+      {
+         serial_print_uint32(value);
+      }
+
+      args += width;
+      size -= width;
+   }
+
+   serial_print_new_line();
+   return;
+}
+#endif
\ No newline at end of file
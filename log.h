@@ -0,0 +1,138 @@
+/********************************************************************************
+* log.h: Innehller funktionalitet fr loggning av frdefinierade meddelanden
+*        via seriell verfring, antingen som text eller som kompakta binra
+*        loggposter, vilket vljs vid kompilering via makrot LOG_BINARY.
+*
+*        Meddelanden deklareras i log_messages.h. Istllet fr att skicka
+*        hela texten skickas i binrt lge endast en loggpost bestende av
+*        meddelande-ID, tidsstmpel samt packade argument:
+*
+*        Flt          Storlek   Innehll
+*        ID            1 byte    0x80 + ID fr ID 0 - 111.
+*                      2 byte    0xF0 | (ID - 112) >> 8, (ID - 112) & 0xFF
+*                                fr ID 112 - 4207.
+*        Tidsstmpel   2 byte    Millisekunder (little endian, slr runt).
+*        Argument      0 - 8     Argument enligt formatstrngen.
+*
+*        Frsta byten i varje loggpost r alltid strre n 0x7F, vilket gr
+*        att loggposter kan blandas med vanlig ASCII-text p samma seriella
+*        linje. Avkodaren tools/log_decode.py terskapar lsbara rader frn en
+*        inspelad bytestrm med hjlp av tabellen i log_messages.h.
+*
+*        En loggpost placeras i sndbufferten i sin helhet med avbrott
+*        inaktiverade, eller inte alls om plats saknas. Loggning kan drmed
+*        ske frn avbrottsrutiner utan att poster blandas ihop eller att
+*        avbrottsrutinen vntar p sndlinjen.
+********************************************************************************/
+#ifndef LOG_H_
+#define LOG_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "serial.h"
+#include "log_messages.h"
+
+/* Makrodefinitioner: */
+#ifndef LOG_BINARY
+#define LOG_BINARY 0 /* 1 = binra loggposter, 0 = textutskrift. */
+#endif
+
+#define LOG_ARGS_MAX 8 /* Maximalt antal byte argument per loggpost. */
+
+/********************************************************************************
+* log_id: Enumeration fr meddelande-ID:n, genererade frn log_messages.h.
+********************************************************************************/
+enum log_id
+{
+#define LOG_MESSAGE(id, format) id,
+   LOG_MESSAGES
+#undef LOG_MESSAGE
+   LOG_NUM_MESSAGES /* Antalet meddelanden. */
+};
+
+/********************************************************************************
+* log_set_timestamp_source: Anger funktion som returnerar tidsstmpeln i
+*                           millisekunder fr nya loggposter. Om ingen
+*                           funktion anges stts tidsstmpeln till 0.
+*
+*                           - timestamp: Pekare till funktionen.
+********************************************************************************/
+void log_set_timestamp_source(uint16_t (*timestamp)(void));
+
+/********************************************************************************
+* log_set_enabled: Aktiverar eller inaktiverar loggning. Inaktiverad loggning
+*                  anvnds nr den seriella linjen anvnds av ett protokoll
+*                  som inte tl annan trafik, exempelvis Modbus RTU.
+*
+*                  - enabled: Indikerar ifall loggning ska vara aktiverad.
+********************************************************************************/
+void log_set_enabled(const bool enabled);
+
+/********************************************************************************
+* log_write: Loggar angivet meddelande med angivna packade argument.
+*
+*            - id  : Meddelandets ID.
+*            - args: Pekare till packade argument (little endian).
+*            - size: Antalet byte argument (max LOG_ARGS_MAX).
+********************************************************************************/
+void log_write(const enum log_id id,
+               const void* args,
+               const uint8_t size);
+
+/********************************************************************************
+* log_dropped: Returnerar antalet loggposter som har kastats fr att
+*              sndbufferten var full.
+********************************************************************************/
+uint16_t log_dropped(void);
+
+/********************************************************************************
+* log_event: Loggar angivet meddelande utan argument.
+*
+*            - id: Meddelandets ID.
+********************************************************************************/
+static inline void log_event(const enum log_id id)
+{
+   log_write(id, 0, 0);
+   return;
+}
+
+/********************************************************************************
+* log_u8: Loggar angivet meddelande med ett 8-bitars argument.
+*
+*         - id   : Meddelandets ID.
+*         - value: Argumentet som ska loggas.
+********************************************************************************/
+static inline void log_u8(const enum log_id id,
+                          const uint8_t value)
+{
+   log_write(id, &value, sizeof(value));
+   return;
+}
+
+/********************************************************************************
+* log_u16: Loggar angivet meddelande med ett 16-bitars argument.
+*
+*          - id   : Meddelandets ID.
+*          - value: Argumentet som ska loggas.
+********************************************************************************/
+static inline void log_u16(const enum log_id id,
+                           const uint16_t value)
+{
+   log_write(id, &value, sizeof(value));
+   return;
+}
+
+/********************************************************************************
+* log_u32: Loggar angivet meddelande med ett 32-bitars argument.
+*
+*          - id   : Meddelandets ID.
+*          - value: Argumentet som ska loggas.
+********************************************************************************/
+static inline void log_u32(const enum log_id id,
+                           const uint32_t value)
+{
+   log_write(id, &value, sizeof(value));
+   return;
+}
+
+#endif /* LOG_H_ */
\ No newline at end of file
@@ -0,0 +1,31 @@
+/********************************************************************************
+* log_messages.h: Innehller meddelandetabellen fr loggning via log.h.
+*
+*                 Varje meddelande deklareras med makrot LOG_MESSAGE, dr
+*                 frsta argumentet utgr meddelandets namn och andra
+*                 argumentet formatstrngen. Vid kompilering genereras ett
+*                 meddelande-ID per rad (i den ordning meddelandena str
+*                 nedan) via enumerationen log_id i log.h. Samma tabell lses
+*                 av avkodaren tools/log_decode.py fr att terskapa lsbara
+*                 rader frn binra loggposter. Nya meddelanden ska drmed
+*                 alltid lggas till sist i tabellen, annars ndras befintliga
+*                 meddelande-ID:n och ldre loggar avkodas felaktigt.
+*
+*                 Formatstrngar kan innehlla fljande argument, vilka
+*                 packas i samma ordning (little endian) i loggposten:
+*
+*                 %hhu / %hhd / %hhx: 8-bitars osignerat / signerat / hex.
+*                 %hu  / %hd  / %hx : 16-bitars osignerat / signerat / hex.
+*                 %lu  / %ld  / %lx : 32-bitars osignerat / signerat / hex.
+********************************************************************************/
+#ifndef LOG_MESSAGES_H_
+#define LOG_MESSAGES_H_
+
+#define LOG_MESSAGES \
+   LOG_MESSAGE(LOG_WATCHDOG_RESET, "Watchdog timer reset!") \
+   LOG_MESSAGE(LOG_NUM_TIMEOUTS, "Number of timeouts: %hhu") \
+   LOG_MESSAGE(LOG_MAX_TIMEOUTS, "Maximum number of timeouts has elapsed!") \
+   LOG_MESSAGE(LOG_SYSTEM_LOCKDOWN, "System lockdown!") \
+   LOG_MESSAGE(LOG_RTC_TIME, "RTC time: %lu s since 2000-01-01")
+
+#endif /* LOG_MESSAGES_H_ */
\ No newline at end of file
@@ -8,13 +8,13 @@
 *         Fr att genomgra Watchdog reset kan anvndaren trycka p en
 *         tryckknapp ansluten till pin 13 (PORTB5). Efter fem timeouts lses
 *         systemet, dr det enda som sker r att en lysdiod ansluten till
-*         pin 8 (PORTB0) blinkar var 50:e millisekund via Timer 1. 
+*         pin 8 (PORTB0) blinkar var 50:e millisekund via en mjukvarutimer. 
 *
 *         Utskrift sker via seriell verfring efter varje Watchdog timeout, 
 *         vid Watchdog reset samt vid lsning av systemet. Fr att undvika
 *         multipla avbrott orsakat av kontaktstudsar inaktiveras PCI-avbrott
 *         p I/O-port B i 300 millisekunder efter nedtryckning, implementerat
-*         via Timer 0.
+*         via en mjukvarutimer. Samtliga mjukvarutimers drivs av Timer 0.
 ********************************************************************************/
 #include "header.h"
 
@@ -27,17 +27,17 @@
 *       var 50:e millisekund tills en total systemterstllning genomfrs.
 *       vrig tid sker PWM-styrning av lysdioder l1 - l3 anslutna till pin
 *       8 - 10 (PORTB0 - PORTB2) via en potentiometer ansluten till analog
-*       pin A0 (PORTC0).
-********************************************************************************/
-int main(void)
-{
-   setup();
-   
-   while (1)
-   {
-      pwm_run(&pwm1);
-   }
-
-   return 0;
+*       pin A0 (PORTC0). Var 10:e millisekund tolkas kommandon mottagna
+*       via seriell terminal, se commands.c, alternativt frfrgningar via
+*       Modbus RTU om Modbus-slaven r aktiverad, se modbus_map.c.
+*
+*       Samtliga delar krs som tasks av den kooperativa schemalggaren,
+*       se tasks.c samt scheduler.h.
+********************************************************************************/
+int main(void)
+{
+   setup();
+   scheduler_run();
+   return 0;
 }
 
@@ -11,11 +11,13 @@
 /* Inkluderingsdirektiv: */
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
 #include <util/delay.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 /* Makrodefinitioner fr port-nummer p ATmega328P samt motsvarande pin-nummer p Arduino Uno: */
 #define D0 0 /* PORTD0 / pin 0. */
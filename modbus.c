@@ -0,0 +1,560 @@
+/********************************************************************************
+* modbus.c: Innehller funktionsdefinitioner fr Modbus RTU-slav via USART.
+********************************************************************************/
+#include "modbus.h"
+
+/* Makrodefinitioner: */
+#define MODBUS_TICK_US 64              /* Tid per timersteg i us (prescaler 1024 vid 16 MHz). */
+#define MODBUS_CHAR_BITS 11UL          /* Antal bitar per tecken enligt specifikationen. */
+#define MODBUS_BAUD_MIN 2400UL         /* Lgsta baud rate, begrnsas av 8-bitars Timer 2. */
+#define MODBUS_FIXED_TIMING_BAUD 19200 /* ver denna baud rate anvnds fasta tider. */
+#define MODBUS_CHAR_GAP_FIXED_US 750   /* Fast t1.5 i us. */
+#define MODBUS_FRAME_GAP_FIXED_US 1750 /* Fast t3.5 i us. */
+
+#define MODBUS_READ_COILS 0x01                /* Funktionskod fr lsning av coils. */
+#define MODBUS_READ_DISCRETE_INPUTS 0x02      /* Funktionskod fr lsning av discrete inputs. */
+#define MODBUS_READ_HOLDING_REGISTERS 0x03    /* Funktionskod fr lsning av holding registers. */
+#define MODBUS_READ_INPUT_REGISTERS 0x04      /* Funktionskod fr lsning av input registers. */
+#define MODBUS_WRITE_SINGLE_COIL 0x05         /* Funktionskod fr skrivning av en coil. */
+#define MODBUS_WRITE_SINGLE_REGISTER 0x06     /* Funktionskod fr skrivning av ett register. */
+#define MODBUS_WRITE_MULTIPLE_COILS 0x0F      /* Funktionskod fr skrivning av flera coils. */
+#define MODBUS_WRITE_MULTIPLE_REGISTERS 0x10  /* Funktionskod fr skrivning av flera register. */
+#define MODBUS_EXCEPTION_FLAG 0x80            /* Stts i funktionskoden vid undantag. */
+
+#define MODBUS_READ_BITS_MAX 2000         /* Maximalt antal bitar per lsning. */
+#define MODBUS_READ_REGISTERS_MAX 125     /* Maximalt antal register per lsning. */
+#define MODBUS_WRITE_BITS_MAX 1968        /* Maximalt antal bitar per skrivning. */
+#define MODBUS_WRITE_REGISTERS_MAX 123    /* Maximalt antal register per skrivning. */
+#define MODBUS_COIL_ON 0xFF00             /* Vrde fr tnd coil vid skrivning av en coil. */
+#define MODBUS_COIL_OFF 0x0000            /* Vrde fr slckt coil vid skrivning av en coil. */
+#define MODBUS_CRC_SIZE 2                 /* Antal byte fr kontrollsumman. */
+
+#if MODBUS_FRAME_MAX < 8 || MODBUS_FRAME_MAX > 256
+#error "MODBUS_FRAME_MAX must be between 8 and 256 bytes!"
+#endif
+
+/* Statiska funktioner: */
+static void modbus_receive(void* arg, uint8_t data);
+static inline void modbus_timer_restart(void);
+static inline uint8_t modbus_ticks(const uint32_t time_us);
+static uint16_t modbus_execute(struct modbus* self,
+                               const uint16_t data_length);
+static uint16_t modbus_read_bits(struct modbus* self,
+                                 const uint16_t data_length,
+                                 const uint16_t num_bits,
+                                 enum modbus_exception (*read)(uint16_t, bool*));
+static uint16_t modbus_read_registers(struct modbus* self,
+                                      const uint16_t data_length,
+                                      const uint16_t num_registers,
+                                      enum modbus_exception (*read)(uint16_t, uint16_t*));
+static uint16_t modbus_write_single_coil(struct modbus* self,
+                                         const uint16_t data_length);
+static uint16_t modbus_write_single_register(struct modbus* self,
+                                             const uint16_t data_length);
+static uint16_t modbus_write_multiple_coils(struct modbus* self,
+                                            const uint16_t data_length);
+static uint16_t modbus_write_multiple_registers(struct modbus* self,
+                                                const uint16_t data_length);
+static uint16_t modbus_exception_response(struct modbus* self,
+                                          const enum modbus_exception exception);
+
+/********************************************************************************
+* modbus_get_word: Returnerar ett 16-bitars vrde lagrat med hg byte frst.
+*
+*                  - data: Pekare till vrdet.
+********************************************************************************/
+static inline uint16_t modbus_get_word(const uint8_t* data)
+{
+   return (uint16_t)(data[0] << 8) | data[1];
+}
+
+/********************************************************************************
+* modbus_put_word: Lagrar ett 16-bitars vrde med hg byte frst.
+*
+*                  - data : Pekare till platsen dr vrdet ska lagras.
+*                  - value: Vrdet som ska lagras.
+********************************************************************************/
+static inline void modbus_put_word(uint8_t* data,
+                                   const uint16_t value)
+{
+   data[0] = (uint8_t)(value >> 8);
+   data[1] = (uint8_t)value;
+   return;
+}
+
+/********************************************************************************
+* modbus_init: Initierar Modbus RTU-slav med angiven adress och
+*              registertabell. Seriell verfring initieras med angiven
+*              baud rate och mottagna tecken leds om till slaven. Tiderna
+*              t1.5 och t3.5 rknas om till antal steg fr Timer 2, avrundat
+*              uppt plus ett steg eftersom prescalern inte nollstlls nr
+*              timern startas om. Returnerar 0 vid lyckad initiering, annars
+*              felkod 1 om adressen eller baud rate r ogiltig.
+*
+*              - self     : Pekare till slaven som ska initieras.
+*              - address  : Slavens adress (1 - 247).
+*              - map      : Pekare till registertabellen.
+*              - baud_rate: Baud rate (min 2400, 0 = SERIAL_BAUD_RATE).
+********************************************************************************/
+int modbus_init(struct modbus* self,
+                const uint8_t address,
+                const struct modbus_map* map,
+                uint32_t baud_rate)
+{
+   if (baud_rate == 0) baud_rate = SERIAL_BAUD_RATE;
+
+   if (address == MODBUS_BROADCAST_ADDRESS || address > MODBUS_ADDRESS_MAX ||
+       !map || baud_rate < MODBUS_BAUD_MIN)
+   {
+      return 1;
+   }
+
+   if (baud_rate > MODBUS_FIXED_TIMING_BAUD)
+   {
+      self->char_gap_ticks = modbus_ticks(MODBUS_CHAR_GAP_FIXED_US);
+      self->frame_gap_ticks = modbus_ticks(MODBUS_FRAME_GAP_FIXED_US);
+   }
+   else
+   {
+      self->char_gap_ticks = modbus_ticks(1500000UL * MODBUS_CHAR_BITS / baud_rate);
+      self->frame_gap_ticks = modbus_ticks(3500000UL * MODBUS_CHAR_BITS / baud_rate);
+   }
+
+   self->map = map;
+   self->address = address;
+   self->length = 0;
+   self->invalid = false;
+   self->char_gap = false;
+   self->num_errors = 0;
+   self->state = MODBUS_STATE_IDLE;
+
+   TCCR2B = 0x00;
+   TCCR2A = 0x00;
+   TIMSK2 = 0x00;
+   OCR2A = self->char_gap_ticks;
+   OCR2B = self->frame_gap_ticks;
+
+   serial_init(baud_rate);
+   serial_set_rx_handler(&modbus_receive, self);
+   return 0;
+}
+
+/********************************************************************************
+* modbus_disable: Inaktiverar angiven slav, stnger av Timer 2 och
+*                 terstller mottagning via mottagarbufferten i serial.c.
+*
+*                 - self: Pekare till slaven som ska inaktiveras.
+********************************************************************************/
+void modbus_disable(struct modbus* self)
+{
+   serial_set_rx_handler(0, 0);
+   TCCR2B = 0x00;
+   TIMSK2 = 0x00;
+   self->state = MODBUS_STATE_DISABLED;
+   return;
+}
+
+/********************************************************************************
+* modbus_poll: Tolkar en komplett mottagen ram, om en sdan finns, och
+*              skickar svaret. Ramar med felaktig CRC rknas i num_errors
+*              och ignoreras, likt ramar till andra slavar. CRC berknas
+*              ver hela ramen inklusive mottagen CRC, vilket ger 0 fr en
+*              korrekt ram. Svaret byggs upp i ramens buffert, vilket r
+*              mjligt eftersom nya tecken ignoreras tills ramen r tolkad.
+*
+*              - self: Pekare till slaven.
+********************************************************************************/
+void modbus_poll(struct modbus* self)
+{
+   if (self->state != MODBUS_STATE_READY) return;
+
+   const uint16_t length = self->length;
+   const uint8_t address = self->frame[0];
+
+   if (length < 2 + MODBUS_CRC_SIZE || modbus_crc(self->frame, length) != 0)
+   {
+      self->num_errors++;
+   }
+   else if (address == self->address || address == MODBUS_BROADCAST_ADDRESS)
+   {
+      const uint16_t response_length = modbus_execute(self, length - 2 - MODBUS_CRC_SIZE);
+
+      if (address != MODBUS_BROADCAST_ADDRESS)
+      {
+         const uint16_t crc = modbus_crc(self->frame, response_length);
+         self->frame[response_length] = (uint8_t)crc;
+         self->frame[response_length + 1] = (uint8_t)(crc >> 8);
+         serial_write(self->frame, response_length + MODBUS_CRC_SIZE);
+      }
+   }
+
+   self->state = MODBUS_STATE_IDLE;
+   return;
+}
+
+/********************************************************************************
+* modbus_frame_gap_elapsed: Anropas frn avbrottsrutinen TIMER2_COMPB_vect nr
+*                           t3.5 har passerat sedan senaste mottagna tecken.
+*                           Timern stngs av och en giltig ram markeras som
+*                           komplett, medan en ogiltig ram kasseras.
+*
+*                           - self: Pekare till slaven.
+********************************************************************************/
+void modbus_frame_gap_elapsed(struct modbus* self)
+{
+   TCCR2B = 0x00;
+   TIMSK2 = 0x00;
+
+   if (self->state != MODBUS_STATE_RECEIVING) return;
+
+   if (self->invalid)
+   {
+      self->num_errors++;
+      self->state = MODBUS_STATE_IDLE;
+   }
+   else
+   {
+      self->state = MODBUS_STATE_READY;
+   }
+   return;
+}
+
+/********************************************************************************
+* modbus_receive: Mottagarfunktion som anropas frn USART:ns avbrottsrutin
+*                 fr varje mottaget tecken. Tecknet lagras i ramen och
+*                 Timer 2 startas om. Ett tecken som tas emot efter t1.5,
+*                 eller som inte ryms i ramen, gr ramen ogiltig. Tecken som
+*                 tas emot medan fregende ram tolkas ignoreras.
+*
+*                 - arg : Pekare till slaven.
+*                 - data: Mottaget tecken.
+********************************************************************************/
+static void modbus_receive(void* arg, uint8_t data)
+{
+   struct modbus* self = (struct modbus*)arg;
+
+   if (self->state == MODBUS_STATE_IDLE)
+   {
+      self->length = 0;
+      self->invalid = false;
+      self->state = MODBUS_STATE_RECEIVING;
+   }
+   else if (self->state != MODBUS_STATE_RECEIVING)
+   {
+      return;
+   }
+   else if (self->char_gap)
+   {
+      self->invalid = true;
+   }
+
+   if (self->length < MODBUS_FRAME_MAX)
+   {
+      self->frame[self->length++] = data;
+   }
+   else
+   {
+      self->invalid = true;
+   }
+
+   self->char_gap = false;
+   modbus_timer_restart();
+   return;
+}
+
+/********************************************************************************
+* modbus_timer_restart: Nollstller och startar Timer 2 med prescaler 1024
+*                       samt avbrott vid t1.5 (OCR2A) och t3.5 (OCR2B).
+*                       Eventuella kvarvarande avbrottsflaggor nollstlls.
+********************************************************************************/
+static inline void modbus_timer_restart(void)
+{
+   TCNT2 = 0;
+   TIFR2 = (1 << OCF2A) | (1 << OCF2B);
+   TIMSK2 = (1 << OCIE2A) | (1 << OCIE2B);
+   TCCR2B = (1 << CS22) | (1 << CS21) | (1 << CS20);
+   return;
+}
+
+/********************************************************************************
+* modbus_ticks: Returnerar antalet steg fr Timer 2 som motsvarar minst
+*               angiven tid.
+*
+*               - time_us: Tiden i mikrosekunder.
+********************************************************************************/
+static inline uint8_t modbus_ticks(const uint32_t time_us)
+{
+   return (uint8_t)((time_us + MODBUS_TICK_US - 1) / MODBUS_TICK_US + 1);
+}
+
+/********************************************************************************
+* modbus_execute: Utfr frfrgan i mottagen ram och bygger upp svaret i
+*                 ramens buffert. Returnerar svarets lngd exklusive CRC.
+*
+*                 - self       : Pekare till slaven.
+*                 - data_length: Antalet byte data efter funktionskoden.
+********************************************************************************/
+static uint16_t modbus_execute(struct modbus* self,
+                               const uint16_t data_length)
+{
+   const struct modbus_map* map = self->map;
+
+   switch (self->frame[1])
+   {
+      case MODBUS_READ_COILS:
+         return modbus_read_bits(self, data_length, map->num_coils, map->read_coil);
+      case MODBUS_READ_DISCRETE_INPUTS:
+         return modbus_read_bits(self, data_length, map->num_discrete_inputs, map->read_discrete_input);
+      case MODBUS_READ_HOLDING_REGISTERS:
+         return modbus_read_registers(self, data_length, map->num_holding_registers, map->read_holding_register);
+      case MODBUS_READ_INPUT_REGISTERS:
+         return modbus_read_registers(self, data_length, map->num_input_registers, map->read_input_register);
+      case MODBUS_WRITE_SINGLE_COIL:
+         return modbus_write_single_coil(self, data_length);
+      case MODBUS_WRITE_SINGLE_REGISTER:
+         return modbus_write_single_register(self, data_length);
+      case MODBUS_WRITE_MULTIPLE_COILS:
+         return modbus_write_multiple_coils(self, data_length);
+      case MODBUS_WRITE_MULTIPLE_REGISTERS:
+         return modbus_write_multiple_registers(self, data_length);
+      default:
+         return modbus_exception_response(self, MODBUS_ILLEGAL_FUNCTION);
+   }
+}
+
+/********************************************************************************
+* modbus_read_bits: Utfr lsning av coils eller discrete inputs. Svaret
+*                   bestr av antalet byte fljt av bitarna, packade med
+*                   frsta biten i den minst signifikanta biten.
+*
+*                   - self       : Pekare till slaven.
+*                   - data_length: Antalet byte data i frfrgan.
+*                   - num_bits   : Antalet tillgngliga bitar.
+*                   - read       : Funktion fr lsning av en bit.
+********************************************************************************/
+static uint16_t modbus_read_bits(struct modbus* self,
+                                 const uint16_t data_length,
+                                 const uint16_t num_bits,
+                                 enum modbus_exception (*read)(uint16_t, bool*))
+{
+   if (!read) return modbus_exception_response(self, MODBUS_ILLEGAL_FUNCTION);
+
+   const uint16_t start = modbus_get_word(self->frame + 2);
+   const uint16_t quantity = modbus_get_word(self->frame + 4);
+   const uint16_t num_bytes = (quantity + 7) / 8;
+
+   if (data_length != 4 || quantity == 0 || quantity > MODBUS_READ_BITS_MAX ||
+       3 + num_bytes + MODBUS_CRC_SIZE > MODBUS_FRAME_MAX)
+   {
+      return modbus_exception_response(self, MODBUS_ILLEGAL_DATA_VALUE);
+   }
+   else if ((uint32_t)start + quantity > num_bits)
+   {
+      return modbus_exception_response(self, MODBUS_ILLEGAL_DATA_ADDRESS);
+   }
+
+   uint8_t* bits = self->frame + 3;
+   self->frame[2] = (uint8_t)num_bytes;
+   memset(bits, 0, num_bytes);
+
+   for (uint16_t i = 0; i < quantity; ++i)
+   {
+      bool value = false;
+      const enum modbus_exception exception = read(start + i, &value);
+      if (exception) return modbus_exception_response(self, exception);
+      if (value) bits[i / 8] |= (1 << (i % 8));
+   }
+   return 3 + num_bytes;
+}
+
+/********************************************************************************
+* modbus_read_registers: Utfr lsning av holding eller input registers.
+*                        Svaret bestr av antalet byte fljt av registren
+*                        med hg byte frst.
+*
+*                        - self         : Pekare till slaven.
+*                        - data_length  : Antalet byte data i frfrgan.
+*                        - num_registers: Antalet tillgngliga register.
+*                        - read         : Funktion fr lsning av ett register.
+********************************************************************************/
+static uint16_t modbus_read_registers(struct modbus* self,
+                                      const uint16_t data_length,
+                                      const uint16_t num_registers,
+                                      enum modbus_exception (*read)(uint16_t, uint16_t*))
+{
+   if (!read) return modbus_exception_response(self, MODBUS_ILLEGAL_FUNCTION);
+
+   const uint16_t start = modbus_get_word(self->frame + 2);
+   const uint16_t quantity = modbus_get_word(self->frame + 4);
+
+   if (data_length != 4 || quantity == 0 || quantity > MODBUS_READ_REGISTERS_MAX ||
+       3 + 2 * quantity + MODBUS_CRC_SIZE > MODBUS_FRAME_MAX)
+   {
+      return modbus_exception_response(self, MODBUS_ILLEGAL_DATA_VALUE);
+   }
+   else if ((uint32_t)start + quantity > num_registers)
+   {
+      return modbus_exception_response(self, MODBUS_ILLEGAL_DATA_ADDRESS);
+   }
+
+   self->frame[2] = (uint8_t)(2 * quantity);
+
+   for (uint16_t i = 0; i < quantity; ++i)
+   {
+      uint16_t value = 0;
+      const enum modbus_exception exception = read(start + i, &value);
+      if (exception) return modbus_exception_response(self, exception);
+      modbus_put_word(self->frame + 3 + 2 * i, value);
+   }
+   return 3 + 2 * quantity;
+}
+
+/********************************************************************************
+* modbus_write_single_coil: Utfr skrivning av en coil, dr vrdet 0xFF00
+*                           tnder och 0x0000 slcker. Svaret utgrs av
+*                           frfrgan i ofrndrat skick.
+*
+*                           - self       : Pekare till slaven.
+*                           - data_length: Antalet byte data i frfrgan.
+********************************************************************************/
+static uint16_t modbus_write_single_coil(struct modbus* self,
+                                         const uint16_t data_length)
+{
+   if (!self->map->write_coil) return modbus_exception_response(self, MODBUS_ILLEGAL_FUNCTION);
+
+   const uint16_t address = modbus_get_word(self->frame + 2);
+   const uint16_t value = modbus_get_word(self->frame + 4);
+
+   if (data_length != 4 || (value != MODBUS_COIL_ON && value != MODBUS_COIL_OFF))
+   {
+      return modbus_exception_response(self, MODBUS_ILLEGAL_DATA_VALUE);
+   }
+   else if (address >= self->map->num_coils)
+   {
+      return modbus_exception_response(self, MODBUS_ILLEGAL_DATA_ADDRESS);
+   }
+
+   const enum modbus_exception exception = self->map->write_coil(address, value == MODBUS_COIL_ON);
+   if (exception) return modbus_exception_response(self, exception);
+   return 6;
+}
+
+/********************************************************************************
+* modbus_write_single_register: Utfr skrivning av ett holding register.
+*                               Svaret utgrs av frfrgan i ofrndrat
+*                               skick.
+*
+*                               - self       : Pekare till slaven.
+*                               - data_length: Antalet byte data i frfrgan.
+********************************************************************************/
+static uint16_t modbus_write_single_register(struct modbus* self,
+                                             const uint16_t data_length)
+{
+   if (!self->map->write_holding_register) return modbus_exception_response(self, MODBUS_ILLEGAL_FUNCTION);
+
+   const uint16_t address = modbus_get_word(self->frame + 2);
+
+   if (data_length != 4)
+   {
+      return modbus_exception_response(self, MODBUS_ILLEGAL_DATA_VALUE);
+   }
+   else if (address >= self->map->num_holding_registers)
+   {
+      return modbus_exception_response(self, MODBUS_ILLEGAL_DATA_ADDRESS);
+   }
+
+   const enum modbus_exception exception =
+      self->map->write_holding_register(address, modbus_get_word(self->frame + 4));
+   if (exception) return modbus_exception_response(self, exception);
+   return 6;
+}
+
+/********************************************************************************
+* modbus_write_multiple_coils: Utfr skrivning av flera coils. Svaret bestr
+*                              av startadressen samt antalet skrivna coils.
+*
+*                              - self       : Pekare till slaven.
+*                              - data_length: Antalet byte data i frfrgan.
+********************************************************************************/
+static uint16_t modbus_write_multiple_coils(struct modbus* self,
+                                            const uint16_t data_length)
+{
+   if (!self->map->write_coil) return modbus_exception_response(self, MODBUS_ILLEGAL_FUNCTION);
+
+   const uint16_t start = modbus_get_word(self->frame + 2);
+   const uint16_t quantity = modbus_get_word(self->frame + 4);
+   const uint8_t num_bytes = self->frame[6];
+   const uint8_t* bits = self->frame + 7;
+
+   if (data_length < 5 || quantity == 0 || quantity > MODBUS_WRITE_BITS_MAX ||
+       num_bytes != (quantity + 7) / 8 || data_length != 5 + num_bytes)
+   {
+      return modbus_exception_response(self, MODBUS_ILLEGAL_DATA_VALUE);
+   }
+   else if ((uint32_t)start + quantity > self->map->num_coils)
+   {
+      return modbus_exception_response(self, MODBUS_ILLEGAL_DATA_ADDRESS);
+   }
+
+   for (uint16_t i = 0; i < quantity; ++i)
+   {
+      const bool value = bits[i / 8] & (1 << (i % 8));
+      const enum modbus_exception exception = self->map->write_coil(start + i, value);
+      if (exception) return modbus_exception_response(self, exception);
+   }
+   return 6;
+}
+
+/********************************************************************************
+* modbus_write_multiple_registers: Utfr skrivning av flera holding
+*                                  registers. Svaret bestr av startadressen
+*                                  samt antalet skrivna register.
+*
+*                                  - self       : Pekare till slaven.
+*                                  - data_length: Antalet byte data i
+*                                                 frfrgan.
+********************************************************************************/
+static uint16_t modbus_write_multiple_registers(struct modbus* self,
+                                                const uint16_t data_length)
+{
+   if (!self->map->write_holding_register) return modbus_exception_response(self, MODBUS_ILLEGAL_FUNCTION);
+
+   const uint16_t start = modbus_get_word(self->frame + 2);
+   const uint16_t quantity = modbus_get_word(self->frame + 4);
+   const uint8_t num_bytes = self->frame[6];
+   const uint8_t* values = self->frame + 7;
+
+   if (data_length < 5 || quantity == 0 || quantity > MODBUS_WRITE_REGISTERS_MAX ||
+       num_bytes != 2 * quantity || data_length != 5 + num_bytes)
+   {
+      return modbus_exception_response(self, MODBUS_ILLEGAL_DATA_VALUE);
+   }
+   else if ((uint32_t)start + quantity > self->map->num_holding_registers)
+   {
+      return modbus_exception_response(self, MODBUS_ILLEGAL_DATA_ADDRESS);
+   }
+
+   for (uint16_t i = 0; i < quantity; ++i)
+   {
+      const enum modbus_exception exception =
+         self->map->write_holding_register(start + i, modbus_get_word(values + 2 * i));
+      if (exception) return modbus_exception_response(self, exception);
+   }
+   return 6;
+}
+
+/********************************************************************************
+* modbus_exception_response: Bygger upp ett undantagssvar, dr den hgsta
+*                            biten i funktionskoden stts fljt av
+*                            undantagskoden. Returnerar svarets lngd.
+*
+*                            - self     : Pekare till slaven.
+*                            - exception: Undantagskoden.
+********************************************************************************/
+static uint16_t modbus_exception_response(struct modbus* self,
+                                          const enum modbus_exception exception)
+{
+   self->frame[1] |= MODBUS_EXCEPTION_FLAG;
+   self->frame[2] = (uint8_t)exception;
+   return 3;
+}
\ No newline at end of file
@@ -0,0 +1,201 @@
+/********************************************************************************
+* modbus.h: Innehller drivrutiner fr en Modbus RTU-slav via USART, vilket
+*           mjliggr avlsning och styrning av systemet frn en PLC eller
+*           annan Modbus-master.
+*
+*           En ram bestr av slavadress, funktionskod, data samt CRC16
+*           (polynom 0xA001, startvrde 0xFFFF, lg byte frst), dr ramar
+*           avgrnsas av tystnad p linjen. Mottagna tecken tas emot direkt
+*           i USART:ns avbrottsrutin via serial_set_rx_handler, dr Timer 2
+*           startas om efter varje tecken:
+*
+*           - Efter 1.5 teckentider utan nytt tecken (t1.5) ska ramen vara
+*             slut. Ett tecken som tas emot drefter men innan t3.5 gr
+*             ramen ogiltig.
+*           - Efter 3.5 teckentider (t3.5) r ramen komplett och tolkas sedan
+*             i huvudprogrammet via modbus_poll.
+*
+*           ver 19200 baud anvnds de fasta tiderna 750 us respektive
+*           1750 us enligt Modbus-specifikationen. Timer 2 rknar med
+*           prescaler 1024 (64 us per steg), vilket ger en lgsta baud rate
+*           p 2400 baud. Timer 2 r drmed reserverad fr Modbus nr slaven
+*           r aktiverad, och realtidsklockan i rtc.h ska d drivas frn
+*           systemets klocka (RTC_SOURCE_SYSTEM). Motsvarande
+*           avbrottsrutiner TIMER2_COMPA_vect och TIMER2_COMPB_vect ska
+*           anropa modbus_char_gap_elapsed respektive
+*           modbus_frame_gap_elapsed, se isr.c.
+*
+*           Fljande funktionskoder stds:
+*
+*           0x01 Read Coils                  0x05 Write Single Coil
+*           0x02 Read Discrete Inputs        0x06 Write Single Register
+*           0x03 Read Holding Registers      0x0F Write Multiple Coils
+*           0x04 Read Input Registers        0x10 Write Multiple Registers
+*
+*           Vilka adresser som finns samt deras innebrd anges av
+*           applikationen via en registertabell (struct modbus_map), se
+*           modbus_map.c. Frfrgningar till broadcast-adressen 0 utfrs
+*           utan svar.
+********************************************************************************/
+#ifndef MODBUS_H_
+#define MODBUS_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "serial.h"
+#include <util/crc16.h>
+
+/* Makrodefinitioner: */
+#ifndef MODBUS_FRAME_MAX
+#define MODBUS_FRAME_MAX 128 /* Maximal ramstorlek i byte (max 256). */
+#endif
+
+#define MODBUS_BROADCAST_ADDRESS 0 /* Adress fr frfrgningar till samtliga slavar. */
+#define MODBUS_ADDRESS_MAX 247     /* Hgsta tilltna slavadress. */
+
+/********************************************************************************
+* modbus_exception: Enumeration fr undantagskoder som returneras till
+*                   mastern nr en frfrgan inte kan utfras.
+********************************************************************************/
+enum modbus_exception
+{
+   MODBUS_OK = 0,                     /* Frfrgan utfrdes. */
+   MODBUS_ILLEGAL_FUNCTION = 1,       /* Funktionskoden stds inte. */
+   MODBUS_ILLEGAL_DATA_ADDRESS = 2,   /* Adressen finns inte. */
+   MODBUS_ILLEGAL_DATA_VALUE = 3,     /* Ogiltigt vrde eller antal. */
+   MODBUS_SLAVE_DEVICE_FAILURE = 4    /* Fel uppstod vid utfrandet. */
+};
+
+/********************************************************************************
+* modbus_state: Enumeration fr slavens mottagningstillstnd.
+********************************************************************************/
+enum modbus_state
+{
+   MODBUS_STATE_DISABLED,  /* Slaven r inte aktiverad. */
+   MODBUS_STATE_IDLE,      /* Vntar p frsta tecknet i nsta ram. */
+   MODBUS_STATE_RECEIVING, /* Tar emot en ram. */
+   MODBUS_STATE_READY      /* En komplett ram vntar p att tolkas. */
+};
+
+/********************************************************************************
+* modbus_map: Strukt fr slavens registertabell, som anger antalet adresser
+*             av varje slag samt funktioner fr lsning och skrivning.
+*             Adresser utanfr angivet antal avvisas innan funktionerna
+*             anropas. Funktionerna returnerar MODBUS_OK vid lyckad
+*             lsning/skrivning, annars en undantagskod. Funktioner som
+*             saknas (0) medfr att motsvarande funktionskoder avvisas.
+********************************************************************************/
+struct modbus_map
+{
+   uint16_t num_coils;             /* Antalet coils (ls- och skrivbara bitar). */
+   uint16_t num_discrete_inputs;   /* Antalet discrete inputs (lsbara bitar). */
+   uint16_t num_holding_registers; /* Antalet holding registers (ls- och skrivbara). */
+   uint16_t num_input_registers;   /* Antalet input registers (lsbara). */
+   enum modbus_exception (*read_coil)(uint16_t address, bool* value);
+   enum modbus_exception (*write_coil)(uint16_t address, bool value);
+   enum modbus_exception (*read_discrete_input)(uint16_t address, bool* value);
+   enum modbus_exception (*read_holding_register)(uint16_t address, uint16_t* value);
+   enum modbus_exception (*write_holding_register)(uint16_t address, uint16_t value);
+   enum modbus_exception (*read_input_register)(uint16_t address, uint16_t* value);
+};
+
+/********************************************************************************
+* modbus: Strukt fr Modbus RTU-slav.
+********************************************************************************/
+struct modbus
+{
+   const struct modbus_map* map;     /* Pekare till registertabellen. */
+   uint8_t frame[MODBUS_FRAME_MAX];  /* Buffert fr mottagen ram och svar. */
+   volatile uint16_t length;         /* Antalet byte i mottagen ram. */
+   volatile enum modbus_state state; /* Mottagningstillstnd. */
+   volatile bool invalid;            /* Indikerar att mottagen ram r ogiltig. */
+   volatile bool char_gap;           /* Indikerar att t1.5 har passerat. */
+   uint8_t address;                  /* Slavens adress (1 - 247). */
+   uint8_t char_gap_ticks;           /* Antal timersteg fr t1.5. */
+   uint8_t frame_gap_ticks;          /* Antal timersteg fr t3.5. */
+   uint16_t num_errors;              /* Antalet kasserade ramar (CRC- eller ramfel). */
+};
+
+/********************************************************************************
+* modbus_init: Initierar Modbus RTU-slav med angiven adress och
+*              registertabell. Seriell verfring initieras med angiven
+*              baud rate och mottagna tecken leds om till slaven, vilket
+*              innebr att serial_read_char inte lngre tar emot ngra
+*              tecken. Returnerar 0 vid lyckad initiering, annars felkod 1
+*              om adressen eller baud rate r ogiltig.
+*
+*              - self     : Pekare till slaven som ska initieras.
+*              - address  : Slavens adress (1 - 247).
+*              - map      : Pekare till registertabellen.
+*              - baud_rate: Baud rate (min 2400, 0 = SERIAL_BAUD_RATE).
+********************************************************************************/
+int modbus_init(struct modbus* self,
+                const uint8_t address,
+                const struct modbus_map* map,
+                uint32_t baud_rate);
+
+/********************************************************************************
+* modbus_disable: Inaktiverar angiven slav och terstller mottagning via
+*                 mottagarbufferten i serial.c.
+*
+*                 - self: Pekare till slaven som ska inaktiveras.
+********************************************************************************/
+void modbus_disable(struct modbus* self);
+
+/********************************************************************************
+* modbus_enabled: Indikerar ifall angiven slav r aktiverad.
+*
+*                 - self: Pekare till slaven.
+********************************************************************************/
+static inline bool modbus_enabled(const struct modbus* self)
+{
+   return self->state != MODBUS_STATE_DISABLED;
+}
+
+/********************************************************************************
+* modbus_poll: Tolkar en komplett mottagen ram, om en sdan finns, och
+*              skickar svaret. Ramar med felaktig CRC eller annan adress
+*              ignoreras. Funktionen blockerar inte och ska anropas
+*              kontinuerligt frn huvudprogrammet.
+*
+*              - self: Pekare till slaven.
+********************************************************************************/
+void modbus_poll(struct modbus* self);
+
+/********************************************************************************
+* modbus_char_gap_elapsed: Anropas frn avbrottsrutinen TIMER2_COMPA_vect nr
+*                          t1.5 har passerat sedan senaste mottagna tecken.
+*
+*                          - self: Pekare till slaven.
+********************************************************************************/
+static inline void modbus_char_gap_elapsed(struct modbus* self)
+{
+   self->char_gap = true;
+   return;
+}
+
+/********************************************************************************
+* modbus_frame_gap_elapsed: Anropas frn avbrottsrutinen TIMER2_COMPB_vect nr
+*                           t3.5 har passerat sedan senaste mottagna tecken.
+*                           Timern stngs av och en giltig ram markeras som
+*                           komplett, medan en ogiltig ram kasseras.
+*
+*                           - self: Pekare till slaven.
+********************************************************************************/
+void modbus_frame_gap_elapsed(struct modbus* self);
+
+/********************************************************************************
+* modbus_crc: Berknar Modbus CRC16 fr angivet antal byte.
+*
+*             - data  : Pekare till datan.
+*             - length: Antalet byte.
+********************************************************************************/
+static inline uint16_t modbus_crc(const uint8_t* data,
+                                  uint16_t length)
+{
+   uint16_t crc = 0xFFFF;
+   while (length--) crc = _crc16_update(crc, *data++);
+   return crc;
+}
+
+#endif /* MODBUS_H_ */
\ No newline at end of file
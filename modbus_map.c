@@ -0,0 +1,207 @@
+/********************************************************************************
+* modbus_map.c: Innehller registertabellen fr Modbus-slaven modbus1, vilket
+*               mjliggr avlsning och styrning av systemet frn en PLC.
+*               Fljande adresser finns:
+*
+*               Coils (ls och skriv):
+*               0 - 2   Lysdioder l1 - l3. Skrivning har endast bestende
+*                       effekt nr PWM-styrning r inaktiverad.
+*               3       PWM-styrning av lysdioderna aktiverad.
+*
+*               Discrete inputs (ls):
+*               0       Tryckknapp b1 nedtryckt.
+*
+*               Holding registers (ls och skriv):
+*               0       PWM-periodtid i mikrosekunder (1 - 65535).
+*               1       Fast duty cycle i promille (0 - 1000), 65535 = styrs
+*                       av potentiometern.
+*               2       Slavadress (1 - 247) lagrad i EEPROM, gller efter
+*                       omstart. 0 medfr att kommandotolken anvnds i stllet
+*                       fr Modbus efter omstart.
+*               3       Antalet Watchdog timeouts lagrat i EEPROM (0 - 255).
+*
+*               Input registers (ls):
+*               0 - 5   AD-omvandlat vrde frn analog pin A0 - A5 (0 - 1023).
+*               6       Temperatur frn TMP36 i hundradels grader Celcius
+*                       (signerat).
+********************************************************************************/
+#include "header.h"
+
+/* Makrodefinitioner: */
+#define COIL_PWM_ENABLED 3                    /* Coil fr aktivering av PWM-styrning. */
+#define NUM_COILS 4                           /* Antalet coils. */
+#define NUM_DISCRETE_INPUTS 1                 /* Antalet discrete inputs. */
+#define HOLDING_REGISTER_PWM_PERIOD_US 0      /* PWM-periodtid i mikrosekunder. */
+#define HOLDING_REGISTER_PWM_DUTY_OVERRIDE 1  /* Fast duty cycle i promille. */
+#define HOLDING_REGISTER_SLAVE_ADDRESS 2      /* Slavadress lagrad i EEPROM. */
+#define HOLDING_REGISTER_TIMEOUTS 3           /* Antalet Watchdog timeouts lagrat i EEPROM. */
+#define NUM_HOLDING_REGISTERS 4               /* Antalet holding registers. */
+#define INPUT_REGISTER_TEMPERATURE 6          /* Temperatur frn TMP36. */
+#define NUM_INPUT_REGISTERS 7                 /* Antalet input registers. */
+
+/* Statiska funktioner: */
+static enum modbus_exception read_coil(uint16_t address, bool* value);
+static enum modbus_exception write_coil(uint16_t address, bool value);
+static enum modbus_exception read_discrete_input(uint16_t address, bool* value);
+static enum modbus_exception read_holding_register(uint16_t address, uint16_t* value);
+static enum modbus_exception write_holding_register(uint16_t address, uint16_t value);
+static enum modbus_exception read_input_register(uint16_t address, uint16_t* value);
+
+/* Registertabell: */
+const struct modbus_map modbus_map =
+{
+   NUM_COILS,
+   NUM_DISCRETE_INPUTS,
+   NUM_HOLDING_REGISTERS,
+   NUM_INPUT_REGISTERS,
+   &read_coil,
+   &write_coil,
+   &read_discrete_input,
+   &read_holding_register,
+   &write_holding_register,
+   &read_input_register
+};
+
+/* Statiska variabler: */
+static struct led* const leds[] = { &l1, &l2, &l3 }; /* Lysdioder som utgr coils 0 - 2. */
+
+/********************************************************************************
+* read_coil: Lser av angiven lysdiod eller ifall PWM-styrning r aktiverad.
+*
+*            - address: Coilens adress.
+*            - value  : Pekare till variabel dr vrdet lagras.
+********************************************************************************/
+static enum modbus_exception read_coil(uint16_t address, bool* value)
+{
+   if (address == COIL_PWM_ENABLED)
+   {
+      *value = pwm1.enabled;
+   }
+   else
+   {
+      *value = led_enabled(leds[address]);
+   }
+   return MODBUS_OK;
+}
+
+/********************************************************************************
+* write_coil: Tnder eller slcker angiven lysdiod, alternativt aktiverar
+*             eller inaktiverar PWM-styrning.
+*
+*             - address: Coilens adress.
+*             - value  : Nytt vrde.
+********************************************************************************/
+static enum modbus_exception write_coil(uint16_t address, bool value)
+{
+   if (address == COIL_PWM_ENABLED)
+   {
+      if (value) pwm_enable(&pwm1);
+      else pwm_disable(&pwm1);
+   }
+   else if (value)
+   {
+      led_on(leds[address]);
+   }
+   else
+   {
+      led_off(leds[address]);
+   }
+   return MODBUS_OK;
+}
+
+/********************************************************************************
+* read_discrete_input: Lser av tryckknapp b1.
+*
+*                      - address: Adressen (endast 0).
+*                      - value  : Pekare till variabel dr vrdet lagras.
+********************************************************************************/
+static enum modbus_exception read_discrete_input(uint16_t address, bool* value)
+{
+   (void)address;
+   *value = button_is_pressed(&b1);
+   return MODBUS_OK;
+}
+
+/********************************************************************************
+* read_holding_register: Lser av angivet holding register.
+*
+*                        - address: Registrets adress.
+*                        - value  : Pekare till variabel dr vrdet lagras.
+********************************************************************************/
+static enum modbus_exception read_holding_register(uint16_t address, uint16_t* value)
+{
+   if (address == HOLDING_REGISTER_PWM_PERIOD_US)
+   {
+      *value = pwm1.period_us;
+   }
+   else if (address == HOLDING_REGISTER_PWM_DUTY_OVERRIDE)
+   {
+      *value = pwm1.duty_override;
+   }
+   else if (address == HOLDING_REGISTER_SLAVE_ADDRESS)
+   {
+      const uint8_t slave_address = eeprom_read_byte(MODBUS_ADDRESS_ADDRESS);
+      *value = slave_address <= MODBUS_ADDRESS_MAX ? slave_address : 0;
+   }
+   else
+   {
+      *value = eeprom_read_byte(TIMEOUT_ADDRESS);
+   }
+   return MODBUS_OK;
+}
+
+/********************************************************************************
+* write_holding_register: Skriver till angivet holding register. Ogiltiga
+*                         vrden avvisas, medan misslyckad skrivning till
+*                         EEPROM-minnet rapporteras som fel i slaven.
+*
+*                         - address: Registrets adress.
+*                         - value  : Nytt vrde.
+********************************************************************************/
+static enum modbus_exception write_holding_register(uint16_t address, uint16_t value)
+{
+   if (address == HOLDING_REGISTER_PWM_PERIOD_US)
+   {
+      if (value == 0) return MODBUS_ILLEGAL_DATA_VALUE;
+      pwm1.period_us = value;
+   }
+   else if (address == HOLDING_REGISTER_PWM_DUTY_OVERRIDE)
+   {
+      if (value > PWM_DUTY_MAX && value != PWM_DUTY_OVERRIDE_NONE) return MODBUS_ILLEGAL_DATA_VALUE;
+      pwm1.duty_override = value;
+   }
+   else if (address == HOLDING_REGISTER_SLAVE_ADDRESS)
+   {
+      if (value > MODBUS_ADDRESS_MAX) return MODBUS_ILLEGAL_DATA_VALUE;
+      if (eeprom_write_byte(MODBUS_ADDRESS_ADDRESS, (uint8_t)value)) return MODBUS_SLAVE_DEVICE_FAILURE;
+   }
+   else
+   {
+      if (value > UINT8_MAX) return MODBUS_ILLEGAL_DATA_VALUE;
+      if (eeprom_write_byte(TIMEOUT_ADDRESS, (uint8_t)value)) return MODBUS_SLAVE_DEVICE_FAILURE;
+   }
+   return MODBUS_OK;
+}
+
+/********************************************************************************
+* read_input_register: Lser av angiven analog pin eller temperaturen frn
+*                      temperatursensor temp1.
+*
+*                      - address: Registrets adress.
+*                      - value  : Pekare till variabel dr vrdet lagras.
+********************************************************************************/
+static enum modbus_exception read_input_register(uint16_t address, uint16_t* value)
+{
+   if (address == INPUT_REGISTER_TEMPERATURE)
+   {
+      const double temperature = tmp36_get_temperature(&temp1) * 100;
+      *value = (uint16_t)(int16_t)(temperature < 0 ? temperature - 0.5 : temperature + 0.5);
+   }
+   else
+   {
+      struct adc input;
+      adc_init(&input, (uint8_t)address);
+      *value = adc_read(&input);
+   }
+   return MODBUS_OK;
+}
\ No newline at end of file
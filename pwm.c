@@ -6,6 +6,10 @@
 
 /* Statiska funktioner: */
 static inline void pwm_run_cycle(struct pwm* self);
+static void pwm_update(struct pwm* self);
+static void pwm_update_hardware(struct pwm* self);
+static void pwm_stagger_restart(struct pwm* self);
+static void pwm_poll_staggered(struct pwm* self);
 
 /********************************************************************************
 * pwm_init: Initierar PWM-kontroller fr PWM-styrning av angiven utenhet via
@@ -27,9 +31,19 @@ void pwm_init(struct pwm* self,
 {
    adc_init(&self->input, input_pin);
    self->period_us = period_us;
+   self->duty_override = PWM_DUTY_OVERRIDE_NONE;
    self->output = output;
    self->output_high = output_high;
    self->output_low = output_low;
+   self->hardware = 0;
+   self->stagger = 0;
+   self->curve = BRIGHTNESS_CURVE_LINEAR;
+   self->duty = 0;
+   self->next_edge_us = 0;
+   self->next_sample_ms = 0;
+   self->sample_ms = PWM_SAMPLE_MS;
+   self->output_on = false;
+   self->running = false;
    self->enabled = true;
    return;
 }
@@ -43,24 +57,45 @@ void pwm_clear(struct pwm* self)
 {
    adc_clear(&self->input);
    self->period_us = 0;
+   self->duty_override = PWM_DUTY_OVERRIDE_NONE;
    self->output = 0;
    self->output_high = 0;
    self->output_low = 0;
+   self->hardware = 0;
+   self->stagger = 0;
+   self->curve = BRIGHTNESS_CURVE_LINEAR;
+   self->duty = 0;
+   self->next_edge_us = 0;
+   self->next_sample_ms = 0;
+   self->sample_ms = 0;
+   self->output_on = false;
+   self->running = false;
    self->enabled = false;
    return;
 }
 
 /********************************************************************************
 * pwm_run: Kr angiven PWM-kontroller under en period och styr ansluten utenhet,
-*          frutsatt att PWM-kontrollern r aktiverad.
+*          frutsatt att PWM-kontrollern r aktiverad. On-tiden berknas
+*          frn en fast duty cycle om duty_override r satt, annars frn
+*          den analoga insignalen. Vid PWM i hrdvara verfrs endast ny
+*          duty cycle till PWM-generatorn.
 *
 *          - self: Pekare till PWM-kontrollern som ska kras.
 ********************************************************************************/
 void pwm_run(struct pwm* self)
 {
    if (!self->enabled) return;
-   adc_get_pwm_values(&self->input, self->period_us);
-   pwm_run_cycle(self);
+   pwm_update(self);
+
+   if (self->hardware)
+   {
+      pwm_update_hardware(self);
+   }
+   else
+   {
+      pwm_run_cycle(self);
+   }
    return;
 }
 
@@ -76,18 +111,182 @@ void pwm_run(struct pwm* self)
 *                                        periodtid som ansluten utenhet ska
 *                                        vara aktiverad, mellan 0 - 1.
 ********************************************************************************/
-void pwm_run_with_duty_cycle(struct pwm* self, 
+void pwm_run_with_duty_cycle(struct pwm* self,
                              const double duty_cycle)
 {
    if (!self->enabled || duty_cycle < 0 || duty_cycle > 1) return;
    self->input.pwm_on_us = (uint16_t)(self->period_us * duty_cycle + 0.5);
    self->input.pwm_off_us = self->period_us - self->input.pwm_on_us;
-   pwm_run_cycle(self);
+   self->duty = (uint16_t)(duty_cycle * PWM_HW_DUTY_MAX + 0.5);
+
+   if (self->hardware)
+   {
+      pwm_update_hardware(self);
+   }
+   else
+   {
+      pwm_run_cycle(self);
+   }
    return;
 }
 
 /********************************************************************************
-* pwm_run_cycle: Kr utenhet ansluten till angiven PWM-kontroller under en 
+* pwm_run_async: Kr angiven PWM-kontroller period efter period s lnge den
+*                r aktiverad, dr on- och off-tiden vntas ut via await_us
+*                i stllet fr frdrjningsloopar. Vid PWM i hrdvara
+*                uppdateras i stllet duty cycle med jmna mellanrum.
+*
+*                - self: Pekare till PWM-kontrollern som ska kras.
+*                - co  : Pekare till coroutinens tillstnd.
+********************************************************************************/
+enum coroutine_state pwm_run_async(struct pwm* self,
+                                   struct coroutine* co)
+{
+   coroutine_begin(co);
+
+   while (self->enabled)
+   {
+      pwm_update(self);
+
+      if (self->hardware)
+      {
+         pwm_update_hardware(self);
+         await_ms(co, self->sample_ms);
+         continue;
+      }
+
+      self->output_high(self->output);
+      await_us(co, self->input.pwm_on_us);
+      self->output_low(self->output);
+      await_us(co, self->input.pwm_off_us);
+   }
+
+   coroutine_end(co);
+}
+
+/********************************************************************************
+* pwm_poll: Avancerar angiven PWM-kontrollers tillstndsmaskin. Vid frsta
+*           anropet efter initiering eller aktivering startas en ny period
+*           direkt. I brjan av varje period lses insignalen av om
+*           avlsningsintervallet har passerat, varefter nsta flank
+*           rknas frn tidpunkten efter avlsningen, s att AD-omvandlingens
+*           frdrjning inte frkortar on-tiden. Vid 0 % respektive 100 %
+*           duty cycle hlls utenheten slckt respektive tnd hela perioden,
+*           utan korta pulser vid periodskiftet.
+*
+*           - self: Pekare till PWM-kontrollern som ska kras.
+********************************************************************************/
+void pwm_poll(struct pwm* self)
+{
+   if (!self->enabled) return;
+
+   if (!self->running)
+   {
+      self->running = true;
+      self->output_on = false;
+      self->next_edge_us = time_us();
+      self->next_sample_ms = time_ms();
+      if (self->stagger) pwm_stagger_restart(self);
+   }
+
+   if (self->hardware)
+   {
+      if (time_reached_ms(self->next_sample_ms))
+      {
+         pwm_update(self);
+         pwm_update_hardware(self);
+         self->next_sample_ms = time_ms() + self->sample_ms;
+      }
+      return;
+   }
+
+   if (self->stagger)
+   {
+      pwm_poll_staggered(self);
+      return;
+   }
+
+   const uint32_t now_us = time_us();
+   if (time_before(now_us, self->next_edge_us)) return;
+
+   if (now_us - self->next_edge_us > self->period_us)
+   {
+      self->next_edge_us = now_us;
+   }
+
+   if (self->output_on && self->input.pwm_off_us)
+   {
+      self->output_low(self->output);
+      self->output_on = false;
+      self->next_edge_us += self->input.pwm_off_us;
+      return;
+   }
+
+   if (time_reached_ms(self->next_sample_ms))
+   {
+      pwm_update(self);
+      self->next_sample_ms = time_ms() + self->sample_ms;
+      self->next_edge_us = time_us();
+   }
+
+   if (self->input.pwm_on_us)
+   {
+      if (!self->output_on) self->output_high(self->output);
+      self->output_on = true;
+      self->next_edge_us += self->input.pwm_on_us;
+   }
+   else
+   {
+      if (self->output_on) self->output_low(self->output);
+      self->output_on = false;
+      self->next_edge_us += self->input.pwm_off_us;
+   }
+
+   return;
+}
+
+/********************************************************************************
+* pwm_set_staggered: Ansluter angiven vektor fr fasfrskjuten PWM. Samtliga
+*                    lysdioder slcks och en ny period startas vid nsta
+*                    anrop av pwm_poll. Med en PWM-generator i hrdvara
+*                    ansluten avvisas fasfrskjuten PWM utan att utsignalen
+*                    rrs, d den drivs av timern.
+*
+*                    - self   : Pekare till PWM-kontrollern.
+*                    - stagger: Pekare till tillstndet (eller 0).
+*                    - leds   : Pekare till vektorn med lysdioderna.
+********************************************************************************/
+int pwm_set_staggered(struct pwm* self,
+                      struct pwm_stagger* stagger,
+                      struct led_vector* leds)
+{
+   if (self->hardware)
+   {
+      if (stagger) return 1;
+      self->stagger = 0;
+      return 0;
+   }
+
+   if (self->stagger) led_vector_off(self->stagger->leds);
+   else if (self->output_low) self->output_low(self->output);
+
+   self->stagger = stagger;
+   self->running = false;
+
+   if (stagger)
+   {
+      stagger->leds = leds;
+      stagger->on_mask = 0;
+      stagger->num_on = 0;
+      stagger->peak_on = 0;
+      led_vector_off(leds);
+   }
+
+   return 0;
+}
+
+/********************************************************************************
+* pwm_run_cycle: Kr utenhet ansluten till angiven PWM-kontroller under en
 *                PWM-period med befintliga PWM-vrden.
 *
 *                - self: Pekare till PWM-kontrollern vars anslutna utenhet
@@ -99,5 +298,161 @@ static inline void pwm_run_cycle(struct pwm* self)
    delay_us(self->input.pwm_on_us);
    self->output_low(self->output);
    delay_us(self->input.pwm_off_us);
+   return;
+}
+
+/********************************************************************************
+* pwm_update: Berknar duty cycle samt on- och off-tid fr nsta period frn
+*             en fast duty cycle om duty_override r satt, annars frn den
+*             analoga insignalen. Vid linjr kurva anvnds
+*             adc_get_pwm_values, annars sls duty cycle upp i vald kurvas
+*             tabell, varefter on-tiden berknas med heltalsaritmetik.
+*
+*             - self: Pekare till PWM-kontrollern.
+********************************************************************************/
+static void pwm_update(struct pwm* self)
+{
+   if (self->duty_override <= PWM_DUTY_MAX)
+   {
+      self->duty = (uint16_t)(((uint32_t)self->duty_override * PWM_HW_DUTY_MAX + PWM_DUTY_MAX / 2) / PWM_DUTY_MAX);
+      self->input.pwm_on_us = (uint16_t)(((uint32_t)self->period_us * self->duty_override +
+                                          PWM_DUTY_MAX / 2) / PWM_DUTY_MAX);
+      self->input.pwm_off_us = self->period_us - self->input.pwm_on_us;
+   }
+   else if (self->curve != BRIGHTNESS_CURVE_LINEAR)
+   {
+      self->duty = brightness_16(self->curve, (uint8_t)(adc_read(&self->input) >> 2));
+      self->input.pwm_on_us = (uint16_t)(((uint32_t)self->period_us * self->duty +
+                                          PWM_HW_DUTY_MAX / 2) / PWM_HW_DUTY_MAX);
+      self->input.pwm_off_us = self->period_us - self->input.pwm_on_us;
+   }
+   else
+   {
+      adc_get_pwm_values(&self->input, self->period_us);
+      self->duty = self->period_us ? (uint16_t)(((uint32_t)self->input.pwm_on_us * PWM_HW_DUTY_MAX +
+                                                 self->period_us / 2) / self->period_us) : 0;
+   }
+
+   return;
+}
+
+/********************************************************************************
+* pwm_update_hardware: verfr aktuell duty cycle till ansluten
+*                      PWM-generator, med full upplsning oberoende av
+*                      periodtiden.
+*
+*                      - self: Pekare till PWM-kontrollern.
+********************************************************************************/
+static void pwm_update_hardware(struct pwm* self)
+{
+   pwm_hw_set_duty(self->hardware, self->duty);
+   return;
+}
+
+/********************************************************************************
+* pwm_stagger_restart: Slcker samtliga lysdioder och startar en ny period
+*                      vid aktuell tidpunkt, dr lysdiod 0 tnds frst.
+*
+*                      - self: Pekare till PWM-kontrollern.
+********************************************************************************/
+static void pwm_stagger_restart(struct pwm* self)
+{
+   struct pwm_stagger* stagger = self->stagger;
+   led_vector_off(stagger->leds);
+   stagger->on_start_us = time_us();
+   stagger->off_start_us = stagger->on_start_us;
+   stagger->on_index = 0;
+   stagger->off_index = 0;
+   stagger->on_mask = 0;
+   stagger->num_on = 0;
+   return;
+}
+
+/********************************************************************************
+* pwm_poll_staggered: Genomfr samtliga flanker som har ntts vid
+*                     fasfrskjuten PWM. Tndningar och slckningar
+*                     schemalggs var fr sig via ett index per flanktyp,
+*                     dr lysdiod k tnds vid periodstart + k * periodtid / n
+*                     och slcks on-tiden senare, drmed kostar varje flank
+*                     lika mycket oavsett antalet lysdioder. Vid samtidiga
+*                     flanker genomfrs slckningen frst. Insignalen lses
+*                     av fre tndningen av lysdiod 0 nr
+*                     avlsningsintervallet har passerat. Vid 0 % respektive
+*                     100 % duty cycle utelmnas tndningar respektive
+*                     slckningar. Om anropen har uteblivit lngre n en
+*                     period startas en ny period.
+*
+*                     - self: Pekare till PWM-kontrollern.
+********************************************************************************/
+static void pwm_poll_staggered(struct pwm* self)
+{
+   struct pwm_stagger* stagger = self->stagger;
+   struct led** leds = stagger->leds->leds;
+   const uint8_t n = (uint8_t)stagger->leds->size;
+   if (!n || n > PWM_STAGGER_MAX) return;
+
+   const uint32_t now_us = time_us();
+
+   for (uint8_t i = 0; i < 2 * n; ++i)
+   {
+      const uint16_t period_us = self->period_us;
+      const uint32_t on_us = stagger->on_start_us + (uint32_t)stagger->on_index * period_us / n;
+      const uint32_t off_us = stagger->off_start_us + (uint32_t)stagger->off_index * period_us / n +
+                              self->input.pwm_on_us;
+      const bool on_due = !time_before(now_us, on_us);
+      const bool off_due = !time_before(now_us, off_us);
+
+      if (on_due && now_us - on_us > period_us)
+      {
+         pwm_stagger_restart(self);
+         continue;
+      }
+
+      if (off_due && (!on_due || !time_before(on_us, off_us)))
+      {
+         const uint32_t mask = 1UL << stagger->off_index;
+
+         if (self->input.pwm_off_us && (stagger->on_mask & mask))
+         {
+            led_off(leds[stagger->off_index]);
+            stagger->on_mask &= ~mask;
+            stagger->num_on--;
+         }
+
+         if (++stagger->off_index == n)
+         {
+            stagger->off_index = 0;
+            stagger->off_start_us += period_us;
+         }
+      }
+      else if (on_due)
+      {
+         const uint32_t mask = 1UL << stagger->on_index;
+
+         if (stagger->on_index == 0 && time_reached_ms(self->next_sample_ms))
+         {
+            pwm_update(self);
+            self->next_sample_ms = time_ms() + self->sample_ms;
+         }
+
+         if (self->input.pwm_on_us && !(stagger->on_mask & mask))
+         {
+            led_on(leds[stagger->on_index]);
+            stagger->on_mask |= mask;
+            if (++stagger->num_on > stagger->peak_on) stagger->peak_on = stagger->num_on;
+         }
+
+         if (++stagger->on_index == n)
+         {
+            stagger->on_index = 0;
+            stagger->on_start_us += period_us;
+         }
+      }
+      else
+      {
+         break;
+      }
+   }
+
    return;
 }
\ No newline at end of file
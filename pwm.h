@@ -8,21 +8,75 @@
 /* Inkluderingsdirektiv: */
 #include "misc.h"
 #include "adc.h"
+#include "coroutine.h"
+#include "pwm_hw.h"
+#include "brightness.h"
+#include "led_vector.h"
+
+/* Makrodefinitioner: */
+#define PWM_DUTY_MAX 1000             /* Duty cycle 100 % vid fast duty cycle (promille). */
+#define PWM_DUTY_OVERRIDE_NONE 0xFFFF /* Duty cycle styrs av den analoga insignalen. */
+
+#define PWM_STAGGER_MAX 32 /* Maximalt antal lysdioder vid fasfrskjuten PWM. */
+
+#ifndef PWM_SAMPLE_MS
+#define PWM_SAMPLE_MS 20 /* Default-intervall mellan avlsningar av insignalen vid pwm_poll. */
+#endif
+
+/********************************************************************************
+* pwm_stagger: Strukt fr tillstndet vid fasfrskjuten PWM, dr lysdioderna
+*              i en vektor tnds frskjutna jmnt ver perioden i stllet
+*              fr samtidigt, se pwm_set_staggered.
+********************************************************************************/
+struct pwm_stagger
+{
+   struct led_vector* leds; /* Lysdioderna som styrs. */
+   uint32_t on_mask;        /* Tnda lysdioder (bit k motsvarar lysdiod k). */
+   uint32_t on_start_us;    /* Periodstart fr nsta tndning. */
+   uint32_t off_start_us;   /* Periodstart fr nsta slckning. */
+   uint8_t on_index;        /* Lysdioden som tnds hrnst. */
+   uint8_t off_index;       /* Lysdioden som slcks hrnst. */
+   uint8_t num_on;          /* Antalet tnda lysdioder. */
+   uint8_t peak_on;         /* Hgsta antalet samtidigt tnda lysdioder. */
+};
 
 /********************************************************************************
 * pwm: Strukt fr PWM-kontrollers, som mjliggr PWM-styrning av en godtycklig 
 *      utenhet, exempelvis en eller flera lysdioder implementerat via ett 
 *      led-objekt eller en vektor innehllande pekare till multipla led-objekt. 
 *      PWM-styrning kan ske via en analog insignal ssom en potentiometer eller
-*      genom att direkt vlja duty cycle.
+*      genom att direkt vlja duty cycle. Om duty_override stts till 0 - 1000
+*      promille anvnds denna duty cycle i stllet fr den analoga insignalen.
+*      Den analoga insignalen kan omvandlas till duty cycle linjrt eller
+*      enligt en kurva som motsvarar upplevd ljusstyrka, se brightness.h
+*      samt pwm_set_curve.
+*      Om en PWM-generator i hrdvara ansluts via pwm_set_hardware genereras
+*      pulserna av timerkretsen i stllet, varvid anropen endast uppdaterar
+*      duty cycle och aldrig blockerar.
+*
+*      Via pwm_poll drivs PWM-kontrollern som en tillstndsmaskin utan att
+*      blockera, dr on- och off-fasen avancerar utifrn systemtiden och den
+*      analoga insignalen endast lses av var sample_ms millisekund. Samtliga
+*      tillstnd lagras i strukten, drmed kan godtyckligt mnga
+*      PWM-kontrollers med olika in- och utenheter kras frn samma loop.
 ********************************************************************************/
 struct pwm
 {
    struct adc input;               /* Analog inenhet, ssom en potentiometer. */
    uint16_t period_us;             /* Periodtid fr PWM mtt i mikrosekunder. */
+   uint16_t duty_override;         /* Fast duty cycle i promille (eller PWM_DUTY_OVERRIDE_NONE). */
    void* output;                   /* Pekare till ansluten utenhet. */
    void (*output_high)(void* arg); /* Pekare till funktion fr att tnda ansluten utenhet. */
    void (*output_low)(void* arg);  /* Pekare till funktion fr att slcka ansluten utenhet. */
+   struct pwm_hw* hardware;        /* PWM-generator i hrdvara (eller 0 fr mjukvaru-PWM). */
+   struct pwm_stagger* stagger;    /* Tillstnd fr fasfrskjuten PWM (eller 0). */
+   enum brightness_curve curve;    /* Kurva fr omvandling av insignalen till duty cycle. */
+   uint16_t duty;                  /* Aktuell duty cycle (0 - PWM_HW_DUTY_MAX). */
+   uint32_t next_edge_us;          /* Tidpunkt fr nsta flank vid pwm_poll. */
+   uint32_t next_sample_ms;        /* Tidpunkt fr nsta avlsning vid pwm_poll. */
+   uint16_t sample_ms;             /* Intervall mellan avlsningar vid pwm_poll. */
+   bool output_on;                 /* Indikerar att utenheten r tnd vid pwm_poll. */
+   bool running;                   /* Indikerar att pwm_poll har startat en period. */
    bool enabled;                   /* Enable-signal fr kontroll av PWM-generering. */
 };
 
@@ -60,6 +114,7 @@ void pwm_clear(struct pwm* self);
 static inline void pwm_enable(struct pwm* self)
 {
    self->enabled = true;
+   self->running = false;
    return;
 }
 
@@ -73,7 +128,117 @@ static inline void pwm_enable(struct pwm* self)
 static inline void pwm_disable(struct pwm* self)
 {
    self->enabled = false;
-   self->output_low(self->output);
+   self->running = false;
+
+   if (self->hardware)
+   {
+      pwm_hw_set_duty(self->hardware, 0);
+   }
+   else if (self->stagger)
+   {
+      led_vector_off(self->stagger->leds);
+      self->stagger->on_mask = 0;
+      self->stagger->num_on = 0;
+   }
+   else
+   {
+      self->output_low(self->output);
+   }
+   return;
+}
+
+/********************************************************************************
+* pwm_set_hardware: Ansluter angiven PWM-generator i hrdvara till angiven
+*                   PWM-kontroller, vilken drefter genererar pulserna i
+*                   stllet fr funktionerna output_high och output_low.
+*                   Duty cycle berknas som tidigare frn den analoga
+*                   insignalen eller duty_override, men period_us pverkar
+*                   endast upplsningen av duty cycle, d frekvensen vljs
+*                   vid initiering av PWM-generatorn. Anges 0 tergr
+*                   PWM-kontrollern till mjukvaru-PWM.
+*
+*                   - self    : Pekare till PWM-kontrollern.
+*                   - hardware: Pekare till initierad PWM-generator (eller 0).
+********************************************************************************/
+static inline void pwm_set_hardware(struct pwm* self,
+                                    struct pwm_hw* hardware)
+{
+   self->hardware = hardware;
+   return;
+}
+
+/********************************************************************************
+* pwm_set_staggered: Ansluter angiven vektor med lysdioder fr fasfrskjuten
+*                    PWM via pwm_poll, dr lysdiod k av n tnds k / n
+*                    perioder efter periodstart och slcks efter on-tiden,
+*                    i stllet fr att samtliga lysdioder tnds och slcks
+*                    samtidigt via output_high och output_low. Varje
+*                    lysdiod har samma on-tid som tidigare, drmed r
+*                    medelljusstyrkan ofrndrad, men antalet samtidigt
+*                    tnda lysdioder och drmed strmspikarna vid flankerna
+*                    minskar. Varje flank kostar lika mycket oavsett antalet
+*                    lysdioder. Vektorn fr innehlla hgst PWM_STAGGER_MAX
+*                    lysdioder. Anges 0 som tillstnd tergr
+*                    PWM-kontrollern till samtidig styrning. Fasfrskjuten
+*                    PWM krver mjukvaru-PWM, d utsignalen annars drivs av
+*                    timern och pwm_poll aldrig styr vektorn.
+*                    Returnerar 0 vid lyckad ndring, annars 1 (PWM-generator
+*                    i hrdvara ansluten).
+*
+*                    - self   : Pekare till PWM-kontrollern.
+*                    - stagger: Pekare till tillstndet (eller 0).
+*                    - leds   : Pekare till vektorn med lysdioderna.
+********************************************************************************/
+int pwm_set_staggered(struct pwm* self,
+                      struct pwm_stagger* stagger,
+                      struct led_vector* leds);
+
+/********************************************************************************
+* pwm_stagger_peak: Returnerar hgsta antalet samtidigt tnda lysdioder vid
+*                   fasfrskjuten PWM sedan fregende anrop, varefter
+*                   vrdet stts till aktuellt antal tnda lysdioder.
+*
+*                   - self: Pekare till tillstndet.
+********************************************************************************/
+static inline uint8_t pwm_stagger_peak(struct pwm_stagger* self)
+{
+   const uint8_t peak = self->peak_on;
+   self->peak_on = self->num_on;
+   return peak;
+}
+
+/********************************************************************************
+* pwm_set_sample_interval: Stter intervallet mellan avlsningar av den
+*                          analoga insignalen vid pwm_poll samt vid PWM i
+*                          hrdvara via pwm_run_async. Ny periodtid samt
+*                          duty_override brjar ocks glla vid nsta
+*                          avlsning. Som default gller PWM_SAMPLE_MS.
+*
+*                          - self     : Pekare till PWM-kontrollern.
+*                          - sample_ms: Intervall i millisekunder (minst 1).
+********************************************************************************/
+static inline void pwm_set_sample_interval(struct pwm* self,
+                                           const uint16_t sample_ms)
+{
+   self->sample_ms = sample_ms ? sample_ms : 1;
+   return;
+}
+
+/********************************************************************************
+* pwm_set_curve: Vljer kurva fr omvandling av den analoga insignalen till
+*                duty cycle. Vid gammakorrigering eller CIE L* omvandlas de
+*                tta mest signifikanta bitarna av AD-omvandlingen via en
+*                uppslagstabell med 16 bitars upplsning, vilket ger jmna
+*                steg i upplevd ljusstyrka. Som default r kurvan linjr.
+*                Fast duty cycle via duty_override pverkas inte.
+*
+*                - self : Pekare till PWM-kontrollern.
+*                - curve: Kurvan.
+********************************************************************************/
+static inline void pwm_set_curve(struct pwm* self,
+                                 const enum brightness_curve curve)
+{
+   self->curve = curve;
    return;
 }
 
@@ -99,7 +264,9 @@ static inline void pwm_toggle(struct pwm* self)
 /********************************************************************************
 * pwm_run: Kr angiven PWM-kontroller under en period och styr ansluten utenhet
 *          via avlsning av ansluten analog insignal, frutsatt att 
-*          PWM-kontrollern r aktiverad.
+*          PWM-kontrollern r aktiverad. Om en fast duty cycle har angivits
+*          via duty_override anvnds denna i stllet. Vid PWM i hrdvara
+*          uppdateras endast duty cycle, utan frdrjning.
 *
 *          - self: Pekare till PWM-kontrollern som ska kras.
 ********************************************************************************/
@@ -119,4 +286,44 @@ void pwm_run(struct pwm* self);
 ********************************************************************************/
 void pwm_run_with_duty_cycle(struct pwm* self, const double duty_cycle);
 
+/********************************************************************************
+* pwm_run_async: Motsvarar upprepade anrop av pwm_run, men implementerad som
+*                en coroutine som vntar ut on- och off-tiden utan att
+*                blockera processorn, se coroutine.h. On- och off-tiden
+*                berknas p nytt infr varje period. Coroutinen kr klart
+*                (COROUTINE_DONE) nr PWM-kontrollern inaktiveras och ska
+*                drefter initieras p nytt innan den anropas igen.
+*
+*                Flanktidernas noggrannhet begrnsas av hur ofta coroutinen
+*                anropas samt av upplsningen fr time_us (4 us). Vid PWM i
+*                hrdvara uppdateras i stllet duty cycle var sample_ms
+*                millisekund.
+*
+*                - self: Pekare till PWM-kontrollern som ska kras.
+*                - co  : Pekare till coroutinens tillstnd.
+********************************************************************************/
+enum coroutine_state pwm_run_async(struct pwm* self,
+                                   struct coroutine* co);
+
+/********************************************************************************
+* pwm_poll: Driver angiven PWM-kontroller utan att blockera och ska anropas
+*           s ofta som mjligt, exempelvis frn huvudprogrammets loop.
+*           Vid varje anrop kontrolleras endast om nsta flank har ntts
+*           enligt systemtiden (time_us), varvid utenheten tnds eller
+*           slcks och nsta flank schemalggs relativt fregende, s att
+*           periodtiden inte pverkas av hur ofta funktionen anropas. Den
+*           analoga insignalen lses av i brjan av en period nr
+*           sample_ms millisekunder har passerat sedan fregende
+*           avlsning. Vid PWM i hrdvara uppdateras endast duty cycle vid
+*           varje avlsning.
+*
+*           Flanktidernas noggrannhet begrnsas av hur ofta funktionen
+*           anropas samt av upplsningen fr time_us (4 us). Om anropen
+*           uteblir lngre n en period startar nsta period direkt i
+*           stllet fr att missade perioder hmtas in.
+*
+*           - self: Pekare till PWM-kontrollern som ska kras.
+********************************************************************************/
+void pwm_poll(struct pwm* self);
+
 #endif /* PWM_H_ */
\ No newline at end of file
@@ -0,0 +1,311 @@
+/********************************************************************************
+* pwm_hw.c: Innehller definitioner av associerade funktioner fr strukten
+*           pwm_hw.
+********************************************************************************/
+#include "pwm_hw.h"
+
+/* Makrodefinitioner: */
+#define PWM_HW_TOP_MIN 0xFF    /* Minsta TOP, dvs. minst 8 bitars upplsning. */
+#define PWM_HW_TOP_MAX 0xFFFF  /* Strsta TOP fr Timer 1. */
+#define PWM_HW_COM_A 7         /* Bit COMnA1 (icke-inverterande PWM p OCnA). */
+#define PWM_HW_COM_B 5         /* Bit COMnB1 (icke-inverterande PWM p OCnB). */
+
+/* Statiska funktioner: */
+static uint32_t pwm_hw_cycles(const struct pwm_hw* self,
+                              const uint16_t prescaler,
+                              const uint16_t top);
+static int pwm_hw_select_clock(struct pwm_hw* self,
+                               const uint32_t frequency_hz,
+                               const uint8_t resolution_bits);
+static volatile uint8_t* pwm_hw_control_register(const struct pwm_hw* self);
+
+/********************************************************************************
+* pwm_hw_init: Initierar PWM-generering p angivna utpinnar till angiven
+*              timerkrets. Timer 1 stlls in i mod 14 (Fast PWM) eller mod 10
+*              (Phase Correct PWM) med ICR1 som TOP, vriga timerkretsar i
+*              mod 3 (Fast PWM) eller mod 1 (Phase Correct PWM) med TOP = 255.
+*              Utpinnarna kopplas inte till timerkretsen frrn en duty cycle
+*              ver 0 anges.
+*
+*              - self           : Pekare till PWM-generatorn.
+*              - timer_sel      : Timerkretsen som ska anvndas.
+*              - channels       : Utpinnar som ska anvndas.
+*              - mode           : Fast PWM eller Phase Correct PWM.
+*              - frequency_hz   : nskad frekvens i Hz.
+*              - resolution_bits: Upplsning i bitar, 0 fr hgsta mjliga.
+********************************************************************************/
+int pwm_hw_init(struct pwm_hw* self,
+                const enum timer_sel timer_sel,
+                const uint8_t channels,
+                const enum pwm_hw_mode mode,
+                const uint32_t frequency_hz,
+                const uint8_t resolution_bits)
+{
+   if (timer_sel == TIMER_SEL_NONE || frequency_hz == 0) return 1;
+   if (!channels || (channels & ~(PWM_HW_CHANNEL_A | PWM_HW_CHANNEL_B))) return 1;
+
+   self->timer_sel = timer_sel;
+   self->mode = mode;
+   self->channels = channels;
+   if (pwm_hw_select_clock(self, frequency_hz, resolution_bits)) return 1;
+
+   const bool fast = mode == PWM_HW_MODE_FAST;
+
+   if (timer_sel == TIMER_SEL_0)
+   {
+      TCCR0B = 0x00;
+      OCR0A = 0x00;
+      OCR0B = 0x00;
+      TCNT0 = 0x00;
+      TCCR0A = fast ? (1 << WGM01) | (1 << WGM00) : (1 << WGM00);
+      TCCR0B = self->clock_select;
+   }
+   else if (timer_sel == TIMER_SEL_1)
+   {
+      const uint8_t sreg = SREG;
+      asm("CLI");
+      TCCR1B = 0x00;
+      ICR1 = self->top;
+      OCR1A = 0x00;
+      OCR1B = 0x00;
+      TCNT1 = 0x00;
+      SREG = sreg;
+      TCCR1A = (1 << WGM11);
+      TCCR1B = (fast ? (1 << WGM13) | (1 << WGM12) : (1 << WGM13)) | self->clock_select;
+   }
+   else
+   {
+      TCCR2B = 0x00;
+      OCR2A = 0x00;
+      OCR2B = 0x00;
+      TCNT2 = 0x00;
+      TCCR2A = fast ? (1 << WGM21) | (1 << WGM20) : (1 << WGM20);
+      TCCR2B = self->clock_select;
+   }
+
+   for (uint8_t channel = TIMER_CHANNEL_A; channel <= TIMER_CHANNEL_B; ++channel)
+   {
+      if (!(channels & (1 << channel))) continue;
+      const uint8_t pin = timer_output_pin(timer_sel, (enum timer_channel)channel);
+
+      if (pin < 8)
+      {
+         PORTD &= ~(1 << pin);
+         DDRD |= (1 << pin);
+      }
+      else
+      {
+         PORTB &= ~(1 << (pin - 8));
+         DDRB |= (1 << (pin - 8));
+      }
+   }
+
+   return 0;
+}
+
+/********************************************************************************
+* pwm_hw_clear: Stoppar timerkretsen och kopplar bort utpinnarna, vilka
+*               drefter hlls lga via respektive PORT-register.
+*
+*               - self: Pekare till PWM-generatorn.
+********************************************************************************/
+void pwm_hw_clear(struct pwm_hw* self)
+{
+   if (self->timer_sel == TIMER_SEL_0)
+   {
+      TCCR0B = 0x00;
+      TCCR0A = 0x00;
+   }
+   else if (self->timer_sel == TIMER_SEL_1)
+   {
+      TCCR1B = 0x00;
+      TCCR1A = 0x00;
+   }
+   else if (self->timer_sel == TIMER_SEL_2)
+   {
+      TCCR2B = 0x00;
+      TCCR2A = 0x00;
+   }
+
+   self->timer_sel = TIMER_SEL_NONE;
+   self->channels = 0;
+   self->clock_select = 0;
+   self->top = 0;
+   return;
+}
+
+/********************************************************************************
+* pwm_hw_set_channel_duty: Skalar angiven duty cycle till ett jmfrelsevrde
+*                          mellan 0 - TOP (avrundat till nrmaste steg) och
+*                          skriver det till OCRnx, som lses in av hrdvaran
+*                          vid nsta periodstart. Vid duty cycle 0 kopplas
+*                          utpinnen bort s att den hlls lg.
+*
+*                          - self   : Pekare till PWM-generatorn.
+*                          - channel: Utpinnen.
+*                          - duty   : Duty cycle (0 - PWM_HW_DUTY_MAX).
+********************************************************************************/
+void pwm_hw_set_channel_duty(struct pwm_hw* self,
+                             const enum timer_channel channel,
+                             const uint16_t duty)
+{
+   if (!(self->channels & (1 << channel))) return;
+
+   const uint16_t compare = (uint16_t)(((uint32_t)duty * self->top + PWM_HW_DUTY_MAX / 2) / PWM_HW_DUTY_MAX);
+   const uint8_t com_bit = channel == TIMER_CHANNEL_A ? PWM_HW_COM_A : PWM_HW_COM_B;
+   volatile uint8_t* control = pwm_hw_control_register(self);
+   const uint8_t sreg = SREG;
+   asm("CLI");
+
+   if (self->timer_sel == TIMER_SEL_0)
+   {
+      if (channel == TIMER_CHANNEL_A) OCR0A = (uint8_t)compare;
+      else OCR0B = (uint8_t)compare;
+   }
+   else if (self->timer_sel == TIMER_SEL_1)
+   {
+      if (channel == TIMER_CHANNEL_A) OCR1A = compare;
+      else OCR1B = compare;
+   }
+   else
+   {
+      if (channel == TIMER_CHANNEL_A) OCR2A = (uint8_t)compare;
+      else OCR2B = (uint8_t)compare;
+   }
+
+   if (duty)
+   {
+      *control |= (1 << com_bit);
+   }
+   else
+   {
+      *control &= ~(1 << com_bit);
+   }
+
+   SREG = sreg;
+   return;
+}
+
+/********************************************************************************
+* pwm_hw_get_frequency: Returnerar uppndd frekvens i Hz utifrn vald
+*                       prescaler, TOP och PWM-mod.
+*
+*                       - self: Pekare till PWM-generatorn.
+********************************************************************************/
+double pwm_hw_get_frequency(const struct pwm_hw* self)
+{
+   const uint16_t prescaler = timer_prescaler(self->timer_sel, self->clock_select);
+   if (!prescaler) return 0.0;
+   return (double)(F_CPU) / pwm_hw_cycles(self, prescaler, self->top);
+}
+
+/********************************************************************************
+* pwm_hw_get_resolution: Returnerar upplsningen i hela bitar, vilket blir 8
+*                        fr Timer 0 samt Timer 2 och 8 - 16 fr Timer 1.
+*
+*                        - self: Pekare till PWM-generatorn.
+********************************************************************************/
+uint8_t pwm_hw_get_resolution(const struct pwm_hw* self)
+{
+   uint8_t bits = 0;
+   for (uint32_t steps = (uint32_t)self->top + 1; steps > 1; steps >>= 1) bits++;
+   return bits;
+}
+
+/********************************************************************************
+* pwm_hw_cycles: Returnerar antalet klockcykler per PWM-period fr angiven
+*                prescaler och TOP i vald PWM-mod.
+*
+*                - self     : Pekare till PWM-generatorn.
+*                - prescaler: Prescaler.
+*                - top      : Hgsta rknarvrde.
+********************************************************************************/
+static uint32_t pwm_hw_cycles(const struct pwm_hw* self,
+                              const uint16_t prescaler,
+                              const uint16_t top)
+{
+   if (self->mode == PWM_HW_MODE_FAST)
+   {
+      return (uint32_t)prescaler * ((uint32_t)top + 1);
+   }
+   else
+   {
+      return 2UL * prescaler * top;
+   }
+}
+
+/********************************************************************************
+* pwm_hw_select_clock: Vljer prescaler och TOP fr angiven frekvens och
+*                      upplsning. Vid fast TOP (8-bitars timerkretsar eller
+*                      angiven upplsning) vljs den prescaler som ger
+*                      frekvensen nrmast nskad frekvens. Vid hgsta mjliga
+*                      upplsning p Timer 1 vljs i stllet minsta prescaler
+*                      dr TOP ryms i 16 bitar, varefter TOP avrundas till
+*                      nrmaste heltal. Returnerar 0 vid lyckat val, annars 1.
+*
+*                      - self           : Pekare till PWM-generatorn.
+*                      - frequency_hz   : nskad frekvens i Hz.
+*                      - resolution_bits: Upplsning i bitar, 0 fr hgsta
+*                                         mjliga.
+********************************************************************************/
+static int pwm_hw_select_clock(struct pwm_hw* self,
+                               const uint32_t frequency_hz,
+                               const uint8_t resolution_bits)
+{
+   const uint32_t cycles = ((F_CPU) + frequency_hz / 2) / frequency_hz;
+   self->clock_select = 0;
+   self->top = 0;
+
+   if (self->timer_sel == TIMER_SEL_1 && resolution_bits == 0)
+   {
+      for (uint8_t clock_select = 1; timer_prescaler(self->timer_sel, clock_select); ++clock_select)
+      {
+         const uint16_t prescaler = timer_prescaler(self->timer_sel, clock_select);
+         const uint32_t top = self->mode == PWM_HW_MODE_FAST ?
+            (cycles + prescaler / 2) / prescaler - 1 : (cycles + prescaler) / (2UL * prescaler);
+
+         if (top <= PWM_HW_TOP_MAX)
+         {
+            if (top < PWM_HW_TOP_MIN) return 1;
+            self->clock_select = clock_select;
+            self->top = (uint16_t)top;
+            return 0;
+         }
+      }
+      return 1;
+   }
+
+   if (resolution_bits != 0 && (resolution_bits < 8 || resolution_bits > 16)) return 1;
+   if (self->timer_sel != TIMER_SEL_1 && resolution_bits > 8) return 1;
+
+   const uint16_t top = resolution_bits ? (uint16_t)((1UL << resolution_bits) - 1) : PWM_HW_TOP_MIN;
+   uint32_t best_error = UINT32_MAX;
+
+   for (uint8_t clock_select = 1; timer_prescaler(self->timer_sel, clock_select); ++clock_select)
+   {
+      const uint32_t achieved = pwm_hw_cycles(self, timer_prescaler(self->timer_sel, clock_select), top);
+      const uint32_t error = achieved > cycles ? achieved - cycles : cycles - achieved;
+
+      if (error < best_error)
+      {
+         best_error = error;
+         self->clock_select = clock_select;
+      }
+   }
+
+   self->top = top;
+   return 0;
+}
+
+/********************************************************************************
+* pwm_hw_control_register: Returnerar en pekare till kontrollregistret
+*                          TCCRnA, som innehller bitarna COMnx1:0.
+*
+*                          - self: Pekare till PWM-generatorn.
+********************************************************************************/
+static volatile uint8_t* pwm_hw_control_register(const struct pwm_hw* self)
+{
+   if (self->timer_sel == TIMER_SEL_0) return &TCCR0A;
+   if (self->timer_sel == TIMER_SEL_1) return &TCCR1A;
+   return &TCCR2A;
+}
\ No newline at end of file
@@ -0,0 +1,151 @@
+/********************************************************************************
+* pwm_hw.h: Innehller drivrutiner fr PWM-generering i hrdvara p
+*           timerkretsarnas utpinnar via strukten pwm_hw, vilket till
+*           skillnad frn mjukvaru-PWM i pwm.c varken belastar processorn
+*           eller pverkas av avbrott och anropsoverhead.
+*
+*           Fljande utpinnar kan anvndas:
+*
+*           Timerkrets   OCnA            OCnB             Upplsning
+*             Timer 0    pin 6 (PORTD6)  pin 5 (PORTD5)   8 bitar
+*             Timer 1    pin 9 (PORTB1)  pin 10 (PORTB2)  8 - 16 bitar
+*             Timer 2    pin 11 (PORTB3) pin 3 (PORTD3)   8 bitar
+*
+*           Timer 0 samt Timer 2 rknar alltid till TOP = 255, drmed vljs
+*           frekvensen endast via prescalern, vilket ger den frekvens som
+*           ligger nrmast nskad frekvens. Timer 1 anvnder i stllet ICR1
+*           som TOP, vilket mjliggr godtycklig frekvens, dr minsta mjliga
+*           prescaler ger hgsta mjliga upplsning (minst 8 bitar), eller
+*           fast upplsning p 8 - 16 bitar, dr prescalern ger den frekvens
+*           som ligger nrmast nskad frekvens. Bda utpinnarna p samma
+*           timerkrets har samma frekvens.
+*
+*           Tv moder stds:
+*
+*           - Fast PWM: Frekvensen blir F_CPU / (prescaler * (TOP + 1)).
+*           - Phase Correct PWM: Timern rknar upp och sedan ned, vilket
+*             halverar frekvensen till F_CPU / (2 * prescaler * TOP), men
+*             ger pulser som r centrerade i perioden.
+*
+*           Duty cycle anges som ett tal mellan 0 - PWM_HW_DUTY_MAX oavsett
+*           upplsning. Jmfrelseregistren OCRnx r dubbelbuffrade i
+*           hrdvara i PWM-moderna, drmed gller ny duty cycle frst frn
+*           nsta period, utan glitchar mitt i en period. 16-bitars register
+*           skrivs med avbrott inaktiverade, d de delar ett tillflligt
+*           register. Vid duty cycle 0 kopplas utpinnen bort frn timern och
+*           hlls lg, vilket ger 0 % ven i Fast PWM (dr OCRnx = 0 annars
+*           ger en puls p ett timersteg per period).
+*
+*           Observera att Timer 0 i detta system utgr systemets tick
+*           (timebase.h), Timer 1 anvnds av Input Capture (capture.h) och
+*           Timer 2 av Modbus (modbus.h) samt realtidsklockan (rtc.h).
+********************************************************************************/
+#ifndef PWM_HW_H_
+#define PWM_HW_H_
+
+/* Inkluderingsdirektiv: */
+#include "timer.h"
+
+/* Makrodefinitioner: */
+#define PWM_HW_DUTY_MAX 0xFFFF                   /* Duty cycle 100 %. */
+#define PWM_HW_CHANNEL_A (1 << TIMER_CHANNEL_A) /* Utpinne OCnA. */
+#define PWM_HW_CHANNEL_B (1 << TIMER_CHANNEL_B) /* Utpinne OCnB. */
+
+/********************************************************************************
+* pwm_hw_mode: Enumeration fr val av PWM-mod.
+********************************************************************************/
+enum pwm_hw_mode
+{
+   PWM_HW_MODE_FAST,         /* Fast PWM (rknar upp till TOP). */
+   PWM_HW_MODE_PHASE_CORRECT /* Phase Correct PWM (rknar upp och ned). */
+};
+
+/********************************************************************************
+* pwm_hw: Strukt fr PWM-generering i hrdvara p en eller bda utpinnarna
+*         till en timerkrets.
+********************************************************************************/
+struct pwm_hw
+{
+   enum timer_sel timer_sel; /* Timerkretsen som genererar PWM. */
+   enum pwm_hw_mode mode;    /* Vald PWM-mod. */
+   uint8_t channels;         /* Anvnda utpinnar (PWM_HW_CHANNEL_A och/eller B). */
+   uint8_t clock_select;     /* Bitar CSn2:0 fr vald prescaler. */
+   uint16_t top;             /* Hgsta rknarvrde, dvs. antal steg per period - 1. */
+};
+
+/********************************************************************************
+* pwm_hw_init: Initierar PWM-generering p angivna utpinnar till angiven
+*              timerkrets med angiven frekvens. Utpinnarna stts till
+*              utportar och hlls lga (duty cycle 0) tills en duty cycle
+*              anges. Returnerar 0 vid lyckad initiering, annars 1 (ogiltig
+*              timerkrets, utpinne eller upplsning, eller en frekvens som
+*              inte kan ns med minst 8 bitars upplsning).
+*
+*              - self           : Pekare till PWM-generatorn.
+*              - timer_sel      : Timerkretsen som ska anvndas.
+*              - channels       : Utpinnar som ska anvndas (PWM_HW_CHANNEL_A
+*                                 och/eller PWM_HW_CHANNEL_B).
+*              - mode           : Fast PWM eller Phase Correct PWM.
+*              - frequency_hz   : nskad frekvens i Hz.
+*              - resolution_bits: Upplsning i bitar (8 - 16 fr Timer 1,
+*                                 8 fr vriga), eller 0 fr hgsta mjliga
+*                                 upplsning vid nskad frekvens.
+********************************************************************************/
+int pwm_hw_init(struct pwm_hw* self,
+                const enum timer_sel timer_sel,
+                const uint8_t channels,
+                const enum pwm_hw_mode mode,
+                const uint32_t frequency_hz,
+                const uint8_t resolution_bits);
+
+/********************************************************************************
+* pwm_hw_clear: Stoppar angiven PWM-generator. Utpinnarna kopplas bort frn
+*               timerkretsen och hlls lga.
+*
+*               - self: Pekare till PWM-generatorn.
+********************************************************************************/
+void pwm_hw_clear(struct pwm_hw* self);
+
+/********************************************************************************
+* pwm_hw_set_channel_duty: Stter duty cycle p angiven utpinne, vilken
+*                          gller frn nsta period.
+*
+*                          - self   : Pekare till PWM-generatorn.
+*                          - channel: Utpinnen.
+*                          - duty   : Duty cycle (0 - PWM_HW_DUTY_MAX).
+********************************************************************************/
+void pwm_hw_set_channel_duty(struct pwm_hw* self,
+                             const enum timer_channel channel,
+                             const uint16_t duty);
+
+/********************************************************************************
+* pwm_hw_set_duty: Stter samma duty cycle p samtliga anvnda utpinnar.
+*
+*                  - self: Pekare till PWM-generatorn.
+*                  - duty: Duty cycle (0 - PWM_HW_DUTY_MAX).
+********************************************************************************/
+static inline void pwm_hw_set_duty(struct pwm_hw* self,
+                                   const uint16_t duty)
+{
+   if (self->channels & PWM_HW_CHANNEL_A) pwm_hw_set_channel_duty(self, TIMER_CHANNEL_A, duty);
+   if (self->channels & PWM_HW_CHANNEL_B) pwm_hw_set_channel_duty(self, TIMER_CHANNEL_B, duty);
+   return;
+}
+
+/********************************************************************************
+* pwm_hw_get_frequency: Returnerar uppndd frekvens i Hz.
+*
+*                       - self: Pekare till PWM-generatorn.
+********************************************************************************/
+double pwm_hw_get_frequency(const struct pwm_hw* self);
+
+/********************************************************************************
+* pwm_hw_get_resolution: Returnerar upplsningen i hela bitar, dvs. det
+*                        strsta antalet bitar n dr 2^n steg ryms i
+*                        perioden.
+*
+*                        - self: Pekare till PWM-generatorn.
+********************************************************************************/
+uint8_t pwm_hw_get_resolution(const struct pwm_hw* self);
+
+#endif /* PWM_HW_H_ */
\ No newline at end of file
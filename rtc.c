@@ -0,0 +1,438 @@
+/********************************************************************************
+* rtc.c: Innehller funktionsdefinitioner fr realtidsklockan.
+********************************************************************************/
+#include "rtc.h"
+
+/* Makrodefinitioner: */
+#define RTC_SECONDS_PER_DAY 86400UL                   /* Antal sekunder per dygn. */
+#define RTC_CLOCK_SELECT ((1 << CS22) | (1 << CS20)) /* Prescaler 128, ett overflow per sekund. */
+#define RTC_WEEKDAY_OFFSET 5                          /* Veckodag fr 2000-01-01 (lrdag). */
+#define RTC_SYNC_TIMEOUT_US 1000000UL                 /* Lngsta vntan p synkronisering. */
+#define RTC_SYNC_POLL_US 10                           /* Vntetid mellan avlsningarna av ASSR. */
+
+#define RTC_BUSY_FLAGS ((1 << TCN2UB) | (1 << OCR2AUB) | (1 << OCR2BUB) | \
+                        (1 << TCR2AUB) | (1 << TCR2BUB)) /* Flaggor fr pgende synkronisering. */
+
+/* Statiska variabler: */
+static volatile uint32_t counter = 0;            /* Sekunder sedan 2000-01-01 00:00:00. */
+static struct rtc_alarm* alarms = 0;             /* Frsta aktiva larmet. */
+static struct soft_timer second_timer;           /* Driver klockan vid RTC_SOURCE_SYSTEM. */
+static enum rtc_source source = RTC_SOURCE_NONE; /* Kllan som driver klockan. */
+
+static const uint8_t days_per_month[12] PROGMEM =
+{
+   31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+};
+
+/* Statiska funktioner: */
+static void rtc_second_elapsed(void* context);
+static uint8_t rtc_days_in_month(const uint16_t year,
+                                 const uint8_t month);
+
+/********************************************************************************
+* rtc_wait_for_sync: Vntar tills samtliga skrivningar till registren fr
+*                    Timer 2 har synkroniserats till kristallens klocka.
+*                    Utan fungerande kristall synkroniseras registren
+*                    aldrig, drmed avbryts vntan efter en sekund, vilket
+*                    motsvarar kristallens lngsta starttid.
+*                    Returnerar 0 vid lyckad synkronisering, annars 1.
+********************************************************************************/
+static int rtc_wait_for_sync(void)
+{
+   for (uint32_t i = 0; i < RTC_SYNC_TIMEOUT_US / RTC_SYNC_POLL_US; ++i)
+   {
+      if (!(ASSR & RTC_BUSY_FLAGS)) return 0;
+      _delay_us(RTC_SYNC_POLL_US);
+   }
+
+   return 1;
+}
+
+/********************************************************************************
+* rtc_leap_year: Indikerar ifall angivet r r ett skottr.
+*
+*                - year: ret som ska kontrolleras.
+********************************************************************************/
+static inline bool rtc_leap_year(const uint16_t year)
+{
+   return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+/********************************************************************************
+* ISR (TIMER2_OVF_vect): Avbrottsrutin som ger rum nr Timer 2 slr runt,
+*                        vilket med kristallen som klla sker varje sekund.
+********************************************************************************/
+ISR (TIMER2_OVF_vect)
+{
+   rtc_second_elapsed(0);
+   return;
+}
+
+/********************************************************************************
+* rtc_init: Stoppar nuvarande klla och startar klockan med angiven klla.
+*           Vid byte till kristallen inaktiveras avbrott fr Timer 2 och
+*           asynkron klocka vljs innan registren skrivs, varefter
+*           synkroniseringen invntas och kvarvarande avbrottsflaggor
+*           nollstlls innan overflow-avbrottet aktiveras. Ifall
+*           synkroniseringen inte slutfrs (ingen kristall) stoppas
+*           Timer 2 och terstlls till synkron drift, varefter 1
+*           returneras s att anroparen kan vlja RTC_SOURCE_SYSTEM.
+*
+*           - new_source: Kllan som ska driva klockan.
+********************************************************************************/
+int rtc_init(const enum rtc_source new_source)
+{
+   rtc_disable();
+
+   if (new_source == RTC_SOURCE_CRYSTAL)
+   {
+      TIMSK2 = 0x00;
+      ASSR = (1 << AS2);
+      TCCR2A = 0x00;
+      TCNT2 = 0;
+      OCR2A = 0;
+      OCR2B = 0;
+      TCCR2B = RTC_CLOCK_SELECT;
+
+      if (rtc_wait_for_sync())
+      {
+         TCCR2B = 0x00;
+         ASSR = 0x00;
+         return 1;
+      }
+
+      TIFR2 = (1 << TOV2) | (1 << OCF2A) | (1 << OCF2B);
+      TIMSK2 = (1 << TOIE2);
+   }
+   else if (new_source == RTC_SOURCE_SYSTEM)
+   {
+      soft_timer_init(&second_timer, &rtc_second_elapsed, 0);
+      if (soft_timer_start(&second_timer, 1000, 1000)) return 1;
+   }
+   else
+   {
+      return 1;
+   }
+
+   source = new_source;
+   return 0;
+}
+
+/********************************************************************************
+* rtc_disable: Stoppar klockan. Vid asynkron drift inaktiveras avbrottet och
+*              Timer 2 stoppas, varefter synkroniseringen invntas innan
+*              Timer 2 terstlls till synkron drift. Timer 2 terstlls
+*              ven om synkroniseringen inte slutfrs, exempelvis om
+*              kristallen har slutat svnga.
+********************************************************************************/
+void rtc_disable(void)
+{
+   if (source == RTC_SOURCE_CRYSTAL)
+   {
+      TIMSK2 &= ~(1 << TOIE2);
+      TCCR2B = 0x00;
+      (void)rtc_wait_for_sync();
+      ASSR = 0x00;
+   }
+   else if (source == RTC_SOURCE_SYSTEM)
+   {
+      soft_timer_cancel(&second_timer);
+   }
+
+   source = RTC_SOURCE_NONE;
+   return;
+}
+
+/********************************************************************************
+* rtc_source: Returnerar kllan som driver klockan.
+********************************************************************************/
+enum rtc_source rtc_source(void)
+{
+   return source;
+}
+
+/********************************************************************************
+* rtc_seconds: Returnerar aktuell tid i sekunder, lst med avbrott
+*              inaktiverade.
+********************************************************************************/
+uint32_t rtc_seconds(void)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   const uint32_t seconds = counter;
+   SREG = sreg;
+   return seconds;
+}
+
+/********************************************************************************
+* rtc_set_seconds: Stller klockan till angiven tid. Vid asynkron drift
+*                  nollstlls TCNT2 nr tidigare skrivning har
+*                  synkroniserats, varefter ett eventuellt vntande
+*                  overflow-avbrott nollstlls. Annars startas
+*                  mjukvarutimern om.
+*
+*                  - seconds: Ny tid i sekunder.
+********************************************************************************/
+void rtc_set_seconds(const uint32_t seconds)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+
+   if (source == RTC_SOURCE_CRYSTAL)
+   {
+      while (ASSR & (1 << TCN2UB));
+      TCNT2 = 0;
+      while (ASSR & (1 << TCN2UB));
+      TIFR2 = (1 << TOV2);
+   }
+   else if (source == RTC_SOURCE_SYSTEM)
+   {
+      soft_timer_start(&second_timer, 1000, 1000);
+   }
+
+   counter = seconds;
+   SREG = sreg;
+   return;
+}
+
+/********************************************************************************
+* rtc_set_time: Omvandlar angiven tid till sekunder och stller klockan.
+*
+*               - time: Pekare till den nya tiden.
+********************************************************************************/
+int rtc_set_time(const struct rtc_time* time)
+{
+   uint32_t seconds;
+   if (rtc_time_to_seconds(time, &seconds)) return 1;
+   rtc_set_seconds(seconds);
+   return 0;
+}
+
+/********************************************************************************
+* rtc_seconds_to_time: Omvandlar angiven tid i sekunder till datum och
+*                      klockslag. Antalet dygn rknas av r fr r och
+*                      sedan mnad fr mnad, vilket krver hgst 136
+*                      respektive 11 iterationer.
+*
+*                      - seconds: Tiden i sekunder.
+*                      - time   : Pekare till strukten dr resultatet lagras.
+********************************************************************************/
+void rtc_seconds_to_time(uint32_t seconds,
+                         struct rtc_time* time)
+{
+   uint16_t days = (uint16_t)(seconds / RTC_SECONDS_PER_DAY);
+   seconds %= RTC_SECONDS_PER_DAY;
+
+   time->second = (uint8_t)(seconds % 60);
+   seconds /= 60;
+   time->minute = (uint8_t)(seconds % 60);
+   time->hour = (uint8_t)(seconds / 60);
+   time->weekday = (uint8_t)((days + RTC_WEEKDAY_OFFSET) % 7);
+
+   time->year = RTC_YEAR_MIN;
+
+   while (days >= 365 + rtc_leap_year(time->year))
+   {
+      days -= 365 + rtc_leap_year(time->year);
+      time->year++;
+   }
+
+   time->month = 1;
+
+   while (days >= rtc_days_in_month(time->year, time->month))
+   {
+      days -= rtc_days_in_month(time->year, time->month);
+      time->month++;
+   }
+
+   time->day = (uint8_t)(days + 1);
+   return;
+}
+
+/********************************************************************************
+* rtc_time_to_seconds: Omvandlar angivet datum och klockslag till sekunder
+*                      efter kontroll av samtliga flt.
+*
+*                      - time   : Pekare till tiden som ska omvandlas.
+*                      - seconds: Pekare till variabeln dr resultatet lagras.
+********************************************************************************/
+int rtc_time_to_seconds(const struct rtc_time* time,
+                        uint32_t* seconds)
+{
+   if (time->year < RTC_YEAR_MIN || time->year > RTC_YEAR_MAX ||
+       time->month < 1 || time->month > 12 || time->day < 1 ||
+       time->day > rtc_days_in_month(time->year, time->month) ||
+       time->hour > 23 || time->minute > 59 || time->second > 59)
+   {
+      return 1;
+   }
+
+   uint32_t days = time->day - 1;
+
+   for (uint16_t year = RTC_YEAR_MIN; year < time->year; ++year)
+   {
+      days += 365 + rtc_leap_year(year);
+   }
+
+   for (uint8_t month = 1; month < time->month; ++month)
+   {
+      days += rtc_days_in_month(time->year, month);
+   }
+
+   *seconds = ((days * 24 + time->hour) * 60 + time->minute) * 60 + time->second;
+   return 0;
+}
+
+/********************************************************************************
+* rtc_alarm_init: Initierar nytt larm.
+*
+*                 - self    : Pekare till larmet som ska initieras.
+*                 - callback: Pekare till rutinen som anropas nr larmet
+*                             lser ut.
+*                 - context : Argument som skickas till callback-rutinen.
+********************************************************************************/
+void rtc_alarm_init(struct rtc_alarm* self,
+                    void (*callback)(void* context),
+                    void* context)
+{
+   self->callback = callback;
+   self->context = context;
+   self->time = 0;
+   self->period = 0;
+   self->next = 0;
+   self->active = false;
+   return;
+}
+
+/********************************************************************************
+* rtc_alarm_start: Startar angivet larm med avbrott inaktiverade. Inaktiva
+*                  larm lggs frst i listan ver aktiva larm.
+*
+*                  - self  : Pekare till larmet som ska startas.
+*                  - time  : Tidpunkt i sekunder.
+*                  - period: Periodtid i sekunder (0 = engngslarm).
+********************************************************************************/
+void rtc_alarm_start(struct rtc_alarm* self,
+                     const uint32_t time,
+                     const uint32_t period)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+
+   if (!self->active)
+   {
+      self->next = alarms;
+      alarms = self;
+      self->active = true;
+   }
+
+   self->time = time;
+   self->period = period;
+   SREG = sreg;
+   return;
+}
+
+/********************************************************************************
+* rtc_alarm_cancel: Tar bort angivet larm frn listan ver aktiva larm med
+*                   avbrott inaktiverade. Larmets pekare till nsta larm
+*                   lmnas orrd, s att sekundavbrottet kan fortstta
+*                   genom listan om en callback-rutin stoppar ett larm.
+*
+*                   - self: Pekare till larmet som ska stoppas.
+********************************************************************************/
+void rtc_alarm_cancel(struct rtc_alarm* self)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+
+   if (self->active)
+   {
+      struct rtc_alarm** link = &alarms;
+      while (*link != self) link = &(*link)->next;
+      *link = self->next;
+      self->active = false;
+   }
+
+   SREG = sreg;
+   return;
+}
+
+/********************************************************************************
+* rtc_sleep: Frstter processorn i Power-save Mode (kristallen) eller Idle
+*            Mode (systemets klocka) tills nsta avbrott. Skrivningen till
+*            TCCR2A synkroniseras under en hel kristallcykel, vilket
+*            garanterar att fregende uppvaknande har passerat. Ifall
+*            synkroniseringen inte slutfrs anvnds Idle Mode, d
+*            processorn annars inte skulle vakna igen.
+********************************************************************************/
+void rtc_sleep(void)
+{
+   if (source == RTC_SOURCE_CRYSTAL)
+   {
+      TCCR2A = 0x00;
+      if (!rtc_wait_for_sync()) set_sleep_mode(SLEEP_MODE_PWR_SAVE);
+   }
+
+   sleep_mode();
+   set_sleep_mode(SLEEP_MODE_IDLE);
+   return;
+}
+
+/********************************************************************************
+* rtc_second_elapsed: Rknar upp klockan en sekund och lser ut samtliga
+*                     aktiva larm vars tidpunkt har ntts. Periodiska larm
+*                     schemalggs om utifrn fregende tidpunkt, dr
+*                     missade perioder (exempelvis efter att klockan har
+*                     stllts fram) hoppas ver. Engngslarm stoppas innan
+*                     callback-rutinen anropas, s att de kan startas om
+*                     frn denna. Anropas frn avbrottsrutinen fr
+*                     respektive klla.
+*
+*                     - context: Anvnds inte.
+********************************************************************************/
+static void rtc_second_elapsed(void* context)
+{
+   const uint32_t now = ++counter;
+   struct rtc_alarm* alarm = alarms;
+
+   while (alarm)
+   {
+      struct rtc_alarm* next = alarm->next;
+
+      if (alarm->active && alarm->time <= now)
+      {
+         if (alarm->period)
+         {
+            alarm->time += alarm->period;
+
+            if (alarm->time <= now)
+            {
+               alarm->time += ((now - alarm->time) / alarm->period + 1) * alarm->period;
+            }
+         }
+         else
+         {
+            rtc_alarm_cancel(alarm);
+         }
+
+         alarm->callback(alarm->context);
+      }
+
+      alarm = next;
+   }
+
+   return;
+}
+
+/********************************************************************************
+* rtc_days_in_month: Returnerar antalet dagar i angiven mnad.
+*
+*                    - year : ret, fr februari under skottr.
+*                    - month: Mnaden (1 - 12).
+********************************************************************************/
+static uint8_t rtc_days_in_month(const uint16_t year,
+                                 const uint8_t month)
+{
+   if (month == 2 && rtc_leap_year(year)) return 29;
+   return pgm_read_byte(&days_per_month[month - 1]);
+}
\ No newline at end of file
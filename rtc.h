@@ -0,0 +1,243 @@
+/********************************************************************************
+* rtc.h: Innehller en realtidsklocka med kalender samt larm, som hller
+*        tiden i sekunder sedan 2000-01-01 00:00:00 och kan anvndas fr
+*        tidsstmplar ver lnga krningar samt fr att vcka processorn
+*        ur Power-save Mode vid en viss tidpunkt.
+*
+*        Klockan drivs av ngon av fljande kllor:
+*
+*        - RTC_SOURCE_CRYSTAL: Timer 2 krs asynkront frn en 32.768 kHz
+*          urkristall ansluten till TOSC1/TOSC2 (PORTB6/PORTB7), med
+*          prescaler 128 i Normal Mode, vilket ger ett overflow-avbrott
+*          (TIMER2_OVF_vect) per sekund. Timer 2 fortstter att rkna i
+*          Power-save Mode, dr vriga klockor r avstngda, drmed kan
+*          processorn sova mellan sekunderna med minimal strmfrbrukning.
+*          Observera att TOSC1/TOSC2 delas med XTAL1/XTAL2, drmed krver
+*          detta att processorn krs frn den interna RC-oscillatorn.
+*
+*        - RTC_SOURCE_SYSTEM: Sekunderna rknas via en periodisk
+*          mjukvarutimer (se soft_timer.h) frn systemets klocka, vilket
+*          fungerar utan kristall, exempelvis i simulatorer samt p kort
+*          dr XTAL1/XTAL2 anvnds av huvudkristallen. Noggrannheten blir
+*          d densamma som fr systemets klocka, och Power-save Mode kan
+*          inte anvndas eftersom systemtiden d str still.
+*
+*        Vid asynkron drift synkroniseras skrivningar till TCNT2, OCR2A,
+*        OCR2B, TCCR2A samt TCCR2B till kristallens klocka, vilket tar upp
+*        till tv kristallcykler (cirka 60 us). Under tiden r motsvarande
+*        flagga i ASSR (TCN2UB, OCR2AUB, OCR2BUB, TCR2AUB respektive
+*        TCR2BUB) ettstlld och registret fr inte skrivas p nytt. Innan
+*        processorn frstts i Power-save Mode mste dessutom en skrivning
+*        ha synkroniserats efter senaste uppvaknandet, annars kan
+*        processorn vakna direkt igen eller inte vakna alls, se rtc_sleep.
+*
+*        Larm anges via strukten rtc_alarm som en tidpunkt i sekunder,
+*        eventuellt med en periodtid, och utlses i sekundavbrottet. Larm
+*        vars tidpunkt redan har passerats (exempelvis efter att klockan
+*        har stllts om) utlses vid nsta sekund. Callback-rutiner anropas
+*        drmed frn en avbrottsrutin och ska vara korta.
+*
+*        Timer 2 anvnds ven av Modbus-slaven i modbus.c, drmed ska
+*        RTC_SOURCE_SYSTEM anvndas nr Modbus r aktiverat.
+********************************************************************************/
+#ifndef RTC_H_
+#define RTC_H_
+
+/* Inkluderingsdirektiv: */
+#include "soft_timer.h"
+#include <avr/sleep.h>
+#include <util/delay.h>
+
+/* Makrodefinitioner: */
+#ifndef RTC_CRYSTAL
+#define RTC_CRYSTAL 0 /* 1 = 32.768 kHz urkristall ansluten till TOSC1/TOSC2. */
+#endif
+
+#define RTC_YEAR_MIN 2000 /* r fr tidpunkten 0 sekunder. */
+#define RTC_YEAR_MAX 2135 /* Sista r som ryms i 32 bitar sekunder. */
+
+/********************************************************************************
+* rtc_source: Enumeration fr val av klla som driver klockan.
+********************************************************************************/
+enum rtc_source
+{
+   RTC_SOURCE_CRYSTAL, /* Timer 2 asynkront frn 32.768 kHz urkristall. */
+   RTC_SOURCE_SYSTEM,  /* Mjukvarutimer frn systemets klocka. */
+   RTC_SOURCE_NONE     /* Klockan r inaktiverad. */
+};
+
+/********************************************************************************
+* rtc_time: Strukt fr lagring av datum och klockslag.
+********************************************************************************/
+struct rtc_time
+{
+   uint16_t year;   /* r (RTC_YEAR_MIN - RTC_YEAR_MAX). */
+   uint8_t month;   /* Mnad (1 - 12). */
+   uint8_t day;     /* Dag i mnaden (1 - 31). */
+   uint8_t hour;    /* Timme (0 - 23). */
+   uint8_t minute;  /* Minut (0 - 59). */
+   uint8_t second;  /* Sekund (0 - 59). */
+   uint8_t weekday; /* Veckodag (0 = mndag, 6 = sndag), stts vid avlsning. */
+};
+
+/********************************************************************************
+* rtc_alarm: Strukt fr implementering av larm, som lser ut en gng eller
+*            periodiskt vid angiven tidpunkt.
+********************************************************************************/
+struct rtc_alarm
+{
+   void (*callback)(void* context); /* Anropas nr larmet lser ut. */
+   void* context;                   /* Argument till callback-rutinen. */
+   uint32_t time;                   /* Tidpunkt i sekunder d larmet lser ut nsta gng. */
+   uint32_t period;                 /* Periodtid i sekunder (0 = engngslarm). */
+   struct rtc_alarm* next;          /* Nsta aktiva larm. */
+   bool active;                     /* Indikerar att larmet r aktivt. */
+};
+
+/********************************************************************************
+* rtc_init: Startar klockan med angiven klla. Aktuell tid behlls, drmed
+*           kan kllan bytas under drift, exempelvis till RTC_SOURCE_SYSTEM
+*           innan Timer 2 tas ver av Modbus. Vid byte till kristallen
+*           vljs asynkron klocka frst, varefter samtliga register fr
+*           Timer 2 skrivs och synkroniseras innan avbrott aktiveras, d
+*           registren kan ha frstrts vid bytet. Kristallen kan behva upp
+*           till en sekund fr att stabiliseras, drmed kan frsta sekunden
+*           bli felaktig.
+*           Returnerar 0 vid lyckad initiering, annars 1 (ogiltig klla,
+*           ingen ledig mjukvarutimer eller ingen kristall, vilket
+*           upptcks d Timer 2 inte har synkroniserats inom en sekund).
+*
+*           - source: Kllan som ska driva klockan.
+********************************************************************************/
+int rtc_init(const enum rtc_source source);
+
+/********************************************************************************
+* rtc_disable: Stoppar klockan och terstller Timer 2 till synkron drift.
+*              Aktiva larm behlls men lser inte ut frrn klockan startas
+*              p nytt.
+********************************************************************************/
+void rtc_disable(void);
+
+/********************************************************************************
+* rtc_source: Returnerar kllan som driver klockan.
+********************************************************************************/
+enum rtc_source rtc_source(void);
+
+/********************************************************************************
+* rtc_seconds: Returnerar aktuell tid i sekunder sedan 2000-01-01 00:00:00.
+*              Lsningen sker med avbrott inaktiverade.
+********************************************************************************/
+uint32_t rtc_seconds(void);
+
+/********************************************************************************
+* rtc_set_seconds: Stller klockan till angiven tid i sekunder sedan
+*                  2000-01-01 00:00:00. Pbrjad sekund startas om, s att
+*                  nsta sekund inleds en hel sekund efter anropet.
+*
+*                  - seconds: Ny tid i sekunder.
+********************************************************************************/
+void rtc_set_seconds(const uint32_t seconds);
+
+/********************************************************************************
+* rtc_set_time: Stller klockan till angivet datum och klockslag.
+*               Returnerar 0 om klockan stlldes, annars 1 (ogiltig tid).
+*
+*               - time: Pekare till den nya tiden (veckodagen ignoreras).
+********************************************************************************/
+int rtc_set_time(const struct rtc_time* time);
+
+/********************************************************************************
+* rtc_seconds_to_time: Omvandlar angiven tid i sekunder sedan 2000-01-01
+*                      00:00:00 till datum och klockslag enligt den
+*                      gregorianska kalendern.
+*
+*                      - seconds: Tiden i sekunder.
+*                      - time   : Pekare till strukten dr resultatet lagras.
+********************************************************************************/
+void rtc_seconds_to_time(uint32_t seconds,
+                         struct rtc_time* time);
+
+/********************************************************************************
+* rtc_time_to_seconds: Omvandlar angivet datum och klockslag till sekunder
+*                      sedan 2000-01-01 00:00:00. Returnerar 0 vid lyckad
+*                      omvandling, annars 1 (ogiltigt datum eller klockslag).
+*
+*                      - time   : Pekare till tiden som ska omvandlas.
+*                      - seconds: Pekare till variabeln dr resultatet lagras.
+********************************************************************************/
+int rtc_time_to_seconds(const struct rtc_time* time,
+                        uint32_t* seconds);
+
+/********************************************************************************
+* rtc_get_time: Lser av aktuellt datum och klockslag.
+*
+*               - time: Pekare till strukten dr tiden ska lagras.
+********************************************************************************/
+static inline void rtc_get_time(struct rtc_time* time)
+{
+   rtc_seconds_to_time(rtc_seconds(), time);
+   return;
+}
+
+/********************************************************************************
+* rtc_alarm_init: Initierar nytt larm, som r inaktivt tills det startas via
+*                 rtc_alarm_start.
+*
+*                 - self    : Pekare till larmet som ska initieras.
+*                 - callback: Pekare till rutinen som anropas nr larmet
+*                             lser ut.
+*                 - context : Argument som skickas till callback-rutinen.
+********************************************************************************/
+void rtc_alarm_init(struct rtc_alarm* self,
+                    void (*callback)(void* context),
+                    void* context);
+
+/********************************************************************************
+* rtc_alarm_start: Startar angivet larm, som lser ut vid angiven tidpunkt
+*                  och drefter, om en periodtid anges, med angivet
+*                  intervall tills larmet stoppas. Ett larm som redan r
+*                  aktivt startas om med den nya tidpunkten.
+*
+*                  - self  : Pekare till larmet som ska startas.
+*                  - time  : Tidpunkt i sekunder sedan 2000-01-01 00:00:00.
+*                  - period: Tid mellan efterfljande utlsningar i
+*                            sekunder (0 = engngslarm).
+********************************************************************************/
+void rtc_alarm_start(struct rtc_alarm* self,
+                     const uint32_t time,
+                     const uint32_t period);
+
+/********************************************************************************
+* rtc_alarm_cancel: Stoppar angivet larm. Om larmet redan r inaktivt sker
+*                   ingenting.
+*
+*                   - self: Pekare till larmet som ska stoppas.
+********************************************************************************/
+void rtc_alarm_cancel(struct rtc_alarm* self);
+
+/********************************************************************************
+* rtc_alarm_active: Indikerar ifall angivet larm r aktivt.
+*
+*                   - self: Pekare till larmet.
+********************************************************************************/
+static inline bool rtc_alarm_active(const struct rtc_alarm* self)
+{
+   return self->active;
+}
+
+/********************************************************************************
+* rtc_sleep: Frstter processorn i vilolge tills nsta avbrott, vilket
+*            senast r nsta sekund. Med kristallen som klla anvnds
+*            Power-save Mode, dr endast Timer 2, Watchdog-timern samt
+*            externa avbrott och PCI-avbrott kan vcka processorn. Innan
+*            dess skrivs TCCR2A och synkroniseringen invntas, s att
+*            processorn inte vaknar direkt igen inom samma kristallcykel
+*            som fregende uppvaknande. Seriell verfring, systemtiden
+*            samt mjukvarutimers str still under tiden, drmed br
+*            sndbufferten tmmas innan anropet. Med systemets klocka som
+*            klla anvnds i stllet Idle Mode. Drefter terstlls Idle
+*            Mode, som anvnds av schemalggaren.
+********************************************************************************/
+void rtc_sleep(void);
+
+#endif /* RTC_H_ */
\ No newline at end of file
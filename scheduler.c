@@ -0,0 +1,290 @@
+/********************************************************************************
+* scheduler.c: Innehller funktionsdefinitioner fr den kooperativa
+*              schemalggaren.
+********************************************************************************/
+#include "scheduler.h"
+
+/* Statiska variabler: */
+static struct task* first = 0; /* Frsta tasken i prioritetsordning. */
+
+/* Statiska funktioner: */
+static inline bool scheduler_ready(const struct task* self,
+                                   const uint32_t now_ms);
+static void scheduler_execute(struct task* self,
+                              const uint32_t now_ms);
+
+/********************************************************************************
+* task_init: Initierar ny task, som inte blir krklar frrn den schemalggs
+*            eller hndelseflaggor postas.
+*
+*            - self    : Pekare till tasken som ska initieras.
+*            - name    : Taskens namn (lagras i programminnet).
+*            - run     : Pekare till rutinen som krs nr tasken r krklar.
+*            - context : Argument som skickas till rutinen.
+*            - priority: Prioritet (0 = hgst).
+********************************************************************************/
+void task_init(struct task* self,
+               PGM_P name,
+               void (*run)(void* context),
+               void* context,
+               const uint8_t priority)
+{
+   self->run = run;
+   self->context = context;
+   self->name = name;
+   self->next = 0;
+   self->next_run_ms = 0;
+   self->period_ms = 0;
+   self->activated_ms = 0;
+   self->deadline_ms = 0;
+   self->events = 0;
+   self->taken_events = 0;
+   self->priority = priority;
+   self->scheduled = false;
+   task_reset_stats(self);
+   return;
+}
+
+/********************************************************************************
+* task_schedule: Schemalgger angiven task att aktiveras efter angiven tid
+*                och drefter, om en periodtid anges, med angivet intervall.
+*
+*                - self     : Pekare till tasken.
+*                - delay_ms : Tid tills frsta aktiveringen.
+*                - period_ms: Tid mellan efterfljande aktiveringar
+*                             (0 = engngsaktivering).
+********************************************************************************/
+void task_schedule(struct task* self,
+                   const uint32_t delay_ms,
+                   const uint32_t period_ms)
+{
+   self->next_run_ms = time_ms() + delay_ms;
+   self->period_ms = period_ms;
+
+   if (!self->deadline_ms && period_ms <= UINT16_MAX)
+   {
+      self->deadline_ms = (uint16_t)period_ms;
+   }
+
+   self->scheduled = true;
+   return;
+}
+
+/********************************************************************************
+* task_unschedule: Tar bort schemalagd aktivering av angiven task.
+*
+*                  - self: Pekare till tasken.
+********************************************************************************/
+void task_unschedule(struct task* self)
+{
+   self->scheduled = false;
+   return;
+}
+
+/********************************************************************************
+* task_post: Postar angivna hndelseflaggor till angiven task. Om inga
+*            flaggor var postade sedan tidigare lagras aktuell tid som
+*            aktiveringstidpunkt, vilken anvnds fr kontroll av deadline.
+*
+*            - self  : Pekare till tasken.
+*            - events: Hndelseflaggor som ska postas (bitvis eller).
+********************************************************************************/
+void task_post(struct task* self,
+               const uint8_t events)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+
+   if (!self->events)
+   {
+      self->activated_ms = time_ms_isr();
+   }
+
+   self->events |= events;
+   SREG = sreg;
+   return;
+}
+
+/********************************************************************************
+* task_reset_stats: Nollstller exekveringsstatistiken fr angiven task.
+*
+*                   - self: Pekare till tasken.
+********************************************************************************/
+void task_reset_stats(struct task* self)
+{
+   self->num_runs = 0;
+   self->total_us = 0;
+   self->max_us = 0;
+   self->num_overruns = 0;
+   return;
+}
+
+/********************************************************************************
+* scheduler_add: Lgger till angiven task i schemalggaren efter samtliga
+*                tasks med samma eller hgre prioritet.
+*
+*                - self: Pekare till tasken som ska lggas till.
+********************************************************************************/
+void scheduler_add(struct task* self)
+{
+   struct task** position = &first;
+
+   while (*position && (*position)->priority <= self->priority)
+   {
+      position = &(*position)->next;
+   }
+
+   self->next = *position;
+   *position = self;
+   return;
+}
+
+/********************************************************************************
+* scheduler_first: Returnerar frsta tasken i prioritetsordning.
+********************************************************************************/
+struct task* scheduler_first(void)
+{
+   return first;
+}
+
+/********************************************************************************
+* scheduler_run_once: Kr den krklara task som har hgst prioritet, vilket
+*                     r den frsta krklara tasken i listan.
+********************************************************************************/
+bool scheduler_run_once(void)
+{
+   const uint32_t now_ms = time_ms();
+
+   for (struct task* task = first; task; task = task->next)
+   {
+      if (scheduler_ready(task, now_ms))
+      {
+         scheduler_execute(task, now_ms);
+         return true;
+      }
+   }
+
+   return false;
+}
+
+/********************************************************************************
+* scheduler_run: Kr schemalggaren kontinuerligt. Innan processorn
+*                frstts i Idle Mode kontrolleras med avbrott inaktiverade
+*                att ingen task har blivit krklar. Eftersom instruktionen
+*                efter SEI alltid exekveras innan ett vntande avbrott
+*                hanteras kan ett avbrott som postar hndelseflaggor inte
+*                intrffa mellan kontrollen och SLEEP utan att vcka
+*                processorn.
+********************************************************************************/
+void scheduler_run(void)
+{
+   set_sleep_mode(SLEEP_MODE_IDLE);
+
+   while (1)
+   {
+      if (scheduler_run_once()) continue;
+
+      asm("CLI");
+      const uint32_t now_ms = time_ms_isr();
+      bool ready = false;
+
+      for (struct task* task = first; task && !ready; task = task->next)
+      {
+         ready = scheduler_ready(task, now_ms);
+      }
+
+      if (!ready)
+      {
+         sleep_enable();
+         asm("SEI");
+         sleep_cpu();
+         sleep_disable();
+      }
+
+      asm("SEI");
+   }
+}
+
+/********************************************************************************
+* scheduler_ready: Indikerar ifall angiven task r krklar, allts om
+*                  hndelseflaggor har postats eller om schemalagd tidpunkt
+*                  har ntts.
+*
+*                  - self  : Pekare till tasken.
+*                  - now_ms: Aktuell systemtid i millisekunder.
+********************************************************************************/
+static inline bool scheduler_ready(const struct task* self,
+                                   const uint32_t now_ms)
+{
+   return self->events || (self->scheduled && !time_before(now_ms, self->next_run_ms));
+}
+
+/********************************************************************************
+* scheduler_execute: Kr angiven task och uppdaterar dess statistik.
+*
+*                    Postade hndelseflaggor tas ver med avbrott
+*                    inaktiverade, s att flaggor som postas under krningen
+*                    inte gr frlorade. Vid schemalagd aktivering rknas
+*                    nsta tidpunkt fram en period i taget, s att perioden
+*                    inte glider. Om ven nsta tidpunkt redan har passerat
+*                    hoppas de missade aktiveringarna ver och rknas som en
+*                    verskridning. Aktiveringstidpunkten r den tidigaste av
+*                    schemalagd tidpunkt och tidpunkten d flaggorna postades.
+*
+*                    - self  : Pekare till tasken som ska kras.
+*                    - now_ms: Aktuell systemtid i millisekunder.
+********************************************************************************/
+static void scheduler_execute(struct task* self,
+                              const uint32_t now_ms)
+{
+   uint32_t activated_ms = now_ms;
+
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   self->taken_events = self->events;
+   self->events = 0;
+   if (self->taken_events) activated_ms = self->activated_ms;
+   SREG = sreg;
+
+   if (self->scheduled && !time_before(now_ms, self->next_run_ms))
+   {
+      if (time_before(self->next_run_ms, activated_ms))
+      {
+         activated_ms = self->next_run_ms;
+      }
+
+      if (!self->period_ms)
+      {
+         self->scheduled = false;
+      }
+      else
+      {
+         self->next_run_ms += self->period_ms;
+
+         if (!time_before(now_ms, self->next_run_ms))
+         {
+            self->next_run_ms = now_ms + self->period_ms;
+            self->num_overruns++;
+         }
+      }
+   }
+
+   const uint32_t start_us = time_us();
+   self->run(self->context);
+   const uint32_t elapsed_us = time_since_us(start_us);
+
+   self->num_runs++;
+   self->total_us += elapsed_us;
+
+   if (elapsed_us > self->max_us)
+   {
+      self->max_us = elapsed_us;
+   }
+
+   if (self->deadline_ms && time_since_ms(activated_ms) > self->deadline_ms)
+   {
+      self->num_overruns++;
+   }
+
+   return;
+}
\ No newline at end of file
@@ -0,0 +1,181 @@
+/********************************************************************************
+* scheduler.h: Innehller en kooperativ schemalggare, dr statiskt
+*              allokerade tasks via strukten task krs till slut
+*              (run-to-completion) i huvudprogrammet i stllet fr i
+*              avbrottsrutiner.
+*
+*              Varje task har en prioritet (0 = hgst) och blir krklar
+*              antingen nr en schemalagd tidpunkt ns (engngs- eller
+*              periodisk aktivering, se task_schedule) eller nr
+*              hndelseflaggor postas via task_post, vilket r tilltet
+*              frn avbrottsrutiner. Av de krklara tasks krs alltid den
+*              med hgst prioritet; vid lika prioritet den som lades till
+*              frst. En task avbryts aldrig av en annan task, drmed
+*              begrnsas frdrjningen fr en task av den lngsta
+*              exekveringstiden bland vriga tasks.
+*
+*              Fr varje task mts antalet krningar samt sammanlagd och
+*              maximal exekveringstid i mikrosekunder. Om en task inte har
+*              krt klart inom sin deadline efter aktiveringen, eller om en
+*              periodisk aktivering hoppas ver, rknas en verskridning.
+*
+*              Nr ingen task r krklar frstts processorn i Idle Mode
+*              tills nsta avbrott, som senast sker vid nsta millisekund.
+********************************************************************************/
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+/* Inkluderingsdirektiv: */
+#include "timebase.h"
+#include <avr/sleep.h>
+
+/* Makrodefinitioner: */
+#define TASK_EVENT_ACTIVATE 0x80 /* Hndelseflagga fr aktivering utan vrig information. */
+
+/********************************************************************************
+* task: Strukt fr implementering av tasks, som krs av schemalggaren nr
+*       de r krklara.
+********************************************************************************/
+struct task
+{
+   void (*run)(void* context); /* Rutin som krs nr tasken r krklar. */
+   void* context;              /* Argument till rutinen. */
+   PGM_P name;                 /* Taskens namn (lagras i programminnet). */
+   struct task* next;          /* Nsta task i prioritetsordning. */
+   uint32_t next_run_ms;       /* Schemalagd tidpunkt fr nsta aktivering. */
+   uint32_t period_ms;         /* Periodtid (0 = engngsaktivering). */
+   uint32_t activated_ms;      /* Tidpunkt d hndelseflaggor senast postades. */
+   uint16_t deadline_ms;       /* Maximal tid frn aktivering till frdig krning (0 = ingen). */
+   volatile uint8_t events;    /* Postade hndelseflaggor som nnu inte har hanterats. */
+   uint8_t taken_events;       /* Hndelseflaggor som hanteras vid aktuell krning. */
+   uint8_t priority;           /* Prioritet (0 = hgst). */
+   bool scheduled;             /* Indikerar schemalagd aktivering. */
+   uint32_t num_runs;          /* Antalet krningar. */
+   uint32_t total_us;          /* Sammanlagd exekveringstid i mikrosekunder. */
+   uint32_t max_us;            /* Lngsta exekveringstid i mikrosekunder. */
+   uint16_t num_overruns;      /* Antalet verskridna deadlines. */
+};
+
+/********************************************************************************
+* task_init: Initierar ny task, som inte blir krklar frrn den schemalggs
+*            eller hndelseflaggor postas.
+*
+*            - self    : Pekare till tasken som ska initieras.
+*            - name    : Taskens namn (lagras i programminnet).
+*            - run     : Pekare till rutinen som krs nr tasken r krklar.
+*            - context : Argument som skickas till rutinen.
+*            - priority: Prioritet (0 = hgst).
+********************************************************************************/
+void task_init(struct task* self,
+               PGM_P name,
+               void (*run)(void* context),
+               void* context,
+               const uint8_t priority);
+
+/********************************************************************************
+* task_schedule: Schemalgger angiven task att aktiveras efter angiven tid
+*                och drefter, om en periodtid anges, med angivet intervall.
+*                Deadline stts till periodtiden om ingen annan har angivits.
+*
+*                - self     : Pekare till tasken.
+*                - delay_ms : Tid tills frsta aktiveringen.
+*                - period_ms: Tid mellan efterfljande aktiveringar
+*                             (0 = engngsaktivering).
+********************************************************************************/
+void task_schedule(struct task* self,
+                   const uint32_t delay_ms,
+                   const uint32_t period_ms);
+
+/********************************************************************************
+* task_unschedule: Tar bort schemalagd aktivering av angiven task. Postade
+*                  hndelseflaggor pverkas inte.
+*
+*                  - self: Pekare till tasken.
+********************************************************************************/
+void task_unschedule(struct task* self);
+
+/********************************************************************************
+* task_set_deadline: Stter maximal tid frn aktivering till frdig krning
+*                    fr angiven task.
+*
+*                    - self       : Pekare till tasken.
+*                    - deadline_ms: Deadline i millisekunder (0 = ingen).
+********************************************************************************/
+static inline void task_set_deadline(struct task* self,
+                                     const uint16_t deadline_ms)
+{
+   self->deadline_ms = deadline_ms;
+   return;
+}
+
+/********************************************************************************
+* task_post: Postar angivna hndelseflaggor till angiven task, som drmed
+*            blir krklar. Kan anropas frn bde huvudprogrammet och
+*            avbrottsrutiner.
+*
+*            - self  : Pekare till tasken.
+*            - events: Hndelseflaggor som ska postas (bitvis eller).
+********************************************************************************/
+void task_post(struct task* self,
+               const uint8_t events);
+
+/********************************************************************************
+* task_activate: Gr angiven task krklar en gng. Kan anropas frn bde
+*                huvudprogrammet och avbrottsrutiner.
+*
+*                - self: Pekare till tasken.
+********************************************************************************/
+static inline void task_activate(struct task* self)
+{
+   task_post(self, TASK_EVENT_ACTIVATE);
+   return;
+}
+
+/********************************************************************************
+* task_events: Returnerar de hndelseflaggor som hanteras vid aktuell
+*              krning av angiven task, allts de som hade postats nr
+*              tasken startade. Flaggor som postas under krningen gr
+*              tasken krklar p nytt.
+*
+*              - self: Pekare till tasken.
+********************************************************************************/
+static inline uint8_t task_events(const struct task* self)
+{
+   return self->taken_events;
+}
+
+/********************************************************************************
+* task_reset_stats: Nollstller exekveringsstatistiken fr angiven task.
+*
+*                   - self: Pekare till tasken.
+********************************************************************************/
+void task_reset_stats(struct task* self);
+
+/********************************************************************************
+* scheduler_add: Lgger till angiven task i schemalggaren, sorterad efter
+*                prioritet.
+*
+*                - self: Pekare till tasken som ska lggas till.
+********************************************************************************/
+void scheduler_add(struct task* self);
+
+/********************************************************************************
+* scheduler_first: Returnerar frsta tasken i prioritetsordning, exempelvis
+*                  fr utskrift av statistik via fltet next.
+********************************************************************************/
+struct task* scheduler_first(void);
+
+/********************************************************************************
+* scheduler_run_once: Kr den krklara task som har hgst prioritet.
+*                     Returnerar true om en task krdes, annars false.
+********************************************************************************/
+bool scheduler_run_once(void);
+
+/********************************************************************************
+* scheduler_run: Kr schemalggaren kontinuerligt. Nr ingen task r krklar
+*                frstts processorn i Idle Mode tills nsta avbrott.
+*                Rutinen returnerar aldrig.
+********************************************************************************/
+void scheduler_run(void);
+
+#endif /* SCHEDULER_H_ */
\ No newline at end of file
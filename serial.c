@@ -4,37 +4,509 @@
 ********************************************************************************/
 #include "serial.h"
 
+/* Makrodefinitioner: */
+#define SERIAL_TX_BUFFER_MASK (SERIAL_TX_BUFFER_SIZE - 1) /* Mask fr indexering av sndbufferten. */
+
+#if SERIAL_TX_BUFFER_SIZE < 2 || SERIAL_TX_BUFFER_SIZE > 256 || \
+    (SERIAL_TX_BUFFER_SIZE & SERIAL_TX_BUFFER_MASK) != 0
+#error "SERIAL_TX_BUFFER_SIZE must be a power of two between 2 and 256!"
+#endif
+
+#define SERIAL_RX_BUFFER_MASK (SERIAL_RX_BUFFER_SIZE - 1) /* Mask fr indexering av mottagarbufferten. */
+
+#if SERIAL_RX_BUFFER_SIZE < 2 || SERIAL_RX_BUFFER_SIZE > 256 || \
+    (SERIAL_RX_BUFFER_SIZE & SERIAL_RX_BUFFER_MASK) != 0
+#error "SERIAL_RX_BUFFER_SIZE must be a power of two between 2 and 256!"
+#endif
+
+#define SERIAL_DECIMAL16_DIGITS 5  /* Maximalt antal decimala siffror i ett 16-bitars tal. */
+#define SERIAL_DECIMAL32_DIGITS 10 /* Maximalt antal decimala siffror i ett 32-bitars tal. */
+
+/* Statiska variabler: */
+static volatile uint8_t tx_buffer[SERIAL_TX_BUFFER_SIZE]; /* Sndbuffert (ringbuffert). */
+static volatile uint8_t tx_head = 0; /* Index efter sista tecken som fr skickas. */
+static volatile uint8_t tx_tail = 0; /* Index fr nsta tecken som ska skickas. */
+static volatile uint8_t tx_end = 0;  /* Index dr nsta tecken placeras. */
+static volatile bool tx_reserved = false; /* Indikerar att en reservation pgr. */
+static uint8_t tx_fill = 0;          /* Index fr nsta tecken i pgende reservation. */
+static enum serial_overflow_policy tx_policy = SERIAL_OVERFLOW_BLOCK; /* tgrd vid full buffert. */
+
+static volatile uint8_t rx_buffer[SERIAL_RX_BUFFER_SIZE]; /* Mottagarbuffert (ringbuffert). */
+static volatile uint8_t rx_head = 0; /* Index dr nsta mottagna tecken placeras. */
+static volatile uint8_t rx_tail = 0; /* Index fr nsta tecken som ska lsas. */
+static void (*rx_handler)(void* arg, uint8_t data) = 0; /* Mottagarfunktion i avbrottsrutinen. */
+static void* rx_handler_arg = 0; /* Argument till mottagarfunktionen. */
+
+/* Tiopotenser fr decimal utskrift (lagras i programminnet): */
+static const uint16_t powers_of_ten16[SERIAL_DECIMAL16_DIGITS] PROGMEM = 
+{
+   10000, 1000, 100, 10, 1
+};
+
+static const uint32_t powers_of_ten32[SERIAL_DECIMAL32_DIGITS] PROGMEM =
+{
+   1000000000, 100000000, 10000000, 1000000, 100000, 10000, 1000, 100, 10, 1
+};
+
+/* Statiska funktioner: */
+static inline void serial_transmit_next(void);
+static inline bool serial_interrupts_enabled(void);
+static void serial_set_divisor(const uint16_t ubrr,
+                               const bool double_speed);
+static void serial_set_baud_rate(const uint32_t baud_rate);
+static void serial_print_decimal16(uint16_t number, 
+                                   const uint8_t first);
+static void serial_print_decimal32(uint32_t number, 
+                                   const uint8_t decimals);
+static inline char serial_hex_digit(const uint8_t nibble);
+
+/********************************************************************************
+* ISR (USART_UDRE_vect): Avbrottsrutin som ger rum nr USART:ns dataregister
+*                        r tomt och nsta tecken kan skickas. Nsta tecken i
+*                        sndbufferten skickas. Nr sndbufferten r tom
+*                        inaktiveras avbrottet tills nya tecken kas.
+********************************************************************************/
+ISR (USART_UDRE_vect)
+{
+   serial_transmit_next();
+   return;
+}
+
+/********************************************************************************
+* ISR (USART_RX_vect): Avbrottsrutin som ger rum nr ett tecken har tagits
+*                      emot. Tecknet placeras i mottagarbufferten, frutsatt
+*                      att det mottogs utan ramfel och att bufferten inte r
+*                      full. Tolkning av mottagna tecken sker aldrig hr utan
+*                      i huvudprogrammet.
+*
+*                      Om en mottagarfunktion har angivits via
+*                      serial_set_rx_handler skickas tecknet i stllet direkt
+*                      till denna, exempelvis fr protokoll dr tiden mellan
+*                      tecken har betydelse.
+********************************************************************************/
+ISR (USART_RX_vect)
+{
+   const uint8_t status = UCSR0A;
+   const uint8_t data = UDR0;
+   const uint8_t next = (rx_head + 1) & SERIAL_RX_BUFFER_MASK;
+
+   if (status & ((1 << FE0) | (1 << UPE0)))
+   {
+      return;
+   }
+   else if (rx_handler)
+   {
+      rx_handler(rx_handler_arg, data);
+   }
+   else if (next != rx_tail)
+   {
+      rx_buffer[rx_head] = data;
+      rx_head = next;
+   }
+   return;
+}
+
 /********************************************************************************
 * serial_init: Initierar USART fr seriell verfring med angiven baud rate,
-*              dr default stts till 9600 kbps (kilobits/sekund). USART 
-*              konfigureras till asynkron verfring med tta bitar i taget,
-*              utan stoppbit.
+*              dr default stts till SERIAL_BAUD_RATE (9600 bps om inget
+*              annat anges). USART konfigureras till asynkron verfring med 
+*              tta bitar i taget, utan stoppbit. Bde sndning och 
+*              mottagning aktiveras, dr mottagning sker avbrottsstyrt.
+*
+*              Divisorn samt valet av dubbel hastighet fr SERIAL_BAUD_RATE
+*              berknas vid kompilering, dr kompileringen avbryts om
+*              avvikelsen r fr stor. vriga baud rates berknas vid
+*              krning med heltalsaritmetik.
 *
-*              - baud_rate_kbps: verfringshastigheten, dvs. antalet bitar som 
-'                                transmitteras per sekund (default = 9600 kbps).
+*              - baud_rate: verfringshastigheten mtt i bitar per sekund,
+*                           eller 0 fr SERIAL_BAUD_RATE (default 9600 bps).
 ********************************************************************************/
-void serial_init(const uint32_t baud_rate_kbps)
+void serial_init(const uint32_t baud_rate)
 {
    static bool serial_initialized = false;
    if (serial_initialized) return;
 
-   UCSR0B = (1 << TXEN0);
+   UCSR0B = (1 << TXEN0) | (1 << RXEN0) | (1 << RXCIE0);
    UCSR0C = (1 << UCSZ00) | (1 << UCSZ01);
 
-   if (baud_rate_kbps == 0 || baud_rate_kbps == 9600)
+   if (baud_rate == 0 || baud_rate == SERIAL_BAUD_RATE)
    {
-      UBRR0 = 103;
+      serial_set_divisor(SERIAL_UBRR(SERIAL_BAUD_RATE), SERIAL_U2X(SERIAL_BAUD_RATE));
    }
    else
    {
-      UBRR0 = (uint8_t)(F_CPU / (16.0 * baud_rate_kbps) - 1 + 0.5);  
+      serial_set_baud_rate(baud_rate);
    }
 
    UDR0 = '\r';
    serial_initialized = true;
+   asm("SEI");
+   return;
+}
+
+/********************************************************************************
+* serial_set_overflow_policy: Vljer tgrd fr nr sndbufferten r full.
+*
+*                             - policy: tgrden som ska anvndas.
+********************************************************************************/
+void serial_set_overflow_policy(const enum serial_overflow_policy policy)
+{
+   tx_policy = policy;
+   return;
+}
+
+/********************************************************************************
+* serial_write: Placerar angivet antal byte i sndbufferten och returnerar
+*               antalet byte som kades. Vid SERIAL_OVERFLOW_DROP avbryts
+*               skrivningen vid frsta byte som inte fr plats.
+*
+*               - data: Pekare till de byte som ska skickas.
+*               - size: Antalet byte som ska skickas.
+********************************************************************************/
+size_t serial_write(const void* data, 
+                    const size_t size)
+{
+   const char* bytes = (const char*)data;
+   size_t num_queued = 0;
+
+   while (num_queued < size && serial_write_char(bytes[num_queued]))
+   {
+      num_queued++;
+   }
+   return num_queued;
+}
+
+/********************************************************************************
+* serial_write_char: Placerar ett enskilt tecken i sndbufferten. Returnerar 1
+*                    om tecknet kades, annars 0.
+*
+*                    Om sndbufferten r full hanteras tecknet enligt vald
+*                    tgrd. Vid SERIAL_OVERFLOW_BLOCK vntas tills plats
+*                    finns. Om avbrott r inaktiverade (exempelvis vid anrop
+*                    frn en avbrottsrutin) kan bufferten inte tmmas under
+*                    vntan, drmed kastas tecknet i stllet som vid
+*                    SERIAL_OVERFLOW_DROP.
+*
+*                    Kontroll av ledig plats, lagring av tecknet samt
+*                    upprkning av tx_end sker med avbrott inaktiverade,
+*                    eftersom bde huvudprogrammet och avbrottsrutiner kan
+*                    skriva till sndbufferten. Vntan sker med avbrott
+*                    aktiverade. Under en pgende reservation placeras
+*                    tecknet efter reservationen och skickas frst nr
+*                    reservationen har slutfrts.
+*
+*                    - character: Tecknet som ska skickas.
+********************************************************************************/
+uint8_t serial_write_char(const char character)
+{
+   while (1)
+   {
+      const uint8_t sreg = SREG;
+      asm("CLI");
+      const uint8_t next = (tx_end + 1) & SERIAL_TX_BUFFER_MASK;
+
+      if (next == tx_tail && tx_policy == SERIAL_OVERFLOW_OVERWRITE && tx_tail != tx_head)
+      {
+         tx_tail = (tx_tail + 1) & SERIAL_TX_BUFFER_MASK;
+      }
+
+      if (next != tx_tail)
+      {
+         tx_buffer[tx_end] = (uint8_t)character;
+         tx_end = next;
+
+         if (!tx_reserved)
+         {
+            tx_head = next;
+            UCSR0B |= (1 << UDRIE0);
+         }
+
+         SREG = sreg;
+         return 1;
+      }
+
+      SREG = sreg;
+
+      if (tx_policy != SERIAL_OVERFLOW_BLOCK || !(sreg & (1 << SREG_I)))
+      {
+         return 0;
+      }
+   }
+}
+
+/********************************************************************************
+* serial_write_string: Placerar ett textstycke i sndbufferten utan
+*                      konvertering av nyradstecken och returnerar antalet
+*                      tecken som kades.
+*
+*                      - s: Pekare till det textstycke som ska skickas.
+********************************************************************************/
+size_t serial_write_string(const char* s)
+{
+   size_t num_queued = 0;
+
+   for (const char* i = s; *i; ++i)
+   {
+      if (!serial_write_char(*i)) break;
+      num_queued++;
+   }
+   return num_queued;
+}
+
+/********************************************************************************
+* serial_write_string_P: Placerar ett textstycke lagrat i programminnet i
+*                        sndbufferten utan konvertering av nyradstecken och
+*                        returnerar antalet tecken som kades.
+*
+*                        - s: Pekare till textstycket i programminnet.
+********************************************************************************/
+size_t serial_write_string_P(PGM_P s)
+{
+   size_t num_queued = 0;
+
+   for (char c = pgm_read_byte(s); c; c = pgm_read_byte(++s))
+   {
+      if (!serial_write_char(c)) break;
+      num_queued++;
+   }
+   return num_queued;
+}
+
+/********************************************************************************
+* serial_tx_reserve: Reserverar angivet antal platser i fljd i sndbufferten,
+*                    vilka drefter fylls via serial_tx_put med avbrott
+*                    aktiverade. Endast reservationen grs med avbrott
+*                    inaktiverade. Returnerar true om platserna
+*                    reserverades, annars false om plats saknas eller om en
+*                    reservation redan pgr.
+*
+*                    - size: Antalet platser som ska reserveras.
+********************************************************************************/
+bool serial_tx_reserve(const size_t size)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+
+   if (tx_reserved || serial_tx_free() < size)
+   {
+      SREG = sreg;
+      return false;
+   }
+
+   tx_fill = tx_end;
+   tx_end = (uint8_t)(tx_end + size) & SERIAL_TX_BUFFER_MASK;
+   tx_reserved = true;
+   SREG = sreg;
+   return true;
+}
+
+/********************************************************************************
+* serial_tx_put: Placerar nsta byte i pgende reservation. Platserna tillhr
+*                endast reservationen, drmed krvs ingen synkronisering.
+*
+*                - data: Byten som ska placeras.
+********************************************************************************/
+void serial_tx_put(const uint8_t data)
+{
+   tx_buffer[tx_fill] = data;
+   tx_fill = (tx_fill + 1) & SERIAL_TX_BUFFER_MASK;
+   return;
+}
+
+/********************************************************************************
+* serial_tx_commit: Slutfr pgende reservation, varvid reserverade byte samt
+*                   tecken som har placerats efter reservationen under tiden
+*                   brjar skickas. En minnesbarrir hindrar kompilatorn frn
+*                   att flytta skrivningarna till reservationen frbi
+*                   publiceringen.
+********************************************************************************/
+void serial_tx_commit(void)
+{
+   asm volatile("" ::: "memory");
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   tx_reserved = false;
+   tx_head = tx_end;
+   UCSR0B |= (1 << UDRIE0);
+   SREG = sreg;
+   return;
+}
+
+/********************************************************************************
+* serial_tx_pending: Returnerar antalet byte som vntar p att skickas,
+*                    inklusive reserverade platser.
+********************************************************************************/
+size_t serial_tx_pending(void)
+{
+   return (uint8_t)(tx_end - tx_tail) & SERIAL_TX_BUFFER_MASK;
+}
+
+/********************************************************************************
+* serial_tx_free: Returnerar antalet lediga platser i sndbufferten. En plats
+*                 hlls alltid tom fr att skilja en full buffert frn en tom.
+********************************************************************************/
+size_t serial_tx_free(void)
+{
+   return SERIAL_TX_BUFFER_MASK - serial_tx_pending();
+}
+
+/********************************************************************************
+* serial_flush: Vntar tills sndbufferten r tom och sista tecknet har
+*               skiftats ut p sndlinjen, vilket indikeras av flaggan TXC0.
+*               Om avbrott r inaktiverade skickas kvarvarande tecken direkt.
+********************************************************************************/
+void serial_flush(void)
+{
+   if (!(UCSR0B & (1 << TXEN0))) return;
+
+   while (tx_head != tx_tail)
+   {
+      if (!serial_interrupts_enabled() && (UCSR0A & (1 << UDRE0)))
+      {
+         serial_transmit_next();
+      }
+   }
+
+   while ((UCSR0A & (1 << TXC0)) == 0);
+   return;
+}
+
+/********************************************************************************
+* serial_discard: Tmmer sndbufferten utan att skicka kvarvarande tecken.
+*                 Ett tecken som redan har placerats i dataregistret skickas.
+********************************************************************************/
+void serial_discard(void)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   tx_tail = tx_head;
+   UCSR0B &= ~(1 << UDRIE0);
+   SREG = sreg;
+   return;
+}
+
+/********************************************************************************
+* serial_read_char: Lser nsta mottagna tecken frn mottagarbufferten.
+*                   Returnerar true om ett tecken lstes, annars false.
+*
+*                   - character: Pekare till variabel dr tecknet lagras.
+********************************************************************************/
+bool serial_read_char(char* character)
+{
+   if (rx_head == rx_tail) return false;
+   *character = (char)rx_buffer[rx_tail];
+   rx_tail = (rx_tail + 1) & SERIAL_RX_BUFFER_MASK;
+   return true;
+}
+
+/********************************************************************************
+* serial_rx_available: Returnerar antalet mottagna tecken som vntar p att
+*                      lsas.
+********************************************************************************/
+size_t serial_rx_available(void)
+{
+   return (uint8_t)(rx_head - rx_tail) & SERIAL_RX_BUFFER_MASK;
+}
+
+/********************************************************************************
+* serial_rx_discard: Tmmer mottagarbufferten.
+********************************************************************************/
+void serial_rx_discard(void)
+{
+   rx_tail = rx_head;
+   return;
+}
+
+/********************************************************************************
+* serial_set_rx_handler: Anger funktion som anropas frn avbrottsrutinen fr
+*                        varje mottaget tecken, i stllet fr att tecknet
+*                        placeras i mottagarbufferten. Anges 0 anvnds
+*                        mottagarbufferten igen.
+*
+*                        - handler: Pekare till funktionen (eller 0).
+*                        - arg    : Argument som skickas till funktionen.
+********************************************************************************/
+void serial_set_rx_handler(void (*handler)(void* arg, uint8_t data),
+                           void* arg)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   rx_handler = handler;
+   rx_handler_arg = arg;
+   SREG = sreg;
    return;
 }
 
+/********************************************************************************
+* serial_line_init: Initierar radinlsning till angiven buffert.
+*
+*                   - self  : Pekare till objektet som ska initieras.
+*                   - buffer: Pekare till buffert dr raden ska lagras.
+*                   - size  : Buffertens storlek (inklusive nolltecken).
+*                   - echo  : Indikerar ifall mottagna tecken ska skrivas
+*                             tillbaka till terminalen.
+********************************************************************************/
+void serial_line_init(struct serial_line* self,
+                      char* buffer,
+                      const uint8_t size,
+                      const bool echo)
+{
+   self->buffer = buffer;
+   self->size = size;
+   self->length = 0;
+   self->previous = '\0';
+   self->echo = echo;
+   self->buffer[0] = '\0';
+   return;
+}
+
+/********************************************************************************
+* serial_line_poll: Lser mottagna tecken till angiven rad och returnerar
+*                   true nr en hel rad har tagits emot, vilket sker vid CR
+*                   eller LF. Ett LF direkt efter ett CR ignoreras s att
+*                   terminaler som skickar CR + LF inte ger en tom rad.
+*                   Backsteg tar bort senast mottagna tecken. Tecken som inte
+*                   fr plats i bufferten kastas.
+*
+*                   - self: Pekare till raden som tecken ska lsas till.
+********************************************************************************/
+bool serial_line_poll(struct serial_line* self)
+{
+   char c;
+
+   while (serial_read_char(&c))
+   {
+      const char previous = self->previous;
+      self->previous = c;
+
+      if (c == '\n' && previous == '\r')
+      {
+         continue;
+      }
+      else if (c == '\r' || c == '\n')
+      {
+         if (self->echo) serial_print_new_line();
+         self->buffer[self->length] = '\0';
+         self->length = 0;
+         return true;
+      }
+      else if (c == '\b' || c == 0x7F)
+      {
+         if (self->length > 0)
+         {
+            self->length--;
+            if (self->echo) serial_print_P("\b \b");
+         }
+      }
+      else if (self->length < self->size - 1)
+      {
+         self->buffer[self->length++] = c;
+         if (self->echo) serial_print_char(c);
+      }
+   }
+   return false;
+}
+
 /********************************************************************************
 * serial_print_string: Skriver ut text via seriell verfring.
 *
@@ -54,6 +526,27 @@ void serial_print_string(const char* s)
    return;
 }
 
+/********************************************************************************
+* serial_print_string_P: Skriver ut text lagrad i programminnet via seriell
+*                        verfring. Nyradstecken fljs av vagnretur, likt
+*                        serial_print_string.
+*
+*                        - s: Pekare till textstycket i programminnet.
+********************************************************************************/
+void serial_print_string_P(PGM_P s)
+{
+   for (char c = pgm_read_byte(s); c; c = pgm_read_byte(++s))
+   {
+      serial_print_char(c);
+
+      if (c == '\n')
+      {
+         serial_print_char('\r');
+      }
+   }
+   return;
+}
+
 /********************************************************************************
 * serial_print_integer: Skriver ut ett signerat heltal via seriell verfring.
 *
@@ -61,9 +554,7 @@ void serial_print_string(const char* s)
 ********************************************************************************/
 void serial_print_integer(const int32_t number)
 {
-   char s[20] = { '\0' };
-   sprintf(s, "%ld", number);
-   serial_print_string(s);
+   serial_print_int32(number);
    return;
 }
 
@@ -74,46 +565,339 @@ void serial_print_integer(const int32_t number)
 ********************************************************************************/
 void serial_print_unsigned(const uint32_t number)
 {
-   char s[20] = { '\0' };
-   sprintf(s, "%lu", number);
-   serial_print_string(s);
+   serial_print_uint32(number);
    return;
 }
 
 /********************************************************************************
-* serial_print_double: Skriver ut ett flyttal med upp till tv decimaler 
-*                      via seriell verfring.
+* serial_print_double: Skriver ut ett flyttal avrundat till tv decimaler 
+*                      via seriell verfring. Flyttalet skalas om till ett
+*                      fixtal med tv decimaler, som skrivs ut via
+*                      serial_print_fixed.
 *
 *                      - number: Flyttalet som ska skrivas ut.
 ********************************************************************************/
 void serial_print_double(const double number)
 {
-   const int32_t integer = (int32_t)number;
-   int32_t decimal;
-   char s[20] = { '\0' };
-   
-   if (integer >= 0)
+   const int32_t fixed = (int32_t)(number < 0 ? number * 100 - 0.5 : number * 100 + 0.5);
+   serial_print_fixed(fixed, 2);
+   return;
+}
+
+/********************************************************************************
+* serial_print_uint8: Skriver ut ett osignerat 8-bitars heltal decimalt.
+*
+*                     - number: Heltalet som ska skrivas ut.
+********************************************************************************/
+void serial_print_uint8(const uint8_t number)
+{
+   serial_print_decimal16(number, SERIAL_DECIMAL16_DIGITS - 3);
+   return;
+}
+
+/********************************************************************************
+* serial_print_uint16: Skriver ut ett osignerat 16-bitars heltal decimalt.
+*
+*                      - number: Heltalet som ska skrivas ut.
+********************************************************************************/
+void serial_print_uint16(const uint16_t number)
+{
+   serial_print_decimal16(number, 0);
+   return;
+}
+
+/********************************************************************************
+* serial_print_uint32: Skriver ut ett osignerat 32-bitars heltal decimalt.
+*                      Tal som ryms i 16 bitar skrivs ut via den snabbare
+*                      16-bitars rutinen.
+*
+*                      - number: Heltalet som ska skrivas ut.
+********************************************************************************/
+void serial_print_uint32(const uint32_t number)
+{
+   if (number <= UINT16_MAX)
    {
-      decimal = (int32_t)((number - integer) * 100 + 0.5);
+      serial_print_decimal16((uint16_t)number, 0);
    }
    else
    {
-      decimal = (int32_t)((integer - number) * 100 + 0.5);
+      serial_print_decimal32(number, 0);
    }
+   return;
+}
+
+/********************************************************************************
+* serial_print_int8: Skriver ut ett signerat 8-bitars heltal decimalt.
+*
+*                    - number: Heltalet som ska skrivas ut.
+********************************************************************************/
+void serial_print_int8(const int8_t number)
+{
+   if (number < 0) serial_write_char('-');
+   serial_print_uint8(number < 0 ? (uint8_t)(0 - (uint8_t)number) : (uint8_t)number);
+   return;
+}
+
+/********************************************************************************
+* serial_print_int16: Skriver ut ett signerat 16-bitars heltal decimalt.
+*
+*                     - number: Heltalet som ska skrivas ut.
+********************************************************************************/
+void serial_print_int16(const int16_t number)
+{
+   if (number < 0) serial_write_char('-');
+   serial_print_uint16(number < 0 ? (uint16_t)(0 - (uint16_t)number) : (uint16_t)number);
+   return;
+}
+
+/********************************************************************************
+* serial_print_int32: Skriver ut ett signerat 32-bitars heltal decimalt.
+*
+*                     - number: Heltalet som ska skrivas ut.
+********************************************************************************/
+void serial_print_int32(const int32_t number)
+{
+   if (number < 0) serial_write_char('-');
+   serial_print_uint32(number < 0 ? (uint32_t)0 - (uint32_t)number : (uint32_t)number);
+   return;
+}
+
+/********************************************************************************
+* serial_print_hex8: Skriver ut ett 8-bitars tal som tv hexadecimala siffror.
+*
+*                    - number: Talet som ska skrivas ut.
+********************************************************************************/
+void serial_print_hex8(const uint8_t number)
+{
+   serial_write_char(serial_hex_digit(number >> 4));
+   serial_write_char(serial_hex_digit(number & 0x0F));
+   return;
+}
+
+/********************************************************************************
+* serial_print_hex16: Skriver ut ett 16-bitars tal som fyra hexadecimala
+*                     siffror.
+*
+*                     - number: Talet som ska skrivas ut.
+********************************************************************************/
+void serial_print_hex16(const uint16_t number)
+{
+   serial_print_hex8((uint8_t)(number >> 8));
+   serial_print_hex8((uint8_t)number);
+   return;
+}
+
+/********************************************************************************
+* serial_print_hex32: Skriver ut ett 32-bitars tal som tta hexadecimala
+*                     siffror.
+*
+*                     - number: Talet som ska skrivas ut.
+********************************************************************************/
+void serial_print_hex32(const uint32_t number)
+{
+   serial_print_hex16((uint16_t)(number >> 16));
+   serial_print_hex16((uint16_t)number);
+   return;
+}
 
-   sprintf(s, "%ld.%ld", integer, decimal);
-   serial_print_string(s);
+/********************************************************************************
+* serial_print_fixed: Skriver ut ett fixtal med angivet antal decimaler, dr
+*                     talet utgr vrdet multiplicerat med 10^decimals.
+*                     Exempelvis skrivs vrdet -1234 med tv decimaler ut
+*                     som -12.34 och vrdet 5 med tre decimaler som 0.005.
+*
+*                     - value   : Fixtalet som ska skrivas ut.
+*                     - decimals: Antalet decimaler (0 - 9).
+********************************************************************************/
+void serial_print_fixed(const int32_t value,
+                        const uint8_t decimals)
+{
+   if (value < 0) serial_write_char('-');
+   serial_print_decimal32(value < 0 ? (uint32_t)0 - (uint32_t)value : (uint32_t)value,
+                          decimals > SERIAL_DECIMAL32_DIGITS - 1 ? SERIAL_DECIMAL32_DIGITS - 1 : decimals);
    return;
 }
 
 /********************************************************************************
-* serial_print_char: Skriver ut ett enskilt tecken via seriell verfring.
+* serial_print_char: Skriver ut ett enskilt tecken via seriell verfring genom
+*                    att placera det i sndbufferten.
 *
 *                    - character: Det tecken som ska skrivas ut.
 ********************************************************************************/
 void serial_print_char(const char character)
 {
-   while ((UCSR0A & (1 << UDRE0)) == 0);
-   UDR0 = character;
+   (void)serial_write_char(character);
+   return;
+}
+
+/********************************************************************************
+* serial_transmit_next: Skickar nsta tecken i sndbufferten. Flaggan TXC0
+*                       nollstlls s att serial_flush kan avgra nr sista
+*                       tecknet har skickats. Om sndbufferten r tom
+*                       inaktiveras avbrott fr tomt dataregister.
+********************************************************************************/
+static inline void serial_transmit_next(void)
+{
+   if (tx_head == tx_tail)
+   {
+      UCSR0B &= ~(1 << UDRIE0);
+      return;
+   }
+
+   UDR0 = tx_buffer[tx_tail];
+   UCSR0A = (UCSR0A & ((1 << U2X0) | (1 << MPCM0))) | (1 << TXC0);
+   tx_tail = (tx_tail + 1) & SERIAL_TX_BUFFER_MASK;
+   return;
+}
+
+/********************************************************************************
+* serial_interrupts_enabled: Indikerar ifall avbrott r globalt aktiverade.
+********************************************************************************/
+static inline bool serial_interrupts_enabled(void)
+{
+   return (SREG & (1 << SREG_I));
+}
+
+/********************************************************************************
+* serial_set_divisor: Stter angiven divisor samt vljer normal eller dubbel
+*                     hastighet.
+*
+*                     - ubrr        : Divisorn som ska skrivas till UBRR0.
+*                     - double_speed: Indikerar ifall dubbel hastighet (U2X0)
+*                                     ska anvndas.
+********************************************************************************/
+static void serial_set_divisor(const uint16_t ubrr,
+                               const bool double_speed)
+{
+   UCSR0A = double_speed ? (1 << U2X0) : 0;
+   UBRR0 = ubrr;
+   return;
+}
+
+/********************************************************************************
+* serial_set_baud_rate: Berknar divisor fr angiven baud rate vid krning
+*                       och vljer normal eller dubbel hastighet beroende p
+*                       vilket lge som ger lgst avvikelse, p samma stt
+*                       som berkningen vid kompilering i serial.h.
+*
+*                       - baud_rate: nskad baud rate i bitar per sekund.
+********************************************************************************/
+static void serial_set_baud_rate(const uint32_t baud_rate)
+{
+   if (baud_rate > F_CPU / 8)
+   {
+      serial_set_divisor(0, true);
+      return;
+   }
+
+   const uint32_t ubrr_normal = (F_CPU + 8 * baud_rate) / (16 * baud_rate) - 1;
+   const uint32_t ubrr_double = (F_CPU + 4 * baud_rate) / (8 * baud_rate) - 1;
+   const uint32_t rate_normal = F_CPU / (16 * (ubrr_normal + 1));
+   const uint32_t rate_double = F_CPU / (8 * (ubrr_double + 1));
+   const uint32_t error_normal = rate_normal > baud_rate ? rate_normal - baud_rate : baud_rate - rate_normal;
+   const uint32_t error_double = rate_double > baud_rate ? rate_double - baud_rate : baud_rate - rate_double;
+
+   if (ubrr_double <= SERIAL_UBRR_MAX && error_double < error_normal)
+   {
+      serial_set_divisor((uint16_t)ubrr_double, true);
+   }
+   else
+   {
+      serial_set_divisor(ubrr_normal > SERIAL_UBRR_MAX ? SERIAL_UBRR_MAX : (uint16_t)ubrr_normal, false);
+   }
+   return;
+}
+
+/********************************************************************************
+* serial_print_decimal16: Skriver ut ett 16-bitars tal decimalt direkt till
+*                         sndbufferten, mest signifikant siffra frst.
+*
+*                         Varje siffra berknas genom upprepad subtraktion av
+*                         aktuell tiopotens (hgst nio subtraktioner per
+*                         siffra), vilket undviker division helt. AVR saknar
+*                         divisionsinstruktion, varp division anropar en
+*                         lngsam mjukvarurutin fr varje siffra.
+*
+*                         - number: Talet som ska skrivas ut.
+*                         - first : Index fr frsta tiopotensen som ska
+*                                   anvndas (0 fr 10 000, 2 fr 100).
+********************************************************************************/
+static void serial_print_decimal16(uint16_t number, 
+                                   const uint8_t first)
+{
+   bool leading_zero = true;
+
+   for (uint8_t i = first; i < SERIAL_DECIMAL16_DIGITS - 1; ++i)
+   {
+      const uint16_t power = pgm_read_word(&powers_of_ten16[i]);
+      char digit = '0';
+
+      while (number >= power)
+      {
+         number -= power;
+         digit++;
+      }
+
+      if (digit != '0' || !leading_zero)
+      {
+         serial_write_char(digit);
+         leading_zero = false;
+      }
+   }
+
+   serial_write_char('0' + (char)number);
+   return;
+}
+
+/********************************************************************************
+* serial_print_decimal32: Skriver ut ett 32-bitars tal decimalt direkt till
+*                         sndbufferten via upprepad subtraktion av
+*                         tiopotenser, se serial_print_decimal16. Om antalet
+*                         decimaler verstiger 0 skrivs en decimalpunkt ut
+*                         fre de sista siffrorna, dr inledande nollor
+*                         skrivs ut s att exempelvis 5 med tv decimaler
+*                         skrivs ut som 0.05.
+*
+*                         - number  : Talet som ska skrivas ut.
+*                         - decimals: Antalet decimaler (0 - 9).
+********************************************************************************/
+static void serial_print_decimal32(uint32_t number, 
+                                   const uint8_t decimals)
+{
+   bool leading_zero = true;
+
+   for (uint8_t i = 0; i < SERIAL_DECIMAL32_DIGITS - 1; ++i)
+   {
+      const uint8_t position = SERIAL_DECIMAL32_DIGITS - 1 - i;
+      const uint32_t power = pgm_read_dword(&powers_of_ten32[i]);
+      char digit = '0';
+
+      while (number >= power)
+      {
+         number -= power;
+         digit++;
+      }
+
+      if (digit != '0' || !leading_zero || position <= decimals)
+      {
+         if (position + 1 == decimals) serial_write_char('.');
+         serial_write_char(digit);
+         leading_zero = false;
+      }
+   }
+
+   if (decimals == 1) serial_write_char('.');
+   serial_write_char('0' + (char)number);
    return;
+}
+
+/********************************************************************************
+* serial_hex_digit: Returnerar motsvarande hexadecimala siffra (0 - F) fr
+*                   angivet 4-bitars tal.
+*
+*                   - nibble: Talet som ska omvandlas (0 - 15).
+********************************************************************************/
+static inline char serial_hex_digit(const uint8_t nibble)
+{
+   return nibble < 10 ? '0' + nibble : 'A' - 10 + nibble;
 }
\ No newline at end of file
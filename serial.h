@@ -1,5 +1,26 @@
 /********************************************************************************
 * serial.h: Innehller drivrutiner fr seriell verfring via USART.
+*
+*           Utskrift sker avbrottsstyrt: tecken som ska skrivas ut placeras i
+*           en ringbuffert, som tms en byte i taget av avbrottsrutinen fr
+*           avbrottsvektor USART_UDRE_vect. Utskriftsfunktionerna returnerar
+*           drmed direkt och kan anropas frn avbrottsrutiner utan att
+*           processorn blir upptagen tills samtliga tecken har skickats.
+*
+*           Vad som sker nr sndbufferten r full vljs via funktionen
+*           serial_set_overflow_policy, se enumerationen serial_overflow_policy.
+*
+*           Heltal, hexadecimala tal samt fixtal skrivs ut siffra fr siffra
+*           direkt till sndbufferten utan sprintf, se serial.c. Kostnaden
+*           r uppskattad till cirka 120 - 1500 klockcykler per heltal
+*           (1 - 10 siffror) mot cirka 1900 - 4300 via sprintf. Siffrorna
+*           r rknade fr hand utifrn instruktionsantal och inte
+*           uppmtta.
+*
+*           Mottagning sker p samma stt avbrottsstyrt via avbrottsvektor
+*           USART_RX_vect, dr mottagna tecken placeras i en mottagarbuffert.
+*           Tecknen lses sedan ut frn huvudprogrammet via serial_read_char
+*           eller radvis via strukten serial_line.
 ********************************************************************************/
 #ifndef SERIAL_H_
 #define SERIAL_H_
@@ -7,12 +28,271 @@
 /* Inkluderingsdirektiv: */
 #include "misc.h"
 
+/* Makrodefinitioner: */
+#ifndef SERIAL_TX_BUFFER_SIZE
+#define SERIAL_TX_BUFFER_SIZE 128 /* Sndbuffertens storlek i byte (tvpotens, max 256). */
+#endif
+
+#ifndef SERIAL_RX_BUFFER_SIZE
+#define SERIAL_RX_BUFFER_SIZE 64 /* Mottagarbuffertens storlek i byte (tvpotens, max 256). */
+#endif
+
+/********************************************************************************
+* Baud rate: Divisorn UBRR0 samt valet av dubbel hastighet (U2X0) berknas vid
+*            kompilering fr baud rate SERIAL_BAUD_RATE. Det lge som ger
+*            lgst avvikelse frn nskad baud rate vljs, dr normal
+*            hastighet vljs vid lika avvikelse eftersom mottagaren d
+*            samplar fler gnger per bit. Kompileringen avbryts om
+*            avvikelsen verstiger SERIAL_BAUD_ERROR_MAX (angivet i
+*            hundradels procent).
+*
+*            Uppnelig avvikelse vid 16 MHz:
+*
+*            Baud rate   UBRR0   U2X0   Verklig baud rate   Avvikelse
+*                 2400     832      1              2401.0     +0.04 %
+*                 4800     416      1              4796.2     -0.08 %
+*                 9600     103      0              9615.4     +0.16 %
+*                14400     138      1             14388.5     -0.08 %
+*                19200      51      0             19230.8     +0.16 %
+*                28800      68      1             28985.5     +0.64 %
+*                38400      25      0             38461.5     +0.16 %
+*                57600      34      1             57142.9     -0.79 %
+*                76800      12      0             76923.1     +0.16 %
+*               115200      16      1            117647.1     +2.12 %
+*               230400       8      1            222222.2     -3.55 %
+*               250000       3      0            250000.0      0.00 %
+*               500000       1      0            500000.0      0.00 %
+*              1000000       0      0           1000000.0      0.00 %
+*              2000000       0      1           2000000.0      0.00 %
+*
+*            Baud rates 250k, 500k, 1M samt 2M ger drmed exakt verfring,
+*            medan 115 200 och 230 400 verstiger rekommenderad avvikelse p
+*            2 % enligt databladet.
+********************************************************************************/
+#ifndef SERIAL_BAUD_RATE
+#define SERIAL_BAUD_RATE 9600UL /* Baud rate vars divisor berknas vid kompilering. */
+#endif
+
+#ifndef SERIAL_BAUD_ERROR_MAX
+#define SERIAL_BAUD_ERROR_MAX 200 /* Maximal avvikelse i hundradels procent (2.00 %). */
+#endif
+
+#define SERIAL_UBRR_MAX 4095 /* Hgsta mjliga vrde p divisorn UBRR0. */
+
+/* Divisor vid normal respektive dubbel hastighet, avrundad till nrmaste heltal: */
+#define SERIAL_UBRR_NORMAL(baud) (((F_CPU) + 8ULL * (baud)) / (16ULL * (baud)) - 1ULL)
+#define SERIAL_UBRR_DOUBLE(baud) (((F_CPU) + 4ULL * (baud)) / (8ULL * (baud)) - 1ULL)
+
+/* Absolut avvikelse i hundradels procent vid normal respektive dubbel hastighet: */
+#define SERIAL_ABS_DIFF(a, b) ((a) > (b) ? (a) - (b) : (b) - (a))
+#define SERIAL_ERROR_NORMAL(baud) \
+   (SERIAL_ABS_DIFF((F_CPU) * 10000ULL / (16ULL * (SERIAL_UBRR_NORMAL(baud) + 1ULL)), \
+                    (baud) * 10000ULL) / (baud))
+#define SERIAL_ERROR_DOUBLE(baud) \
+   (SERIAL_UBRR_DOUBLE(baud) > SERIAL_UBRR_MAX ? 10000ULL : \
+    SERIAL_ABS_DIFF((F_CPU) * 10000ULL / (8ULL * (SERIAL_UBRR_DOUBLE(baud) + 1ULL)), \
+                    (baud) * 10000ULL) / (baud))
+
+/* Valt lge (1 = dubbel hastighet), motsvarande divisor samt avvikelse: */
+#define SERIAL_U2X(baud) (SERIAL_ERROR_DOUBLE(baud) < SERIAL_ERROR_NORMAL(baud) ? 1 : 0)
+#define SERIAL_UBRR(baud) (SERIAL_U2X(baud) ? SERIAL_UBRR_DOUBLE(baud) : SERIAL_UBRR_NORMAL(baud))
+#define SERIAL_BAUD_ERROR(baud) \
+   (SERIAL_U2X(baud) ? SERIAL_ERROR_DOUBLE(baud) : SERIAL_ERROR_NORMAL(baud))
+
+#if SERIAL_BAUD_RATE < 1 || SERIAL_BAUD_RATE > (F_CPU) / 8
+#error "SERIAL_BAUD_RATE is out of range for F_CPU!"
+#elif SERIAL_UBRR_NORMAL(SERIAL_BAUD_RATE) > SERIAL_UBRR_MAX
+#error "SERIAL_BAUD_RATE is too low for F_CPU!"
+#elif SERIAL_BAUD_ERROR(SERIAL_BAUD_RATE) > SERIAL_BAUD_ERROR_MAX
+#error "Baud rate error for SERIAL_BAUD_RATE exceeds SERIAL_BAUD_ERROR_MAX!"
+#endif
+
+/********************************************************************************
+* serial_overflow_policy: Enumeration fr val av tgrd nr ett tecken ska
+*                         placeras i sndbufferten och denna r full.
+********************************************************************************/
+enum serial_overflow_policy
+{
+   SERIAL_OVERFLOW_BLOCK,    /* Vntar tills plats finns (default), kastar vid inaktiverade avbrott. */
+   SERIAL_OVERFLOW_DROP,     /* Kastar nya tecken som inte fr plats. */
+   SERIAL_OVERFLOW_OVERWRITE /* Skriver ver de ldsta tecknen i sndbufferten. */
+};
+
+/********************************************************************************
+* serial_line: Strukt fr radvis inlsning av mottagna tecken, exempelvis
+*              kommandon skrivna i en seriell terminal. Tecken samlas i en
+*              angiven buffert tills ett radslut (CR eller LF) tas emot.
+********************************************************************************/
+struct serial_line
+{
+   char* buffer;   /* Pekare till buffert dr raden lagras. */
+   uint8_t size;   /* Buffertens storlek, inklusive nolltecken. */
+   uint8_t length; /* Antalet tecken i raden hittills. */
+   char previous;  /* Senast mottaget tecken (fr hantering av CR + LF). */
+   bool echo;      /* Indikerar ifall mottagna tecken ska skrivas tillbaka. */
+};
+
 /********************************************************************************
 * serial_init: Initierar USART fr seriell verfring med angiven baud rate.
+*              Fr baud rate SERIAL_BAUD_RATE (eller 0) anvnds divisorn som
+*              berknats och kontrollerats vid kompilering. vriga baud rates
+*              berknas vid krning utan kontroll av avvikelsen.
+*
+*              - baud_rate: verfringshastighet mtt i bitar per sekund,
+*                           eller 0 fr SERIAL_BAUD_RATE.
+********************************************************************************/
+void serial_init(const uint32_t baud_rate);
+
+/********************************************************************************
+* serial_set_overflow_policy: Vljer tgrd fr nr sndbufferten r full.
 *
-*              - baud_rate: verfringshastighet mtt i kilobits per sekund.
+*                             - policy: tgrden som ska anvndas.
 ********************************************************************************/
-void serial_init(const uint32_t baud_rate_kbps);
+void serial_set_overflow_policy(const enum serial_overflow_policy policy);
+
+/********************************************************************************
+* serial_write: Placerar angivet antal byte i sndbufferten och returnerar
+*               antalet byte som kades. Returvrdet understiger angivet
+*               antal byte endast om tecken har kastats (SERIAL_OVERFLOW_DROP,
+*               eller SERIAL_OVERFLOW_BLOCK med avbrott inaktiverade).
+*
+*               - data: Pekare till de byte som ska skickas.
+*               - size: Antalet byte som ska skickas.
+********************************************************************************/
+size_t serial_write(const void* data, 
+                    const size_t size);
+
+/********************************************************************************
+* serial_write_char: Placerar ett enskilt tecken i sndbufferten. Returnerar 1
+*                    om tecknet kades, annars 0.
+*
+*                    - character: Tecknet som ska skickas.
+********************************************************************************/
+uint8_t serial_write_char(const char character);
+
+/********************************************************************************
+* serial_write_string: Placerar ett textstycke i sndbufferten utan
+*                      konvertering av nyradstecken och returnerar antalet
+*                      tecken som kades.
+*
+*                      - s: Pekare till det textstycke som ska skickas.
+********************************************************************************/
+size_t serial_write_string(const char* s);
+
+/********************************************************************************
+* serial_write_string_P: Placerar ett textstycke lagrat i programminnet i
+*                        sndbufferten utan konvertering av nyradstecken och
+*                        returnerar antalet tecken som kades.
+*
+*                        - s: Pekare till textstycket i programminnet.
+********************************************************************************/
+size_t serial_write_string_P(PGM_P s);
+
+/********************************************************************************
+* serial_tx_reserve: Reserverar angivet antal platser i fljd i sndbufferten,
+*                    exempelvis fr en ram som ska skickas i sin helhet utan
+*                    att avbrott r inaktiverade medan den skrivs. Platserna
+*                    fylls via serial_tx_put och skickas efter anrop av
+*                    serial_tx_commit. Tecken som skrivs frn avbrottsrutiner
+*                    under tiden hamnar efter reservationen. Endast en
+*                    reservation t gngen kan gras, och endast frn
+*                    huvudprogrammet. Returnerar true om platserna
+*                    reserverades, annars false.
+*
+*                    - size: Antalet platser som ska reserveras.
+********************************************************************************/
+bool serial_tx_reserve(const size_t size);
+
+/********************************************************************************
+* serial_tx_put: Placerar nsta byte i pgende reservation.
+*
+*                - data: Byten som ska placeras.
+********************************************************************************/
+void serial_tx_put(const uint8_t data);
+
+/********************************************************************************
+* serial_tx_commit: Slutfr pgende reservation, varvid reserverade byte
+*                   brjar skickas.
+********************************************************************************/
+void serial_tx_commit(void);
+
+/********************************************************************************
+* serial_tx_pending: Returnerar antalet byte som vntar p att skickas.
+********************************************************************************/
+size_t serial_tx_pending(void);
+
+/********************************************************************************
+* serial_tx_free: Returnerar antalet lediga platser i sndbufferten.
+********************************************************************************/
+size_t serial_tx_free(void);
+
+/********************************************************************************
+* serial_flush: Vntar tills sndbufferten r tom och sista tecknet har
+*               skiftats ut p sndlinjen.
+********************************************************************************/
+void serial_flush(void);
+
+/********************************************************************************
+* serial_discard: Tmmer sndbufferten utan att skicka kvarvarande tecken.
+********************************************************************************/
+void serial_discard(void);
+
+/********************************************************************************
+* serial_read_char: Lser nsta mottagna tecken frn mottagarbufferten.
+*                   Returnerar true om ett tecken lstes, annars false.
+*
+*                   - character: Pekare till variabel dr tecknet lagras.
+********************************************************************************/
+bool serial_read_char(char* character);
+
+/********************************************************************************
+* serial_rx_available: Returnerar antalet mottagna tecken som vntar p att
+*                      lsas.
+********************************************************************************/
+size_t serial_rx_available(void);
+
+/********************************************************************************
+* serial_rx_discard: Tmmer mottagarbufferten.
+********************************************************************************/
+void serial_rx_discard(void);
+
+/********************************************************************************
+* serial_set_rx_handler: Anger funktion som anropas frn avbrottsrutinen fr
+*                        varje mottaget tecken, i stllet fr att tecknet
+*                        placeras i mottagarbufferten. Funktionen ska vara
+*                        kort d den exekveras med avbrott inaktiverade.
+*                        Anges 0 anvnds mottagarbufferten igen.
+*
+*                        - handler: Pekare till funktionen (eller 0).
+*                        - arg    : Argument som skickas till funktionen.
+********************************************************************************/
+void serial_set_rx_handler(void (*handler)(void* arg, uint8_t data),
+                           void* arg);
+
+/********************************************************************************
+* serial_line_init: Initierar radinlsning till angiven buffert.
+*
+*                   - self  : Pekare till objektet som ska initieras.
+*                   - buffer: Pekare till buffert dr raden ska lagras.
+*                   - size  : Buffertens storlek (inklusive nolltecken).
+*                   - echo  : Indikerar ifall mottagna tecken ska skrivas
+*                             tillbaka till terminalen.
+********************************************************************************/
+void serial_line_init(struct serial_line* self,
+                      char* buffer,
+                      const uint8_t size,
+                      const bool echo);
+
+/********************************************************************************
+* serial_line_poll: Lser mottagna tecken till angiven rad och returnerar
+*                   true nr en hel rad har tagits emot. Raden r d
+*                   nollterminerad i bufferten fram till nsta anrop.
+*                   Funktionen blockerar inte och ska anropas kontinuerligt
+*                   frn huvudprogrammet.
+*
+*                   - self: Pekare till raden som tecken ska lsas till.
+********************************************************************************/
+bool serial_line_poll(struct serial_line* self);
 
 /********************************************************************************
 * serial_print_string: Skriver ut text via seriell verfring.
@@ -21,6 +301,25 @@ void serial_init(const uint32_t baud_rate_kbps);
 ********************************************************************************/
 void serial_print_string(const char* s);
 
+/********************************************************************************
+* serial_print_string_P: Skriver ut text lagrad i programminnet via seriell
+*                        verfring. Texten lses tecken fr tecken via
+*                        pgm_read_byte och kopieras drmed aldrig till
+*                        RAM-minnet.
+*
+*                        - s: Pekare till textstycket i programminnet.
+********************************************************************************/
+void serial_print_string_P(PGM_P s);
+
+/********************************************************************************
+* serial_print_P: Skriver ut en strngliteral som lagras i programminnet i
+*                 stllet fr att kopieras till RAM-minnet vid uppstart.
+*                 Anvnds i stllet fr serial_print_string fr fasta texter.
+*
+*                 - s: Strngliteralen som ska skrivas ut.
+********************************************************************************/
+#define serial_print_P(s) serial_print_string_P(PSTR(s))
+
 /********************************************************************************
 * serial_print_integer: Skriver ut ett signerat heltal via seriell verfring.
 *
@@ -36,12 +335,90 @@ void serial_print_integer(const int32_t number);
 void serial_print_unsigned(const uint32_t number);
 
 /********************************************************************************
-* serial_print_double: Skriver ut ett flyttal via seriell verfring.
+* serial_print_double: Skriver ut ett flyttal avrundat till tv decimaler via
+*                      seriell verfring.
 *
 *                      - number: Flyttalet som ska skrivas ut.
 ********************************************************************************/
 void serial_print_double(const double number);
 
+/********************************************************************************
+* serial_print_uint8: Skriver ut ett osignerat 8-bitars heltal decimalt.
+*
+*                     - number: Heltalet som ska skrivas ut.
+********************************************************************************/
+void serial_print_uint8(const uint8_t number);
+
+/********************************************************************************
+* serial_print_uint16: Skriver ut ett osignerat 16-bitars heltal decimalt.
+*
+*                      - number: Heltalet som ska skrivas ut.
+********************************************************************************/
+void serial_print_uint16(const uint16_t number);
+
+/********************************************************************************
+* serial_print_uint32: Skriver ut ett osignerat 32-bitars heltal decimalt.
+*
+*                      - number: Heltalet som ska skrivas ut.
+********************************************************************************/
+void serial_print_uint32(const uint32_t number);
+
+/********************************************************************************
+* serial_print_int8: Skriver ut ett signerat 8-bitars heltal decimalt.
+*
+*                    - number: Heltalet som ska skrivas ut.
+********************************************************************************/
+void serial_print_int8(const int8_t number);
+
+/********************************************************************************
+* serial_print_int16: Skriver ut ett signerat 16-bitars heltal decimalt.
+*
+*                     - number: Heltalet som ska skrivas ut.
+********************************************************************************/
+void serial_print_int16(const int16_t number);
+
+/********************************************************************************
+* serial_print_int32: Skriver ut ett signerat 32-bitars heltal decimalt.
+*
+*                     - number: Heltalet som ska skrivas ut.
+********************************************************************************/
+void serial_print_int32(const int32_t number);
+
+/********************************************************************************
+* serial_print_hex8: Skriver ut ett 8-bitars tal som tv hexadecimala siffror.
+*
+*                    - number: Talet som ska skrivas ut.
+********************************************************************************/
+void serial_print_hex8(const uint8_t number);
+
+/********************************************************************************
+* serial_print_hex16: Skriver ut ett 16-bitars tal som fyra hexadecimala
+*                     siffror.
+*
+*                     - number: Talet som ska skrivas ut.
+********************************************************************************/
+void serial_print_hex16(const uint16_t number);
+
+/********************************************************************************
+* serial_print_hex32: Skriver ut ett 32-bitars tal som tta hexadecimala
+*                     siffror.
+*
+*                     - number: Talet som ska skrivas ut.
+********************************************************************************/
+void serial_print_hex32(const uint32_t number);
+
+/********************************************************************************
+* serial_print_fixed: Skriver ut ett fixtal med angivet antal decimaler, dr
+*                     talet utgr vrdet multiplicerat med 10^decimals.
+*                     Exempelvis skrivs vrdet -1234 med tv decimaler ut
+*                     som -12.34.
+*
+*                     - value   : Fixtalet som ska skrivas ut.
+*                     - decimals: Antalet decimaler (0 - 9).
+********************************************************************************/
+void serial_print_fixed(const int32_t value,
+                        const uint8_t decimals);
+
 /********************************************************************************
 * serial_print_char: Skriver ut ett enskilt tecken via seriell verfring.
 *
@@ -55,7 +432,8 @@ void serial_print_char(const char character);
 ********************************************************************************/
 static inline void serial_print_new_line(void)
 {
-   serial_print_string("\n");
+   serial_print_char('\n');
+   serial_print_char('\r');
    return;
 }
 
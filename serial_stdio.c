@@ -0,0 +1,87 @@
+/********************************************************************************
+* serial_stdio.c: Innehller funktionsdefinitioner fr stdio-strmmen fr
+*                 seriell verfring.
+********************************************************************************/
+#include "serial_stdio.h"
+
+#if SERIAL_STDIO_BUFFER_SIZE < 2 || SERIAL_STDIO_BUFFER_SIZE > 255
+#error "SERIAL_STDIO_BUFFER_SIZE must be between 2 and 255!"
+#endif
+
+/* Statiska variabler: */
+static FILE serial_stdio_file;                     /* Strmmen fr seriell verfring. */
+static char line_buffer[SERIAL_STDIO_BUFFER_SIZE]; /* Radbuffert. */
+static uint8_t line_length = 0;                    /* Antalet tecken i radbufferten. */
+
+/* Statiska funktioner: */
+static int serial_stdio_put(char c, FILE* stream);
+static void serial_stdio_append(const char c);
+
+/********************************************************************************
+* serial_stdio_init: Initierar stdio-strmmen fr seriell verfring samt
+*                    stter stdout och stderr till strmmen. Seriell
+*                    verfring mste initieras separat via serial_init.
+********************************************************************************/
+void serial_stdio_init(void)
+{
+   fdev_setup_stream(&serial_stdio_file, serial_stdio_put, 0, _FDEV_SETUP_WRITE);
+   line_length = 0;
+   stdout = &serial_stdio_file;
+   stderr = &serial_stdio_file;
+   return;
+}
+
+/********************************************************************************
+* serial_stdio_stream: Returnerar en pekare till stdio-strmmen, exempelvis
+*                      fr anrop av fprintf.
+********************************************************************************/
+FILE* serial_stdio_stream(void)
+{
+   return &serial_stdio_file;
+}
+
+/********************************************************************************
+* serial_stdio_flush: Placerar mellanlagrade tecken i sndbufferten. Om
+*                     sndbufferten r full hanteras tecknen enligt vald
+*                     tgrd i serial.c.
+********************************************************************************/
+void serial_stdio_flush(void)
+{
+   serial_write(line_buffer, line_length);
+   line_length = 0;
+   return;
+}
+
+/********************************************************************************
+* serial_stdio_put: Put-funktion fr stdio-strmmen. Tecknet mellanlagras i
+*                   radbufferten, som tms vid nyradstecken, som d fljs av
+*                   vagnretur. Returnerar alltid 0.
+*
+*                   - c     : Tecknet som ska skrivas ut.
+*                   - stream: Pekare till strmmen (anvnds ej).
+********************************************************************************/
+static int serial_stdio_put(char c, FILE* stream)
+{
+   (void)stream;
+   serial_stdio_append(c);
+
+   if (c == '\n')
+   {
+      serial_stdio_append('\r');
+      serial_stdio_flush();
+   }
+   return 0;
+}
+
+/********************************************************************************
+* serial_stdio_append: Lgger till ett tecken i radbufferten, som tms nr
+*                      den blir full.
+*
+*                      - c: Tecknet som ska lggas till.
+********************************************************************************/
+static void serial_stdio_append(const char c)
+{
+   line_buffer[line_length++] = c;
+   if (line_length == SERIAL_STDIO_BUFFER_SIZE) serial_stdio_flush();
+   return;
+}
\ No newline at end of file
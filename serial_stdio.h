@@ -0,0 +1,61 @@
+/********************************************************************************
+* serial_stdio.h: Innehller en stdio-strm fr seriell verfring, vilket
+*                 mjliggr utskrift via printf, puts med mera frn stdout
+*                 och stderr utan anrop av serial_print-funktionerna.
+*
+*                 Utskrivna tecken mellanlagras i en radbuffert som tms till
+*                 sndbufferten i serial.c vid nyradstecken eller nr
+*                 radbufferten r full. Strmmens put-funktion anropas drmed
+*                 fr varje tecken utan att varje tecken kas fr sig.
+*                 Nyradstecken fljs av vagnretur, likt serial_print_string.
+*                 Text utan avslutande nyradstecken, exempelvis en prompt,
+*                 skickas via serial_stdio_flush (fflush saknar effekt i
+*                 avr-libc).
+*
+*                 Vilken version av vfprintf som lnkas in vljs vid bygget
+*                 via lnkarflaggor, vilka i projektfilen anges via
+*                 egenskapen VfprintfLinkerFlags:
+*
+*                 Flaggor                          Version
+*                 -Wl,-u,vfprintf -lprintf_min     Minimal (default), endast
+*                                                  heltal och text, ingen
+*                                                  fltbredd eller flaggor.
+*                 (inga)                           Standard, allt utom
+*                                                  flyttal.
+*                 -Wl,-u,vfprintf -lprintf_flt     Fullstndig, inklusive
+*                                                  flyttal (%f, %e, %g).
+*
+*                 Strmmen r avsedd fr huvudprogrammet. Avbrottsrutiner
+*                 ska logga via log.h.
+********************************************************************************/
+#ifndef SERIAL_STDIO_H_
+#define SERIAL_STDIO_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "serial.h"
+
+/* Makrodefinitioner: */
+#ifndef SERIAL_STDIO_BUFFER_SIZE
+#define SERIAL_STDIO_BUFFER_SIZE 32 /* Radbuffertens storlek i byte (max 255). */
+#endif
+
+/********************************************************************************
+* serial_stdio_init: Initierar stdio-strmmen fr seriell verfring samt
+*                    stter stdout och stderr till strmmen. Seriell
+*                    verfring mste initieras separat via serial_init.
+********************************************************************************/
+void serial_stdio_init(void);
+
+/********************************************************************************
+* serial_stdio_stream: Returnerar en pekare till stdio-strmmen, exempelvis
+*                      fr anrop av fprintf.
+********************************************************************************/
+FILE* serial_stdio_stream(void);
+
+/********************************************************************************
+* serial_stdio_flush: Placerar mellanlagrade tecken i sndbufferten.
+********************************************************************************/
+void serial_stdio_flush(void);
+
+#endif /* SERIAL_STDIO_H_ */
\ No newline at end of file
@@ -0,0 +1,436 @@
+/********************************************************************************
+* servo.c: Innehller funktionsdefinitioner fr multiplexade RC-servon via
+*          Timer 1 Compare A.
+********************************************************************************/
+#include "servo.h"
+
+/* Makrodefinitioner: */
+#define SERVO_CLOCK_SELECT (1 << CS11)                                     /* Prescaler 8 fr Timer 1. */
+#define SERVO_TICKS_PER_US ((uint16_t)((F_CPU) / 8000000UL))               /* Timersteg per mikrosekund. */
+#define SERVO_FRAME_TICKS ((uint16_t)(SERVO_FRAME_US * SERVO_TICKS_PER_US)) /* Ramtid i timersteg. */
+#define SERVO_GAP_TICKS ((uint16_t)(100 * SERVO_TICKS_PER_US))              /* Minsta paus efter sista pulsen. */
+#define SERVO_PIN_MAX 19                                                   /* Hgsta pin-nummer (PORTC5). */
+
+#if SERVO_FRAME_US * ((F_CPU) / 8000000UL) > 65535UL
+#error "SERVO_FRAME_US is too long for Timer 1!"
+#endif
+
+#if SERVO_MIN_US < SERVO_PULSE_MIN_US || SERVO_MAX_US > SERVO_PULSE_MAX_US
+#error "SERVO_MIN_US and SERVO_MAX_US must be in the range 500 - 2500!"
+#endif
+
+/********************************************************************************
+* servo_setpoint: Strukt fr lagring av brvrde samt maximal frflyttning
+*                 per ram fr en kanal, bda mtt i timersteg.
+********************************************************************************/
+struct servo_setpoint
+{
+   uint16_t target; /* Brvrde (pulsbredd), 0 fr avstngd kanal. */
+   uint16_t step;   /* Maximal frflyttning per ram, 0 fr direkt instllning. */
+};
+
+/* Statiska variabler: */
+static struct led servos[SERVO_CHANNELS_MAX];                    /* Pinnar per kanal. */
+static struct servo_setpoint setpoints[2][SERVO_CHANNELS_MAX];   /* Brvrden (dubbelbuffrade). */
+static struct servo_setpoint next[SERVO_CHANNELS_MAX];           /* Senast satta brvrden. */
+static uint16_t min_ticks[SERVO_CHANNELS_MAX];                   /* Pulsbredd vid vinkeln 0. */
+static uint16_t max_ticks[SERVO_CHANNELS_MAX];                   /* Pulsbredd vid vinkeln SERVO_ANGLE_MAX. */
+static uint16_t speeds[SERVO_CHANNELS_MAX];                      /* Maximal hastighet i grader per sekund. */
+static volatile uint16_t positions[SERVO_CHANNELS_MAX];          /* Aktuell pulsbredd per kanal. */
+static uint8_t num_channels = 0;                                 /* Antalet kanaler. */
+static volatile uint8_t active = 0;                              /* Index fr brvrden som anvnds av avbrottsrutinen. */
+static volatile bool pending = false;                            /* Indikerar att bakre brvrden ska brja anvndas. */
+static volatile uint8_t current = 0;                             /* Kanal vars puls pgr, num_channels under pausen. */
+static uint16_t elapsed = 0;                                     /* Frfluten tid i aktuell ram i timersteg. */
+static bool enabled = false;                                     /* Indikerar att pulsgenereringen r aktiverad. */
+
+/* Statiska funktioner: */
+static void servo_update(void);
+static void servo_update_step(const uint8_t channel);
+
+/********************************************************************************
+* servo_ticks: Returnerar angiven pulsbredd i timersteg, begrnsad till
+*              SERVO_PULSE_MIN_US - SERVO_PULSE_MAX_US.
+*
+*              - pulse_us: Pulsbredden i mikrosekunder.
+********************************************************************************/
+static inline uint16_t servo_ticks(uint16_t pulse_us)
+{
+   if (pulse_us < SERVO_PULSE_MIN_US) pulse_us = SERVO_PULSE_MIN_US;
+   if (pulse_us > SERVO_PULSE_MAX_US) pulse_us = SERVO_PULSE_MAX_US;
+   return pulse_us * SERVO_TICKS_PER_US;
+}
+
+/********************************************************************************
+* servo_step: Flyttar pulsbredden fr angiven kanal hgst en frflyttning mot
+*             brvrdet och returnerar den nya pulsbredden, eller 0 om
+*             kanalen r avstngd. En kanal som stngs av slutar direkt att
+*             f pulser, och en kanal som just har slagits p stlls in
+*             direkt, eftersom servots tidigare position r oknd. Drmed
+*             sker frflyttning endast mellan giltiga pulsbredder.
+*
+*             - channel: Kanalen.
+********************************************************************************/
+static inline uint16_t servo_step(const uint8_t channel)
+{
+   const struct servo_setpoint* setpoint = &setpoints[active][channel];
+   const uint16_t target = setpoint->target;
+   uint16_t position = positions[channel];
+
+   if (target == 0 || position == 0 || setpoint->step == 0)
+   {
+      position = target;
+   }
+   else if (position < target)
+   {
+      position = target - position > setpoint->step ? position + setpoint->step : target;
+   }
+   else if (position > target)
+   {
+      position = position - target > setpoint->step ? position - setpoint->step : target;
+   }
+
+   positions[channel] = position;
+   return position;
+}
+
+/********************************************************************************
+* ISR (TIMER1_COMPA_vect): Avbrottsrutin som ger rum i slutet av varje puls
+*                          samt i slutet av ramen. Fregende kanals pin
+*                          stts lg och nsta pslagna kanals pin hg,
+*                          varefter nsta avbrott schemalggs efter dess
+*                          pulsbredd. Efter sista kanalen schemalggs
+*                          resten av ramen. I brjan av varje ram byts till
+*                          nya brvrden, frutsatt att sdana har satts.
+********************************************************************************/
+ISR (TIMER1_COMPA_vect)
+{
+   uint8_t n = current;
+   uint16_t pulse = 0;
+
+   if (n < num_channels)
+   {
+      led_off(&servos[n++]);
+   }
+   else
+   {
+      n = 0;
+      elapsed = 0;
+
+      if (pending)
+      {
+         active ^= 1;
+         pending = false;
+      }
+   }
+
+   while (n < num_channels && (pulse = servo_step(n)) == 0)
+   {
+      n++;
+   }
+
+   if (n < num_channels)
+   {
+      led_on(&servos[n]);
+      OCR1A += pulse;
+      elapsed += pulse;
+   }
+   else
+   {
+      OCR1A += elapsed + SERVO_GAP_TICKS < SERVO_FRAME_TICKS ? SERVO_FRAME_TICKS - elapsed : SERVO_GAP_TICKS;
+   }
+
+   current = n;
+   return;
+}
+
+/********************************************************************************
+* servo_init: Stter angivna pinnar till lga utportar och startar avbrotten
+*             fr Timer 1 Compare A. Frsta ramen startar en paus efter
+*             Timer 1:s aktuella vrde.
+*
+*             - pins    : Pekare till array med pin-nummer p Arduino Uno.
+*             - num_pins: Antalet pinnar.
+********************************************************************************/
+int servo_init(const uint8_t* pins,
+               const uint8_t num_pins)
+{
+   if (num_pins > SERVO_CHANNELS_MAX) return 1;
+
+   for (uint8_t i = 0; i < num_pins; ++i)
+   {
+      if (pins[i] > SERVO_PIN_MAX) return 1;
+   }
+
+   servo_disable();
+   if (timer1_acquire(SERVO_CLOCK_SELECT)) return 1;
+   num_channels = num_pins;
+
+   for (uint8_t i = 0; i < num_channels; ++i)
+   {
+      led_init(&servos[i], pins[i]);
+      led_off(&servos[i]);
+      min_ticks[i] = SERVO_MIN_US * SERVO_TICKS_PER_US;
+      max_ticks[i] = SERVO_MAX_US * SERVO_TICKS_PER_US;
+      speeds[i] = 0;
+      next[i].target = 0;
+      next[i].step = 0;
+      setpoints[0][i] = next[i];
+      setpoints[1][i] = next[i];
+      positions[i] = 0;
+   }
+
+   const uint8_t sreg = SREG;
+   asm("CLI");
+
+   active = 0;
+   pending = false;
+   current = num_channels;
+   OCR1A = TCNT1 + SERVO_GAP_TICKS;
+   TIFR1 = (1 << OCF1A);
+   TIMSK1 |= (1 << OCIE1A);
+   enabled = true;
+
+   SREG = sreg;
+   return 0;
+}
+
+/********************************************************************************
+* servo_disable: Inaktiverar avbrotten fr Timer 1 Compare A, stter samtliga
+*                pinnar lga och slpper Timer 1. En pgende puls avbryts,
+*                vilket servot ignorerar som en fr kort puls.
+********************************************************************************/
+void servo_disable(void)
+{
+   if (!enabled) return;
+
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   TIMSK1 &= ~(1 << OCIE1A);
+
+   for (uint8_t i = 0; i < num_channels; ++i)
+   {
+      led_off(&servos[i]);
+   }
+
+   enabled = false;
+   SREG = sreg;
+
+   timer1_release();
+   return;
+}
+
+/********************************************************************************
+* servo_enabled: Indikerar ifall pulsgenereringen r aktiverad.
+********************************************************************************/
+bool servo_enabled(void)
+{
+   return enabled;
+}
+
+/********************************************************************************
+* servo_channels: Returnerar antalet kanaler.
+********************************************************************************/
+uint8_t servo_channels(void)
+{
+   return num_channels;
+}
+
+/********************************************************************************
+* servo_get_pin: Returnerar pin-numret p Arduino Uno fr angiven kanal, eller
+*                0 om kanalen inte finns.
+*
+*                - channel: Kanalen.
+********************************************************************************/
+uint8_t servo_get_pin(const uint8_t channel)
+{
+   return channel < num_channels ? led_get_pin(&servos[channel]) : 0;
+}
+
+/********************************************************************************
+* servo_set_range: Stter pulsbredderna vid vinklarna 0 och SERVO_ANGLE_MAX
+*                  fr angiven kanal, begrnsade till SERVO_PULSE_MIN_US -
+*                  SERVO_PULSE_MAX_US. En kortare pulsbredd vid
+*                  SERVO_ANGLE_MAX n vid 0 ger omvnd rotationsriktning.
+*                  Maximal frflyttning per ram rknas om, eftersom den
+*                  beror p intervallet.
+*
+*                  - channel: Kanalen.
+*                  - min_us : Pulsbredd vid vinkeln 0 i mikrosekunder.
+*                  - max_us : Pulsbredd vid vinkeln SERVO_ANGLE_MAX.
+********************************************************************************/
+void servo_set_range(const uint8_t channel,
+                     const uint16_t min_us,
+                     const uint16_t max_us)
+{
+   if (channel >= num_channels) return;
+   min_ticks[channel] = servo_ticks(min_us);
+   max_ticks[channel] = servo_ticks(max_us);
+   servo_update_step(channel);
+   servo_update();
+   return;
+}
+
+/********************************************************************************
+* servo_set_speed: Stter maximal hastighet fr angiven kanal och rknar om
+*                  den till en frflyttning i timersteg per ram.
+*
+*                  - channel      : Kanalen.
+*                  - degrees_per_s: Maximal hastighet i grader per sekund,
+*                                   eller 0 fr direkt instllning.
+********************************************************************************/
+void servo_set_speed(const uint8_t channel,
+                     const uint16_t degrees_per_s)
+{
+   if (channel >= num_channels) return;
+   speeds[channel] = degrees_per_s;
+   servo_update_step(channel);
+   servo_update();
+   return;
+}
+
+/********************************************************************************
+* servo_write_us: Stter brvrdet fr angiven kanal i mikrosekunder.
+*
+*                 - channel : Kanalen.
+*                 - pulse_us: Pulsbredden i mikrosekunder, eller 0 fr att
+*                             stnga av kanalen.
+********************************************************************************/
+void servo_write_us(const uint8_t channel,
+                    const uint16_t pulse_us)
+{
+   if (channel >= num_channels) return;
+   next[channel].target = pulse_us ? servo_ticks(pulse_us) : 0;
+   servo_update();
+   return;
+}
+
+/********************************************************************************
+* servo_write_angle: Stter brvrdet fr angiven kanal som en vinkel, vilken
+*                    interpoleras linjrt mellan kanalens pulsbredder vid
+*                    vinklarna 0 och SERVO_ANGLE_MAX.
+*
+*                    - channel: Kanalen.
+*                    - angle  : Vinkeln i tiondels grader.
+********************************************************************************/
+void servo_write_angle(const uint8_t channel,
+                       const uint16_t angle)
+{
+   if (channel >= num_channels) return;
+   const int32_t range = (int32_t)max_ticks[channel] - min_ticks[channel];
+   const int32_t offset = range * (angle < SERVO_ANGLE_MAX ? angle : SERVO_ANGLE_MAX) / SERVO_ANGLE_MAX;
+   next[channel].target = (uint16_t)(min_ticks[channel] + offset);
+   servo_update();
+   return;
+}
+
+/********************************************************************************
+* servo_write_all_us: Stter brvrdena fr samtliga kanaler i mikrosekunder
+*                     och lagrar dem i den bakre bufferten en gng fr
+*                     samtliga kanaler.
+*
+*                     - pulses_us: Pekare till array med en pulsbredd per
+*                                  kanal.
+********************************************************************************/
+void servo_write_all_us(const uint16_t* pulses_us)
+{
+   for (uint8_t i = 0; i < num_channels; ++i)
+   {
+      next[i].target = pulses_us[i] ? servo_ticks(pulses_us[i]) : 0;
+   }
+
+   servo_update();
+   return;
+}
+
+/********************************************************************************
+* servo_read_us: Returnerar senast satt brvrde fr angiven kanal i
+*                mikrosekunder, eller 0 om kanalen r avstngd eller inte
+*                finns.
+*
+*                - channel: Kanalen.
+********************************************************************************/
+uint16_t servo_read_us(const uint8_t channel)
+{
+   return channel < num_channels ? next[channel].target / SERVO_TICKS_PER_US : 0;
+}
+
+/********************************************************************************
+* servo_position_us: Returnerar aktuell pulsbredd fr angiven kanal i
+*                    mikrosekunder. Pulsbredden lses med avbrott
+*                    inaktiverade, eftersom den uppdateras av
+*                    avbrottsrutinen.
+*
+*                    - channel: Kanalen.
+********************************************************************************/
+uint16_t servo_position_us(const uint8_t channel)
+{
+   if (channel >= num_channels) return 0;
+
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   const uint16_t position = positions[channel];
+   SREG = sreg;
+   return position / SERVO_TICKS_PER_US;
+}
+
+/********************************************************************************
+* servo_moving: Indikerar ifall angiven kanal nnu inte har ntt sitt senast
+*               satta brvrde.
+*
+*               - channel: Kanalen.
+********************************************************************************/
+bool servo_moving(const uint8_t channel)
+{
+   if (channel >= num_channels) return false;
+
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   const bool moving = positions[channel] != next[channel].target;
+   SREG = sreg;
+   return moving;
+}
+
+/********************************************************************************
+* servo_update: Kopierar senast satta brvrden in i den bakre bufferten och
+*               markerar dem som klara att anvndas. Flaggan pending
+*               nollstlls frst, drmed kan avbrottsrutinen inte byta
+*               buffert under kopieringen. En minnesbarrir hindrar
+*               kompilatorn frn att flytta kopieringen frbi pending =
+*               true, eftersom bufferten inte r volatile.
+********************************************************************************/
+static void servo_update(void)
+{
+   pending = false;
+   struct servo_setpoint* back = setpoints[active ^ 1];
+
+   for (uint8_t i = 0; i < num_channels; ++i)
+   {
+      back[i] = next[i];
+   }
+
+   asm volatile("" ::: "memory");
+   pending = true;
+   return;
+}
+
+/********************************************************************************
+* servo_update_step: Rknar om maximal hastighet fr angiven kanal till
+*                    maximal frflyttning i timersteg per ram, avrundat uppt
+*                    s att en satt hastighet aldrig ger stillastende. Ett
+*                    varv p 180 grader motsvarar kanalens intervall.
+*
+*                    - channel: Kanalen.
+********************************************************************************/
+static void servo_update_step(const uint8_t channel)
+{
+   const uint16_t range = max_ticks[channel] > min_ticks[channel] ?
+      max_ticks[channel] - min_ticks[channel] : min_ticks[channel] - max_ticks[channel];
+   const uint32_t ticks_per_s = (uint32_t)speeds[channel] * range / (SERVO_ANGLE_MAX / 10);
+   const uint32_t step = (ticks_per_s * (SERVO_FRAME_US / 100) + 9999) / 10000;
+
+   if (speeds[channel] == 0) next[channel].step = 0;
+   else if (step == 0) next[channel].step = 1;
+   else next[channel].step = step > UINT16_MAX ? UINT16_MAX : (uint16_t)step;
+   return;
+}
\ No newline at end of file
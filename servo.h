@@ -0,0 +1,177 @@
+/********************************************************************************
+* servo.h: Innehller drivrutiner fr upp till SERVO_CHANNELS_MAX
+*          RC-servon p godtyckliga digitala pinnar, styrda via en enda
+*          avbrottsvektor p Timer 1.
+*
+*          Servona fr sina pulser i tur och ordning under varje ram:
+*          avbrottsrutinen slcker fregende servos pin, tnder nsta och
+*          schemalgger nsta avbrott efter aktuell pulsbredd. Nr samtliga
+*          servon har ftt sin puls vntar drivrutinen resten av ramen, s
+*          att varje servo fr en puls var SERVO_FRAME_US:e mikrosekund.
+*          Om summan av pulsbredderna verskrider ramtiden, exempelvis tolv
+*          servon med 2 ms pulser, frlngs ramen i stllet, vilket servon
+*          tolererar (vanligtvis 10 - 30 ms mellan pulserna).
+*
+*          Drivrutinen delar den frirullande rknaren p Timer 1 (prescaler
+*          8) med Input Capture och BAM, se timer1_acquire i timer.h, och
+*          anvnder jmfrelseregistret OCR1A samt avbrottsvektor
+*          TIMER1_COMPA_vect. Upplsningen blir drmed ett timersteg, dvs.
+*          0.5 us. Varje avbrott schemalggs relativt fregende, drmed
+*          ackumuleras inte avbrottsrutinens frdrjning.
+*
+*          Brvrden stts i mikrosekunder eller tiondels grader och r
+*          dubbelbuffrade: nya brvrden lagras i en bakre buffert, som
+*          avbrottsrutinen byter till frst i brjan av nsta ram. Drmed
+*          brjar samtliga ndringar glla samtidigt.
+*
+*          Fr varje servo kan en maximal hastighet sttas. Avbrottsrutinen
+*          flyttar d pulsbredden hgst ett givet antal timersteg per ram
+*          mot brvrdet, med enbart addition och jmfrelse av heltal.
+********************************************************************************/
+#ifndef SERVO_H_
+#define SERVO_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "timer.h"
+#include "led.h"
+
+/* Makrodefinitioner: */
+#define SERVO_CHANNELS_MAX 12   /* Maximalt antal servon. */
+#define SERVO_PULSE_MIN_US 500  /* Kortast tilltna pulsbredd i mikrosekunder. */
+#define SERVO_PULSE_MAX_US 2500 /* Lngst tilltna pulsbredd i mikrosekunder. */
+#define SERVO_ANGLE_MAX 1800    /* Strsta vinkel i tiondels grader (180 grader). */
+
+#ifndef SERVO_FRAME_US
+#define SERVO_FRAME_US 20000 /* Ramtid i mikrosekunder (50 Hz). */
+#endif
+
+#ifndef SERVO_MIN_US
+#define SERVO_MIN_US 1000 /* Frvald pulsbredd vid vinkeln 0 grader. */
+#endif
+
+#ifndef SERVO_MAX_US
+#define SERVO_MAX_US 2000 /* Frvald pulsbredd vid vinkeln SERVO_ANGLE_MAX. */
+#endif
+
+/********************************************************************************
+* servo_init: Startar pulsgenereringen fr servon anslutna till angivna
+*             pinnar, dr pinnen p index i utgr kanal i. Samtliga kanaler
+*             startar avstngda (ingen puls) tills ett brvrde stts.
+*             Returnerar 0 vid lyckad initiering, annars 1 (fler n
+*             SERVO_CHANNELS_MAX pinnar, eller Timer 1 anvnds i en annan
+*             mod).
+*
+*             - pins    : Pekare till array med pin-nummer p Arduino Uno.
+*             - num_pins: Antalet pinnar.
+********************************************************************************/
+int servo_init(const uint8_t* pins,
+               const uint8_t num_pins);
+
+/********************************************************************************
+* servo_disable: Stoppar pulsgenereringen och stter samtliga pinnar lga.
+*                Timer 1 stoppas om den inte delas med en annan drivrutin.
+********************************************************************************/
+void servo_disable(void);
+
+/********************************************************************************
+* servo_enabled: Indikerar ifall pulsgenereringen r aktiverad.
+********************************************************************************/
+bool servo_enabled(void);
+
+/********************************************************************************
+* servo_channels: Returnerar antalet kanaler.
+********************************************************************************/
+uint8_t servo_channels(void);
+
+/********************************************************************************
+* servo_get_pin: Returnerar pin-numret p Arduino Uno fr angiven kanal.
+*
+*                - channel: Kanalen.
+********************************************************************************/
+uint8_t servo_get_pin(const uint8_t channel);
+
+/********************************************************************************
+* servo_set_range: Stter pulsbredderna som motsvarar vinklarna 0 och
+*                  SERVO_ANGLE_MAX fr angiven kanal, vilka anvnds av
+*                  servo_write_angle samt servo_set_speed. Frvalt r
+*                  SERVO_MIN_US respektive SERVO_MAX_US.
+*
+*                  - channel: Kanalen.
+*                  - min_us : Pulsbredd vid vinkeln 0 i mikrosekunder.
+*                  - max_us : Pulsbredd vid vinkeln SERVO_ANGLE_MAX.
+********************************************************************************/
+void servo_set_range(const uint8_t channel,
+                     const uint16_t min_us,
+                     const uint16_t max_us);
+
+/********************************************************************************
+* servo_set_speed: Stter maximal hastighet fr angiven kanal, vilken gller
+*                  frn och med nsta ram. Vid 0 stlls pulsbredden in
+*                  direkt, annars flyttas den gradvis mot brvrdet.
+*
+*                  - channel      : Kanalen.
+*                  - degrees_per_s: Maximal hastighet i grader per sekund.
+********************************************************************************/
+void servo_set_speed(const uint8_t channel,
+                     const uint16_t degrees_per_s);
+
+/********************************************************************************
+* servo_write_us: Stter brvrdet fr angiven kanal i mikrosekunder, vilket
+*                 gller frn och med nsta ram. Pulsbredden begrnsas till
+*                 SERVO_PULSE_MIN_US - SERVO_PULSE_MAX_US. Vid 0 stngs
+*                 kanalen av, drmed upphr pulserna och servot slpper.
+*
+*                 - channel : Kanalen.
+*                 - pulse_us: Pulsbredden i mikrosekunder, eller 0.
+********************************************************************************/
+void servo_write_us(const uint8_t channel,
+                    const uint16_t pulse_us);
+
+/********************************************************************************
+* servo_write_angle: Stter brvrdet fr angiven kanal som en vinkel, vilket
+*                    gller frn och med nsta ram. Vinkeln rknas om till
+*                    en pulsbredd med full upplsning (0.5 us) inom
+*                    kanalens intervall, se servo_set_range.
+*
+*                    - channel: Kanalen.
+*                    - angle  : Vinkeln i tiondels grader (0 - SERVO_ANGLE_MAX).
+********************************************************************************/
+void servo_write_angle(const uint8_t channel,
+                       const uint16_t angle);
+
+/********************************************************************************
+* servo_write_all_us: Stter brvrdena fr samtliga kanaler i mikrosekunder,
+*                     vilka brjar glla samtidigt frn och med nsta ram.
+*
+*                     - pulses_us: Pekare till array med en pulsbredd per
+*                                  kanal, se servo_write_us.
+********************************************************************************/
+void servo_write_all_us(const uint16_t* pulses_us);
+
+/********************************************************************************
+* servo_read_us: Returnerar senast satt brvrde fr angiven kanal i
+*                mikrosekunder, eller 0 om kanalen r avstngd.
+*
+*                - channel: Kanalen.
+********************************************************************************/
+uint16_t servo_read_us(const uint8_t channel);
+
+/********************************************************************************
+* servo_position_us: Returnerar aktuell pulsbredd fr angiven kanal i
+*                    mikrosekunder, vilken skiljer sig frn brvrdet medan
+*                    servot flyttas med begrnsad hastighet.
+*
+*                    - channel: Kanalen.
+********************************************************************************/
+uint16_t servo_position_us(const uint8_t channel);
+
+/********************************************************************************
+* servo_moving: Indikerar ifall angiven kanal nnu inte har ntt sitt
+*               brvrde.
+*
+*               - channel: Kanalen.
+********************************************************************************/
+bool servo_moving(const uint8_t channel);
+
+#endif /* SERVO_H_ */
\ No newline at end of file
@@ -7,8 +7,19 @@
 struct led l1, l2, l3;
 struct led_vector v1;
 struct button b1;
-struct timer t0, t1;
+struct timer t0;
+struct soft_timer debounce_timer;
+struct blink lockdown_blink;
 struct pwm pwm1;
+struct pwm_stagger pwm1_stagger;
+#if PWM_HARDWARE
+struct pwm_hw pwm1_hw;
+#endif
+struct shell shell1;
+struct tmp36 temp1;
+struct modbus modbus1;
+struct task watchdog_task, comm_task, pwm_task, startup_task;
+struct rtc_alarm rtc_log_alarm;
 
 /********************************************************************************
 * setup: Initierar systemet enligt fljande:
@@ -22,17 +33,24 @@ struct pwm pwm1;
 *           aktiverar avbrott vid nedtryckning/uppslppning. 
 *           Avbrottsvektor fr avbrottsrutinen r PCINT0_vect.
 *
-*        4. Initierar timer t0 till den 8-bitars timerkretsen Timer 0, som 
-*           lper ut efter 300 millisekunder efter aktivering i Normal Mode. 
-*           Avbrottsvektor fr avbrottsrutinen r TIMER0_OVF_vect.
+*        4. Initierar timer t0 till den 8-bitars timerkretsen Timer 0 som
+*           systemets tick, vilket krs i CTC Mode med avbrott varje
+*           millisekund (prescaler 64, OCR0A = 249). Avbrottsvektor fr
+*           avbrottsrutinen r TIMER0_COMPA_vect, som driver systemtiden
+*           (se timebase.h) samt samtliga mjukvarutimers (se soft_timer.h).
+*           Systemtiden anvnds som tidsstmpel fr loggning och telemetri.
 *
-*        5. Initierar timer t1 till den 16-bitars timerkretsen Timer 1, som
-*           lper ut efter 50 millisekunder efter aktivering i CTC Mode
-*           (rknar upp till 256 och fungerar drmed som en 8-bitars timer).
-*           Avbrottsvektor fr avbrottsrutinen r TIMER0_COMPA_vect.
+*        5. Initierar mjukvarutimer debounce_timer, som teraktiverar
+*           PCI-avbrott p I/O-port B 300 millisekunder efter nedtryckning,
+*           samt blinkningen lockdown_blink, som togglar lysdiod l1 var
+*           50:e millisekund nr systemet har lsts. Blinkningen fr
+*           anvnda Timer 1 fr toggling i hrdvara, men d pin 8 inte r
+*           en utpinne till Timer 1 sker den via en mjukvarutimer, se
+*           blink.h. Timer 1 och Timer 2 anvnds drmed inte fr tidmtning.
 *
-*        6. Initierar seriell verfring med en baud rate p 9600 kbps fr
-*           att mjliggra utskrift till seriell terminal.
+*        6. Initierar seriell verfring med en baud rate p 9600 bps fr
+*           att mjliggra utskrift till seriell terminal. stdout och stderr
+*           kopplas till seriell verfring, s att printf kan anvndas.
 *
 *        7. Skriver startvrdet 0 till adressen 100 i EEPROM-minnet. Denna
 *           adress anvnds fr att lagra antalet passerade Watchdog timeouts.
@@ -42,7 +60,46 @@ struct pwm pwm1;
 *           motsvarande avbrottsrutin r WDT_vect.
 *
 *        9. Initierar PWM-kontroller pwm1 fr PWM-styrning av lysdioderna med
-*           en periodtid p 1000 mikrosekunder.
+*           en periodtid p 1000 mikrosekunder, dr potentiometerns lge
+*           omvandlas till duty cycle enligt CIE L*, s att ljusstyrkan
+*           upplevs ka jmnt ver hela vridomrdet (se brightness.h).
+*           Med PWM_HARDWARE satt till 1 genereras PWM i stllet i
+*           hrdvara av Timer 1 p pin 9 - 10 (OC1A samt OC1B) med en
+*           frekvens p 1 kHz, dr potentiometern endast lses av var
+*           20:e millisekund. Lysdioden p pin 8 saknar utpinne frn
+*           timerkretsen och styrs d inte av pwm1. Timer 1 anvnds d
+*           inte fr Input Capture (kommandot capture).
+*
+*       10. Initierar temperatursensor temp1 ansluten till analog pin A1.
+*
+*       11. Om en giltig slavadress (1 - 247) finns lagrad p adressen 101
+*           i EEPROM-minnet initieras Modbus-slaven modbus1 med
+*           registertabellen i modbus_map.c, vilket mjliggr avlsning och
+*           styrning via Modbus RTU. Loggning inaktiveras d fr att inte
+*           stra Modbus-ramarna. Annars initieras kommandotolken shell1 med
+*           kommandotabellen i commands.c, vilket mjliggr justering av
+*           systemet via seriell terminal.
+*
+*       12. Initierar mjukvaru-UART:en fr en andra seriell kanal med en baud
+*           rate p 9600 bps, med sndning p pin 3 (PORTD3) och mottagning
+*           p pin 2 (PORTD2). Bittiden genereras av Timer 0 via
+*           avbrottsvektor TIMER0_COMPB_vect och startbitar detekteras via
+*           avbrottsvektor INT0_vect, se soft_serial.h.
+*
+*       13. Initierar schemalggarens tasks watchdog, comm, pwm och
+*           startup, se tasks.c. Task comm schemalggs var 10:e
+*           millisekund och task pwm aktiveras direkt. Task startup blinkar
+*           lysdioderna i v1 en efter en som startsekvens, varefter pwm1
+*           aktiveras. Huvudprogrammet kr sedan schemalggaren.
+*
+*       14. Startar realtidsklockan, se rtc.h. Med RTC_CRYSTAL satt till 1
+*           drivs den av Timer 2 frn en 32.768 kHz urkristall, frutsatt
+*           att Modbus inte r aktiverat (Modbus anvnder Timer 2), annars
+*           frn systemets klocka. Vid binr loggning startas larmet
+*           rtc_log_alarm, som loggar klockans tid var 60:e sekund. Drmed
+*           kan avkodaren tools/log_decode.py frse samtliga loggposter med
+*           datum och klockslag, eftersom loggposternas tidsstmplar i
+*           millisekunder slr runt frst efter 65.5 sekunder.
 ********************************************************************************/
 void setup(void)
 {
@@ -59,15 +116,64 @@ void setup(void)
    button_init(&b1, 13);
    button_enable_interrupt(&b1);
 
-   timer_init(&t0, TIMER_SEL_0, 300);
-   timer_init(&t1, TIMER_SEL_1, 50);
+   timer_init(&t0, TIMER_SEL_0, 1);
+   timer_enable_interrupt(&t0);
+   timebase_init();
+   soft_timer_init(&debounce_timer, &debounce_timer_elapsed, 0);
+   blink_init(&lockdown_blink, &l1, TIMER_SEL_1);
 
-   serial_init(9600);
+   serial_init(SERIAL_BAUD_RATE);
+   serial_stdio_init();
+   log_set_timestamp_source(&time_ms16);
+   telemetry_set_timestamp_source(&time_ms);
    eeprom_write_byte(TIMEOUT_ADDRESS, 0);
 
    wdt_init(WDT_TIMEOUT_8192_MS);
    wdt_enable_interrupt();
 
-   pwm_init(&pwm1, A0, 1000, &v1, &led_vector_on, &led_vector_off);
-   return;
+   pwm_init(&pwm1, A0, 1000, &v1, &led_vector_on, &led_vector_off);
+   pwm_set_curve(&pwm1, BRIGHTNESS_CURVE_CIE);
+#if PWM_HARDWARE
+   if (pwm_hw_init(&pwm1_hw, TIMER_SEL_1, PWM_HW_CHANNEL_A | PWM_HW_CHANNEL_B, PWM_HW_MODE_FAST, 1000, 0) == 0)
+   {
+      pwm_set_hardware(&pwm1, &pwm1_hw);
+   }
+#endif
+   tmp36_init(&temp1, A1);
+
+   if (modbus_init(&modbus1, eeprom_read_byte(MODBUS_ADDRESS_ADDRESS), &modbus_map, SERIAL_BAUD_RATE) == 0)
+   {
+      log_set_enabled(false);
+   }
+   else
+   {
+      shell_init(&shell1, commands, num_commands);
+   }
+
+   soft_serial_init(SOFT_SERIAL_BAUD_RATE);
+
+   task_init(&watchdog_task, PSTR("watchdog"), &watchdog_task_run, 0, 0);
+   task_init(&comm_task, PSTR("comm"), &comm_task_run, 0, 1);
+   task_init(&pwm_task, PSTR("pwm"), &pwm_task_run, &pwm1, 2);
+   task_init(&startup_task, PSTR("startup"), &startup_task_run, &v1, 3);
+   task_set_deadline(&watchdog_task, 50);
+   scheduler_add(&watchdog_task);
+   scheduler_add(&comm_task);
+   scheduler_add(&pwm_task);
+   scheduler_add(&startup_task);
+   task_schedule(&comm_task, 0, 10);
+   task_activate(&pwm_task);
+   pwm_disable(&pwm1);
+   task_activate(&startup_task);
+
+   if (!RTC_CRYSTAL || modbus_enabled(&modbus1) || rtc_init(RTC_SOURCE_CRYSTAL))
+   {
+      rtc_init(RTC_SOURCE_SYSTEM);
+   }
+
+   rtc_alarm_init(&rtc_log_alarm, &rtc_log_alarm_elapsed, 0);
+#if LOG_BINARY
+   rtc_alarm_start(&rtc_log_alarm, 0, RTC_LOG_INTERVAL_S);
+#endif
+   return;
 }
\ No newline at end of file
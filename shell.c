@@ -0,0 +1,169 @@
+/********************************************************************************
+* shell.c: Innehller funktionsdefinitioner fr kommandotolken shell.
+********************************************************************************/
+#include "shell.h"
+
+/* Statiska funktioner: */
+static uint8_t shell_split(char* line, 
+                           char** argv);
+static void shell_print_help(const struct shell* self);
+
+/********************************************************************************
+* shell_init: Initierar ny kommandotolk med angiven kommandotabell. Mottagna
+*             tecken skrivs tillbaka till terminalen. Kommandot help, som
+*             listar samtliga kommandon, r alltid tillgngligt.
+*
+*             - self        : Pekare till kommandotolken som ska initieras.
+*             - commands    : Pekare till kommandotabellen.
+*             - num_commands: Antalet kommandon i tabellen.
+********************************************************************************/
+void shell_init(struct shell* self,
+                const struct shell_command* commands,
+                const uint8_t num_commands)
+{
+   serial_init(SERIAL_BAUD_RATE);
+   serial_line_init(&self->line, self->buffer, SHELL_LINE_SIZE, true);
+   self->commands = commands;
+   self->num_commands = num_commands;
+   serial_print_P("> ");
+   return;
+}
+
+/********************************************************************************
+* shell_poll: Lser mottagna tecken och utfr kommandot nr en hel rad har
+*             tagits emot, fljt av utskrift av en ny prompt. Tomma rader
+*             ger endast en ny prompt.
+*
+*             - self: Pekare till kommandotolken.
+********************************************************************************/
+void shell_poll(struct shell* self)
+{
+   if (!serial_line_poll(&self->line)) return;
+
+   if (self->buffer[0] != '\0' && shell_execute(self, self->buffer))
+   {
+      serial_print_P("Unknown command, type help for a list of commands!\n");
+   }
+
+   serial_print_P("> ");
+   return;
+}
+
+/********************************************************************************
+* shell_execute: Delar upp angiven rad i argument och sker igenom
+*                kommandotabellen efter ett kommando med samma namn som
+*                frsta argumentet. Kommandot anropas med samtliga argument,
+*                dr argv[0] utgr kommandonamnet. Returnerar 0 om kommandot
+*                hittades (eller raden var tom), annars felkod 1.
+*
+*                - self: Pekare till kommandotolken.
+*                - line: Pekare till raden som ska utfras.
+********************************************************************************/
+int shell_execute(struct shell* self,
+                  char* line)
+{
+   char* argv[SHELL_MAX_ARGS];
+   const uint8_t argc = shell_split(line, argv);
+   if (argc == 0) return 0;
+
+   if (strcmp_P(argv[0], PSTR("help")) == 0)
+   {
+      shell_print_help(self);
+      return 0;
+   }
+
+   for (const struct shell_command* i = self->commands; i < self->commands + self->num_commands; ++i)
+   {
+      if (strcmp_P(argv[0], i->name) == 0)
+      {
+         i->handler(argc, argv);
+         return 0;
+      }
+   }
+   return 1;
+}
+
+/********************************************************************************
+* shell_parse_unsigned: Tolkar angivet argument som ett osignerat heltal,
+*                       angivet decimalt eller hexadecimalt med prefix 0x.
+*                       Decimala tal med inledande nollor avvisas, d de
+*                       annars kan frvxlas med oktala tal. Frtecken,
+*                       blanksteg samt tal som inte ryms i 32 bitar avvisas.
+*                       Variabeln som value pekar p skrivs endast vid
+*                       lyckad tolkning.
+*                       Returnerar true vid lyckad tolkning, annars false.
+*
+*                       - s    : Pekare till argumentet som ska tolkas.
+*                       - value: Pekare till variabel dr talet lagras.
+********************************************************************************/
+bool shell_parse_unsigned(const char* s,
+                          uint32_t* value)
+{
+   if (!s || *s == '\0') return false;
+   const bool hex = s[0] == '0' && (s[1] == 'x' || s[1] == 'X');
+
+   if (hex)
+   {
+      s += 2;
+      if (*s == '\0') return false;
+   }
+   else if (s[0] == '0' && s[1] != '\0')
+   {
+      return false;
+   }
+
+   for (const char* c = s; *c; ++c)
+   {
+      if (!(hex ? isxdigit((unsigned char)*c) : isdigit((unsigned char)*c))) return false;
+   }
+
+   errno = 0;
+   const unsigned long result = strtoul(s, 0, hex ? 16 : 10);
+   if (errno == ERANGE || result > UINT32_MAX) return false;
+
+   *value = (uint32_t)result;
+   return true;
+}
+
+/********************************************************************************
+* shell_split: Delar upp angiven rad i argument separerade med mellanslag.
+*              Mellanslagen erstts med nolltecken och pekare till varje
+*              argument lagras i angiven array. Argument utver
+*              SHELL_MAX_ARGS ignoreras. Antalet argument returneras.
+*
+*              - line: Pekare till raden som ska delas upp.
+*              - argv: Pekare till array dr argumenten ska lagras.
+********************************************************************************/
+static uint8_t shell_split(char* line, 
+                           char** argv)
+{
+   uint8_t argc = 0;
+   char* i = line;
+
+   while (*i && argc < SHELL_MAX_ARGS)
+   {
+      while (*i == ' ') *i++ = '\0';
+      if (*i == '\0') break;
+      argv[argc++] = i;
+      while (*i && *i != ' ') i++;
+   }
+   return argc;
+}
+
+/********************************************************************************
+* shell_print_help: Skriver ut samtliga kommandon i kommandotabellen
+*                   tillsammans med respektive hjlptext.
+*
+*                   - self: Pekare till kommandotolken.
+********************************************************************************/
+static void shell_print_help(const struct shell* self)
+{
+   for (const struct shell_command* i = self->commands; i < self->commands + self->num_commands; ++i)
+   {
+      serial_print_string_P(i->name);
+      serial_print_P(": ");
+      serial_print_string_P(i->help);
+      serial_print_new_line();
+   }
+   return;
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+/********************************************************************************
+* shell.h: Innehller en enkel kommandotolk fr seriell terminal via strukten
+*          shell samt associerade funktioner. Kommandon definieras i en
+*          tabell bestende av strukter av typen shell_command, dr varje
+*          kommando har ett namn, en hjlptext samt en funktion som anropas
+*          med kommandots argument.
+*
+*          Mottagna rader tolkas i huvudprogrammet via funktionen shell_poll,
+*          aldrig i avbrottsrutinen fr mottagning, vilket medfr att
+*          kommandon kan ta godtycklig tid utan att pverka avbrott.
+********************************************************************************/
+#ifndef SHELL_H_
+#define SHELL_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "serial.h"
+#include <ctype.h>
+#include <errno.h>
+
+/* Makrodefinitioner: */
+#define SHELL_LINE_SIZE 32 /* Maximal radlngd inklusive nolltecken. */
+#define SHELL_MAX_ARGS 6   /* Maximalt antal argument inklusive kommandonamnet. */
+
+/********************************************************************************
+* shell_command: Strukt fr ett kommando i kommandotolkens kommandotabell.
+*                Namn och hjlptext ska lagras i programminnet (PROGMEM).
+********************************************************************************/
+struct shell_command
+{
+   PGM_P name;                                 /* Kommandots namn i programminnet. */
+   void (*handler)(uint8_t argc, char** argv); /* Funktion som utfr kommandot. */
+   PGM_P help;                                 /* Kort hjlptext i programminnet. */
+};
+
+/********************************************************************************
+* shell: Strukt fr kommandotolk, som lser rader via seriell verfring och
+*        anropar motsvarande kommando i angiven kommandotabell.
+********************************************************************************/
+struct shell
+{
+   struct serial_line line;              /* Radinlsning frn seriell terminal. */
+   char buffer[SHELL_LINE_SIZE];         /* Buffert fr mottagen rad. */
+   const struct shell_command* commands; /* Pekare till kommandotabellen. */
+   uint8_t num_commands;                 /* Antalet kommandon i tabellen. */
+};
+
+/********************************************************************************
+* shell_init: Initierar ny kommandotolk med angiven kommandotabell. Mottagna
+*             tecken skrivs tillbaka till terminalen. Kommandot help, som
+*             listar samtliga kommandon, r alltid tillgngligt.
+*
+*             - self        : Pekare till kommandotolken som ska initieras.
+*             - commands    : Pekare till kommandotabellen.
+*             - num_commands: Antalet kommandon i tabellen.
+********************************************************************************/
+void shell_init(struct shell* self,
+                const struct shell_command* commands,
+                const uint8_t num_commands);
+
+/********************************************************************************
+* shell_poll: Lser mottagna tecken och utfr kommandot nr en hel rad har
+*             tagits emot. Funktionen blockerar inte och ska anropas
+*             kontinuerligt frn huvudprogrammet.
+*
+*             - self: Pekare till kommandotolken.
+********************************************************************************/
+void shell_poll(struct shell* self);
+
+/********************************************************************************
+* shell_execute: Delar upp angiven rad i argument och utfr motsvarande
+*                kommando. Raden modifieras under tolkningen. Returnerar 0
+*                om kommandot hittades, annars felkod 1.
+*
+*                - self: Pekare till kommandotolken.
+*                - line: Pekare till raden som ska utfras.
+********************************************************************************/
+int shell_execute(struct shell* self,
+                  char* line);
+
+/********************************************************************************
+* shell_parse_unsigned: Tolkar angivet argument som ett osignerat heltal,
+*                       angivet decimalt eller hexadecimalt med prefix 0x.
+*                       Decimala tal med inledande nollor avvisas, d de
+*                       annars kan frvxlas med oktala tal. Frtecken,
+*                       blanksteg samt tal som inte ryms i 32 bitar avvisas.
+*                       Variabeln som value pekar p skrivs endast vid
+*                       lyckad tolkning.
+*                       Returnerar true vid lyckad tolkning, annars false.
+*
+*                       - s    : Pekare till argumentet som ska tolkas.
+*                       - value: Pekare till variabel dr talet lagras.
+********************************************************************************/
+bool shell_parse_unsigned(const char* s,
+                          uint32_t* value);
+
+#endif /* SHELL_H_ */
\ No newline at end of file
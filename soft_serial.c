@@ -0,0 +1,684 @@
+/********************************************************************************
+* soft_serial.c: Innehller funktionsdefinitioner fr implementering av en
+*                andra seriell kanal via mjukvaru-UART, dr bittiden genereras
+*                av Compare Match B p Timer 0.
+*
+*                Tidpunkter lagras som vrden p TCNT0, dvs. modulo ett varv
+*                av Timer 0. En bitgrns rknas som passerad om den ligger
+*                mer n en bittid framt i tiden, vilket ger en marginal p
+*                minst SOFT_SERIAL_LATE_CYCLES klockcykler fr sena avbrott.
+********************************************************************************/
+#include "soft_serial.h"
+
+/* Makrodefinitioner: */
+#define SOFT_SERIAL_TX_BUFFER_MASK (SOFT_SERIAL_TX_BUFFER_SIZE - 1) /* Mask fr indexering av sndbufferten. */
+
+#if SOFT_SERIAL_TX_BUFFER_SIZE < 2 || SOFT_SERIAL_TX_BUFFER_SIZE > 256 || \
+    (SOFT_SERIAL_TX_BUFFER_SIZE & SOFT_SERIAL_TX_BUFFER_MASK) != 0
+#error "SOFT_SERIAL_TX_BUFFER_SIZE must be a power of two between 2 and 256!"
+#endif
+
+#define SOFT_SERIAL_RX_BUFFER_MASK (SOFT_SERIAL_RX_BUFFER_SIZE - 1) /* Mask fr indexering av mottagarbufferten. */
+
+#if SOFT_SERIAL_RX_BUFFER_SIZE < 2 || SOFT_SERIAL_RX_BUFFER_SIZE > 256 || \
+    (SOFT_SERIAL_RX_BUFFER_SIZE & SOFT_SERIAL_RX_BUFFER_MASK) != 0
+#error "SOFT_SERIAL_RX_BUFFER_SIZE must be a power of two between 2 and 256!"
+#endif
+
+#define SOFT_SERIAL_TIMER_CLOCK (1 << CS01)   /* Prescaler 8 om Timer 0 inte redan r igng. */
+#define SOFT_SERIAL_TIMER_CLOCK_MASK ((1 << CS02) | (1 << CS01) | (1 << CS00))
+#define SOFT_SERIAL_BIT_TICKS_MIN 12          /* Kortaste bittid i timersteg (upplsning). */
+#define SOFT_SERIAL_BIT_CYCLES_MIN 384        /* Kortaste bittid i klockcykler (avbrottens lngd). */
+#define SOFT_SERIAL_LATE_CYCLES 256           /* Minsta marginal fr sena bitgrnser i klockcykler. */
+#define SOFT_SERIAL_RX_LATENCY_CYCLES 40      /* Frn flank till avlsning av TCNT0 i klockcykler. */
+#define SOFT_SERIAL_TX_START_TICKS 4          /* Frdrjning innan frsta startbiten. */
+#define SOFT_SERIAL_DATA_BITS 8               /* Antal databitar per tecken. */
+
+#define SOFT_SERIAL_TX_BIT (SOFT_SERIAL_TX_PIN) /* Sndlinjens bit i PORTD. */
+#define SOFT_SERIAL_RX_BIT PORTD2               /* Mottagarlinjens bit i PORTD (INT0). */
+
+/* Statiska variabler: */
+static volatile uint8_t tx_buffer[SOFT_SERIAL_TX_BUFFER_SIZE]; /* Sndbuffert (ringbuffert). */
+static volatile uint8_t tx_head = 0; /* Index dr nsta tecken placeras. */
+static volatile uint8_t tx_tail = 0; /* Index fr nsta tecken som ska skickas. */
+static enum serial_overflow_policy tx_policy = SERIAL_OVERFLOW_BLOCK; /* tgrd vid full buffert. */
+
+static volatile uint8_t rx_buffer[SOFT_SERIAL_RX_BUFFER_SIZE]; /* Mottagarbuffert (ringbuffert). */
+static volatile uint8_t rx_head = 0; /* Index dr nsta mottagna tecken placeras. */
+static volatile uint8_t rx_tail = 0; /* Index fr nsta tecken som ska lsas. */
+static volatile uint16_t rx_errors = 0; /* Antalet kastade tecken. */
+
+static uint8_t bit_ticks = 0;      /* Bittid i timersteg (0 = ej initierad). */
+static uint8_t rx_start_ticks = 0; /* Tid frn startbitens flank till dess mitt. */
+static uint16_t timer_period = 0;  /* Antal timersteg per varv av Timer 0. */
+
+/* Prescaler fr bitar CS02:0 (0 = stoppad eller extern klocka): */
+static const uint16_t timer_prescalers[] PROGMEM =
+{
+   0, 1, 8, 64, 256, 1024, 0, 0
+};
+
+static volatile bool tx_active = false; /* Indikerar pgende sndning. */
+static volatile uint8_t tx_next = 0;    /* Tidpunkt fr nsta bitgrns vid sndning. */
+static volatile uint8_t tx_bits = 0;    /* Antal kvarvarande bitar i aktuellt tecken. */
+static volatile uint8_t tx_data = 0;    /* Tecken som skiftas ut. */
+
+static volatile bool rx_active = false; /* Indikerar pgende mottagning. */
+static volatile uint8_t rx_next = 0;    /* Tidpunkt fr nsta sampling vid mottagning. */
+static volatile uint8_t rx_bits = 0;    /* Antal samplade bitar i aktuellt tecken. */
+static volatile uint8_t rx_data = 0;    /* Tecken som skiftas in. */
+
+/* Statiska funktioner: */
+static void soft_serial_update(void);
+static void soft_serial_tx_next_bit(void);
+static void soft_serial_rx_next_bit(void);
+static void soft_serial_rx_restart(void);
+static void soft_serial_tx_start(void);
+static void soft_serial_poll(void);
+static inline bool soft_serial_interrupts_enabled(void);
+static inline uint8_t soft_serial_timer_add(const uint8_t time,
+                                            const uint8_t ticks);
+static inline uint8_t soft_serial_ticks_left(const uint8_t time,
+                                             const uint8_t now);
+static inline bool soft_serial_due(const uint8_t time,
+                                   const uint8_t now);
+
+/********************************************************************************
+* ISR (TIMER0_COMPB_vect): Avbrottsrutin som ger rum vid nsta schemalagda
+*                          bitgrns fr sndning eller mottagning.
+********************************************************************************/
+ISR (TIMER0_COMPB_vect)
+{
+   soft_serial_update();
+   return;
+}
+
+/********************************************************************************
+* ISR (INT0_vect): Avbrottsrutin som ger rum vid fallande flank p pin 2,
+*                  dvs. vid brjan av en startbit. Tidpunkten fr flanken
+*                  lses av direkt och frsta samplingen schemalggs till
+*                  mitten av startbiten. INT0 inaktiveras tills tecknets
+*                  stoppbit har samplats.
+********************************************************************************/
+ISR (INT0_vect)
+{
+   const uint8_t now = TCNT0;
+   EIMSK &= ~(1 << INT0);
+
+   rx_bits = 0;
+   rx_next = soft_serial_timer_add(now, rx_start_ticks);
+   rx_active = true;
+   soft_serial_update();
+   return;
+}
+
+/********************************************************************************
+* soft_serial_init: Initierar mjukvaru-UART:en med angiven baud rate, tta
+*                   databitar, ingen paritet och en stoppbit. Prescaler samt
+*                   varvets lngd lses av frn Timer 0 (OCR0A + 1 i CTC Mode,
+*                   annars 256), varefter bittiden avrundas till nrmaste
+*                   hela timersteg. Med 4 us upplsning ger detta en
+*                   avvikelse p 0.16 % vid 9600 och 19 200 baud.
+*                   Sndlinjen stts hg (viloniv) och intern pullup
+*                   aktiveras p mottagarlinjen, s att en ej ansluten linje
+*                   inte ger falska startbitar.
+*
+*                   - baud_rate: verfringshastighet mtt i bitar per sekund
+*                                (0 = SOFT_SERIAL_BAUD_RATE).
+********************************************************************************/
+int soft_serial_init(const uint32_t baud_rate)
+{
+   const uint32_t baud = baud_rate ? baud_rate : SOFT_SERIAL_BAUD_RATE;
+   const uint8_t clock = TCCR0B & SOFT_SERIAL_TIMER_CLOCK_MASK;
+   const uint16_t prescaler = pgm_read_word(&timer_prescalers[clock ? clock : SOFT_SERIAL_TIMER_CLOCK]);
+   const uint16_t period = clock && (TCCR0A & (1 << WGM01)) ? OCR0A + 1 : 256;
+   const uint16_t late_ticks = (SOFT_SERIAL_LATE_CYCLES + prescaler - 1) / prescaler;
+   const uint32_t ticks = ((F_CPU) / prescaler + baud / 2) / baud;
+
+   if (prescaler == 0 || ticks < SOFT_SERIAL_BIT_TICKS_MIN || ticks + late_ticks >= period ||
+       ticks * prescaler < SOFT_SERIAL_BIT_CYCLES_MIN)
+   {
+      return 1;
+   }
+
+   soft_serial_disable();
+   bit_ticks = (uint8_t)ticks;
+   timer_period = period;
+   rx_start_ticks = bit_ticks / 2 - (SOFT_SERIAL_RX_LATENCY_CYCLES + prescaler / 2) / prescaler;
+
+   PORTD |= (1 << SOFT_SERIAL_TX_BIT);
+   DDRD |= (1 << SOFT_SERIAL_TX_BIT);
+   DDRD &= ~(1 << SOFT_SERIAL_RX_BIT);
+   PORTD |= (1 << SOFT_SERIAL_RX_BIT);
+
+   if (clock == 0)
+   {
+      TCCR0A &= ~((1 << WGM01) | (1 << WGM00));
+      TCCR0B = SOFT_SERIAL_TIMER_CLOCK;
+   }
+
+   EICRA = (EICRA & ~((1 << ISC01) | (1 << ISC00))) | (1 << ISC01);
+   EIFR = (1 << INTF0);
+   EIMSK |= (1 << INT0);
+   asm("SEI");
+   return 0;
+}
+
+/********************************************************************************
+* soft_serial_disable: Inaktiverar mjukvaru-UART:en. Pgende verfring
+*                      avbryts och buffrarna tms. Sndlinjen lmnas hg.
+********************************************************************************/
+void soft_serial_disable(void)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   EIMSK &= ~(1 << INT0);
+   TIMSK0 &= ~(1 << OCIE0B);
+
+   tx_active = false;
+   rx_active = false;
+   tx_head = tx_tail = 0;
+   rx_head = rx_tail = 0;
+   rx_errors = 0;
+
+   if (bit_ticks)
+   {
+      PORTD |= (1 << SOFT_SERIAL_TX_BIT);
+   }
+   SREG = sreg;
+   return;
+}
+
+/********************************************************************************
+* soft_serial_set_overflow_policy: Vljer tgrd fr nr sndbufferten r
+*                                  full, se serial_overflow_policy.
+*
+*                                  - policy: tgrden som ska anvndas.
+********************************************************************************/
+void soft_serial_set_overflow_policy(const enum serial_overflow_policy policy)
+{
+   tx_policy = policy;
+   return;
+}
+
+/********************************************************************************
+* soft_serial_write: Placerar angivet antal byte i sndbufferten och
+*                    returnerar antalet byte som kades. Vid
+*                    SERIAL_OVERFLOW_DROP avbryts skrivningen vid frsta byte
+*                    som inte fr plats.
+*
+*                    - data: Pekare till de byte som ska skickas.
+*                    - size: Antalet byte som ska skickas.
+********************************************************************************/
+size_t soft_serial_write(const void* data,
+                         const size_t size)
+{
+   const char* bytes = (const char*)data;
+   size_t num_queued = 0;
+
+   while (num_queued < size && soft_serial_write_char(bytes[num_queued]))
+   {
+      num_queued++;
+   }
+   return num_queued;
+}
+
+/********************************************************************************
+* soft_serial_write_char: Placerar ett enskilt tecken i sndbufferten och
+*                         startar sndningen om den inte redan pgr.
+*                         Returnerar 1 om tecknet kades, annars 0.
+*
+*                         Full sndbuffert hanteras enligt vald tgrd, likt
+*                         serial_write_char. Om avbrott r inaktiverade vid
+*                         SERIAL_OVERFLOW_BLOCK hanteras bitgrnserna genom
+*                         pollning av flaggan OCF0B fr att undvika ddlge.
+*
+*                         - character: Tecknet som ska skickas.
+********************************************************************************/
+uint8_t soft_serial_write_char(const char character)
+{
+   const uint8_t next = (tx_head + 1) & SOFT_SERIAL_TX_BUFFER_MASK;
+   if (!bit_ticks) return 0;
+
+   while (next == tx_tail)
+   {
+      if (tx_policy == SERIAL_OVERFLOW_DROP)
+      {
+         return 0;
+      }
+      else if (tx_policy == SERIAL_OVERFLOW_OVERWRITE)
+      {
+         const uint8_t sreg = SREG;
+         asm("CLI");
+         if (next == tx_tail) tx_tail = (tx_tail + 1) & SOFT_SERIAL_TX_BUFFER_MASK;
+         SREG = sreg;
+      }
+      else if (!soft_serial_interrupts_enabled())
+      {
+         soft_serial_poll();
+      }
+   }
+
+   tx_buffer[tx_head] = (uint8_t)character;
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   tx_head = next;
+   soft_serial_tx_start();
+   SREG = sreg;
+   return 1;
+}
+
+/********************************************************************************
+* soft_serial_write_string: Placerar ett textstycke i sndbufferten utan
+*                           konvertering av nyradstecken och returnerar
+*                           antalet tecken som kades.
+*
+*                           - s: Pekare till det textstycke som ska skickas.
+********************************************************************************/
+size_t soft_serial_write_string(const char* s)
+{
+   size_t num_queued = 0;
+
+   for (const char* i = s; *i; ++i)
+   {
+      if (!soft_serial_write_char(*i)) break;
+      num_queued++;
+   }
+   return num_queued;
+}
+
+/********************************************************************************
+* soft_serial_write_string_P: Placerar ett textstycke lagrat i programminnet
+*                             i sndbufferten utan konvertering av
+*                             nyradstecken och returnerar antalet tecken
+*                             som kades.
+*
+*                             - s: Pekare till textstycket i programminnet.
+********************************************************************************/
+size_t soft_serial_write_string_P(PGM_P s)
+{
+   size_t num_queued = 0;
+
+   for (char c = pgm_read_byte(s); c; c = pgm_read_byte(++s))
+   {
+      if (!soft_serial_write_char(c)) break;
+      num_queued++;
+   }
+   return num_queued;
+}
+
+/********************************************************************************
+* soft_serial_tx_pending: Returnerar antalet byte som vntar p att skickas.
+********************************************************************************/
+size_t soft_serial_tx_pending(void)
+{
+   return (uint8_t)(tx_head - tx_tail) & SOFT_SERIAL_TX_BUFFER_MASK;
+}
+
+/********************************************************************************
+* soft_serial_tx_free: Returnerar antalet lediga platser i sndbufferten. En
+*                      plats hlls alltid tom fr att skilja en full buffert
+*                      frn en tom.
+********************************************************************************/
+size_t soft_serial_tx_free(void)
+{
+   return SOFT_SERIAL_TX_BUFFER_MASK - soft_serial_tx_pending();
+}
+
+/********************************************************************************
+* soft_serial_flush: Vntar tills sndbufferten r tom och sista tecknets
+*                    stoppbit har skickats. Om avbrott r inaktiverade
+*                    hanteras bitgrnserna genom pollning.
+********************************************************************************/
+void soft_serial_flush(void)
+{
+   if (!bit_ticks) return;
+
+   while (tx_active)
+   {
+      if (!soft_serial_interrupts_enabled())
+      {
+         soft_serial_poll();
+      }
+   }
+   return;
+}
+
+/********************************************************************************
+* soft_serial_discard: Tmmer sndbufferten utan att skicka kvarvarande
+*                      tecken. Ett tecken som redan skiftas ut skickas klart.
+********************************************************************************/
+void soft_serial_discard(void)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   tx_tail = tx_head;
+   SREG = sreg;
+   return;
+}
+
+/********************************************************************************
+* soft_serial_read_char: Lser nsta mottagna tecken frn mottagarbufferten.
+*                        Returnerar true om ett tecken lstes, annars false.
+*
+*                        - character: Pekare till variabel dr tecknet lagras.
+********************************************************************************/
+bool soft_serial_read_char(char* character)
+{
+   if (rx_head == rx_tail) return false;
+   *character = (char)rx_buffer[rx_tail];
+   rx_tail = (rx_tail + 1) & SOFT_SERIAL_RX_BUFFER_MASK;
+   return true;
+}
+
+/********************************************************************************
+* soft_serial_rx_available: Returnerar antalet mottagna tecken som vntar p
+*                           att lsas.
+********************************************************************************/
+size_t soft_serial_rx_available(void)
+{
+   return (uint8_t)(rx_head - rx_tail) & SOFT_SERIAL_RX_BUFFER_MASK;
+}
+
+/********************************************************************************
+* soft_serial_rx_discard: Tmmer mottagarbufferten.
+********************************************************************************/
+void soft_serial_rx_discard(void)
+{
+   rx_tail = rx_head;
+   return;
+}
+
+/********************************************************************************
+* soft_serial_rx_errors: Returnerar antalet mottagna tecken som har kastats,
+*                        antingen p grund av ramfel (stoppbiten ej satt)
+*                        eller full mottagarbuffert.
+********************************************************************************/
+uint16_t soft_serial_rx_errors(void)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   const uint16_t num_errors = rx_errors;
+   SREG = sreg;
+   return num_errors;
+}
+
+/********************************************************************************
+* soft_serial_print_string: Skriver ut text via mjukvaru-UART:en, dr
+*                           nyradstecken fljs av vagnretur.
+*
+*                           - s: Pekare till det textstycke som ska skrivas ut.
+********************************************************************************/
+void soft_serial_print_string(const char* s)
+{
+   for (const char* i = s; *i; ++i)
+   {
+      soft_serial_print_char(*i);
+
+      if (*i == '\n')
+      {
+         soft_serial_print_char('\r');
+      }
+   }
+   return;
+}
+
+/********************************************************************************
+* soft_serial_print_string_P: Skriver ut text lagrad i programminnet via
+*                             mjukvaru-UART:en, dr nyradstecken fljs av
+*                             vagnretur.
+*
+*                             - s: Pekare till textstycket i programminnet.
+********************************************************************************/
+void soft_serial_print_string_P(PGM_P s)
+{
+   for (char c = pgm_read_byte(s); c; c = pgm_read_byte(++s))
+   {
+      soft_serial_print_char(c);
+
+      if (c == '\n')
+      {
+         soft_serial_print_char('\r');
+      }
+   }
+   return;
+}
+
+/********************************************************************************
+* soft_serial_update: Hanterar samtliga bitgrnser som har passerats och
+*                     schemalgger Compare Match B till den nrmast
+*                     frestende. Om tidpunkten hinner passeras innan OCR0B
+*                     har skrivits hanteras den direkt, annars skulle nsta
+*                     compare match drja ett helt varv. Avbrottet inaktiveras
+*                     nr varken sndning eller mottagning pgr. Anropas
+*                     med avbrott inaktiverade.
+********************************************************************************/
+static void soft_serial_update(void)
+{
+   while (tx_active || rx_active)
+   {
+      const uint8_t now = TCNT0;
+      uint8_t next;
+
+      if (rx_active && soft_serial_due(rx_next, now))
+      {
+         soft_serial_rx_next_bit();
+         continue;
+      }
+      else if (tx_active && soft_serial_due(tx_next, now))
+      {
+         soft_serial_tx_next_bit();
+         continue;
+      }
+
+      if (!tx_active)
+      {
+         next = rx_next;
+      }
+      else if (!rx_active)
+      {
+         next = tx_next;
+      }
+      else
+      {
+         next = soft_serial_ticks_left(rx_next, now) < soft_serial_ticks_left(tx_next, now) ?
+                rx_next : tx_next;
+      }
+
+      OCR0B = next;
+      TIFR0 = (1 << OCF0B);
+      TIMSK0 |= (1 << OCIE0B);
+      if (!soft_serial_due(next, TCNT0)) return;
+   }
+
+   TIMSK0 &= ~(1 << OCIE0B);
+   return;
+}
+
+/********************************************************************************
+* soft_serial_tx_next_bit: Skickar nsta bit vid sndning. Efter stoppbiten
+*                          hmtas nsta tecken frn sndbufferten, dr
+*                          sndningen avslutas om bufferten r tom.
+********************************************************************************/
+static void soft_serial_tx_next_bit(void)
+{
+   if (tx_bits == 0)
+   {
+      if (tx_head == tx_tail)
+      {
+         tx_active = false;
+         return;
+      }
+
+      tx_data = tx_buffer[tx_tail];
+      tx_tail = (tx_tail + 1) & SOFT_SERIAL_TX_BUFFER_MASK;
+      tx_bits = SOFT_SERIAL_DATA_BITS + 1;
+      PORTD &= ~(1 << SOFT_SERIAL_TX_BIT);
+   }
+   else if (tx_bits > 1)
+   {
+      if (tx_data & 0x01)
+      {
+         PORTD |= (1 << SOFT_SERIAL_TX_BIT);
+      }
+      else
+      {
+         PORTD &= ~(1 << SOFT_SERIAL_TX_BIT);
+      }
+
+      tx_data >>= 1;
+      tx_bits--;
+   }
+   else
+   {
+      PORTD |= (1 << SOFT_SERIAL_TX_BIT);
+      tx_bits = 0;
+   }
+
+   tx_next = soft_serial_timer_add(tx_next, bit_ticks);
+   return;
+}
+
+/********************************************************************************
+* soft_serial_rx_next_bit: Samplar mottagarlinjen mitt i aktuell bit. Om
+*                          linjen r hg vid startbitens mitt var flanken en
+*                          strning och mottagningen avbryts. Vid stoppbiten
+*                          placeras tecknet i mottagarbufferten, frutsatt
+*                          att stoppbiten r satt och att bufferten inte r
+*                          full.
+********************************************************************************/
+static void soft_serial_rx_next_bit(void)
+{
+   const bool high = PIND & (1 << SOFT_SERIAL_RX_BIT);
+
+   if (rx_bits == 0)
+   {
+      if (high)
+      {
+         soft_serial_rx_restart();
+         return;
+      }
+   }
+   else if (rx_bits <= SOFT_SERIAL_DATA_BITS)
+   {
+      rx_data >>= 1;
+      if (high) rx_data |= 0x80;
+   }
+   else
+   {
+      const uint8_t next = (rx_head + 1) & SOFT_SERIAL_RX_BUFFER_MASK;
+
+      if (high && next != rx_tail)
+      {
+         rx_buffer[rx_head] = rx_data;
+         rx_head = next;
+      }
+      else if (rx_errors < UINT16_MAX)
+      {
+         rx_errors++;
+      }
+
+      soft_serial_rx_restart();
+      return;
+   }
+
+   rx_bits++;
+   rx_next = soft_serial_timer_add(rx_next, bit_ticks);
+   return;
+}
+
+/********************************************************************************
+* soft_serial_rx_restart: Avslutar mottagning av aktuellt tecken och
+*                         teraktiverar INT0 fr detektering av nsta
+*                         startbit. Flaggan INTF0 nollstlls frst, d
+*                         flanker inuti tecknet annars skulle ge avbrott.
+********************************************************************************/
+static void soft_serial_rx_restart(void)
+{
+   rx_active = false;
+   EIFR = (1 << INTF0);
+   EIMSK |= (1 << INT0);
+   return;
+}
+
+/********************************************************************************
+* soft_serial_tx_start: Startar sndning om den inte redan pgr. Frsta
+*                       startbiten schemalggs ngra timersteg framt i
+*                       tiden. Anropas med avbrott inaktiverade.
+********************************************************************************/
+static void soft_serial_tx_start(void)
+{
+   if (tx_active) return;
+
+   tx_bits = 0;
+   tx_next = soft_serial_timer_add(TCNT0, SOFT_SERIAL_TX_START_TICKS);
+   tx_active = true;
+   soft_serial_update();
+   return;
+}
+
+/********************************************************************************
+* soft_serial_poll: Hanterar passerade bitgrnser nr avbrott r inaktiverade,
+*                   exempelvis vid utskrift frn en avbrottsrutin.
+********************************************************************************/
+static void soft_serial_poll(void)
+{
+   if (TIFR0 & (1 << OCF0B))
+   {
+      TIFR0 = (1 << OCF0B);
+      soft_serial_update();
+   }
+   return;
+}
+
+/********************************************************************************
+* soft_serial_interrupts_enabled: Indikerar ifall avbrott r aktiverade
+*                                 globalt.
+********************************************************************************/
+static inline bool soft_serial_interrupts_enabled(void)
+{
+   return (SREG & (1 << SREG_I));
+}
+
+/********************************************************************************
+* soft_serial_timer_add: Returnerar tidpunkten angivet antal timersteg efter
+*                        angiven tidpunkt, rknat modulo ett varv av Timer 0.
+*
+*                        - time : Tidpunkten som vrde p TCNT0.
+*                        - ticks: Antalet timersteg som ska adderas.
+********************************************************************************/
+static inline uint8_t soft_serial_timer_add(const uint8_t time,
+                                            const uint8_t ticks)
+{
+   const uint16_t sum = (uint16_t)time + ticks;
+   return (uint8_t)(sum >= timer_period ? sum - timer_period : sum);
+}
+
+/********************************************************************************
+* soft_serial_ticks_left: Returnerar antalet timersteg frn aktuell tidpunkt
+*                         till angiven tidpunkt, rknat modulo ett varv av
+*                         Timer 0.
+*
+*                         - time: Tidpunkten som vrde p TCNT0.
+*                         - now : Aktuellt vrde p TCNT0.
+********************************************************************************/
+static inline uint8_t soft_serial_ticks_left(const uint8_t time,
+                                             const uint8_t now)
+{
+   return (uint8_t)(time >= now ? time - now : time + timer_period - now);
+}
+
+/********************************************************************************
+* soft_serial_due: Indikerar ifall angiven tidpunkt har ntts. Tidpunkter som
+*                  ligger mer n en bittid framt rknas som passerade, d
+*                  en bitgrns aldrig schemalggs lngre fram n s.
+*
+*                  - time: Tidpunkten som ska kontrolleras.
+*                  - now : Aktuellt vrde p TCNT0.
+********************************************************************************/
+static inline bool soft_serial_due(const uint8_t time,
+                                   const uint8_t now)
+{
+   const uint8_t ticks_left = soft_serial_ticks_left(time, now);
+   return ticks_left == 0 || ticks_left > bit_ticks;
+}
\ No newline at end of file
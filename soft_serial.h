@@ -0,0 +1,225 @@
+/********************************************************************************
+* soft_serial.h: Innehller drivrutiner fr en andra seriell kanal via
+*                mjukvaru-UART, exempelvis fr kommunikation med en GPS-modul
+*                eller en RS-485-transceiver, d den enda USART:en anvnds
+*                av serial.c.
+*
+*                Bittiden genereras av Compare Match B p Timer 0, som delas
+*                med timer t0 (se timer.c). Prescaler samt toppvrde (OCR0A i
+*                CTC Mode) lses av vid initieringen och bittiden rknas i
+*                samma timersteg, drmed ska soft_serial_init anropas efter
+*                timer_init fr Timer 0, samt p nytt om tiden fr t0
+*                ndras. Varje bit schemalggs genom att OCR0B stts till
+*                tidpunkten fr nsta bitgrns, drmed krvs ingen
+*                frdrjning via _delay_us och huvudprogrammet fortstter
+*                exekvera mellan bitarna.
+*                Sndning och mottagning delar samma compare-kanal, dr
+*                avbrottsrutinen hanterar den av dem som ligger nrmast i
+*                tid. verfringen r drmed full duplex.
+*
+*                Startbiten vid mottagning detekteras via externt avbrott
+*                INT0 p fallande flank, varefter varje bit samplas mitt i
+*                bittiden. Mottagarlinjen r drmed fast ansluten till pin 2
+*                (PORTD2), medan sndlinjen vljs via SOFT_SERIAL_TX_PIN.
+*
+*                Tillfrlitlig verfring sker upp till 19 200 baud. En bittid
+*                mste rymmas inom ett varv av Timer 0 och motsvara minst
+*                tolv timersteg; med prescaler 64 (4 us upplsning) och ett
+*                varv p 1 ms innebr detta 1200 - 19 200 baud bland
+*                standardhastigheterna. Andra avbrottsrutiner frdrjer
+*                bitgrnserna och ska drfr vara korta; ett avbrott som
+*                blockerar lngre n ungefr en halv bittid kan ge ramfel
+*                p tecknet som verfrs.
+*
+*                Grnssnittet motsvarar serial.h med prefixet soft_serial, s
+*                att samma kod kan anvndas med bda kanalerna. Formaterad
+*                utskrift av tal saknas dock.
+********************************************************************************/
+#ifndef SOFT_SERIAL_H_
+#define SOFT_SERIAL_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "serial.h"
+
+/* Makrodefinitioner: */
+#ifndef SOFT_SERIAL_TX_BUFFER_SIZE
+#define SOFT_SERIAL_TX_BUFFER_SIZE 32 /* Sndbuffertens storlek i byte (tvpotens, max 256). */
+#endif
+
+#ifndef SOFT_SERIAL_RX_BUFFER_SIZE
+#define SOFT_SERIAL_RX_BUFFER_SIZE 32 /* Mottagarbuffertens storlek i byte (tvpotens, max 256). */
+#endif
+
+#ifndef SOFT_SERIAL_BAUD_RATE
+#define SOFT_SERIAL_BAUD_RATE 9600UL /* Default baud rate fr mjukvaru-UART:en. */
+#endif
+
+#ifndef SOFT_SERIAL_TX_PIN
+#define SOFT_SERIAL_TX_PIN 3 /* Sndlinjens pin p Arduino Uno (0 - 7, dvs. PORTD). */
+#endif
+
+#if SOFT_SERIAL_TX_PIN < 0 || SOFT_SERIAL_TX_PIN > 7 || SOFT_SERIAL_TX_PIN == 2
+#error "SOFT_SERIAL_TX_PIN must be one of pin 0 - 7 except pin 2 (INT0)!"
+#endif
+
+/********************************************************************************
+* soft_serial_init: Initierar mjukvaru-UART:en med angiven baud rate, tta
+*                   databitar, ingen paritet och en stoppbit. Timer 0 startas
+*                   i Normal Mode med prescaler 8 om den inte redan r igng.
+*                   Returnerar 0 vid lyckad initiering, annars 1 (baud rate
+*                   som inte kan uppns med Timer 0:s aktuella prescaler
+*                   och toppvrde).
+*
+*                   - baud_rate: verfringshastighet mtt i bitar per sekund
+*                                (0 = SOFT_SERIAL_BAUD_RATE).
+********************************************************************************/
+int soft_serial_init(const uint32_t baud_rate);
+
+/********************************************************************************
+* soft_serial_disable: Inaktiverar mjukvaru-UART:en. Pgende verfring
+*                      avbryts och buffrarna tms.
+********************************************************************************/
+void soft_serial_disable(void);
+
+/********************************************************************************
+* soft_serial_set_overflow_policy: Vljer tgrd fr nr sndbufferten r
+*                                  full, se serial_overflow_policy.
+*
+*                                  - policy: tgrden som ska anvndas.
+********************************************************************************/
+void soft_serial_set_overflow_policy(const enum serial_overflow_policy policy);
+
+/********************************************************************************
+* soft_serial_write: Placerar angivet antal byte i sndbufferten och
+*                    returnerar antalet byte som kades.
+*
+*                    - data: Pekare till de byte som ska skickas.
+*                    - size: Antalet byte som ska skickas.
+********************************************************************************/
+size_t soft_serial_write(const void* data,
+                         const size_t size);
+
+/********************************************************************************
+* soft_serial_write_char: Placerar ett enskilt tecken i sndbufferten.
+*                         Returnerar 1 om tecknet kades, annars 0.
+*
+*                         - character: Tecknet som ska skickas.
+********************************************************************************/
+uint8_t soft_serial_write_char(const char character);
+
+/********************************************************************************
+* soft_serial_write_string: Placerar ett textstycke i sndbufferten utan
+*                           konvertering av nyradstecken och returnerar
+*                           antalet tecken som kades.
+*
+*                           - s: Pekare till det textstycke som ska skickas.
+********************************************************************************/
+size_t soft_serial_write_string(const char* s);
+
+/********************************************************************************
+* soft_serial_write_string_P: Placerar ett textstycke lagrat i programminnet
+*                             i sndbufferten utan konvertering av
+*                             nyradstecken och returnerar antalet tecken
+*                             som kades.
+*
+*                             - s: Pekare till textstycket i programminnet.
+********************************************************************************/
+size_t soft_serial_write_string_P(PGM_P s);
+
+/********************************************************************************
+* soft_serial_tx_pending: Returnerar antalet byte som vntar p att skickas.
+********************************************************************************/
+size_t soft_serial_tx_pending(void);
+
+/********************************************************************************
+* soft_serial_tx_free: Returnerar antalet lediga platser i sndbufferten.
+********************************************************************************/
+size_t soft_serial_tx_free(void);
+
+/********************************************************************************
+* soft_serial_flush: Vntar tills sndbufferten r tom och sista tecknets
+*                    stoppbit har skickats.
+********************************************************************************/
+void soft_serial_flush(void);
+
+/********************************************************************************
+* soft_serial_discard: Tmmer sndbufferten utan att skicka kvarvarande
+*                      tecken. Ett tecken som redan skiftas ut skickas klart.
+********************************************************************************/
+void soft_serial_discard(void);
+
+/********************************************************************************
+* soft_serial_read_char: Lser nsta mottagna tecken frn mottagarbufferten.
+*                        Returnerar true om ett tecken lstes, annars false.
+*
+*                        - character: Pekare till variabel dr tecknet lagras.
+********************************************************************************/
+bool soft_serial_read_char(char* character);
+
+/********************************************************************************
+* soft_serial_rx_available: Returnerar antalet mottagna tecken som vntar p
+*                           att lsas.
+********************************************************************************/
+size_t soft_serial_rx_available(void);
+
+/********************************************************************************
+* soft_serial_rx_discard: Tmmer mottagarbufferten.
+********************************************************************************/
+void soft_serial_rx_discard(void);
+
+/********************************************************************************
+* soft_serial_rx_errors: Returnerar antalet mottagna tecken som har kastats,
+*                        antingen p grund av ramfel (stoppbiten ej satt)
+*                        eller full mottagarbuffert.
+********************************************************************************/
+uint16_t soft_serial_rx_errors(void);
+
+/********************************************************************************
+* soft_serial_print_string: Skriver ut text via mjukvaru-UART:en, dr
+*                           nyradstecken fljs av vagnretur.
+*
+*                           - s: Pekare till det textstycke som ska skrivas ut.
+********************************************************************************/
+void soft_serial_print_string(const char* s);
+
+/********************************************************************************
+* soft_serial_print_string_P: Skriver ut text lagrad i programminnet via
+*                             mjukvaru-UART:en, dr nyradstecken fljs av
+*                             vagnretur.
+*
+*                             - s: Pekare till textstycket i programminnet.
+********************************************************************************/
+void soft_serial_print_string_P(PGM_P s);
+
+/********************************************************************************
+* soft_serial_print_P: Skriver ut en strngliteral som lagras i
+*                      programminnet, se serial_print_P.
+*
+*                      - s: Strngliteralen som ska skrivas ut.
+********************************************************************************/
+#define soft_serial_print_P(s) soft_serial_print_string_P(PSTR(s))
+
+/********************************************************************************
+* soft_serial_print_char: Skriver ut ett enskilt tecken via mjukvaru-UART:en.
+*
+*                         - character: Det tecken som ska skrivas ut.
+********************************************************************************/
+static inline void soft_serial_print_char(const char character)
+{
+   (void)soft_serial_write_char(character);
+   return;
+}
+
+/********************************************************************************
+* soft_serial_print_new_line: Stter nsta utskrift till lngst till vnster
+*                             p nsta rad via utskrift av ett nyradstecken.
+********************************************************************************/
+static inline void soft_serial_print_new_line(void)
+{
+   soft_serial_print_char('\n');
+   soft_serial_print_char('\r');
+   return;
+}
+
+#endif /* SOFT_SERIAL_H_ */
\ No newline at end of file
@@ -0,0 +1,274 @@
+/********************************************************************************
+* soft_timer.c: Innehller funktionsdefinitioner fr implementering av
+*               mjukvarutimers via strukten soft_timer.
+*
+*               Heapen lagrar pekare till aktiva timers, dr heap[0] alltid
+*               r den timer som lper ut frst. Varje timer lagrar sin egen
+*               position i heapen, s att den kan tas bort utan skning.
+*               Tidpunkter jmfrs via time_before, drmed hanteras overflow
+*               av systemtiden korrekt s lnge ingen frdrjning verstiger
+*               2^31 millisekunder.
+*
+*               Efter varje ndring av heapen lagras frsta timerns tidpunkt
+*               i soft_timer_next_expiry, som jmfrs med systemtiden i
+*               avbrottsrutinen fr Timer 0. Om heapen r tom lagras
+*               fregende millisekund, som inte ns frrn systemtiden har
+*               slagit runt, varvid heapen endast kontrolleras p nytt.
+********************************************************************************/
+#include "soft_timer.h"
+
+/* Globala variabler: */
+volatile uint32_t soft_timer_next_expiry = 0xFFFFFFFF; /* Tidpunkt d frsta timern lper ut. */
+
+/* Statiska variabler: */
+static struct soft_timer* heap[SOFT_TIMER_MAX]; /* Aktiva timers (binr min-heap). */
+static uint8_t heap_size = 0;                   /* Antalet aktiva timers. */
+
+/* Statiska funktioner: */
+static void soft_timer_insert(struct soft_timer* self);
+static void soft_timer_remove(struct soft_timer* self);
+static void soft_timer_sift_up(uint8_t index);
+static void soft_timer_sift_down(uint8_t index);
+static inline void soft_timer_place(struct soft_timer* self,
+                                    const uint8_t index);
+static inline void soft_timer_update_next(void);
+
+/********************************************************************************
+* ISR (SOFT_TIMER_DISPATCH_vect): Fullstndig avbrottsrutin, som avbrottsrutinen
+*                                 fr Timer 0 hoppar till nr systemtiden nr
+*                                 soft_timer_next_expiry. Samtliga register
+*                                 sparas undan hr, s att callback-rutinerna
+*                                 kan anropas.
+********************************************************************************/
+ISR (SOFT_TIMER_DISPATCH_vect)
+{
+   soft_timer_tick();
+   return;
+}
+
+/********************************************************************************
+* soft_timer_init: Initierar ny mjukvarutimer, som r inaktiv tills den
+*                  startas via soft_timer_start.
+*
+*                  - self    : Pekare till timern som ska initieras.
+*                  - callback: Pekare till rutinen som anropas nr timern
+*                              lper ut.
+*                  - context : Argument som skickas till callback-rutinen.
+********************************************************************************/
+void soft_timer_init(struct soft_timer* self,
+                     void (*callback)(void* context),
+                     void* context)
+{
+   self->callback = callback;
+   self->context = context;
+   self->expires = 0;
+   self->period = 0;
+   self->index = SOFT_TIMER_INACTIVE;
+   return;
+}
+
+/********************************************************************************
+* soft_timer_start: Startar angiven timer, som lper ut efter angiven tid och
+*                   drefter, om en periodtid anges, med angivet intervall
+*                   tills timern stoppas. En aktiv timer tas frst bort ur
+*                   heapen och placeras sedan in p nytt.
+*
+*                   - self     : Pekare till timern som ska startas.
+*                   - delay_ms : Tid tills timern lper ut frsta gngen.
+*                   - period_ms: Tid mellan efterfljande utlsningar
+*                                (0 = engngstimer).
+********************************************************************************/
+int soft_timer_start(struct soft_timer* self,
+                     const uint32_t delay_ms,
+                     const uint32_t period_ms)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+
+   if (soft_timer_active(self))
+   {
+      soft_timer_remove(self);
+   }
+   else if (heap_size >= SOFT_TIMER_MAX)
+   {
+      SREG = sreg;
+      return 1;
+   }
+
+   self->expires = time_ms_isr() + (delay_ms ? delay_ms : 1);
+   self->period = period_ms;
+   soft_timer_insert(self);
+   soft_timer_update_next();
+   SREG = sreg;
+   return 0;
+}
+
+/********************************************************************************
+* soft_timer_cancel: Stoppar angiven timer. Om timern redan r inaktiv sker
+*                    ingenting.
+*
+*                    - self: Pekare till timern som ska stoppas.
+********************************************************************************/
+void soft_timer_cancel(struct soft_timer* self)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+
+   if (soft_timer_active(self))
+   {
+      soft_timer_remove(self);
+      soft_timer_update_next();
+   }
+
+   SREG = sreg;
+   return;
+}
+
+/********************************************************************************
+* soft_timer_num_active: Returnerar antalet aktiva timers.
+********************************************************************************/
+uint8_t soft_timer_num_active(void)
+{
+   return heap_size;
+}
+
+/********************************************************************************
+* soft_timer_tick: Anropar callback-rutinerna fr samtliga timers som har
+*                  lpt ut vid aktuell systemtid. Om ingen timer lper ut
+*                  jmfrs endast frsta timern i heapen med aktuell tid.
+*                  Varje timer tas bort ur (eller placeras om i) heapen
+*                  innan dess callback-rutin anropas, s att rutinen kan
+*                  starta eller stoppa timern.
+********************************************************************************/
+void soft_timer_tick(void)
+{
+   const uint32_t now = time_ms_isr();
+
+   while (heap_size && !time_before(now, heap[0]->expires))
+   {
+      struct soft_timer* timer = heap[0];
+      soft_timer_remove(timer);
+
+      if (timer->period)
+      {
+         timer->expires += timer->period;
+         soft_timer_insert(timer);
+      }
+
+      timer->callback(timer->context);
+   }
+
+   soft_timer_update_next();
+   return;
+}
+
+/********************************************************************************
+* soft_timer_insert: Placerar angiven timer sist i heapen och flyttar den
+*                    sedan uppt till rtt position.
+*
+*                    - self: Pekare till timern som ska placeras in.
+********************************************************************************/
+static void soft_timer_insert(struct soft_timer* self)
+{
+   soft_timer_place(self, heap_size++);
+   soft_timer_sift_up(self->index);
+   return;
+}
+
+/********************************************************************************
+* soft_timer_remove: Tar bort angiven timer ur heapen genom att sista timern
+*                    flyttas till dess position, varefter den flyttade
+*                    timern flyttas uppt eller nedt till rtt position.
+*
+*                    - self: Pekare till timern som ska tas bort.
+********************************************************************************/
+static void soft_timer_remove(struct soft_timer* self)
+{
+   const uint8_t index = self->index;
+   struct soft_timer* last = heap[--heap_size];
+
+   self->index = SOFT_TIMER_INACTIVE;
+   if (last == self) return;
+
+   soft_timer_place(last, index);
+   soft_timer_sift_up(index);
+   soft_timer_sift_down(last->index);
+   return;
+}
+
+/********************************************************************************
+* soft_timer_sift_up: Flyttar timern p angiven position uppt i heapen s
+*                     lnge den lper ut fre sin frlder.
+*
+*                     - index: Timerns position i heapen.
+********************************************************************************/
+static void soft_timer_sift_up(uint8_t index)
+{
+   struct soft_timer* self = heap[index];
+
+   while (index > 0)
+   {
+      const uint8_t parent = (index - 1) / 2;
+      if (!time_before(self->expires, heap[parent]->expires)) break;
+      soft_timer_place(heap[parent], index);
+      index = parent;
+   }
+
+   soft_timer_place(self, index);
+   return;
+}
+
+/********************************************************************************
+* soft_timer_sift_down: Flyttar timern p angiven position nedt i heapen s
+*                       lnge ngot av dess barn lper ut fre den.
+*
+*                       - index: Timerns position i heapen.
+********************************************************************************/
+static void soft_timer_sift_down(uint8_t index)
+{
+   struct soft_timer* self = heap[index];
+
+   while (1)
+   {
+      const uint16_t left = 2 * (uint16_t)index + 1;
+      uint16_t child = left;
+
+      if (left >= heap_size) break;
+      if (left + 1 < heap_size && time_before(heap[left + 1]->expires, heap[left]->expires))
+      {
+         child = left + 1;
+      }
+
+      if (!time_before(heap[child]->expires, self->expires)) break;
+      soft_timer_place(heap[child], index);
+      index = (uint8_t)child;
+   }
+
+   soft_timer_place(self, index);
+   return;
+}
+
+/********************************************************************************
+* soft_timer_place: Placerar angiven timer p angiven position i heapen och
+*                   uppdaterar timerns lagrade position.
+*
+*                   - self : Pekare till timern.
+*                   - index: Position i heapen.
+********************************************************************************/
+static inline void soft_timer_place(struct soft_timer* self,
+                                    const uint8_t index)
+{
+   heap[index] = self;
+   self->index = index;
+   return;
+}
+
+/********************************************************************************
+* soft_timer_update_next: Lagrar tidpunkten d frsta timern i heapen lper
+*                         ut, eller fregende millisekund om heapen r tom.
+********************************************************************************/
+static inline void soft_timer_update_next(void)
+{
+   soft_timer_next_expiry = heap_size ? heap[0]->expires : time_ms_isr() - 1;
+   return;
+}
\ No newline at end of file
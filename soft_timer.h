@@ -0,0 +1,120 @@
+/********************************************************************************
+* soft_timer.h: Innehller drivrutiner fr mjukvarutimers via strukten
+*               soft_timer, dr ett godtyckligt antal engngstimers samt
+*               periodiska timers delar p en och samma hrdvarutimer.
+*
+*               Tiden mts via systemtiden i timebase.h. Avbrottsrutinen fr
+*               systemtiden (TIMER0_COMPA_vect, se isr.c) rknar upp tiden
+*               och jmfr den med soft_timer_next_expiry. Endast nr en
+*               timer lper ut hoppar den vidare till den fullstndiga
+*               avbrottsrutinen SOFT_TIMER_DISPATCH_vect, som anropar
+*               soft_timer_tick. Drmed r Timer 1 och Timer 2 lediga fr
+*               annat, exempelvis PWM.
+*
+*               Aktiva timers lagras i en binr min-heap sorterad efter
+*               tidpunkten d respektive timer lper ut. Start och stopp av
+*               en timer krver drmed O(log n) operationer, medan
+*               avbrottsrutinen endast jmfr frsta timern i heapen med
+*               aktuell tid och sledes bara hanterar timers som faktiskt
+*               lper ut vid aktuellt tick.
+*
+*               Callback-rutiner anropas frn avbrottsrutinen och ska drmed
+*               vara korta. Det gr bra att starta och stoppa timers, ven
+*               den egna, frn en callback-rutin.
+********************************************************************************/
+#ifndef SOFT_TIMER_H_
+#define SOFT_TIMER_H_
+
+/* Inkluderingsdirektiv: */
+#include "timebase.h"
+
+/* Makrodefinitioner: */
+#ifndef SOFT_TIMER_MAX
+#define SOFT_TIMER_MAX 32 /* Maximalt antal samtidigt aktiva timers (max 255). */
+#endif
+
+#define SOFT_TIMER_INACTIVE 0xFF /* Heapindex fr timers som inte r aktiva. */
+#define SOFT_TIMER_DISPATCH_vect __vector_soft_timer_dispatch /* Avbrottsrutin fr utlsning. */
+
+/* Externa variabler: */
+extern volatile uint32_t soft_timer_next_expiry; /* Tidpunkt d frsta timern lper ut. */
+
+/********************************************************************************
+* soft_timer: Strukt fr implementering av mjukvarutimers, som antingen lper
+*             ut en gng (engngstimer) eller periodiskt.
+********************************************************************************/
+struct soft_timer
+{
+   void (*callback)(void* context); /* Anropas nr timern lper ut. */
+   void* context;                   /* Argument till callback-rutinen. */
+   uint32_t expires;                /* Systemtid d timern lper ut nsta gng. */
+   uint32_t period;                 /* Periodtid i millisekunder (0 = engngstimer). */
+   uint8_t index;                   /* Position i heapen (SOFT_TIMER_INACTIVE om inaktiv). */
+};
+
+/********************************************************************************
+* soft_timer_init: Initierar ny mjukvarutimer, som r inaktiv tills den
+*                  startas via soft_timer_start.
+*
+*                  - self    : Pekare till timern som ska initieras.
+*                  - callback: Pekare till rutinen som anropas nr timern
+*                              lper ut.
+*                  - context : Argument som skickas till callback-rutinen.
+********************************************************************************/
+void soft_timer_init(struct soft_timer* self,
+                     void (*callback)(void* context),
+                     void* context);
+
+/********************************************************************************
+* soft_timer_start: Startar angiven timer, som lper ut efter angiven tid och
+*                   drefter, om en periodtid anges, med angivet intervall
+*                   tills timern stoppas. En frdrjning p 0 ms innebr
+*                   nsta millisekund. En timer som redan r aktiv startas
+*                   om.
+*                   Returnerar 0 om timern startades, annars 1 (maximalt
+*                   antal aktiva timers har uppntts).
+*
+*                   - self     : Pekare till timern som ska startas.
+*                   - delay_ms : Tid tills timern lper ut frsta gngen.
+*                   - period_ms: Tid mellan efterfljande utlsningar
+*                                (0 = engngstimer).
+********************************************************************************/
+int soft_timer_start(struct soft_timer* self,
+                     const uint32_t delay_ms,
+                     const uint32_t period_ms);
+
+/********************************************************************************
+* soft_timer_cancel: Stoppar angiven timer. Om timern redan r inaktiv sker
+*                    ingenting.
+*
+*                    - self: Pekare till timern som ska stoppas.
+********************************************************************************/
+void soft_timer_cancel(struct soft_timer* self);
+
+/********************************************************************************
+* soft_timer_active: Indikerar ifall angiven timer r aktiv.
+*
+*                    - self: Pekare till timern.
+********************************************************************************/
+static inline bool soft_timer_active(const struct soft_timer* self)
+{
+   return self->index != SOFT_TIMER_INACTIVE;
+}
+
+/********************************************************************************
+* soft_timer_num_active: Returnerar antalet aktiva timers.
+********************************************************************************/
+uint8_t soft_timer_num_active(void);
+
+/********************************************************************************
+* soft_timer_tick: Anropar callback-rutinerna fr samtliga timers som har
+*                  lpt ut vid aktuell systemtid. Periodiska timers
+*                  schemalggs om utifrn fregende tidpunkt, s att fel
+*                  inte ackumuleras. Anropas frn avbrottsrutinen
+*                  SOFT_TIMER_DISPATCH_vect nr systemtiden har ntt
+*                  soft_timer_next_expiry, och fr endast anropas med
+*                  avbrott inaktiverade.
+********************************************************************************/
+void soft_timer_tick(void);
+
+#endif /* SOFT_TIMER_H_ */
\ No newline at end of file
@@ -0,0 +1,182 @@
+/********************************************************************************
+* tasks.c: Innehller systemets tasks, som krs av schemalggaren i
+*          huvudprogrammet i stllet fr i avbrottsrutiner, se scheduler.h.
+*          Fljande tasks finns:
+*
+*          Task       Prioritet   Aktivering
+*          watchdog   0           Av WDT_vect vid varje Watchdog timeout.
+*          comm       1           Var 10:e millisekund, samt av
+*                                 TIMER2_COMPB_vect nr en Modbus-ram r
+*                                 komplett.
+*          pwm        2           Direkt efter varje krning s lnge pwm1
+*                                 r aktiverad, annars var 10:e
+*                                 millisekund. Vid PWM i hrdvara var
+*                                 sample_ms millisekund.
+*          startup    3           En gng vid start, drefter varje
+*                                 millisekund tills startsekvensen har
+*                                 krt klart.
+*
+*          PWM-genereringen sker i mjukvara via tillstndsmaskinen
+*          pwm_poll, som vid varje krning endast kontrollerar om nsta
+*          flank har ntts och lser av potentiometern var sample_ms
+*          millisekund. Task pwm r drmed krklar s lnge PWM-styrning r
+*          aktiverad, men vriga tasks frdrjs hgst en sdan kontroll.
+*          Nr systemet har lsts inaktiveras PWM-styrningen, varvid
+*          processorn frstts i Idle Mode mellan avbrotten.
+*
+*          Om pwm1 har anslutits till en PWM-generator i hrdvara (se
+*          PWM_HARDWARE i header.h) genereras pulserna av timerkretsen och
+*          task pwm lser d endast av potentiometern och uppdaterar duty
+*          cycle med jmna mellanrum, varvid processorn kan vila ven
+*          medan PWM-styrning r aktiverad.
+*
+*          Task startup kr startsekvensen som en coroutine (se
+*          coroutine.h) via led_vector_blink_sequentially_async, dr
+*          lysdioderna i v1 tnds en efter en. Vntan mellan lysdioderna
+*          blockerar inte processorn, drmed kan vriga tasks, exempelvis
+*          kommandotolken, kras under tiden. pwm1 hlls inaktiverad tills
+*          sekvensen har krt klart, s att lysdioderna inte styrs frn tv
+*          hll samtidigt.
+********************************************************************************/
+#include "header.h"
+
+/* Makrodefinitioner: */
+#define PWM_DISABLED_POLL_MS 10 /* Intervall fr kontroll av teraktiverad PWM-styrning. */
+#define STARTUP_BLINK_MS 100    /* Tid varje lysdiod r tnd under startsekvensen. */
+#define STARTUP_POLL_MS 1       /* Intervall mellan anropen av startsekvensens coroutine. */
+
+/* Statiska variabler: */
+static bool system_lockdown = false;       /* Indikerar ifall systemet har lsts. */
+static struct coroutine startup_coroutine; /* Tillstnd fr startsekvensen. */
+
+/********************************************************************************
+* watchdog_task_run: Krs efter varje Watchdog timeout. Antalet timeouts
+*                    rknas upp i EEPROM-minnet och loggas via seriell
+*                    verfring. Nr maximalt antal timeouts har genomfrts
+*                    lses systemet i ett tillstnd dr lysdioden ansluten
+*                    till pin 8 (PORTB0) blinkar var 50:e millisekund.
+*                    Tryckknappen inaktiveras med avbrott inaktiverade, s
+*                    att PCI-avbrottet inte kan exekveras under tiden.
+*
+*                    - context: Anvnds inte.
+********************************************************************************/
+void watchdog_task_run(void* context)
+{
+   if (system_lockdown) return;
+
+   uint8_t num_timeouts = eeprom_read_byte(TIMEOUT_ADDRESS);
+   log_u8(LOG_NUM_TIMEOUTS, ++num_timeouts);
+
+   if (num_timeouts >= TIMEOUT_MAX)
+   {
+      system_lockdown = true;
+      log_event(LOG_MAX_TIMEOUTS);
+      log_event(LOG_SYSTEM_LOCKDOWN);
+
+      const uint8_t sreg = SREG;
+      asm("CLI");
+      button_clear(&b1);
+      soft_timer_cancel(&debounce_timer);
+      SREG = sreg;
+
+      bam_disable();
+      servo_disable();
+      pwm_disable(&pwm1);
+      blink_start(&lockdown_blink, 50);
+   }
+   else
+   {
+      eeprom_write_byte(TIMEOUT_ADDRESS, num_timeouts);
+   }
+
+   return;
+}
+
+/********************************************************************************
+* system_locked: Indikerar ifall systemet har lsts efter maximalt antal
+*                Watchdog timeouts, se watchdog_task_run. Anvnds av
+*                kommandot leds, s att varken pwm1 eller BAM aktiveras p
+*                nytt efter lsningen.
+********************************************************************************/
+bool system_locked(void)
+{
+   return system_lockdown;
+}
+
+/********************************************************************************
+* comm_task_run: Tolkar frfrgningar via Modbus RTU om Modbus-slaven r
+*                aktiverad, annars kommandon mottagna via seriell terminal.
+*
+*                - context: Anvnds inte.
+********************************************************************************/
+void comm_task_run(void* context)
+{
+   if (modbus_enabled(&modbus1))
+   {
+      modbus_poll(&modbus1);
+   }
+   else
+   {
+      shell_poll(&shell1);
+   }
+
+   return;
+}
+
+/********************************************************************************
+* pwm_task_run: Avancerar PWM-genereringen fr angiven PWM-kontroller via
+*               pwm_poll och aktiverar sedan tasken p nytt. Nr
+*               PWM-kontrollern har inaktiverats krs tasken i stllet p
+*               nytt efter PWM_DISABLED_POLL_MS millisekunder, exempelvis om
+*               den teraktiveras via Modbus. Vid PWM i hrdvara krs tasken
+*               p nytt vid nsta avlsning, dvs. efter sample_ms
+*               millisekunder.
+*
+*               - context: Pekare till PWM-kontrollern.
+********************************************************************************/
+void pwm_task_run(void* context)
+{
+   struct pwm* pwm = (struct pwm*)context;
+   pwm_poll(pwm);
+
+   if (!pwm->enabled)
+   {
+      task_schedule(&pwm_task, PWM_DISABLED_POLL_MS, 0);
+   }
+   else if (pwm->hardware)
+   {
+      task_schedule(&pwm_task, pwm->sample_ms, 0);
+   }
+   else
+   {
+      task_activate(&pwm_task);
+   }
+
+   return;
+}
+
+/********************************************************************************
+* startup_task_run: Kr startsekvensen fr angiven vektor fram till nsta
+*                   vntepunkt och schemalgger sedan tasken p nytt efter
+*                   STARTUP_POLL_MS millisekunder. Nr sekvensen har krt
+*                   klart aktiveras pwm1, frutsatt att systemet inte har
+*                   lsts och att BAM inte har startats via kommandot leds
+*                   under tiden.
+*
+*                   - context: Pekare till vektorn med lysdioderna.
+********************************************************************************/
+void startup_task_run(void* context)
+{
+   struct led_vector* leds = (struct led_vector*)context;
+
+   if (led_vector_blink_sequentially_async(leds, &startup_coroutine, STARTUP_BLINK_MS) == COROUTINE_WAITING)
+   {
+      task_schedule(&startup_task, STARTUP_POLL_MS, 0);
+   }
+   else if (!system_lockdown && !bam_enabled())
+   {
+      pwm_enable(&pwm1);
+   }
+
+   return;
+}
\ No newline at end of file
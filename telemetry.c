@@ -0,0 +1,215 @@
+/********************************************************************************
+* telemetry.c: Innehller funktionsdefinitioner fr verfring av typade
+*              mtvrden i form av COBS-kodade ramar med CRC16.
+********************************************************************************/
+#include "telemetry.h"
+
+/* Makrodefinitioner: */
+#define TELEMETRY_CRC_INIT 0xFFFF /* Startvrde fr kontrollsumman. */
+
+#if TELEMETRY_FRAME_MAX > 253
+#error "TELEMETRY_FRAME_MAX must not exceed 253 bytes (one COBS code byte per frame)!"
+#endif
+
+/********************************************************************************
+* telemetry_reader: Strukt fr sekventiell lsning av en ram frdelad ver
+*                   flera segment.
+********************************************************************************/
+struct telemetry_reader
+{
+   const struct telemetry_segment* segment; /* Pekare till aktuellt segment. */
+   uint16_t offset;                         /* Position i aktuellt segment. */
+};
+
+/* Statiska variabler: */
+static uint32_t (*telemetry_timestamp)(void) = 0; /* Funktion som returnerar aktuell tidsstmpel. */
+static uint8_t telemetry_sequence = 0;            /* Sekvensnummer fr nsta ram. */
+static volatile uint16_t telemetry_num_dropped = 0; /* Antalet kastade ramar. */
+
+/* Statiska funktioner: */
+static void telemetry_drop(void);
+static uint8_t telemetry_read(struct telemetry_reader* self);
+static void telemetry_encode(const struct telemetry_segment* segments,
+                             uint8_t size);
+
+/********************************************************************************
+* telemetry_set_timestamp_source: Anger funktion som returnerar tidsstmpeln
+*                                 i millisekunder fr nya ramar. Om ingen
+*                                 funktion anges stts tidsstmpeln till 0.
+*
+*                                 - timestamp: Pekare till funktionen.
+********************************************************************************/
+void telemetry_set_timestamp_source(uint32_t (*timestamp)(void))
+{
+   telemetry_timestamp = timestamp;
+   return;
+}
+
+/********************************************************************************
+* telemetry_send: Skickar en ram av angiven typ, vars data utgrs av angivna
+*                 segment. Returnerar 0 om ramen placerades i sndbufferten,
+*                 annars felkod 1 om ramen r fr stor eller om plats saknas
+*                 i sndbufferten, vilket rknas i telemetry_dropped.
+*
+*                 Ramhuvud och kontrollsumma lggs till som egna segment
+*                 runt anroparens segment, s att data aldrig kopieras.
+*                 Endast reservationen av plats i sndbufferten sker med
+*                 avbrott inaktiverade, medan kontrollsumman berknas och
+*                 ramen kodas med avbrott aktiverade. Ramen brjar skickas
+*                 frst nr den r komplett.
+*
+*                 - type        : Ramtyp.
+*                 - segments    : Pekare till ramens datasegment.
+*                 - num_segments: Antalet segment (max TELEMETRY_SEGMENTS_MAX).
+********************************************************************************/
+int telemetry_send(const enum telemetry_type type,
+                   const struct telemetry_segment* segments,
+                   const uint8_t num_segments)
+{
+   struct telemetry_segment frame[TELEMETRY_SEGMENTS_MAX + 2];
+   uint8_t header[TELEMETRY_HEADER_SIZE];
+   uint8_t crc_bytes[TELEMETRY_CRC_SIZE];
+   const uint32_t timestamp = telemetry_timestamp ? telemetry_timestamp() : 0;
+   uint16_t size = TELEMETRY_HEADER_SIZE + TELEMETRY_CRC_SIZE;
+   uint16_t crc = TELEMETRY_CRC_INIT;
+
+   header[0] = (uint8_t)type;
+   header[1] = telemetry_sequence++;
+   header[2] = (uint8_t)timestamp;
+   header[3] = (uint8_t)(timestamp >> 8);
+   header[4] = (uint8_t)(timestamp >> 16);
+   header[5] = (uint8_t)(timestamp >> 24);
+
+   if (num_segments > TELEMETRY_SEGMENTS_MAX)
+   {
+      telemetry_drop();
+      return 1;
+   }
+
+   frame[0].data = header;
+   frame[0].size = sizeof(header);
+
+   for (uint8_t i = 0; i < num_segments; ++i)
+   {
+      frame[i + 1] = segments[i];
+      size += segments[i].size;
+   }
+
+   if (size > TELEMETRY_FRAME_MAX)
+   {
+      telemetry_drop();
+      return 1;
+   }
+
+   for (uint8_t i = 0; i <= num_segments; ++i)
+   {
+      const uint8_t* data = (const uint8_t*)frame[i].data;
+
+      for (uint16_t j = 0; j < frame[i].size; ++j)
+      {
+         crc = _crc_xmodem_update(crc, data[j]);
+      }
+   }
+
+   crc_bytes[0] = (uint8_t)crc;
+   crc_bytes[1] = (uint8_t)(crc >> 8);
+   frame[num_segments + 1].data = crc_bytes;
+   frame[num_segments + 1].size = sizeof(crc_bytes);
+
+   if (!serial_tx_reserve((size_t)(size + 3)))
+   {
+      telemetry_drop();
+      return 1;
+   }
+
+   telemetry_encode(frame, (uint8_t)size);
+   serial_tx_commit();
+   return 0;
+}
+
+/********************************************************************************
+* telemetry_dropped: Returnerar antalet ramar som har kastats. Rknaren lses
+*                    med avbrott inaktiverade, eftersom den r 16 bitar.
+********************************************************************************/
+uint16_t telemetry_dropped(void)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   const uint16_t num_dropped = telemetry_num_dropped;
+   SREG = sreg;
+   return num_dropped;
+}
+
+/********************************************************************************
+* telemetry_drop: Rknar upp antalet kastade ramar med avbrott inaktiverade.
+********************************************************************************/
+static void telemetry_drop(void)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   telemetry_num_dropped++;
+   SREG = sreg;
+   return;
+}
+
+/********************************************************************************
+* telemetry_read: Returnerar nsta byte i ramen och stegar vidare. Tomma
+*                 segment hoppas ver.
+*
+*                 - self: Pekare till lsaren.
+********************************************************************************/
+static uint8_t telemetry_read(struct telemetry_reader* self)
+{
+   while (self->offset >= self->segment->size)
+   {
+      self->segment++;
+      self->offset = 0;
+   }
+   return ((const uint8_t*)self->segment->data)[self->offset++];
+}
+
+/********************************************************************************
+* telemetry_encode: COBS-kodar angiven ram direkt till reserverade platser i
+*                   sndbufferten, omgiven av en nolla p vardera sida. Varje
+*                   block inleds med en kodbyte som anger avstndet till
+*                   nsta nolla i ramen (eller till ramens slut), vilket
+*                   krver att blocket frst sks igenom med en separat
+*                   lsare. Eftersom ramen r hgst 253 byte
+*                   blir kodad ram alltid exakt en byte strre n ramen.
+*
+*                   - segments: Pekare till ramens segment.
+*                   - size    : Ramens totala storlek i byte.
+********************************************************************************/
+static void telemetry_encode(const struct telemetry_segment* segments,
+                             uint8_t size)
+{
+   struct telemetry_reader reader = { segments, 0 };
+   serial_tx_put(0);
+
+   while (1)
+   {
+      struct telemetry_reader lookahead = reader;
+      uint8_t length = 0;
+
+      while (length < size && telemetry_read(&lookahead) != 0)
+      {
+         length++;
+      }
+
+      serial_tx_put(length + 1);
+
+      for (uint8_t i = 0; i < length; ++i)
+      {
+         serial_tx_put(telemetry_read(&reader));
+      }
+
+      size -= length;
+      if (size == 0) break;
+
+      telemetry_read(&reader);
+      size--;
+   }
+
+   serial_tx_put(0);
+   return;
+}
\ No newline at end of file
@@ -0,0 +1,174 @@
+/********************************************************************************
+* telemetry.h: Innehller funktionalitet fr verfring av typade mtvrden
+*              via seriell verfring i form av binra ramar, vilket erstter
+*              tolkning av fri textutskrift p mottagarsidan.
+*
+*              Varje ram bestr av fljande flt innan kodning:
+*
+*              Flt          Storlek   Innehll
+*              Typ           1 byte    Ramtyp, se enum telemetry_type.
+*              Sekvens       1 byte    Rknas upp fr varje ram, ven kastade
+*                                      ramar, s att frlorade ramar mrks.
+*              Tidsstmpel   4 byte    Millisekunder (little endian).
+*              Data          0 - N     Ramtypens data (little endian).
+*              CRC           2 byte    CRC-16/CCITT-FALSE (polynom 0x1021,
+*                                      startvrde 0xFFFF) ver samtliga
+*                                      fregende flt (little endian).
+*
+*              Ramen kodas med COBS (Consistent Overhead Byte Stuffing), vilket
+*              tar bort samtliga nollor ur ramen p bekostnad av en extra byte,
+*              och omges av en nolla p vardera sida. Mottagaren kan drmed
+*              alltid synkronisera om vid nsta nolla efter en frlorad eller
+*              skadad ram, ven om annan text skickas mellan ramarna.
+*              Avkodaren tools/telemetry_decode.py kontrollerar CRC samt
+*              sekvensnummer och rapporterar skadade och frlorade ramar.
+*
+*              Data fr respektive ramtyp:
+*
+*              TELEMETRY_SAMPLES    kanal (1), antal (1), antal x 16 bitar.
+*              TELEMETRY_COUNTERS   frsta ID (1), antal (1), antal x 32 bitar.
+*              TELEMETRY_EVENT      hndelse (1), 0 - N byte godtycklig data.
+*
+*              Ramar kodas direkt frn anroparens buffertar till sndbufferten
+*              utan mellanlagring. Plats fr hela ramen reserveras frst med
+*              avbrott inaktiverade, eller inte alls om plats saknas, varefter
+*              ramen kodas med avbrott aktiverade, se serial_tx_reserve.
+*              Loggposter frn avbrottsrutiner hamnar drmed aldrig mitt i en
+*              ram, och avbrott frdrjs inte under kodningen. Funktionerna
+*              ska anropas frn huvudprogrammet, inte frn avbrottsrutiner.
+********************************************************************************/
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "serial.h"
+#include <util/crc16.h>
+
+/* Makrodefinitioner: */
+#define TELEMETRY_HEADER_SIZE 6  /* Antal byte fr typ, sekvens och tidsstmpel. */
+#define TELEMETRY_CRC_SIZE 2     /* Antal byte fr kontrollsumman. */
+#define TELEMETRY_SEGMENTS_MAX 4 /* Maximalt antal datasegment per ram. */
+
+/* Maximal ramstorlek innan kodning, s att kodad ram med omgivande nollor
+   (ramstorlek + 3 byte) alltid ryms i en tom sndbuffert. */
+#define TELEMETRY_FRAME_MAX (SERIAL_TX_BUFFER_SIZE - 4)
+
+/* Maximalt antal byte data per ram. */
+#define TELEMETRY_PAYLOAD_MAX (TELEMETRY_FRAME_MAX - TELEMETRY_HEADER_SIZE - TELEMETRY_CRC_SIZE)
+
+/********************************************************************************
+* telemetry_type: Enumeration fr ramtyper.
+********************************************************************************/
+enum telemetry_type
+{
+   TELEMETRY_SAMPLES = 1,  /* Serie av 16-bitars mtvrden frn en kanal. */
+   TELEMETRY_COUNTERS = 2, /* Serie av 32-bitars rknare med lpande ID. */
+   TELEMETRY_EVENT = 3     /* Hndelse med godtycklig data. */
+};
+
+/********************************************************************************
+* telemetry_segment: Strukt fr ett datasegment i en ram, vilket pekar direkt
+*                    p anroparens data. Ramens data utgrs av samtliga
+*                    segment i ordning.
+********************************************************************************/
+struct telemetry_segment
+{
+   const void* data; /* Pekare till segmentets data. */
+   uint16_t size;    /* Segmentets storlek i byte. */
+};
+
+/********************************************************************************
+* telemetry_set_timestamp_source: Anger funktion som returnerar tidsstmpeln
+*                                 i millisekunder fr nya ramar. Om ingen
+*                                 funktion anges stts tidsstmpeln till 0.
+*
+*                                 - timestamp: Pekare till funktionen.
+********************************************************************************/
+void telemetry_set_timestamp_source(uint32_t (*timestamp)(void));
+
+/********************************************************************************
+* telemetry_send: Skickar en ram av angiven typ, vars data utgrs av angivna
+*                 segment. Returnerar 0 om ramen placerades i sndbufferten,
+*                 annars felkod 1 om ramen r fr stor eller om plats saknas
+*                 i sndbufferten, vilket rknas i telemetry_dropped.
+*
+*                 - type        : Ramtyp.
+*                 - segments    : Pekare till ramens datasegment.
+*                 - num_segments: Antalet segment (max TELEMETRY_SEGMENTS_MAX).
+********************************************************************************/
+int telemetry_send(const enum telemetry_type type,
+                   const struct telemetry_segment* segments,
+                   const uint8_t num_segments);
+
+/********************************************************************************
+* telemetry_dropped: Returnerar antalet ramar som har kastats.
+********************************************************************************/
+uint16_t telemetry_dropped(void);
+
+/********************************************************************************
+* telemetry_send_samples: Skickar en serie 16-bitars mtvrden frn angiven
+*                         kanal direkt frn angiven array. Returnerar 0 vid
+*                         lyckad verfring, annars felkod 1.
+*
+*                         - channel: Kanalens nummer.
+*                         - samples: Pekare till mtvrdena.
+*                         - count  : Antalet mtvrden.
+********************************************************************************/
+static inline int telemetry_send_samples(const uint8_t channel,
+                                         const uint16_t* samples,
+                                         const uint8_t count)
+{
+   const uint8_t info[2] = { channel, count };
+   const struct telemetry_segment segments[2] =
+   {
+      { info, sizeof(info) },
+      { samples, count * sizeof(uint16_t) }
+   };
+   return telemetry_send(TELEMETRY_SAMPLES, segments, 2);
+}
+
+/********************************************************************************
+* telemetry_send_counters: Skickar en serie 32-bitars rknare direkt frn
+*                          angiven array, dr rknarna tilldelas lpande ID
+*                          med start p angivet ID. Returnerar 0 vid lyckad
+*                          verfring, annars felkod 1.
+*
+*                          - first_id: Frsta rknarens ID.
+*                          - counters: Pekare till rknarna.
+*                          - count   : Antalet rknare.
+********************************************************************************/
+static inline int telemetry_send_counters(const uint8_t first_id,
+                                          const uint32_t* counters,
+                                          const uint8_t count)
+{
+   const uint8_t info[2] = { first_id, count };
+   const struct telemetry_segment segments[2] =
+   {
+      { info, sizeof(info) },
+      { counters, count * sizeof(uint32_t) }
+   };
+   return telemetry_send(TELEMETRY_COUNTERS, segments, 2);
+}
+
+/********************************************************************************
+* telemetry_send_event: Skickar en hndelse med angiven data. Returnerar 0
+*                       vid lyckad verfring, annars felkod 1.
+*
+*                       - event: Hndelsens nummer.
+*                       - data : Pekare till data (0 om data saknas).
+*                       - size : Antalet byte data.
+********************************************************************************/
+static inline int telemetry_send_event(const uint8_t event,
+                                       const void* data,
+                                       const uint8_t size)
+{
+   const struct telemetry_segment segments[2] =
+   {
+      { &event, sizeof(event) },
+      { data, size }
+   };
+   return telemetry_send(TELEMETRY_EVENT, segments, 2);
+}
+
+#endif /* TELEMETRY_H_ */
\ No newline at end of file
@@ -0,0 +1,72 @@
+/********************************************************************************
+* timebase.c: Innehller funktionsdefinitioner fr systemtiden.
+********************************************************************************/
+#include "timebase.h"
+
+/* Globala variabler: */
+volatile uint32_t timebase_ms = 0; /* Antalet passerade millisekunder. */
+
+/* Statiska variabler: */
+static uint16_t timebase_us_per_step = 1024; /* Mikrosekunder per steg i TCNT0 (8 fraktionella bitar). */
+
+/********************************************************************************
+* timebase_init: Nollstller systemtiden och berknar antalet mikrosekunder
+*                per steg i rknarregistret TCNT0. I CTC Mode rknar Timer 0
+*                OCR0A + 1 steg per millisekund, annars 256 steg. Kvoten
+*                lagras med tta fraktionella bitar, s att omrkningen i
+*                time_us endast krver en multiplikation och ett skift.
+********************************************************************************/
+void timebase_init(void)
+{
+   const uint16_t steps = (TCCR0A & (1 << WGM01)) ? OCR0A + 1 : 256;
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   timebase_ms = 0;
+   timebase_us_per_step = (uint16_t)((1000UL * 256 + steps / 2) / steps);
+   SREG = sreg;
+   return;
+}
+
+/********************************************************************************
+* time_us_isr: Returnerar antalet passerade mikrosekunder sedan start.
+*              Rknarregistret lses fre flaggan OCF0A. Om flaggan r satt
+*              har Timer 0 slagit runt utan att millisekunden har rknats
+*              upp, varvid rknarregistret lses om och en millisekund
+*              lggs till.
+********************************************************************************/
+uint32_t time_us_isr(void)
+{
+   uint32_t ms = timebase_ms;
+   uint8_t steps = TCNT0;
+
+   if (TIFR0 & (1 << OCF0A))
+   {
+      steps = TCNT0;
+      ms++;
+   }
+
+   return ms * 1000 + (uint16_t)(((uint32_t)steps * timebase_us_per_step) >> 8);
+}
+
+/********************************************************************************
+* time_us: Returnerar antalet passerade mikrosekunder sedan start. Avbrott
+*          inaktiveras under avlsningen, s att millisekunderna och
+*          rknarregistret lses vid samma tillflle.
+********************************************************************************/
+uint32_t time_us(void)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   const uint32_t us = time_us_isr();
+   SREG = sreg;
+   return us;
+}
+
+/********************************************************************************
+* time_ms16: Returnerar de 16 minst signifikanta bitarna av antalet passerade
+*            millisekunder.
+********************************************************************************/
+uint16_t time_ms16(void)
+{
+   return (uint16_t)time_ms();
+}
\ No newline at end of file
@@ -0,0 +1,155 @@
+/********************************************************************************
+* timebase.h: Innehller en monoton systemtid i millisekunder samt
+*             mikrosekunder, som drivs av Timer 0 i CTC Mode med ett avbrott
+*             varje millisekund (timer t0, avbrottsvektor TIMER0_COMPA_vect).
+*
+*             Millisekunderna rknas upp i avbrottsrutinen, antingen via
+*             anrop av timebase_tick eller, som i isr.c, direkt i assembler
+*             fr minimal exekveringstid. Mikrosekunderna berknas genom
+*             att antalet millisekunder kombineras med aktuellt vrde i
+*             rknarregistret TCNT0, vilket med prescaler 64 ger en
+*             upplsning p 4 us.
+*
+*             Tiderna rknas modulo 2^32 och slr drmed runt efter cirka
+*             49.7 dygn (millisekunder) respektive 71.6 minuter
+*             (mikrosekunder). Tidpunkter ska drfr alltid jmfras via
+*             funktionerna time_before, time_after samt time_since_*, som
+*             hanterar overflow korrekt s lnge differensen understiger
+*             2^31.
+*
+*             Funktionerna time_ms samt time_us kan anropas verallt. I
+*             avbrottsrutiner (dr avbrott redan r inaktiverade) kan
+*             time_ms_isr samt time_us_isr anvndas fr att tidsstmpla
+*             hndelser utan att statusregistret behver sparas undan.
+********************************************************************************/
+#ifndef TIMEBASE_H_
+#define TIMEBASE_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+
+/* Externa variabler: */
+extern volatile uint32_t timebase_ms; /* Antalet passerade millisekunder. */
+
+/********************************************************************************
+* timebase_init: Nollstller systemtiden och berknar antalet mikrosekunder
+*                per steg i rknarregistret TCNT0 utifrn aktuellt
+*                jmfrelsevrde OCR0A. Ska anropas efter att Timer 0 har
+*                konfigurerats fr avbrott varje millisekund.
+********************************************************************************/
+void timebase_init(void);
+
+/********************************************************************************
+* timebase_tick: Rknar upp systemtiden en millisekund. Ska anropas frn
+*                avbrottsrutinen fr Timer 0 varje millisekund.
+********************************************************************************/
+static inline void timebase_tick(void)
+{
+   timebase_ms++;
+   return;
+}
+
+/********************************************************************************
+* time_ms_isr: Returnerar antalet passerade millisekunder sedan start. Fr
+*              endast anropas nr avbrott r inaktiverade, exempelvis i
+*              avbrottsrutiner.
+********************************************************************************/
+static inline uint32_t time_ms_isr(void)
+{
+   return timebase_ms;
+}
+
+/********************************************************************************
+* time_us_isr: Returnerar antalet passerade mikrosekunder sedan start. Om
+*              Timer 0 har ntt jmfrelsevrdet men avbrottsrutinen nnu
+*              inte har exekverats rknas den pbrjade millisekunden med.
+*              Fr endast anropas nr avbrott r inaktiverade, exempelvis i
+*              avbrottsrutiner.
+********************************************************************************/
+uint32_t time_us_isr(void);
+
+/********************************************************************************
+* time_ms: Returnerar antalet passerade millisekunder sedan start. Avbrott
+*          inaktiveras under avlsningen, s att samtliga fyra byte lses
+*          frn samma millisekund.
+********************************************************************************/
+static inline uint32_t time_ms(void)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   const uint32_t ms = timebase_ms;
+   SREG = sreg;
+   return ms;
+}
+
+/********************************************************************************
+* time_us: Returnerar antalet passerade mikrosekunder sedan start med en
+*          upplsning p ett steg i Timer 0 (4 us med prescaler 64).
+********************************************************************************/
+uint32_t time_us(void);
+
+/********************************************************************************
+* time_ms16: Returnerar de 16 minst signifikanta bitarna av antalet passerade
+*            millisekunder, exempelvis fr tidsstmplar i loggposter.
+********************************************************************************/
+uint16_t time_ms16(void);
+
+/********************************************************************************
+* time_before: Indikerar ifall tidpunkt time1 infaller fre tidpunkt time2,
+*              ven om tiden har slagit runt dremellan.
+*
+*              - time1: Frsta tidpunkten.
+*              - time2: Andra tidpunkten.
+********************************************************************************/
+static inline bool time_before(const uint32_t time1,
+                               const uint32_t time2)
+{
+   return (int32_t)(time1 - time2) < 0;
+}
+
+/********************************************************************************
+* time_after: Indikerar ifall tidpunkt time1 infaller efter tidpunkt time2,
+*             ven om tiden har slagit runt dremellan.
+*
+*             - time1: Frsta tidpunkten.
+*             - time2: Andra tidpunkten.
+********************************************************************************/
+static inline bool time_after(const uint32_t time1,
+                              const uint32_t time2)
+{
+   return (int32_t)(time1 - time2) > 0;
+}
+
+/********************************************************************************
+* time_since_ms: Returnerar antalet millisekunder som har passerat sedan
+*                angiven tidpunkt.
+*
+*                - start_ms: Tidpunkten i millisekunder (frn time_ms).
+********************************************************************************/
+static inline uint32_t time_since_ms(const uint32_t start_ms)
+{
+   return time_ms() - start_ms;
+}
+
+/********************************************************************************
+* time_since_us: Returnerar antalet mikrosekunder som har passerat sedan
+*                angiven tidpunkt.
+*
+*                - start_us: Tidpunkten i mikrosekunder (frn time_us).
+********************************************************************************/
+static inline uint32_t time_since_us(const uint32_t start_us)
+{
+   return time_us() - start_us;
+}
+
+/********************************************************************************
+* time_reached_ms: Indikerar ifall angiven tidpunkt har ntts.
+*
+*                  - deadline_ms: Tidpunkten i millisekunder.
+********************************************************************************/
+static inline bool time_reached_ms(const uint32_t deadline_ms)
+{
+   return !time_before(time_ms(), deadline_ms);
+}
+
+#endif /* TIMEBASE_H_ */
\ No newline at end of file
@@ -4,12 +4,37 @@
 #include "timer.h"
 
 /* Makrodefinitioner: */
-#define TIME_BETWEEN_INTERRUPTS_MS 0.128 /* Tid mellan varje timergenererat avbrott. */
+#define TIMER_NUM_CLOCKS_0 5    /* Antal prescalers fr Timer 0 samt Timer 1. */
+#define TIMER_NUM_CLOCKS_2 7    /* Antal prescalers fr Timer 2. */
+#define TIMER_TOP_MAX_8 256UL   /* Maximalt antal timersteg per avbrott fr 8-bitars timers. */
+#define TIMER_TOP_MAX_16 65536UL /* Maximalt antal timersteg per avbrott fr Timer 1. */
+#define TIMER_CYCLES_MIN 256    /* Minsta antal klockcykler mellan tv avbrott. */
+#define TIMER_SEARCH_MAX 256    /* Maximalt antal prvade avbrott per period och prescaler. */
+
+/* Prescalers fr bitar CSn2:0 = 1, 2, ... (lagras i programminnet): */
+static const uint16_t timer_prescalers_0[TIMER_NUM_CLOCKS_0] PROGMEM =
+{
+   1, 8, 64, 256, 1024
+};
+
+static const uint16_t timer_prescalers_2[TIMER_NUM_CLOCKS_2] PROGMEM =
+{
+   1, 8, 32, 64, 128, 256, 1024
+};
+
+/* Utpinnar OCnA samt OCnB per timerkrets (lagras i programminnet): */
+static const uint8_t timer_output_pins[3][2] PROGMEM =
+{
+   { D6, D5 }, { B1, B2 }, { B3, D3 }
+};
 
 /* Statiska funktioner: */
 static void timer_init_circuit(struct timer* self);
 static void timer_disable_circuit(struct timer* self);
-static inline uint32_t timer_get_max_count(const double time_ms);
+static void timer_select_clock(struct timer* self,
+                               const double time_ms);
+static int timer_select_output_clock(struct timer* self,
+                                     const double time_ms);
 
 /********************************************************************************
 * timer_init: Initierar ny timerkrets med angiven tid mtt i millisekunder.
@@ -21,17 +46,85 @@ static inline uint32_t timer_get_max_count(const double time_ms);
 *             - timer_sel: Val av timerkrets.
 *             - time_ms  : Tiden timern ska sttas p mtt i millisekunder.
 ********************************************************************************/
-void timer_init(struct timer* self, 
-                const enum timer_sel timer_sel, 
+void timer_init(struct timer* self,
+                const enum timer_sel timer_sel,
                 const double time_ms)
 {
    self->counter = 0;
-   self->max_count = timer_get_max_count(time_ms);
    self->timer_sel = timer_sel;
+   timer_select_clock(self, time_ms);
    timer_init_circuit(self);
    return;
 }
 
+/********************************************************************************
+* timer_init_output: Initierar ny timerkrets fr toggling av angiven utpinne
+*                    i hrdvara. Bitarna COMnx1:0 stts till 01 (toggla vid
+*                    compare match). Fr utpinne OCnB stts OCRnB till 0,
+*                    drmed togglas den en gng per period, precis som OCnA.
+*
+*                    - self     : Pekare till timern som ska initieras.
+*                    - timer_sel: Val av timerkrets.
+*                    - time_ms  : Tid mellan tv toggningar i millisekunder.
+*                    - channel  : Utpinnen som ska togglas.
+********************************************************************************/
+int timer_init_output(struct timer* self,
+                      const enum timer_sel timer_sel,
+                      const double time_ms,
+                      const enum timer_channel channel)
+{
+   if (timer_sel == TIMER_SEL_NONE || (timer_sel == TIMER_SEL_0 && channel == TIMER_CHANNEL_B))
+   {
+      return 1;
+   }
+
+   self->counter = 0;
+   self->timer_sel = timer_sel;
+   if (timer_select_output_clock(self, time_ms)) return 1;
+   timer_init_circuit(self);
+
+   const uint8_t com_bit = channel == TIMER_CHANNEL_A ? COM0A0 : COM0B0;
+   const uint8_t pin = timer_output_pin(timer_sel, channel);
+
+   if (timer_sel == TIMER_SEL_0)
+   {
+      TCCR0A |= (1 << com_bit);
+   }
+   else if (timer_sel == TIMER_SEL_1)
+   {
+      if (channel == TIMER_CHANNEL_B) OCR1B = 0;
+      TCCR1A |= (1 << com_bit);
+   }
+   else
+   {
+      if (channel == TIMER_CHANNEL_B) OCR2B = 0;
+      TCCR2A |= (1 << com_bit);
+   }
+
+   if (pin < 8)
+   {
+      DDRD |= (1 << pin);
+   }
+   else
+   {
+      DDRB |= (1 << (pin - 8));
+   }
+
+   return 0;
+}
+
+/********************************************************************************
+* timer_output_pin: Returnerar pin-numret fr angiven timerkrets utpinne.
+*
+*                   - timer_sel: Timerkretsen.
+*                   - channel  : Utpinnen.
+********************************************************************************/
+uint8_t timer_output_pin(const enum timer_sel timer_sel,
+                         const enum timer_channel channel)
+{
+   return pgm_read_byte(&timer_output_pins[timer_sel][channel]);
+}
+
 /********************************************************************************
 * timer_clear: Genomfr total nollstllning av angiven timerkrets.
 *
@@ -42,6 +135,10 @@ void timer_clear(struct timer* self)
    timer_disable_circuit(self);
    self->counter = 0;
    self->max_count = 0;
+   self->width = TIMER_WIDTH_0;
+   self->top = 0;
+   self->clock_select = 0;
+   self->time_ms = 0;
    self->timsk = 0;
    self->timsk_bit = 0;
    self->timer_sel = TIMER_SEL_NONE;
@@ -50,8 +147,8 @@ void timer_clear(struct timer* self)
 
 /********************************************************************************
 * timer_toggle_interrupt: Togglar aktivering av timergenererat avbrott p
-*                         angiven timer. Om avbrott r aktiverat vid anrop sker 
-*                         inaktivering. P samma stt gller att om avbrott r 
+*                         angiven timer. Om avbrott r aktiverat vid anrop sker
+*                         inaktivering. P samma stt gller att om avbrott r
 *                         inaktiverat vid anrop s sker aktivering.
 *
 *                         - self: Pekare till timern som aktivering av
@@ -73,21 +170,26 @@ void timer_toggle_interrupt(struct timer* self)
 /********************************************************************************
 * timer_elapsed: Indikerar ifall angiven timer har lpt ut genom att returnera
 *                true eller false. Ifall timern har lpt ut nollstlls rknaren
-*                infr nsta upprkning.
+*                infr nsta upprkning. Avbrott inaktiveras under tiden, s
+*                att en upprkning mellan jmfrelsen och nollstllningen
+*                inte gr frlorad.
 *
 *                - self: Pekare till timern som ska kontrolleras.
 ********************************************************************************/
 bool timer_elapsed(struct timer* self)
 {
+   const uint8_t sreg = SREG;
+   bool elapsed = false;
+   asm("CLI");
+
    if (self->counter >= self->max_count)
    {
-     self->counter = 0;
-     return true;
-   }
-   else
-   {
-      return false;
+      self->counter = 0;
+      elapsed = true;
    }
+
+   SREG = sreg;
+   return elapsed;
 }
 
 /********************************************************************************
@@ -104,24 +206,71 @@ void timer_reset(struct timer* self)
 
 /********************************************************************************
 * timer_set_new_time: Stter ny tid p angiven timerkrets mtt i millisekunder.
-* 
+*                     Prescaler samt jmfrelsevrde vljs om, varefter
+*                     timerkretsen startas om frn noll. Ett aktiverat avbrott
+*                     frblir aktiverat.
+*
 *                     - self   : Pekare till timern vars tid ska uppdateras.
 *                     - time_ms: Tiden timern ska sttas p i millisekunder.
 ********************************************************************************/
-void timer_set_new_time(struct timer* self, 
+void timer_set_new_time(struct timer* self,
                         const double time_ms)
 {
-   self->max_count = timer_get_max_count(time_ms);
+   const bool interrupt_enabled = timer_interrupt_enabled(self);
+   timer_select_clock(self, time_ms);
+   timer_init_circuit(self);
+   self->counter = 0;
+
+   if (interrupt_enabled)
+   {
+      timer_enable_interrupt(self);
+   }
    return;
 }
 
 /********************************************************************************
-* timer_init_circuit: Initierar angiven timerkrets. Timer 0 samt Timer 2
-*                     initieras i Normal Mode, medan Timer 1 initieras i
-*                     CTC Mode med upprkning till 256. Vid aktiverat avbrott
-*                     p godtycklig initierad timer sker timergenererat avbrott 
-*                     var 0.128:e millisekund. Adresserna till motsvarande
+* timer_get_prescaler: Returnerar vald prescaler fr angiven timer.
+*
+*                      - self: Pekare till timern.
+********************************************************************************/
+uint16_t timer_get_prescaler(const struct timer* self)
+{
+   return timer_prescaler(self->timer_sel, self->clock_select);
+}
+
+/********************************************************************************
+* timer_get_time_ms: Returnerar uppndd tid i millisekunder, berknad som
+*                    antalet avbrott per period multiplicerat med tiden
+*                    mellan varje avbrott.
+*
+*                    - self: Pekare till timern.
+********************************************************************************/
+double timer_get_time_ms(const struct timer* self)
+{
+   return (double)self->max_count * (self->top + 1UL) * timer_get_prescaler(self) * 1000.0 / (F_CPU);
+}
+
+/********************************************************************************
+* timer_get_error_ppm: Returnerar uppndd tids avvikelse frn nskad tid
+*                      mtt i miljondelar, avrundat till nrmaste heltal.
+*
+*                      - self: Pekare till timern.
+********************************************************************************/
+int32_t timer_get_error_ppm(const struct timer* self)
+{
+   if (self->time_ms <= 0) return 0;
+   const double error = (timer_get_time_ms(self) - self->time_ms) / self->time_ms * 1e6;
+   return (int32_t)(error < 0 ? error - 0.5 : error + 0.5);
+}
+
+/********************************************************************************
+* timer_init_circuit: Initierar angiven timerkrets i CTC Mode med vald
+*                     prescaler samt jmfrelsevrde OCRnA = top, s att
+*                     timergenererat avbrott vid aktivering sker var
+*                     (top + 1):e timersteg. Adresserna till motsvarande
 *                     maskregister som bit fr aktivering av avbrott sparas.
+*                     vriga bitar i maskregistret lmnas orrda, s att
+*                     exempelvis Compare Match B kan anvndas av annan kod.
 *
 *                     - self     : Pekare till timerkretsen som ska initieras.
 ********************************************************************************/
@@ -129,22 +278,30 @@ static void timer_init_circuit(struct timer* self)
 {
    if (self->timer_sel == TIMER_SEL_0)
    {
-      TCCR0B = (1 << CS01);
+      TCCR0A = (1 << WGM01);
+      OCR0A = (uint8_t)self->top;
+      TCNT0 = 0;
+      TCCR0B = self->clock_select;
       self->timsk = &TIMSK0;
-      self->timsk_bit = TOIE0;
+      self->timsk_bit = OCIE0A;
    }
    else if (self->timer_sel == TIMER_SEL_1)
    {
-      TCCR1B = (1 << CS11) | (1 << WGM12);
-      OCR1A = 256;
+      TCCR1A = 0x00;
+      OCR1A = self->top;
+      TCNT1 = 0;
+      TCCR1B = (1 << WGM12) | self->clock_select;
       self->timsk = &TIMSK1;
       self->timsk_bit = OCIE1A;
    }
    else if (self->timer_sel == TIMER_SEL_2)
    {
-      TCCR2B = (1 << CS21);
+      TCCR2A = (1 << WGM21);
+      OCR2A = (uint8_t)self->top;
+      TCNT2 = 0;
+      TCCR2B = self->clock_select;
       self->timsk = &TIMSK2;
-      self->timsk_bit = TOIE2;
+      self->timsk_bit = OCIE2A;
    }
 
    asm("SEI");
@@ -153,38 +310,239 @@ static void timer_init_circuit(struct timer* self)
 
 /********************************************************************************
 * timer_disable_circuit: Inaktiverar angiven timerkrets s att varken upprkning
-*                        eller avbrott kan ske. 
+*                        eller avbrott kan ske.
 *
-*                        - self: Pekare till timern som ska inaktiveras.  
+*                        - self: Pekare till timern som ska inaktiveras. 
 ********************************************************************************/
 static void timer_disable_circuit(struct timer* self)
 {
    if (self->timer_sel == TIMER_SEL_0)
    {
       TCCR0B = 0x00;
-      TIMSK0 = 0x00;
+      TCCR0A = 0x00;
+      TIMSK0 &= ~(1 << OCIE0A);
+      OCR0A = 0x00;
    }
    else if (self->timer_sel == TIMER_SEL_1)
    {
       TCCR1B = 0x00;
-      TIMSK1 = 0x00;
+      TCCR1A = 0x00;
+      TIMSK1 &= ~(1 << OCIE1A);
       OCR1A = 0x00;
    }
    else if (self->timer_sel == TIMER_SEL_2)
    {
       TCCR2B = 0x00;
-      TIMSK2 = 0x00;
+      TCCR2A = 0x00;
+      TIMSK2 &= ~(1 << OCIE2A);
+      OCR2A = 0x00;
+   }
+   return;
+}
+
+/********************************************************************************
+* timer_select_clock: Vljer prescaler, antal timersteg per avbrott
+*                     (top + 1) samt antal avbrott per period (max_count)
+*                     fr angiven tid. Fr varje prescaler prvas antalet
+*                     avbrott frn det minsta mjliga och uppt, tills
+*                     avvikelsen ryms inom TIMER_ERROR_MAX_PPM. Bland
+*                     godtagna kombinationer vljs den med minst antal
+*                     avbrott, dr lgst avvikelse avgr vid lika antal.
+*                     Saknas godtagen kombination vljs den med lgst
+*                     avvikelse. Drefter vljs rknarens bredd fr
+*                     timer_tick via timer_select_width.
+*
+*                     Avbrott ttare n var TIMER_CYCLES_MIN:e klockcykel
+*                     tillts inte, drmed ger mycket korta tider den
+*                     kortaste tilltna perioden. Tider som verstiger
+*                     65 535 maximala perioder ger p samma stt den
+*                     lngsta mjliga tiden.
+*
+*                     - self   : Pekare till timern.
+*                     - time_ms: nskad tid i millisekunder.
+********************************************************************************/
+static void timer_select_clock(struct timer* self,
+                               const double time_ms)
+{
+   const uint8_t num_clocks = self->timer_sel == TIMER_SEL_2 ? TIMER_NUM_CLOCKS_2 : TIMER_NUM_CLOCKS_0;
+   const uint32_t top_max = self->timer_sel == TIMER_SEL_1 ? TIMER_TOP_MAX_16 : TIMER_TOP_MAX_8;
+   const double cycles = time_ms * ((F_CPU) / 1000.0);
+   const double tolerance = cycles * (TIMER_ERROR_MAX_PPM / 1e6);
+   double best_error = cycles + 1.0;
+   uint8_t last_clock = 1;
+
+   self->time_ms = time_ms;
+   self->clock_select = 0;
+   self->top = 0;
+   self->max_count = 0;
+
+   for (uint8_t clock_select = 1; clock_select <= num_clocks; ++clock_select)
+   {
+      const uint16_t prescaler = timer_prescaler(self->timer_sel, clock_select);
+      if (self->timer_sel == TIMER_SEL_0 && prescaler > TIMER0_PRESCALER_MAX) break;
+      last_clock = clock_select;
+      if (cycles / prescaler > (double)top_max * UINT16_MAX) continue;
+
+      const uint32_t ticks = (uint32_t)(cycles / prescaler + 0.5);
+      uint32_t count = (ticks + top_max - 1) / top_max;
+      if (count == 0) count = 1;
+
+      for (const uint32_t last = count + TIMER_SEARCH_MAX; count < last && count <= UINT16_MAX; ++count)
+      {
+         const uint32_t top = (ticks + count / 2) / count;
+         if (top > top_max) continue;
+         if (top * prescaler < TIMER_CYCLES_MIN) break;
+
+         const double achieved = (double)count * top * prescaler;
+         const double error = achieved > cycles ? achieved - cycles : cycles - achieved;
+         const bool accepted = error <= tolerance;
+         const bool best_accepted = best_error <= tolerance;
+
+         if ((accepted && (!best_accepted || count < self->max_count ||
+             (count == self->max_count && error < best_error))) ||
+             (!accepted && !best_accepted && error < best_error))
+         {
+            self->clock_select = clock_select;
+            self->top = (uint16_t)(top - 1);
+            self->max_count = (uint16_t)count;
+            best_error = error;
+         }
+
+         if (accepted) break;
+      }
    }
+
+   if (self->clock_select == 0 && cycles > TIMER_CYCLES_MIN)
+   {
+      self->clock_select = last_clock;
+      self->top = (uint16_t)(top_max - 1);
+      self->max_count = UINT16_MAX;
+   }
+   else if (self->clock_select == 0)
+   {
+      self->clock_select = 1;
+      self->top = TIMER_CYCLES_MIN - 1;
+      self->max_count = 1;
+   }
+
+   timer_select_width(self);
    return;
 }
 
 /********************************************************************************
-* timer_get_max_count: Returnerar antalet timergenererade avbrott som krvs
-*                      fr angiven tid, avrundad till nrmaste heltal.
+* timer_select_output_clock: Vljer minsta prescaler dr angiven tid ryms i
+*                            en enda timerperiod, vilket ger bst
+*                            upplsning, samt motsvarande jmfrelsevrde.
+*                            Antalet avbrott per period stts till 1.
+*                            Returnerar 0 om en prescaler hittades, annars 1.
+*
+*                            - self   : Pekare till timern.
+*                            - time_ms: nskad tid i millisekunder.
+********************************************************************************/
+static int timer_select_output_clock(struct timer* self,
+                                     const double time_ms)
+{
+   const uint8_t num_clocks = self->timer_sel == TIMER_SEL_2 ? TIMER_NUM_CLOCKS_2 : TIMER_NUM_CLOCKS_0;
+   const uint32_t top_max = self->timer_sel == TIMER_SEL_1 ? TIMER_TOP_MAX_16 : TIMER_TOP_MAX_8;
+   const double cycles = time_ms * ((F_CPU) / 1000.0);
+
+   self->time_ms = time_ms;
+   self->clock_select = 0;
+   self->top = 0;
+   self->max_count = 1;
+   self->width = TIMER_WIDTH_0;
+
+   for (uint8_t clock_select = 1; clock_select <= num_clocks; ++clock_select)
+   {
+      const uint16_t prescaler = timer_prescaler(self->timer_sel, clock_select);
+      if (self->timer_sel == TIMER_SEL_0 && prescaler > TIMER0_PRESCALER_MAX) break;
+
+      const double ticks = cycles / prescaler + 0.5;
+      if (ticks < 1.0) return 1;
+
+      if (ticks < top_max + 1.0)
+      {
+         self->clock_select = clock_select;
+         self->top = (uint16_t)((uint32_t)ticks - 1);
+         return 0;
+      }
+   }
+
+   return 1;
+}
+
+/********************************************************************************
+* timer_prescaler: Returnerar prescalern som motsvarar angivna bitar CSn2:0
+*                  fr angiven timerkrets, eller 0 om bitarna inte motsvarar
+*                  ngon prescaler.
+*
+*                  - timer_sel   : Timerkretsen.
+*                  - clock_select: Bitar CSn2:0 (1 - 5, fr Timer 2 1 - 7).
+********************************************************************************/
+uint16_t timer_prescaler(const enum timer_sel timer_sel,
+                         const uint8_t clock_select)
+{
+   if (clock_select == 0) return 0;
+
+   if (timer_sel == TIMER_SEL_2)
+   {
+      if (clock_select > TIMER_NUM_CLOCKS_2) return 0;
+      return pgm_read_word(&timer_prescalers_2[clock_select - 1]);
+   }
+   else
+   {
+      if (clock_select > TIMER_NUM_CLOCKS_0) return 0;
+      return pgm_read_word(&timer_prescalers_0[clock_select - 1]);
+   }
+}
+
+/********************************************************************************
+* timer1_acquire: Startar Timer 1 i Normal Mode med rknaren nollstlld om
+*                 den r stoppad. Om den redan rknar kontrolleras att den
+*                 gr det i Normal Mode med angiven prescaler.
 *
-*                      - time_ms: nskad tid mtt i millisekunder.
+*                 - clock_select: Bitar CS12:0 (1 - 5).
 ********************************************************************************/
-static inline uint32_t timer_get_max_count(const double time_ms)
+int timer1_acquire(const uint8_t clock_select)
 {
-   return (uint32_t)(time_ms / TIME_BETWEEN_INTERRUPTS_MS + 0.5);
+   const uint8_t clock_mask = (1 << CS12) | (1 << CS11) | (1 << CS10);
+   const uint8_t wgm_mask_b = (1 << WGM13) | (1 << WGM12);
+   const uint8_t wgm_mask_a = (1 << WGM11) | (1 << WGM10);
+   if (clock_select == 0 || clock_select > TIMER_NUM_CLOCKS_0) return 1;
+
+   const uint8_t sreg = SREG;
+   asm("CLI");
+   int result = 0;
+
+   if (!(TCCR1B & clock_mask))
+   {
+      TCCR1A = 0x00;
+      TCNT1 = 0;
+      TCCR1B = (TCCR1B & ~(clock_mask | wgm_mask_b)) | clock_select;
+   }
+   else if ((TCCR1A & wgm_mask_a) || (TCCR1B & wgm_mask_b) || (TCCR1B & clock_mask) != clock_select)
+   {
+      result = 1;
+   }
+
+   SREG = sreg;
+   return result;
+}
+
+/********************************************************************************
+* timer1_release: Stoppar Timer 1 om inget avbrott (Input Capture, Compare
+*                 A, Compare B eller Overflow) lngre r aktiverat.
+********************************************************************************/
+void timer1_release(void)
+{
+   const uint8_t sreg = SREG;
+   asm("CLI");
+
+   if (!(TIMSK1 & ((1 << ICIE1) | (1 << OCIE1B) | (1 << OCIE1A) | (1 << TOIE1))))
+   {
+      TCCR1B &= ~((1 << CS12) | (1 << CS11) | (1 << CS10));
+   }
+
+   SREG = sreg;
+   return;
 }
\ No newline at end of file
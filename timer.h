@@ -1,7 +1,53 @@
 /********************************************************************************
-* timer.h: Innehller drivrutiner fr interruptbaserade timerkretsar via 
-*          strukten timer samt associerade funktioner. Dessa timerkretsar 
+* timer.h: Innehller drivrutiner fr interruptbaserade timerkretsar via
+*          strukten timer samt associerade funktioner. Dessa timerkretsar
 *          fungerar ocks utmrkt att anvnda som rknare.
+*
+*          Samtliga timerkretsar krs i CTC Mode, dr prescaler samt
+*          jmfrelsevrde (OCRnA) vljs vid initieringen utifrn nskad
+*          tid, s att de flesta tider krver ett eller ett ftal avbrott.
+*          Endast tider som verstiger timerkretsens maximala period
+*          frlngs i mjukvara genom att avbrotten rknas upp, se
+*          timer_tick (i avbrottsrutiner) samt timer_count och
+*          timer_elapsed. Uppndd tid samt avvikelse kan lsas av via
+*          timer_get_time_ms respektive timer_get_error_ppm.
+*
+*          Rknaren delas mellan avbrottsrutinen och huvudprogrammet och r
+*          16 bitar bred, drmed sker tkomst frn huvudprogrammet med
+*          avbrott inaktiverade s att rknaren inte ndras mitt i en
+*          lsning eller nollstllning. I avbrottsrutiner rknar timer_tick
+*          med den smalaste bredd som antalet avbrott per period krver
+*          (se timer_width): ingen rknare alls vid ett avbrott per period,
+*          annars endast den minst signifikanta byten om hgst 255
+*          avbrott krvs.
+*
+*          Maximal period per avbrott vid 16 MHz:
+*
+*          Timerkrets   Bitar   Prescaler   Upplsning   Maximal period
+*            Timer 0        8          64         4 us          1.024 ms
+*            Timer 1       16        1024        64 us       4194.304 ms
+*            Timer 2        8        1024        64 us         16.384 ms
+*
+*          Via timer_init_output kan timerkretsen i stllet toggla ngon av
+*          sina utpinnar OCnA/OCnB direkt i hrdvara vid varje compare
+*          match, vilket ger en blinkning eller fyrkantsvg med fast
+*          frekvens helt utan avbrott:
+*
+*          Timerkrets   OCnA            OCnB
+*            Timer 0    pin 6 (PORTD6)  pin 5 (PORTD5)
+*            Timer 1    pin 9 (PORTB1)  pin 10 (PORTB2)
+*            Timer 2    pin 11 (PORTB3) pin 3 (PORTD3)
+*
+*          Tiden mellan tv toggningar mste d rymmas i en enda
+*          timerperiod (se tabellen nedan), eftersom ingen upprkning i
+*          mjukvara sker. Bda utpinnarna p samma timerkrets togglas med
+*          samma frekvens, d OCRnA utgr periodens slut i CTC Mode.
+*
+*          Prescalern fr Timer 0 begrnsas till TIMER0_PRESCALER_MAX, d
+*          Timer 0 ven ger bittiden fr mjukvaru-UART:en i soft_serial.c.
+*          Timer 2 anvnds av Modbus-slaven i modbus.c samt, vid drift frn
+*          urkristall, av realtidsklockan i rtc.c och ska drmed inte
+*          anvndas via strukten timer samtidigt som ngon av dessa.
 ********************************************************************************/
 #ifndef TIMER_H_
 #define TIMER_H_
@@ -9,6 +55,15 @@
 /* Inkluderingsdirektiv: */
 #include "misc.h"
 
+/* Makrodefinitioner: */
+#ifndef TIMER0_PRESCALER_MAX
+#define TIMER0_PRESCALER_MAX 64 /* Hgsta prescaler fr Timer 0 (4 us upplsning vid 16 MHz). */
+#endif
+
+#ifndef TIMER_ERROR_MAX_PPM
+#define TIMER_ERROR_MAX_PPM 100 /* Godtagen avvikelse i miljondelar vid val av prescaler. */
+#endif
+
 /********************************************************************************
 * timer_sel: Enumeration fr val av timerkrets.
 ********************************************************************************/
@@ -20,14 +75,43 @@ enum timer_sel
    TIMER_SEL_NONE /* Timer ospecificerad. */
 };
 
+/********************************************************************************
+* timer_channel: Enumeration fr val av utpinne (compare-enhet) p en
+*                timerkrets.
+********************************************************************************/
+enum timer_channel
+{
+   TIMER_CHANNEL_A, /* Utpinne OCnA. */
+   TIMER_CHANNEL_B  /* Utpinne OCnB. */
+};
+
+/********************************************************************************
+* timer_width: Enumeration fr rknarens bredd vid timer_tick, som vljs
+*              utifrn antalet avbrott per period (max_count).
+********************************************************************************/
+enum timer_width
+{
+   TIMER_WIDTH_0,  /* Ett avbrott per period, ingen rknare krvs. */
+   TIMER_WIDTH_8,  /* Hgst 255 avbrott per period, 8 bitar rcker. */
+   TIMER_WIDTH_16  /* Fler n 255 avbrott per period, 16 bitar krvs. */
+};
+
 /********************************************************************************
 * timer: Strukt fr implementering av interruptbaserade timerkretsar, som
 *        vid behov kan anvndas som rknare.
 ********************************************************************************/
 struct timer
 {
-   volatile uint32_t counter; /* 32-bitars rknare. */
-   uint32_t max_count;        /* Maxvrde som upprkning ska ske till. */
+   union
+   {
+      volatile uint16_t counter; /* Antal avbrott sedan timern senast lpte ut. */
+      volatile uint8_t counter8; /* Minst signifikanta byten av counter (TIMER_WIDTH_8). */
+   };
+   uint16_t max_count;        /* Antal avbrott per period (1 om ingen frlngning krvs). */
+   uint16_t top;              /* Jmfrelsevrde OCRnA, dvs. antal timersteg per avbrott - 1. */
+   uint8_t clock_select;      /* Bitar CSn2:0 fr vald prescaler. */
+   uint8_t width;             /* Rknarens bredd vid timer_tick (enum timer_width). */
+   double time_ms;            /* nskad tid i millisekunder. */
    volatile uint8_t* timsk;   /* Pekare till maskregister fr aktivering av avbrott. */
    uint8_t timsk_bit;         /* Bit fr aktivering av avbrott i motsvarande maskregister. */
    enum timer_sel timer_sel;  /* Val av timerkrets. */
@@ -35,18 +119,55 @@ struct timer
 
 /********************************************************************************
 * timer_init: Initierar ny timerkrets med angiven tid mtt i millisekunder.
-*             Om timern ska anvndas som rknare fr att rkna upp till ett
-*             specifikt maxvrde br funktionen timer_set_max_count anropas
-*             direkt efter initieringen.
+*             Prescaler samt jmfrelsevrde vljs s att antalet avbrott
+*             per period minimeras, givet att avvikelsen frn angiven tid
+*             inte verstiger TIMER_ERROR_MAX_PPM. Om ingen kombination
+*             uppfyller detta vljs den med lgst avvikelse. Om timern ska
+*             anvndas som rknare fr att rkna upp till ett specifikt
+*             maxvrde br funktionen timer_set_max_count anropas direkt
+*             efter initieringen.
 *
 *             - self     : Pekare till timern som ska initieras.
 *             - timer_sel: Val av timerkrets.
 *             - time_ms  : Tiden timern ska sttas p mtt i millisekunder.
 ********************************************************************************/
-void timer_init(struct timer* self, 
-                const enum timer_sel timer_sel, 
+void timer_init(struct timer* self,
+                const enum timer_sel timer_sel,
                 const double time_ms);
 
+/********************************************************************************
+* timer_init_output: Initierar ny timerkrets i CTC Mode, dr angiven utpinne
+*                    togglas i hrdvara varje gng angiven tid har passerat.
+*                    Utpinnen stts till utport, medan avbrott inte
+*                    aktiveras, drmed genereras en fyrkantsvg med
+*                    periodtiden 2 * time_ms utan att processorn belastas.
+*                    Minsta mjliga prescaler vljs, vilket ger bst
+*                    upplsning. Uppndd tid kan lsas av via
+*                    timer_get_time_ms. Utsignalen stoppas via timer_clear.
+*                    Returnerar 0 vid lyckad initiering, annars 1 (tiden
+*                    ryms inte i en timerperiod eller utpinnen OC0B, som
+*                    anvnds av mjukvaru-UART:en, angavs).
+*
+*                    - self     : Pekare till timern som ska initieras.
+*                    - timer_sel: Val av timerkrets.
+*                    - time_ms  : Tid mellan tv toggningar i millisekunder.
+*                    - channel  : Utpinnen som ska togglas.
+********************************************************************************/
+int timer_init_output(struct timer* self,
+                      const enum timer_sel timer_sel,
+                      const double time_ms,
+                      const enum timer_channel channel);
+
+/********************************************************************************
+* timer_output_pin: Returnerar pin-numret p Arduino Uno fr angiven
+*                   timerkrets utpinne, exempelvis 9 fr OC1A.
+*
+*                   - timer_sel: Timerkretsen (TIMER_SEL_0 - TIMER_SEL_2).
+*                   - channel  : Utpinnen.
+********************************************************************************/
+uint8_t timer_output_pin(const enum timer_sel timer_sel,
+                         const enum timer_channel channel);
+
 /********************************************************************************
 * timer_clear: Genomfr total nollstllning av angiven timerkrets.
 *
@@ -56,19 +177,14 @@ void timer_clear(struct timer* self);
 
 /********************************************************************************
 * timer_enable_interrupt: Aktiverar timergenererat avbrott, som ger rum nr
-*                         timern rknar upp till overflow eller specificerat max.
-*
-*                         Timer 0 samt Timer 2 aktiveras i Normal Mode, medan
-*                         Timer 1 aktiveras i CTC Mode med upprkning till 256,
-*                         vilket gr att tiden mellan varje timergenererat
-*                         avbrott r samma oavsett anvnd timerkrets.
+*                         timern rknar upp till valt jmfrelsevrde.
 *
 *                         Avbrottsvektorer fr timerkretsarna deklareras nedan:
 *
 *                         Timerkrets     Avbrottsvektor
-*                           Timer 0     TIMER0_OVF_vect
+*                           Timer 0     TIMER0_COMPA_vect
 *                           Timer 1     TIMER1_COMPA_vect
-*                           Timer 2     TIMER2_OVF_vect
+*                           Timer 2     TIMER2_COMPA_vect
 *
 *                         - self: Pekare till timern som timergenererat
 *                                 avbrott ska aktiveras p.
@@ -95,7 +211,7 @@ static inline void timer_disable_interrupt(struct timer* self)
 * timer_toggle_interrupt: Togglar aktivering av timergenererat avbrott p
 *                         angiven timer.
 *
-*                         - self: Pekare till timern som aktivering av 
+*                         - self: Pekare till timern som aktivering av
 *                                 timergenererat avbrott ska togglas p.
 ********************************************************************************/
 void timer_toggle_interrupt(struct timer* self);
@@ -123,23 +239,75 @@ static inline void timer_count(struct timer* self)
    return;
 }
 
+/********************************************************************************
+* timer_tick: Rknar upp angiven timer och indikerar ifall den har lpt ut,
+*             varvid rknaren nollstlls infr nsta period. Avsedd fr
+*             avbrottsrutiner som ersttning fr timer_count fljt av
+*             timer_elapsed; hela upprkningen sker inline, medan anropet
+*             av timer_elapsed tvingar kompilatorn att spara undan samtliga
+*             register som en anropad funktion fr skriva ver.
+*
+*             Rknaren anvnds med den bredd som valdes tillsammans med
+*             max_count. Vid ett avbrott per period lper timern ut vid
+*             varje anrop utan att rknaren lses, och vid hgst 255
+*             avbrott per period rknas endast den minst signifikanta
+*             byten upp. Den mest signifikanta byten frblir d noll,
+*             drmed r rknaren fortsatt giltig fr timer_elapsed.
+*
+*             - self: Pekare till timern som ska rknas upp.
+********************************************************************************/
+static inline bool timer_tick(struct timer* self)
+{
+   if (self->width == TIMER_WIDTH_0) return true;
+
+   if (self->width == TIMER_WIDTH_8)
+   {
+      const uint8_t counter8 = self->counter8 + 1;
+
+      if (counter8 >= (uint8_t)self->max_count)
+      {
+         self->counter8 = 0;
+         return true;
+      }
+
+      self->counter8 = counter8;
+      return false;
+   }
+
+   const uint16_t counter = self->counter + 1;
+
+   if (counter >= self->max_count)
+   {
+      self->counter = 0;
+      return true;
+   }
+
+   self->counter = counter;
+   return false;
+}
+
 /********************************************************************************
 * timer_elapsed: Indikerar ifall angiven timer har lpt ut genom att returnera
 *                true eller false. Ifall timern har lpt ut nollstlls rknaren
-*                infr nsta upprkning.
+*                infr nsta upprkning. Rknaren lses och nollstlls med
+*                avbrott inaktiverade.
 *
 *                - self: Pekare till timern som ska kontrolleras.
 ********************************************************************************/
 bool timer_elapsed(struct timer* self);
 
 /********************************************************************************
-* timer_reset_counter: Nollstller rknaren p angiven timer.
+* timer_reset_counter: Nollstller rknaren p angiven timer med avbrott
+*                      inaktiverade.
 *
 *                      - self: Pekare till timern vars rknare ska nollstllas.
 ********************************************************************************/
 static inline void timer_reset_counter(struct timer* self)
 {
+   const uint8_t sreg = SREG;
+   asm("CLI");
    self->counter = 0;
+   SREG = sreg;
    return;
 }
 
@@ -151,26 +319,106 @@ static inline void timer_reset_counter(struct timer* self)
 void timer_reset(struct timer* self);
 
 /********************************************************************************
-* timer_set_new_time: Stter ny tid p angiven timerkrets.
+* timer_set_new_time: Stter ny tid p angiven timerkrets, dr prescaler
+*                     samt jmfrelsevrde vljs om enligt timer_init.
 *
 *                    - self   : Pekare till timern vars tid ska uppdateras.
 *                    - time_ms: Tiden timern ska sttas p mtt i millisekunder.
 ********************************************************************************/
-void timer_set_new_time(struct timer* self, 
+void timer_set_new_time(struct timer* self,
                         const double time_ms);
 
+/********************************************************************************
+* timer_select_width: Vljer smalaste rknarbredd fr timer_tick utifrn
+*                     angiven timers antal avbrott per period.
+*
+*                     - self: Pekare till timern.
+********************************************************************************/
+static inline void timer_select_width(struct timer* self)
+{
+   self->width = self->max_count <= 1 ? TIMER_WIDTH_0 :
+                 self->max_count <= UINT8_MAX ? TIMER_WIDTH_8 : TIMER_WIDTH_16;
+   return;
+}
+
 /********************************************************************************
 * timer_set_new_max_count: Stter nytt maxvrde fr upprkning av timern nr
-*                          denna ska anvndas som en rknare.
+*                          denna ska anvndas som en rknare. Rknarens bredd
+*                          vljs om och rknaren nollstlls med avbrott
+*                          inaktiverade, s att en smalare bredd inte lmnar
+*                          kvar en ettstlld mest signifikant byte.
 *
 *                          - self   : Pekare till timern.
 *                          - max_count: Maxvrde fr upprkningen.
 ********************************************************************************/
 static inline void timer_set_max_count(struct timer* self,
-                                       const uint32_t max_count)
+                                       const uint16_t max_count)
 {
+   const uint8_t sreg = SREG;
+   asm("CLI");
    self->max_count = max_count;
+   timer_select_width(self);
+   self->counter = 0;
+   SREG = sreg;
    return;
 }
 
+/********************************************************************************
+* timer_get_prescaler: Returnerar vald prescaler fr angiven timer.
+*
+*                      - self: Pekare till timern.
+********************************************************************************/
+uint16_t timer_get_prescaler(const struct timer* self);
+
+/********************************************************************************
+* timer_prescaler: Returnerar prescalern som motsvarar angivna bitar CSn2:0
+*                  fr angiven timerkrets, eller 0 om bitarna inte motsvarar
+*                  ngon prescaler. Kan anvndas fr att prova samtliga
+*                  prescalers i stigande ordning med start frn 1.
+*
+*                  - timer_sel   : Timerkretsen.
+*                  - clock_select: Bitar CSn2:0 (1 - 5, fr Timer 2 1 - 7).
+********************************************************************************/
+uint16_t timer_prescaler(const enum timer_sel timer_sel,
+                         const uint8_t clock_select);
+
+/********************************************************************************
+* timer1_acquire: Startar Timer 1 som frirullande rknare (Normal Mode) med
+*                 angivna bitar CS12:0 om den r stoppad. Flera drivrutiner
+*                 kan drmed dela rknaren via var sitt avbrott, exempelvis
+*                 Input Capture (capture.h) och Compare B (bam.h), dr
+*                 respektive avbrott schemalggs relativt rknarens aktuella
+*                 vrde i stllet fr att rknaren nollstlls. Returnerar 0
+*                 om Timer 1 drefter rknar fritt med angiven prescaler,
+*                 annars 1 (Timer 1 anvnds i en annan mod, exempelvis via
+*                 strukten timer eller pwm_hw, eller med en annan prescaler).
+*
+*                 - clock_select: Bitar CS12:0 (1 - 5).
+********************************************************************************/
+int timer1_acquire(const uint8_t clock_select);
+
+/********************************************************************************
+* timer1_release: Stoppar Timer 1 om inget avbrott lngre r aktiverat fr
+*                 den. Anropas av drivrutiner som delar Timer 1 efter att
+*                 det egna avbrottet har inaktiverats.
+********************************************************************************/
+void timer1_release(void);
+
+/********************************************************************************
+* timer_get_time_ms: Returnerar uppndd tid i millisekunder, dvs. tiden
+*                    mellan tv tillfllen som timern lper ut.
+*
+*                    - self: Pekare till timern.
+********************************************************************************/
+double timer_get_time_ms(const struct timer* self);
+
+/********************************************************************************
+* timer_get_error_ppm: Returnerar uppndd tids avvikelse frn nskad tid
+*                      mtt i miljondelar, dr positivt vrde innebr att
+*                      timern lper ut fr sent.
+*
+*                      - self: Pekare till timern.
+********************************************************************************/
+int32_t timer_get_error_ppm(const struct timer* self);
+
 #endif /* TIMER_H_ */
\ No newline at end of file
@@ -6,7 +6,7 @@
 /********************************************************************************
 * tmp36_init: Initierar pin ansluten till temperatursensor TMP36 fr mtning
 *             samt utskrift av rumstemperaturen. Seriell verfring initieras
-*             ocks med en baud rate (verfringshastighet) p 9600 kbps.
+*             ocks med en baud rate (verfringshastighet) p 9600 bps.
 *
 *             - self: Pekare till temperatursensorn som ska initieras.
 *             - pin : Analog pin A0 - A5 som temperatursensorn r ansluten till.
@@ -15,7 +15,7 @@ void tmp36_init(struct tmp36* self,
                 const uint8_t pin)
 {
    adc_init(&self->adc, pin);
-   serial_init(9600);
+   serial_init(SERIAL_BAUD_RATE);
    return;
 }
 
@@ -27,9 +27,9 @@ void tmp36_init(struct tmp36* self,
 ********************************************************************************/
 void tmp36_print_temperature(const struct tmp36* self)
 {
-   serial_print_string("Temperature: ");
+   serial_print_P("Temperature: ");
    serial_print_double(tmp36_get_temperature(self));
-   serial_print_string(" degrees Celcius.\n");
+   serial_print_P(" degrees Celcius.\n");
    return;
 }
 
@@ -41,8 +41,8 @@ void tmp36_print_temperature(const struct tmp36* self)
 ********************************************************************************/
 void tmp36_print_voltage(const struct tmp36* self)
 {
-   serial_print_string("Voltage: ");
+   serial_print_P("Voltage: ");
    serial_print_double(tmp36_get_input_voltage(self));
-   serial_print_string(" V\n.");
+   serial_print_P(" V\n");
    return;
 }
\ No newline at end of file
@@ -41,7 +41,7 @@ struct tmp36
 /********************************************************************************
 * tmp36_init: Initierar pin ansluten till temperatursensor TMP36 fr mtning
 *             samt utskrift av rumstemperaturen. Seriell verfring initieras
-*             ocks med en baud rate (verfringshastighet) p 9600 kbps.
+*             ocks med en baud rate (verfringshastighet) p 9600 bps.
 *
 *             - self: Pekare till temperatursensorn som ska initieras.
 *             - pin : Analog pin A0 - A5 som temperatursensorn r ansluten till.
@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+"""Generate the brightness lookup tables in brightness_tables.h.
+
+Each table maps an 8-bit input level (for example the potentiometer reading
+shifted down from 10 bits) to an output duty cycle, so that equal steps of
+the input give equal steps of perceived brightness. Two curves are
+generated, each for 8-, 10- and 16-bit output:
+
+    gamma   output = max * (level / 255) ^ gamma
+    cie     CIE 1976 lightness L* = 100 * level / 255 converted to
+            luminance: (L* / 903.3) for L* <= 8, otherwise
+            ((L* + 16) / 116) ^ 3
+
+The tables are stored in program memory and read by brightness.c. The
+output is written with CRLF line endings in Latin-1 like the rest of the
+sources. Run this script again after changing the gamma value and commit
+the regenerated header.
+
+Usage:
+    python3 tools/brightness_tables.py
+    python3 tools/brightness_tables.py --gamma 2.8 -o brightness_tables.h
+"""
+
+import argparse
+import os
+
+LEVELS = 256
+RESOLUTIONS = (8, 10, 16)
+VALUES_PER_LINE = {8: 16, 10: 12, 16: 8}
+
+
+def gamma_curve(gamma):
+    return lambda x: x ** gamma
+
+
+def cie_curve(x):
+    lightness = 100.0 * x
+    if lightness <= 8.0:
+        return lightness / 903.3
+    return ((lightness + 16.0) / 116.0) ** 3
+
+
+def table(curve, bits):
+    top = (1 << bits) - 1
+    return [int(round(curve(i / (LEVELS - 1)) * top)) for i in range(LEVELS)]
+
+
+def c_array(name, values, bits, comment):
+    kind = 'uint8_t' if bits == 8 else 'uint16_t'
+    width = len(str((1 << bits) - 1))
+    per_line = VALUES_PER_LINE[bits]
+    lines = ['/* %s */' % comment,
+             'static const %s %s[BRIGHTNESS_LEVELS] PROGMEM =' % (kind, name), '{']
+    for i in range(0, len(values), per_line):
+        chunk = ', '.join(str(v).rjust(width) for v in values[i:i + per_line])
+        lines.append('   ' + chunk + (',' if i + per_line < len(values) else ''))
+    lines.append('};')
+    return lines
+
+
+def generate(gamma):
+    out = [
+        '/' + '*' * 80,
+        '* brightness_tables.h: Uppslagstabeller för ljusstyrka, genererade av',
+        '*                      tools/brightness_tables.py (gamma = %.2f).' % gamma,
+        '*                      Redigera inte denna fil manuellt, utan generera',
+        '*                      den på nytt via skriptet. Inkluderas endast av',
+        '*                      brightness.c.',
+        '*' * 80 + '/',
+        '#ifndef BRIGHTNESS_TABLES_H_',
+        '#define BRIGHTNESS_TABLES_H_',
+        '',
+    ]
+    curves = (('gamma', gamma_curve(gamma), 'Gammakorrigering'),
+              ('cie', cie_curve, 'CIE 1976 L*'))
+    for name, curve, title in curves:
+        for bits in RESOLUTIONS:
+            out += c_array('brightness_%s_%d' % (name, bits), table(curve, bits), bits,
+                           '%s, %d bitar (0 - %d):' % (title, bits, (1 << bits) - 1))
+            out.append('')
+    out.append('#endif /* BRIGHTNESS_TABLES_H_ */')
+    return '\r\n'.join(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--gamma', type=float, default=2.2, help='gamma exponent (default: 2.2)')
+    parser.add_argument('-o', '--output', default=os.path.join(
+        os.path.dirname(os.path.abspath(__file__)), '..', 'brightness_tables.h'))
+    args = parser.parse_args()
+
+    with open(args.output, 'wb') as f:
+        f.write(generate(args.gamma).encode('latin-1'))
+    return 0
+
+
+if __name__ == '__main__':
+    raise SystemExit(main())
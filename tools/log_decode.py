@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+"""Decode binary log records from the serial driver into readable lines.
+
+The firmware (built with LOG_BINARY=1, see log.h) sends one record per log
+call:
+
+    ID          1 byte   0x80 + id for id 0 - 111
+                2 bytes  0xF0 | (id - 112) >> 8, (id - 112) & 0xFF
+    timestamp   2 bytes  milliseconds, little endian, wraps at 65536
+    arguments   0 - 8    packed little endian, sizes given by the format
+
+Message IDs are the line order of LOG_MESSAGE entries in log_messages.h,
+which this script reads to rebuild the text. Bytes below 0x80 are plain
+ASCII output (for example the command shell) and are passed through.
+
+Once a LOG_RTC_TIME record has been seen (logged every minute by the
+real-time clock, see rtc.h), timestamps are printed as date and time
+relative to the latest such record instead of seconds since start.
+
+Usage:
+    stty -F /dev/ttyACM0 9600 raw
+    python3 tools/log_decode.py /dev/ttyACM0
+    python3 tools/log_decode.py capture.bin
+"""
+
+import argparse
+import datetime
+import os
+import re
+import struct
+import sys
+
+SHORT_ID_FIRST = 0x80
+LONG_ID_FIRST = 0xF0
+SHORT_IDS = LONG_ID_FIRST - SHORT_ID_FIRST
+
+MESSAGE_PATTERN = re.compile(r'LOG_MESSAGE\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+SPEC_PATTERN = re.compile(r'%(hh|h|l)?([dux%])')
+SPEC_SIZES = {'hh': 1, 'h': 2, None: 2, 'l': 4}
+SPEC_FORMATS = {1: 'b', 2: 'h', 4: 'i'}
+
+RTC_MESSAGE = 'LOG_RTC_TIME'
+RTC_EPOCH = datetime.datetime(2000, 1, 1)
+
+
+def load_messages(path):
+    """Return a list of (name, format) tuples in message ID order."""
+    with open(path, encoding='latin-1') as f:
+        return MESSAGE_PATTERN.findall(f.read())
+
+
+def argument_sizes(fmt):
+    """Return the byte size of each argument in the given format string."""
+    return [SPEC_SIZES[m.group(1)] for m in SPEC_PATTERN.finditer(fmt) if m.group(2) != '%']
+
+
+def render(fmt, payload):
+    """Insert the packed arguments into the format string."""
+    offset = 0
+
+    def substitute(m):
+        nonlocal offset
+        length, conversion = m.group(1), m.group(2)
+        if conversion == '%':
+            return '%'
+        size = SPEC_SIZES[length]
+        code = SPEC_FORMATS[size]
+        if conversion != 'd':
+            code = code.upper()
+        (value,) = struct.unpack_from('<' + code, payload, offset)
+        offset += size
+        return '%0*X' % (2 * size, value) if conversion == 'x' else str(value)
+
+    return SPEC_PATTERN.sub(substitute, fmt)
+
+
+class Decoder:
+    """Incremental decoder for a byte stream of mixed text and log records."""
+
+    def __init__(self, messages, out):
+        self.messages = messages
+        self.out = out
+        self.buffer = bytearray()
+        self.last_timestamp = None
+        self.epoch_ms = 0
+        self.anchor = None
+        self.errors = 0
+
+    def feed(self, data):
+        self.buffer += data
+        while self.buffer:
+            first = self.buffer[0]
+            if first < SHORT_ID_FIRST:
+                self.out.write(chr(first))
+                del self.buffer[0]
+                continue
+            record = self.parse_record()
+            if record is None:
+                return
+            length, line = record
+            del self.buffer[:length]
+            if line is not None:
+                self.out.write(line + '\n')
+
+    def parse_record(self):
+        """Return (length, line) for the record at the buffer start, or None
+        if more bytes are needed. Unknown IDs skip a single byte."""
+        first = self.buffer[0]
+        if first >= LONG_ID_FIRST:
+            if len(self.buffer) < 2:
+                return None
+            message_id = SHORT_IDS + (((first & 0x0F) << 8) | self.buffer[1])
+            header = 2
+        else:
+            message_id = first - SHORT_ID_FIRST
+            header = 1
+
+        if message_id >= len(self.messages):
+            self.errors += 1
+            return 1, '<unknown log message 0x%02X>' % first
+
+        name, fmt = self.messages[message_id]
+        size = sum(argument_sizes(fmt))
+        length = header + 2 + size
+        if len(self.buffer) < length:
+            return None
+
+        (timestamp,) = struct.unpack_from('<H', self.buffer, header)
+        payload = bytes(self.buffer[header + 2:length])
+        ms = self.unwrap(timestamp)
+        if name == RTC_MESSAGE:
+            (seconds,) = struct.unpack_from('<I', payload)
+            self.anchor = (seconds, ms)
+        return length, '[%s] %s' % (self.stamp(ms), render(fmt, payload))
+
+    def stamp(self, ms):
+        """Return the timestamp as date and time if the real-time clock is
+        known, otherwise as seconds since the first record."""
+        if self.anchor is None:
+            return '%10.3f' % (ms / 1000.0)
+        seconds, anchor_ms = self.anchor
+        time = RTC_EPOCH + datetime.timedelta(seconds=seconds, milliseconds=ms - anchor_ms)
+        return time.strftime('%Y-%m-%d %H:%M:%S.') + '%03d' % (time.microsecond // 1000)
+
+    def unwrap(self, timestamp):
+        """Extend the 16-bit millisecond timestamp, assuming records arrive in
+        order and less than 65.5 seconds apart."""
+        if self.last_timestamp is not None and timestamp < self.last_timestamp:
+            self.epoch_ms += 0x10000
+        self.last_timestamp = timestamp
+        return self.epoch_ms + timestamp
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('input', nargs='?', default='-',
+                        help='captured byte stream or serial device (default: stdin)')
+    parser.add_argument('--messages', default=os.path.join(here, '..', 'log_messages.h'),
+                        help='path to log_messages.h')
+    args = parser.parse_args()
+
+    decoder = Decoder(load_messages(args.messages), sys.stdout)
+    stream = sys.stdin.buffer if args.input == '-' else open(args.input, 'rb', buffering=0)
+
+    with stream:
+        while True:
+            data = stream.read(256)
+            if not data:
+                break
+            decoder.feed(data)
+            sys.stdout.flush()
+
+    return 1 if decoder.errors else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""Minimal Modbus RTU master for talking to the board's Modbus slave.
+
+The slave (see modbus.h and modbus_map.c) is enabled with the shell command
+"modbus <address>" or by a valid slave address in EEPROM. This script sends
+one request per invocation and prints the response. It only needs the
+Python standard library and works with any tty, including pseudo-terminals
+such as a simulator or socat pty pair.
+
+Usage:
+    python3 tools/modbus_master.py /dev/ttyACM0 --slave 1 read-holding 0 4
+    python3 tools/modbus_master.py /dev/ttyACM0 read-input 0 7
+    python3 tools/modbus_master.py /dev/ttyACM0 write-register 1 500
+    python3 tools/modbus_master.py /dev/ttyACM0 write-coils 0 1 0 1
+"""
+
+import argparse
+import os
+import select
+import struct
+import sys
+import termios
+import time
+
+READ_COILS = 0x01
+READ_DISCRETE_INPUTS = 0x02
+READ_HOLDING_REGISTERS = 0x03
+READ_INPUT_REGISTERS = 0x04
+WRITE_SINGLE_COIL = 0x05
+WRITE_SINGLE_REGISTER = 0x06
+WRITE_MULTIPLE_COILS = 0x0F
+WRITE_MULTIPLE_REGISTERS = 0x10
+
+EXCEPTIONS = {
+    1: 'illegal function',
+    2: 'illegal data address',
+    3: 'illegal data value',
+    4: 'slave device failure',
+}
+
+
+class ModbusError(Exception):
+    pass
+
+
+def crc16(data):
+    """Modbus CRC16 (polynomial 0xA001, initial value 0xFFFF)."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def frame(slave, pdu):
+    """Return the RTU frame for the given slave address and PDU."""
+    data = bytes([slave]) + pdu
+    return data + struct.pack('<H', crc16(data))
+
+
+def open_port(path, baud):
+    """Open the tty in raw 8N1 mode at the given baud rate."""
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    attrs = termios.tcgetattr(fd)
+    speed = getattr(termios, 'B%d' % baud)
+    attrs[0] = 0                                            # iflag
+    attrs[1] = 0                                            # oflag
+    attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL  # cflag
+    attrs[3] = 0                                            # lflag
+    attrs[4] = attrs[5] = speed
+    attrs[6][termios.VMIN] = 0
+    attrs[6][termios.VTIME] = 0
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    return fd
+
+
+class Master:
+    """Sends requests and reads responses of the expected length."""
+
+    def __init__(self, fd, slave, timeout):
+        self.fd = fd
+        self.slave = slave
+        self.timeout = timeout
+
+    def request(self, pdu):
+        termios.tcflush(self.fd, termios.TCIFLUSH)
+        os.write(self.fd, frame(self.slave, pdu))
+        if self.slave == 0:
+            return None
+
+        response = bytearray()
+        deadline = time.monotonic() + self.timeout
+        while len(response) < self.expected_length(response):
+            remaining = deadline - time.monotonic()
+            if remaining <= 0 or not select.select([self.fd], [], [], remaining)[0]:
+                raise ModbusError('timeout after %d bytes' % len(response))
+            response += os.read(self.fd, 256)
+
+        response = bytes(response[:self.expected_length(response)])
+        if crc16(response) != 0:
+            raise ModbusError('CRC mismatch in response %s' % response.hex(' '))
+        if response[0] != self.slave or response[1] & 0x7F != pdu[0]:
+            raise ModbusError('unexpected response %s' % response.hex(' '))
+        if response[1] & 0x80:
+            code = response[2]
+            raise ModbusError('exception %d (%s)' % (code, EXCEPTIONS.get(code, 'unknown')))
+        return response[2:-2]
+
+    @staticmethod
+    def expected_length(response):
+        """Return the total response length known so far (at least 5)."""
+        if len(response) < 3:
+            return 5
+        if response[1] & 0x80:
+            return 5
+        if response[1] <= READ_INPUT_REGISTERS:
+            return 3 + response[2] + 2
+        return 8
+
+    def read_bits(self, function, address, count):
+        data = self.request(struct.pack('>BHH', function, address, count))
+        return [bool(data[1 + i // 8] & (1 << (i % 8))) for i in range(count)]
+
+    def read_registers(self, function, address, count):
+        data = self.request(struct.pack('>BHH', function, address, count))
+        return list(struct.unpack('>%dH' % count, data[1:]))
+
+    def write_coil(self, address, value):
+        self.request(struct.pack('>BHH', WRITE_SINGLE_COIL, address, 0xFF00 if value else 0))
+
+    def write_register(self, address, value):
+        self.request(struct.pack('>BHH', WRITE_SINGLE_REGISTER, address, value))
+
+    def write_coils(self, address, values):
+        packed = bytearray((len(values) + 7) // 8)
+        for i, value in enumerate(values):
+            if value:
+                packed[i // 8] |= 1 << (i % 8)
+        self.request(struct.pack('>BHHB', WRITE_MULTIPLE_COILS, address, len(values), len(packed))
+                     + bytes(packed))
+
+    def write_registers(self, address, values):
+        self.request(struct.pack('>BHHB%dH' % len(values), WRITE_MULTIPLE_REGISTERS, address,
+                                 len(values), 2 * len(values), *values))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('port', help='serial device or pseudo-terminal')
+    parser.add_argument('--baud', type=int, default=9600)
+    parser.add_argument('--slave', type=int, default=1, help='slave address (0 = broadcast)')
+    parser.add_argument('--timeout', type=float, default=1.0, help='response timeout in seconds')
+    parser.add_argument('command', choices=['read-coils', 'read-discrete', 'read-holding',
+                                            'read-input', 'write-coil', 'write-register',
+                                            'write-coils', 'write-registers'])
+    parser.add_argument('address', type=lambda s: int(s, 0))
+    parser.add_argument('values', nargs='*', type=lambda s: int(s, 0),
+                        help='count for reads, value(s) for writes')
+    args = parser.parse_args()
+
+    fd = open_port(args.port, args.baud)
+    master = Master(fd, args.slave, args.timeout)
+    reads = {
+        'read-coils': (master.read_bits, READ_COILS),
+        'read-discrete': (master.read_bits, READ_DISCRETE_INPUTS),
+        'read-holding': (master.read_registers, READ_HOLDING_REGISTERS),
+        'read-input': (master.read_registers, READ_INPUT_REGISTERS),
+    }
+
+    try:
+        if args.command in reads:
+            read, function = reads[args.command]
+            count = args.values[0] if args.values else 1
+            for i, value in enumerate(read(function, args.address, count)):
+                print('%d: %d' % (args.address + i, value))
+        elif not args.values:
+            parser.error('%s needs at least one value' % args.command)
+        elif args.command == 'write-coil':
+            master.write_coil(args.address, args.values[0])
+        elif args.command == 'write-register':
+            master.write_register(args.address, args.values[0])
+        elif args.command == 'write-coils':
+            master.write_coils(args.address, args.values)
+        else:
+            master.write_registers(args.address, args.values)
+    except ModbusError as error:
+        print('error: %s' % error, file=sys.stderr)
+        return 1
+    finally:
+        os.close(fd)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
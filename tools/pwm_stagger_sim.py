@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""Simulate synchronous and phase-staggered PWM and trace the on count.
+
+Models the edge scheduling in pwm_poll (see pwm.c): in synchronous mode all
+LEDs of the vector turn on at the start of each period, in staggered mode
+LED k of n turns on k * period / n later. Every LED stays on for the same
+on time, so the average brightness is the same in both modes. The trace
+prints one row per time step with the LEDs that are on and the number of
+LEDs on at the same time, followed by the peak and average on count, which
+is what the supply has to deliver.
+
+This is an idealized model of the schedule, not the firmware itself: edges
+land exactly on time and the code in pwm_poll_staggered is never executed.
+It shows what the firmware aims for; the peak measured on the target is
+reported by the shell command "pwm" when staggering is enabled (software
+PWM only, stagger mode is refused with PWM_HARDWARE=1).
+
+Usage:
+    python3 tools/pwm_stagger_sim.py --leds 8 --duty 25
+    python3 tools/pwm_stagger_sim.py --leds 3 --duty 60 --steps 20 --summary
+"""
+
+import argparse
+import sys
+
+
+def on_intervals(leds, period, on_time, staggered):
+    """Return the (on, off) times within one period for each LED."""
+    intervals = []
+    for k in range(leds):
+        start = k * period // leds if staggered else 0
+        intervals.append((start, start + on_time))
+    return intervals
+
+
+def is_on(interval, t, period):
+    """Return True if the LED is on at time t, including wrap-around."""
+    start, end = interval
+    return start <= t < end or start <= t + period < end
+
+
+def simulate(leds, period, on_time, staggered, steps):
+    """Return a list of (time, states) for evenly spaced times in a period."""
+    intervals = on_intervals(leds, period, on_time, staggered)
+    trace = []
+    for step in range(steps):
+        t = step * period // steps
+        trace.append((t, [is_on(i, t, period) for i in intervals]))
+    return trace
+
+
+def print_trace(name, trace, summary, out):
+    counts = [sum(states) for _, states in trace]
+    if not summary:
+        out.write('%s:\n' % name)
+        for (t, states), count in zip(trace, counts):
+            row = ''.join('#' if on else '.' for on in states)
+            out.write('%8u us  %s  %2d\n' % (t, row, count))
+    out.write('%-10s peak on: %d, average on: %.2f\n'
+              % (name, max(counts), sum(counts) / len(counts)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--leds', type=int, default=8, help='number of LEDs (1 - 32)')
+    parser.add_argument('--duty', type=float, default=25.0, help='duty cycle in percent')
+    parser.add_argument('--period', type=int, default=1000, help='PWM period in microseconds')
+    parser.add_argument('--steps', type=int, default=40, help='time steps per period')
+    parser.add_argument('--summary', action='store_true', help='print only peak and average')
+    args = parser.parse_args()
+
+    if not 1 <= args.leds <= 32:
+        parser.error('--leds must be 1 - 32')
+    if not 0 <= args.duty <= 100:
+        parser.error('--duty must be 0 - 100')
+
+    on_time = int(args.period * args.duty / 100 + 0.5)
+    for name, staggered in (('sync', False), ('staggered', True)):
+        trace = simulate(args.leds, args.period, on_time, staggered, max(args.steps, 1))
+        print_trace(name, trace, args.summary, sys.stdout)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+"""Decode COBS framed telemetry from the serial driver into readable lines.
+
+The firmware (see telemetry.h) sends one frame per telemetry call. Before
+encoding a frame holds:
+
+    type        1 byte   1 = samples, 2 = counters, 3 = event
+    sequence    1 byte   increments per frame, including dropped frames
+    timestamp   4 bytes  milliseconds, little endian
+    payload     0 - N    depends on the type, little endian
+    crc         2 bytes  CRC-16/CCITT-FALSE over all previous fields
+
+    samples     channel (1), count (1), count x uint16
+    counters    first id (1), count (1), count x uint32
+    event       event (1), 0 - N bytes of data
+
+Frames are COBS encoded with a zero byte on each side. Every chunk between
+zero bytes is checked for a valid COBS encoding, length and CRC before it
+is parsed, so corrupted frames are reported instead of misparsed. Gaps in
+the sequence number are reported as lost frames. The exit status is 1 if
+any frame was bad or lost. With --text, chunks of printable ASCII that are
+not valid frames (for example shell output on the same line) are printed
+as they are instead of being reported.
+
+Usage:
+    stty -F /dev/ttyACM0 9600 raw
+    python3 tools/telemetry_decode.py /dev/ttyACM0
+    python3 tools/telemetry_decode.py capture.bin
+"""
+
+import argparse
+import struct
+import sys
+
+HEADER = struct.Struct('<BBI')
+CRC_SIZE = 2
+FRAME_MIN = HEADER.size + CRC_SIZE
+
+SAMPLES = 1
+COUNTERS = 2
+EVENT = 3
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, the same as _crc_xmodem_update from 0xFFFF."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+        crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    """Return the decoded frame, or None if the encoding is invalid."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def describe(kind, payload):
+    """Return the payload as text, or None if its length does not match."""
+    if kind in (SAMPLES, COUNTERS):
+        if len(payload) < 2:
+            return None
+        first, count = payload[0], payload[1]
+        code = 'H' if kind == SAMPLES else 'I'
+        if len(payload) != 2 + count * struct.calcsize(code):
+            return None
+        values = struct.unpack_from('<%d%s' % (count, code), payload, 2)
+        if kind == SAMPLES:
+            return 'samples channel %u: %s' % (first, ' '.join(map(str, values)))
+        return 'counters ' + ' '.join('%u=%u' % (first + i, v) for i, v in enumerate(values))
+    if kind == EVENT:
+        if len(payload) < 1:
+            return None
+        return 'event %u %s' % (payload[0], payload[1:].hex(' ')) if len(payload) > 1 \
+            else 'event %u' % payload[0]
+    return None
+
+
+class Decoder:
+    """Incremental decoder for a byte stream of COBS encoded frames."""
+
+    def __init__(self, out, text=False):
+        self.out = out
+        self.text = text
+        self.buffer = bytearray()
+        self.sequence = None
+        self.bad = 0
+        self.lost = 0
+
+    def feed(self, data):
+        self.buffer += data
+        while True:
+            end = self.buffer.find(0)
+            if end < 0:
+                return
+            chunk = bytes(self.buffer[:end])
+            del self.buffer[:end + 1]
+            if chunk:
+                self.frame(chunk)
+
+    def error(self, reason, chunk):
+        if self.text and all(32 <= c < 127 or c in b'\r\n\t' for c in chunk):
+            self.out.write(chunk.decode('ascii').replace('\r', ''))
+            return
+        self.bad += 1
+        self.out.write('<bad frame: %s, %d bytes>\n' % (reason, len(chunk)))
+
+    def frame(self, chunk):
+        frame = cobs_decode(chunk)
+        if frame is None:
+            return self.error('invalid COBS', chunk)
+        if len(frame) < FRAME_MIN:
+            return self.error('too short', chunk)
+        (crc,) = struct.unpack_from('<H', frame, len(frame) - CRC_SIZE)
+        if crc16(frame[:-CRC_SIZE]) != crc:
+            return self.error('CRC mismatch', chunk)
+
+        kind, sequence, timestamp = HEADER.unpack_from(frame)
+        text = describe(kind, frame[HEADER.size:-CRC_SIZE])
+        if text is None:
+            return self.error('unknown type %u or bad length' % kind, chunk)
+
+        if self.sequence is not None:
+            missing = (sequence - self.sequence - 1) & 0xFF
+            if missing:
+                self.lost += missing
+                self.out.write('<lost %d frame(s)>\n' % missing)
+        self.sequence = sequence
+        self.out.write('[%10.3f] #%03u %s\n' % (timestamp / 1000.0, sequence, text))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('input', nargs='?', default='-',
+                        help='captured byte stream or serial device (default: stdin)')
+    parser.add_argument('--text', action='store_true',
+                        help='print plain text between frames instead of reporting it')
+    args = parser.parse_args()
+
+    decoder = Decoder(sys.stdout, args.text)
+    stream = sys.stdin.buffer if args.input == '-' else open(args.input, 'rb', buffering=0)
+
+    with stream:
+        while True:
+            data = stream.read(256)
+            if not data:
+                break
+            decoder.feed(data)
+            sys.stdout.flush()
+
+    return 1 if decoder.bad or decoder.lost else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
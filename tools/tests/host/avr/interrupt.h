@@ -0,0 +1,13 @@
+/********************************************************************************
+* avr/interrupt.h: Ersttning fr avr-libc vid kompilering fr vrden.
+*                  Avbrottsrutiner blir vanliga funktioner som testerna
+*                  anropar direkt, och asm("CLI") respektive asm("SEI")
+*                  ignoreras, eftersom testerna krs i en enda trd.
+********************************************************************************/
+#ifndef HOST_AVR_INTERRUPT_H_
+#define HOST_AVR_INTERRUPT_H_
+
+#define ISR(vector, ...) void vector(void)
+#define asm(...) ((void)0)
+
+#endif /* HOST_AVR_INTERRUPT_H_ */
\ No newline at end of file
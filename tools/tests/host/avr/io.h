@@ -0,0 +1,59 @@
+/********************************************************************************
+* avr/io.h: Ersttning fr avr-libc vid kompilering av drivrutiner fr vrden
+*           i de automatiska testerna. Endast register och bitar som
+*           testade drivrutiner anvnder finns, dr registren r vanliga
+*           variabler definierade i host_regs.c.
+********************************************************************************/
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_
+
+/* Inkluderingsdirektiv: */
+#include <stdint.h>
+
+/* Statusregister: */
+extern volatile uint8_t SREG;
+#define SREG_I 7
+
+/* Pin change-avbrott (anvnds av misc.h): */
+extern volatile uint8_t PCICR;
+
+/* Timer 2 (anvnds av modbus.c): */
+extern volatile uint8_t TCCR2A;
+extern volatile uint8_t TCCR2B;
+extern volatile uint8_t TCNT2;
+extern volatile uint8_t OCR2A;
+extern volatile uint8_t OCR2B;
+extern volatile uint8_t TIMSK2;
+extern volatile uint8_t TIFR2;
+
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define OCIE2A 1
+#define OCIE2B 2
+#define OCF2A 1
+#define OCF2B 2
+
+/* USART 0: */
+extern volatile uint8_t UCSR0A;
+extern volatile uint8_t UCSR0B;
+extern volatile uint8_t UCSR0C;
+extern volatile uint8_t UDR0;
+extern volatile uint16_t UBRR0;
+
+#define MPCM0 0
+#define U2X0 1
+#define UPE0 2
+#define DOR0 3
+#define FE0 4
+#define UDRE0 5
+#define TXC0 6
+#define RXC0 7
+#define TXEN0 3
+#define RXEN0 4
+#define UDRIE0 5
+#define RXCIE0 7
+#define UCSZ00 1
+#define UCSZ01 2
+
+#endif /* HOST_AVR_IO_H_ */
\ No newline at end of file
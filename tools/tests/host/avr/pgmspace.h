@@ -0,0 +1,21 @@
+/********************************************************************************
+* avr/pgmspace.h: Ersttning fr avr-libc vid kompilering fr vrden, dr
+*                 programminnet r vanligt minne.
+********************************************************************************/
+#ifndef HOST_AVR_PGMSPACE_H_
+#define HOST_AVR_PGMSPACE_H_
+
+/* Inkluderingsdirektiv: */
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define PGM_P const char*
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+#define pgm_read_dword(address) (*(const uint32_t*)(address))
+#define strcmp_P strcmp
+#define strlen_P strlen
+
+#endif /* HOST_AVR_PGMSPACE_H_ */
\ No newline at end of file
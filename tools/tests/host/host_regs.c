@@ -0,0 +1,21 @@
+/********************************************************************************
+* host_regs.c: Definierar registren i avr/io.h som vanliga variabler vid
+*              kompilering fr vrden.
+********************************************************************************/
+#include <avr/io.h>
+
+/* Globala objekt: */
+volatile uint8_t SREG = (1 << SREG_I);
+volatile uint8_t PCICR;
+volatile uint8_t TCCR2A;
+volatile uint8_t TCCR2B;
+volatile uint8_t TCNT2;
+volatile uint8_t OCR2A;
+volatile uint8_t OCR2B;
+volatile uint8_t TIMSK2;
+volatile uint8_t TIFR2;
+volatile uint8_t UCSR0A = (1 << UDRE0);
+volatile uint8_t UCSR0B;
+volatile uint8_t UCSR0C;
+volatile uint8_t UDR0;
+volatile uint16_t UBRR0;
\ No newline at end of file
@@ -0,0 +1,39 @@
+/********************************************************************************
+* util/crc16.h: Ersttning fr avr-libc vid kompilering fr vrden, med samma
+*               berkningar som avr-libc:s referensimplementeringar.
+********************************************************************************/
+#ifndef HOST_UTIL_CRC16_H_
+#define HOST_UTIL_CRC16_H_
+
+/* Inkluderingsdirektiv: */
+#include <stdint.h>
+
+/********************************************************************************
+* _crc16_update: CRC16 med polynom 0xA001 (Modbus).
+********************************************************************************/
+static inline uint16_t _crc16_update(uint16_t crc, const uint8_t data)
+{
+   crc ^= data;
+
+   for (uint8_t i = 0; i < 8; ++i)
+   {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : (crc >> 1);
+   }
+   return crc;
+}
+
+/********************************************************************************
+* _crc_xmodem_update: CRC-16/CCITT med polynom 0x1021 (telemetri).
+********************************************************************************/
+static inline uint16_t _crc_xmodem_update(uint16_t crc, const uint8_t data)
+{
+   crc ^= (uint16_t)data << 8;
+
+   for (uint8_t i = 0; i < 8; ++i)
+   {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+   }
+   return crc;
+}
+
+#endif /* HOST_UTIL_CRC16_H_ */
\ No newline at end of file
@@ -0,0 +1,11 @@
+/********************************************************************************
+* util/delay.h: Ersttning fr avr-libc vid kompilering fr vrden, dr
+*               frdrjningar ignoreras.
+********************************************************************************/
+#ifndef HOST_UTIL_DELAY_H_
+#define HOST_UTIL_DELAY_H_
+
+static inline void _delay_ms(double delay_time_ms) { (void)delay_time_ms; }
+static inline void _delay_us(double delay_time_us) { (void)delay_time_us; }
+
+#endif /* HOST_UTIL_DELAY_H_ */
\ No newline at end of file
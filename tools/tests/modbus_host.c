@@ -0,0 +1,185 @@
+/********************************************************************************
+* modbus_host.c: Testprogram fr vrden som kr Modbus-slaven i modbus.c bakom
+*                en pseudoterminal, s att test_modbus.py kan agera master
+*                via tools/modbus_master.py precis som mot kortet.
+*
+*                Pseudoterminalens namn skrivs p frsta raden till stdout.
+*                Mottagna byte matas in via USART:ns avbrottsrutin och
+*                svaret skickas via sndavbrottet. Timer 2 emuleras med
+*                verklig tid: t1.5 respektive t3.5 anses ha passerat nr
+*                OCR2A respektive OCR2B timersteg (64 us) har frflutit
+*                sedan senaste mottagna byte, varvid motsvarande
+*                avbrottsrutin anropas. Programmet avslutas nr stdin
+*                stngs.
+*
+*                Slaven har adress 1 och fljande registertabell:
+*
+*                Holding registers 0 - 7: Startvrde 0x1000 + adress.
+*                                         Skrivning av 0xDEAD ger
+*                                         MODBUS_SLAVE_DEVICE_FAILURE.
+*                Input registers 0 - 3:   100 + adress.
+*                Coils/discrete inputs:   Saknas (MODBUS_ILLEGAL_FUNCTION).
+********************************************************************************/
+#define _GNU_SOURCE /* posix_openpt, ptsname och cfmakeraw. */
+#include "modbus.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Makrodefinitioner: */
+#define SLAVE_ADDRESS 1         /* Slavens adress. */
+#define BAUD_RATE 2400          /* Baud rate, vilken avgr t1.5 och t3.5. */
+#define TICK_US 64              /* Tid per steg fr Timer 2 i mikrosekunder. */
+#define NUM_HOLDING_REGISTERS 8 /* Antalet holding registers. */
+#define NUM_INPUT_REGISTERS 4   /* Antalet input registers. */
+#define FAILURE_VALUE 0xDEAD    /* Vrde som ger MODBUS_SLAVE_DEVICE_FAILURE. */
+
+/* Avbrottsrutiner i serial.c: */
+void USART_RX_vect(void);
+void USART_UDRE_vect(void);
+
+/* Statiska variabler: */
+static uint16_t holding_registers[NUM_HOLDING_REGISTERS]; /* Holding registers. */
+static struct modbus slave;                               /* Slaven som testas. */
+
+/********************************************************************************
+* read_holding_register: Lser ett holding register.
+********************************************************************************/
+static enum modbus_exception read_holding_register(uint16_t address, uint16_t* value)
+{
+   *value = holding_registers[address];
+   return MODBUS_OK;
+}
+
+/********************************************************************************
+* write_holding_register: Skriver ett holding register, dr FAILURE_VALUE
+*                         simulerar ett fel vid utfrandet.
+********************************************************************************/
+static enum modbus_exception write_holding_register(uint16_t address, uint16_t value)
+{
+   if (value == FAILURE_VALUE) return MODBUS_SLAVE_DEVICE_FAILURE;
+   holding_registers[address] = value;
+   return MODBUS_OK;
+}
+
+/********************************************************************************
+* read_input_register: Lser ett input register.
+********************************************************************************/
+static enum modbus_exception read_input_register(uint16_t address, uint16_t* value)
+{
+   *value = 100 + address;
+   return MODBUS_OK;
+}
+
+/* Registertabell: */
+static const struct modbus_map map =
+{
+   0,
+   0,
+   NUM_HOLDING_REGISTERS,
+   NUM_INPUT_REGISTERS,
+   0,
+   0,
+   0,
+   &read_holding_register,
+   &write_holding_register,
+   &read_input_register
+};
+
+/********************************************************************************
+* now_us: Returnerar monoton tid i mikrosekunder.
+********************************************************************************/
+static uint64_t now_us(void)
+{
+   struct timespec time;
+   clock_gettime(CLOCK_MONOTONIC, &time);
+   return (uint64_t)time.tv_sec * 1000000 + (uint64_t)time.tv_nsec / 1000;
+}
+
+/********************************************************************************
+* main: ppnar pseudoterminalen och kr slaven tills stdin stngs.
+********************************************************************************/
+int main(void)
+{
+   const int master = posix_openpt(O_RDWR | O_NOCTTY);
+   if (master < 0 || grantpt(master) || unlockpt(master)) return 1;
+
+   /* Slavsidan hlls ppen, s att lsning inte misslyckas innan testet
+      har ppnat den. */
+   const int keep_open = open(ptsname(master), O_RDWR | O_NOCTTY);
+   if (keep_open < 0) return 1;
+
+   struct termios attributes;
+   tcgetattr(keep_open, &attributes);
+   cfmakeraw(&attributes);
+   tcsetattr(keep_open, TCSANOW, &attributes);
+
+   for (uint16_t i = 0; i < NUM_HOLDING_REGISTERS; ++i)
+   {
+      holding_registers[i] = 0x1000 + i;
+   }
+
+   if (modbus_init(&slave, SLAVE_ADDRESS, &map, BAUD_RATE)) return 1;
+   printf("%s\n", ptsname(master));
+   fflush(stdout);
+
+   uint64_t last_byte_us = 0;
+   bool char_gap_signaled = false;
+
+   while (1)
+   {
+      struct pollfd fds[2] = { { master, POLLIN, 0 }, { STDIN_FILENO, POLLIN, 0 } };
+      poll(fds, 2, 1);
+
+      if (fds[1].revents) break;
+
+      if (TCCR2B)
+      {
+         const uint64_t ticks = (now_us() - last_byte_us) / TICK_US;
+
+         if (!char_gap_signaled && ticks >= OCR2A)
+         {
+            modbus_char_gap_elapsed(&slave);
+            char_gap_signaled = true;
+         }
+
+         if (ticks >= OCR2B)
+         {
+            modbus_frame_gap_elapsed(&slave);
+         }
+      }
+
+      if (fds[0].revents & POLLIN)
+      {
+         uint8_t data[MODBUS_FRAME_MAX];
+         const ssize_t length = read(master, data, sizeof(data));
+
+         for (ssize_t i = 0; i < length; ++i)
+         {
+            UCSR0A = (1 << UDRE0);
+            UDR0 = data[i];
+            USART_RX_vect();
+         }
+
+         if (length > 0)
+         {
+            last_byte_us = now_us();
+            char_gap_signaled = false;
+         }
+      }
+
+      modbus_poll(&slave);
+
+      while (1)
+      {
+         USART_UDRE_vect();
+         if (!(UCSR0B & (1 << UDRIE0))) break;
+         const uint8_t data = UDR0;
+         if (write(master, &data, 1) != 1) return 1;
+      }
+   }
+
+   return 0;
+}
\ No newline at end of file
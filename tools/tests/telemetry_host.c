@@ -0,0 +1,80 @@
+/********************************************************************************
+* telemetry_host.c: Testprogram fr vrden som skickar en fast serie
+*                   telemetriramar via telemetry.c och serial.c och skriver
+*                   de kodade byten till stdout, dr test_telemetry.py
+*                   avkodar dem med tools/telemetry_decode.py. Antalet
+*                   kastade ramar skrivs till stderr.
+********************************************************************************/
+#include "telemetry.h"
+
+/* Avbrottsrutin i serial.c: */
+void USART_UDRE_vect(void);
+
+/********************************************************************************
+* timestamp: Returnerar en fast tidsstmpel utan nollor, s att ramhuvudet
+*            inte bryter lnga fljder av nollskilda byte.
+********************************************************************************/
+static uint32_t timestamp(void)
+{
+   return 0x04030201;
+}
+
+/********************************************************************************
+* drain: Skickar samtliga byte i sndbufferten genom att anropa
+*        avbrottsrutinen s lnge den r aktiverad och skriver dem till
+*        stdout.
+********************************************************************************/
+static void drain(void)
+{
+   while (1)
+   {
+      USART_UDRE_vect();
+      if (!(UCSR0B & (1 << UDRIE0))) break;
+      putchar(UDR0);
+   }
+   return;
+}
+
+/********************************************************************************
+* main: Skickar fljande ramar i ordning, med sekvensnummer 0 - 6:
+*
+*       0. Hndelseram utan data alls (tom data, ogiltig lngd).
+*       1. Hndelse 7 utan extra data.
+*       2. Mtvrden frn kanal 1 med antal 0.
+*       3. 16 mtvrden som samtliga r 0.
+*       4. Hndelse med maximal datamngd utan nollor.
+*       5. Hndelse med fr mycket data, vilken kastas.
+*       6. Rknare med ID 2 och 3.
+********************************************************************************/
+int main(void)
+{
+   static const uint16_t zeros[16] = { 0 };
+   static const uint32_t counters[2] = { 1, 0xFFFFFFFF };
+   uint8_t data[TELEMETRY_PAYLOAD_MAX];
+
+   for (uint8_t i = 0; i < sizeof(data); ++i)
+   {
+      data[i] = (uint8_t)(i % 255 + 1);
+   }
+
+   telemetry_set_timestamp_source(&timestamp);
+
+   telemetry_send(TELEMETRY_EVENT, 0, 0);
+   drain();
+   telemetry_send_event(7, 0, 0);
+   drain();
+   telemetry_send_samples(1, 0, 0);
+   drain();
+   telemetry_send_samples(0, zeros, 16);
+   drain();
+   telemetry_send_event(0xAA, data, TELEMETRY_PAYLOAD_MAX - 1);
+   drain();
+   telemetry_send_event(0xAA, data, TELEMETRY_PAYLOAD_MAX);
+   drain();
+   telemetry_send_counters(2, counters, 2);
+   drain();
+
+   fflush(stdout);
+   fprintf(stderr, "dropped %u\n", telemetry_dropped());
+   return 0;
+}
\ No newline at end of file
@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+"""Tests for the Modbus RTU slave in modbus.c through a pseudo-terminal.
+
+modbus_host.c is compiled for the host together with the real modbus.c and
+serial.c (see host/ for the register stand-ins). It runs the slave behind a
+pseudo-terminal, with Timer 2 emulated in real time. These tests act as the
+master through tools/modbus_master.py, just as against the board. They check
+the responses to FC03/04/06/16, the exception codes, frames with a bad CRC
+and the inter-frame timing. The slave runs at 2400 baud, so t1.5 is about
+7 ms and t3.5 about 16 ms, which leaves room for scheduling jitter on the
+host. Needs gcc and a POSIX pseudo-terminal; otherwise the tests are skipped.
+
+Usage:
+    python3 -m unittest discover -s tools/tests -v
+"""
+
+import os
+import select
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+import unittest
+
+TESTS = os.path.dirname(os.path.abspath(__file__))
+REPO = os.path.dirname(os.path.dirname(TESTS))
+sys.path.insert(0, os.path.join(REPO, 'tools'))
+
+import modbus_master  # noqa: E402
+from modbus_master import ModbusError  # noqa: E402
+
+BAUD = 2400
+SLAVE = 1
+CHAR_GAP = 0.011   # Between t1.5 (7.0 ms) and t3.5 (16.1 ms).
+FRAME_GAP = 0.040  # Well beyond t3.5.
+
+
+def build_host_program(directory):
+    """Compile modbus_host.c with modbus.c and serial.c for the host."""
+    program = os.path.join(directory, 'modbus_host')
+    sources = [os.path.join(TESTS, 'modbus_host.c'),
+               os.path.join(TESTS, 'host', 'host_regs.c'),
+               os.path.join(REPO, 'modbus.c'),
+               os.path.join(REPO, 'serial.c')]
+    subprocess.run(['gcc', '-std=gnu99', '-Wall', '-Werror', '-I', os.path.join(TESTS, 'host'),
+                    '-I', REPO, '-o', program] + sources, check=True)
+    return program
+
+
+@unittest.skipIf(shutil.which('gcc') is None or os.name != 'posix',
+                 'gcc and a POSIX pseudo-terminal are required')
+class ModbusSlave(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls.directory = tempfile.TemporaryDirectory()
+        cls.process = subprocess.Popen([build_host_program(cls.directory.name)],
+                                       stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+        path = cls.process.stdout.readline().decode().strip()
+        cls.fd = modbus_master.open_port(path, BAUD)
+        cls.master = modbus_master.Master(cls.fd, SLAVE, timeout=0.5)
+
+    @classmethod
+    def tearDownClass(cls):
+        os.close(cls.fd)
+        cls.process.stdin.close()
+        cls.process.wait(timeout=5)
+        cls.directory.cleanup()
+
+    def setUp(self):
+        time.sleep(FRAME_GAP)
+
+    def assertException(self, code, function, *args):
+        with self.assertRaisesRegex(ModbusError, r'^exception %d ' % code):
+            function(*args)
+
+    def assertNoResponse(self, timeout=0.3):
+        readable = select.select([self.fd], [], [], timeout)[0]
+        self.assertFalse(readable, 'unexpected response %s' % (os.read(self.fd, 256).hex(' ')
+                                                                  if readable else ''))
+
+    def holding(self, address, count):
+        return self.master.read_registers(modbus_master.READ_HOLDING_REGISTERS, address, count)
+
+    def test_read_holding_registers(self):
+        self.master.write_registers(0, [0x1000, 0x1001])
+        self.assertEqual(self.holding(0, 2), [0x1000, 0x1001])
+
+    def test_read_input_registers(self):
+        self.assertEqual(self.master.read_registers(modbus_master.READ_INPUT_REGISTERS, 1, 3),
+                         [101, 102, 103])
+
+    def test_write_single_register(self):
+        self.master.write_register(2, 500)
+        self.assertEqual(self.holding(2, 1), [500])
+
+    def test_write_multiple_registers(self):
+        self.master.write_registers(4, [1, 2, 0xFFFF, 4])
+        self.assertEqual(self.holding(4, 4), [1, 2, 0xFFFF, 4])
+
+    def test_raw_response_bytes(self):
+        self.master.write_register(3, 0x1234)
+        request = modbus_master.frame(SLAVE, struct.pack('>BHH', 0x03, 3, 1))
+        os.write(self.fd, request)
+        time.sleep(0.1)
+        response = os.read(self.fd, 256)
+        self.assertEqual(response, modbus_master.frame(SLAVE, bytes([0x03, 2, 0x12, 0x34])))
+
+    def test_illegal_function(self):
+        self.assertException(1, self.master.read_bits, modbus_master.READ_COILS, 0, 1)
+        self.assertException(1, self.master.request, bytes([0x2B, 0x0E, 0x01, 0x00]))
+
+    def test_illegal_data_address(self):
+        self.assertException(2, self.holding, 6, 4)
+        self.assertException(2, self.master.write_register, 8, 1)
+        self.assertException(2, self.master.write_registers, 7, [1, 2])
+
+    def test_illegal_data_value(self):
+        self.assertException(3, self.holding, 0, 0)
+        self.assertException(3, self.holding, 0, 126)
+
+    def test_slave_device_failure(self):
+        self.assertException(4, self.master.write_register, 1, 0xDEAD)
+
+    def test_bad_crc_is_ignored(self):
+        request = bytearray(modbus_master.frame(SLAVE, struct.pack('>BHH', 0x06, 5, 77)))
+        request[-1] ^= 0xFF
+        os.write(self.fd, bytes(request))
+        self.assertNoResponse()
+        self.assertNotEqual(self.holding(5, 1), [77])
+
+    def test_other_slave_is_ignored(self):
+        os.write(self.fd, modbus_master.frame(SLAVE + 1, struct.pack('>BHH', 0x03, 0, 1)))
+        self.assertNoResponse()
+
+    def test_broadcast_executes_without_response(self):
+        os.write(self.fd, modbus_master.frame(0, struct.pack('>BHH', 0x06, 6, 606)))
+        self.assertNoResponse()
+        self.assertEqual(self.holding(6, 1), [606])
+
+    def test_gap_beyond_t35_splits_frame(self):
+        request = modbus_master.frame(SLAVE, struct.pack('>BHH', 0x06, 7, 707))
+        os.write(self.fd, request[:3])
+        time.sleep(FRAME_GAP)
+        os.write(self.fd, request[3:])
+        self.assertNoResponse()
+        self.assertNotEqual(self.holding(7, 1), [707])
+
+    def test_gap_between_t15_and_t35_invalidates_frame(self):
+        request = modbus_master.frame(SLAVE, struct.pack('>BHH', 0x06, 7, 708))
+        os.write(self.fd, request[:4])
+        time.sleep(CHAR_GAP)
+        os.write(self.fd, request[4:])
+        self.assertNoResponse()
+        self.assertNotEqual(self.holding(7, 1), [708])
+
+    def test_recovers_after_errors(self):
+        os.write(self.fd, b'\x01\x03\x00')
+        self.assertNoResponse()
+        self.master.write_register(0, 42)
+        self.assertEqual(self.holding(0, 1), [42])
+
+
+if __name__ == '__main__':
+    unittest.main()
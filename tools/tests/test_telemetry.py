@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+"""Round-trip tests for the telemetry frames from telemetry.c.
+
+telemetry_host.c is compiled for the host together with the real
+telemetry.c and serial.c (see host/ for the register stand-ins). It sends a
+fixed series of frames and writes the encoded bytes to stdout. These are
+decoded with tools/telemetry_decode.py and compared with the expected text.
+Runs of 254 and 255 zero-free bytes are longer than any frame the firmware
+can send (TELEMETRY_FRAME_MAX), so they are checked against a reference
+COBS encoder instead. Needs gcc on the host; the tests are skipped without
+it.
+
+Usage:
+    python3 -m unittest discover -s tools/tests -v
+"""
+
+import io
+import os
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+import unittest
+
+TESTS = os.path.dirname(os.path.abspath(__file__))
+REPO = os.path.dirname(os.path.dirname(TESTS))
+sys.path.insert(0, os.path.join(REPO, 'tools'))
+
+import telemetry_decode  # noqa: E402
+
+TIMESTAMP = 0x04030201
+
+
+def cobs_encode(data):
+    """Reference COBS encoder, code 0xFF after every 254 zero-free bytes."""
+    out = bytearray()
+    block = bytearray()
+    for byte in data:
+        if byte == 0:
+            out.append(len(block) + 1)
+            out += block
+            block = bytearray()
+        else:
+            block.append(byte)
+            if len(block) == 254:
+                out.append(0xFF)
+                out += block
+                block = bytearray()
+    out.append(len(block) + 1)
+    out += block
+    return bytes(out)
+
+
+def frame(kind, sequence, payload):
+    """Return an unencoded frame with header and CRC, as telemetry.c builds it."""
+    data = struct.pack('<BBI', kind, sequence, TIMESTAMP) + payload
+    return data + struct.pack('<H', telemetry_decode.crc16(data))
+
+
+def decode(stream):
+    """Return the decoder output and the decoder for the given byte stream."""
+    out = io.StringIO()
+    decoder = telemetry_decode.Decoder(out)
+    decoder.feed(stream)
+    return out.getvalue(), decoder
+
+
+def build_host_program(directory):
+    """Compile telemetry_host.c with telemetry.c and serial.c for the host."""
+    program = os.path.join(directory, 'telemetry_host')
+    sources = [os.path.join(TESTS, 'telemetry_host.c'),
+               os.path.join(TESTS, 'host', 'host_regs.c'),
+               os.path.join(REPO, 'telemetry.c'),
+               os.path.join(REPO, 'serial.c')]
+    subprocess.run(['gcc', '-std=gnu99', '-Wall', '-Werror', '-I', os.path.join(TESTS, 'host'),
+                    '-I', REPO, '-o', program] + sources, check=True)
+    return program
+
+
+@unittest.skipIf(shutil.which('gcc') is None, 'gcc is required to build the host program')
+class FirmwareRoundTrip(unittest.TestCase):
+    """Frames from the firmware encoder decoded by telemetry_decode.py."""
+
+    @classmethod
+    def setUpClass(cls):
+        with tempfile.TemporaryDirectory() as directory:
+            result = subprocess.run([build_host_program(directory)], check=True,
+                                    stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        cls.stream = result.stdout
+        cls.stderr = result.stderr.decode()
+        cls.chunks = [chunk for chunk in cls.stream.split(b'\0') if chunk]
+
+    def test_frames_decode(self):
+        text, decoder = decode(self.stream)
+        lines = text.splitlines()
+        self.assertEqual(lines[0], '<bad frame: unknown type 3 or bad length, 9 bytes>')
+        self.assertEqual(lines[1], '[ 67305.985] #001 event 7')
+        self.assertEqual(lines[2], '[ 67305.985] #002 samples channel 1: ')
+        self.assertEqual(lines[3], '[ 67305.985] #003 samples channel 0: ' + ' '.join(['0'] * 16))
+        self.assertTrue(lines[4].startswith('[ 67305.985] #004 event 170 01 02 03'))
+        self.assertEqual(lines[5], '<lost 1 frame(s)>')
+        self.assertEqual(lines[6], '[ 67305.985] #006 counters 2=1 3=4294967295')
+        self.assertEqual(len(lines), 7)
+        self.assertEqual((decoder.bad, decoder.lost), (1, 1))
+
+    def test_empty_payload_has_valid_crc(self):
+        data = telemetry_decode.cobs_decode(self.chunks[0])
+        self.assertEqual(data, frame(telemetry_decode.EVENT, 0, b''))
+
+    def test_all_zero_payload(self):
+        data = telemetry_decode.cobs_decode(self.chunks[3])
+        self.assertEqual(data, frame(telemetry_decode.SAMPLES, 3, bytes([0, 16]) + bytes(32)))
+        self.assertNotIn(0, self.chunks[3])
+
+    def test_matches_reference_encoder(self):
+        for chunk in self.chunks:
+            self.assertEqual(chunk, cobs_encode(telemetry_decode.cobs_decode(chunk)))
+
+    def test_longest_zero_free_frame(self):
+        data = telemetry_decode.cobs_decode(self.chunks[4])
+        self.assertEqual(len(self.chunks[4]), len(data) + 1)
+        self.assertNotIn(0, data[:-2])
+
+    def test_dropped_frame_is_counted(self):
+        self.assertEqual(self.stderr.strip(), 'dropped 1')
+
+    def test_corrupted_crc(self):
+        data = bytearray(telemetry_decode.cobs_decode(self.chunks[-1]))
+        data[-1] ^= 0x01
+        stream = b'\0' + cobs_encode(bytes(data)) + b'\0' + self.chunks[-1] + b'\0'
+        text, decoder = decode(stream)
+        self.assertEqual(text.splitlines()[0], '<bad frame: CRC mismatch, %d bytes>' % len(self.chunks[-1]))
+        self.assertIn('#006 counters 2=1 3=4294967295', text)
+        self.assertEqual(decoder.bad, 1)
+
+
+class ZeroFreeRuns(unittest.TestCase):
+    """COBS blocks at and beyond the 254-byte limit of one code byte."""
+
+    def check_run(self, length):
+        payload = bytes([7]) + bytes(i % 255 + 1 for i in range(length))
+        data = frame(telemetry_decode.EVENT, 1, payload)
+        encoded = cobs_encode(data)
+        self.assertEqual(telemetry_decode.cobs_decode(encoded), data)
+        text, decoder = decode(b'\0' + encoded + b'\0')
+        self.assertIn('#001 event 7 01 02', text)
+        self.assertEqual(decoder.bad, 0)
+
+    def test_254_bytes(self):
+        data = bytes(i % 255 + 1 for i in range(254))
+        self.assertEqual(cobs_encode(data)[0], 0xFF)
+        self.assertEqual(telemetry_decode.cobs_decode(cobs_encode(data)), data)
+        self.assertEqual(telemetry_decode.cobs_decode(b'\xff' + data), data)
+        self.check_run(254)
+
+    def test_255_bytes(self):
+        data = bytes(i % 255 + 1 for i in range(255))
+        self.assertEqual(cobs_encode(data), b'\xff' + data[:254] + b'\x02' + data[254:])
+        self.assertEqual(telemetry_decode.cobs_decode(cobs_encode(data)), data)
+        self.check_run(255)
+
+
+if __name__ == '__main__':
+    unittest.main()